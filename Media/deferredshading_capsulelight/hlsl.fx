@@ -20,26 +20,36 @@ cbuffer cbGBufferUnpack : register(b7)
 	matrix ViewInv;
 }
 
-cbuffer cbCapsuleLight : register(b8)
+// one record per light, all lights rendered by one instanced draw
+struct CapsuleLightData
 {
-	float4 CapsuleLightPos;
-	float4 CapsuleLightRangeRcp;
-	float4 CapsuleDir;
-	float4 CapsuleLen;
-	float4 CapsuleColor;
-
-	float4 HalfSegmentLen;
-	float4 CapsuleRange;
+	float3 CapsuleLightPos;
+	float CapsuleLightRangeRcp;
+	float3 CapsuleDir;
+	float CapsuleLen;
+	float3 CapsuleColor;
+	float HalfSegmentLen;
+	float CapsuleRange;
+	float3 Pad;
 	matrix LightProjection;
-}
+};
+
+StructuredBuffer<CapsuleLightData> CapsuleLights : register(t8);
 
 
 /////////////////////////////////////////////////////////////////////////////
 // Vertex shader
 /////////////////////////////////////////////////////////////////////////////
-float4 VS() : SV_Position
+struct VS_OUTPUT
+{
+	uint LightIdx : TEXCOORD0;
+};
+
+VS_OUTPUT VS(uint instID : SV_InstanceID)
 {
-	return float4(0.0, 0.0, 0.0, 1.0);
+	VS_OUTPUT Output;
+	Output.LightIdx = instID;
+	return Output;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -65,6 +75,7 @@ HS_CONSTANT_DATA_OUTPUT CapsuleLightConstantHS()
 struct HS_OUTPUT
 {
 	float4 CapsuleDir : POSITION;
+	uint LightIdx : TEXCOORD0;
 };
 
 static const float4 CapsuelDir[2] = {
@@ -77,11 +88,13 @@ static const float4 CapsuelDir[2] = {
 [outputtopology("triangle_ccw")]
 [outputcontrolpoints(4)]
 [patchconstantfunc("CapsuleLightConstantHS")]
-HS_OUTPUT CapsuleLightHS(uint PatchID : SV_PrimitiveID)
+HS_OUTPUT CapsuleLightHS(InputPatch<VS_OUTPUT, 1> patch, uint PatchID : SV_PrimitiveID)
 {
 	HS_OUTPUT Output;
 
+	// PrimitiveID restart at 0 every instance
 	Output.CapsuleDir = CapsuelDir[PatchID];
+	Output.LightIdx = patch[0].LightIdx;
 
 	return Output;
 }
@@ -93,6 +106,7 @@ struct DS_OUTPUT
 {
 	float4 Position : SV_POSITION;
 	float2 cpPos	: TEXCOORD0;
+	nointerpolation uint LightIdx : TEXCOORD1;
 };
 
 #define CylinderPortion 0.2f
@@ -103,6 +117,8 @@ struct DS_OUTPUT
 DS_OUTPUT CapsuleLightDS(HS_CONSTANT_DATA_OUTPUT input, float2 UV : SV_DomainLocation
 	, const OutputPatch<HS_OUTPUT, 4> quad)
 {
+	const CapsuleLightData light = CapsuleLights[quad[0].LightIdx];
+
 	// Transform the UV's into clip-space
 	float2 posClipSpace = UV.xy * float2(2.0, -2.0) + float2(-1.0, 1.0);
 
@@ -122,19 +138,20 @@ DS_OUTPUT CapsuleLightDS(HS_CONSTANT_DATA_OUTPUT input, float2 UV : SV_DomainLoc
 	float cylinderOffsetZ = saturate((maxLen * ExpendAmount - 1.0) / CylinderPortion);
 
 	// Apply the range
-	halfSpherePos *= CapsuleRange.x;
+	halfSpherePos *= light.CapsuleRange;
 
 	// Offset the cone vertices to thier final position
 	float4 posLS = float4(halfSpherePos.xy, 
-		halfSpherePos.z + HalfSegmentLen.x - cylinderOffsetZ * HalfSegmentLen.x, 1.0f);
+		halfSpherePos.z + light.HalfSegmentLen - cylinderOffsetZ * light.HalfSegmentLen, 1.0f);
 
 	// Move the vertex to the selected capsule side
 	posLS *= quad[0].CapsuleDir;
 
 	// Transform all the way to projected space and generate the UV coordinates
 	DS_OUTPUT Output;
-	Output.Position = mul(posLS, LightProjection);
+	Output.Position = mul(posLS, light.LightProjection);
 	Output.cpPos = Output.Position.xy / Output.Position.w;
+	Output.LightIdx = quad[0].LightIdx;
 
 	return Output;
 }
@@ -206,15 +223,15 @@ SURFACE_DATA UnpackGBuffer_Loc(int2 location)
 }
 
 
-float3 CalcCapsule(float3 position, Material material, bool bUseShadow)
+float3 CalcCapsule(float3 position, Material material, CapsuleLightData light, bool bUseShadow)
 {
 	float3 ToEye = EyePosition - position;
 
 	// Find the shortest distance between the pixel and capsules segment
-	float3 ToCapsuleStart = position - CapsuleLightPos.xyz;
-	float DistOnLine = dot(ToCapsuleStart, CapsuleDir.xyz) / CapsuleLen.x;
-	DistOnLine = saturate(DistOnLine) * CapsuleLen.x;
-	float3 PointOnLine = CapsuleLightPos.xyz + CapsuleDir.xyz * DistOnLine;
+	float3 ToCapsuleStart = position - light.CapsuleLightPos;
+	float DistOnLine = dot(ToCapsuleStart, light.CapsuleDir) / light.CapsuleLen;
+	DistOnLine = saturate(DistOnLine) * light.CapsuleLen;
+	float3 PointOnLine = light.CapsuleLightPos + light.CapsuleDir * DistOnLine;
 	float3 ToLight = PointOnLine - position;
 	float DistToLight = length(ToLight);
 
@@ -230,9 +247,9 @@ float3 CalcCapsule(float3 position, Material material, bool bUseShadow)
 	finalColor += pow(NDotH, material.specPow) * material.specIntensity;
 
 	// Attenuation
-	float DistToLightNorm = 1.0 - saturate(DistToLight * CapsuleLightRangeRcp.x);
+	float DistToLightNorm = 1.0 - saturate(DistToLight * light.CapsuleLightRangeRcp);
 	float Attn = DistToLightNorm * DistToLightNorm;
-	finalColor *= CapsuleColor.rgb * Attn;
+	finalColor *= light.CapsuleColor * Attn;
 
 	return finalColor;
 }
@@ -251,7 +268,7 @@ float4 CapsuleLightCommonPS(DS_OUTPUT In, bool bUseShadow) : SV_TARGET
 	float3 position = CalcWorldPos(In.cpPos, gbd.LinearDepth);
 
 	// Calculate the light contribution
-	float3 finalColor = CalcCapsule(position, mat, bUseShadow);
+	float3 finalColor = CalcCapsule(position, mat, CapsuleLights[In.LightIdx], bUseShadow);
 
 	// return the final color
 	return float4(finalColor, 1.0);
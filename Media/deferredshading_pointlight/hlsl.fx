@@ -20,22 +20,32 @@ cbuffer cbGBufferUnpack : register(b7)
 	matrix ViewInv;
 }
 
-cbuffer cbPointLight : register(b8)
+// one record per light, all lights rendered by one instanced draw
+struct PointLightData
 {
-	float4 PointLightPos;
-	float4 PointLightRangeRcp;
-	float4 PointColor;
-	float4 LightPerspectiveValues;
+	float3 PointLightPos;
+	float PointLightRangeRcp;
+	float3 PointColor;
+	float Pad;
 	matrix LightProjection;
-}
+};
+
+StructuredBuffer<PointLightData> PointLights : register(t8);
 
 
 /////////////////////////////////////////////////////////////////////////////
 // Vertex shader
 /////////////////////////////////////////////////////////////////////////////
-float4 VS() : SV_Position
+struct VS_OUTPUT
 {
-	return float4(0.0, 0.0, 0.0, 1.0);
+	uint LightIdx : TEXCOORD0;
+};
+
+VS_OUTPUT VS(uint instID : SV_InstanceID)
+{
+	VS_OUTPUT Output;
+	Output.LightIdx = instID;
+	return Output;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -61,6 +71,7 @@ HS_CONSTANT_DATA_OUTPUT PointLightConstantHS()
 struct HS_OUTPUT
 {
 	float3 HemiDir : POSITION;
+	uint LightIdx : TEXCOORD0;
 };
 
 static const float3 HemilDir[2] = {
@@ -73,11 +84,13 @@ static const float3 HemilDir[2] = {
 [outputtopology("triangle_ccw")]
 [outputcontrolpoints(4)]
 [patchconstantfunc("PointLightConstantHS")]
-HS_OUTPUT PointLightHS(uint PatchID : SV_PrimitiveID)
+HS_OUTPUT PointLightHS(InputPatch<VS_OUTPUT, 1> patch, uint PatchID : SV_PrimitiveID)
 {
 	HS_OUTPUT Output;
 
+	// PrimitiveID restart at 0 every instance
 	Output.HemiDir = HemilDir[PatchID];
+	Output.LightIdx = patch[0].LightIdx;
 
 	return Output;
 }
@@ -89,6 +102,7 @@ struct DS_OUTPUT
 {
 	float4 Position : SV_POSITION;
 	float2 cpPos	: TEXCOORD0;
+	nointerpolation uint LightIdx : TEXCOORD1;
 };
 
 [domain("quad")]
@@ -108,7 +122,8 @@ DS_OUTPUT PointLightDS(HS_CONSTANT_DATA_OUTPUT input, float2 UV : SV_DomainLocat
 
 	// Transform all the way to projected space
 	DS_OUTPUT Output;
-	Output.Position = mul(posLS, LightProjection);
+	Output.Position = mul(posLS, PointLights[quad[0].LightIdx].LightProjection);
+	Output.LightIdx = quad[0].LightIdx;
 
 	// Store the clip space position
 	Output.cpPos = Output.Position.xy / Output.Position.w;
@@ -184,9 +199,9 @@ SURFACE_DATA UnpackGBuffer_Loc(int2 location)
 
 
 
-float3 CalcPoint(float3 position, Material material, bool bUseShadow)
+float3 CalcPoint(float3 position, Material material, PointLightData light, bool bUseShadow)
 {
-	float3 ToLight = PointLightPos.xyz - position;
+	float3 ToLight = light.PointLightPos - position;
 	float3 ToEye = EyePosition - position;
 	float DistToLight = length(ToLight);
 
@@ -202,9 +217,9 @@ float3 CalcPoint(float3 position, Material material, bool bUseShadow)
 	finalColor += pow(NDotH, material.specPow) * material.specIntensity;
 
 	// Attenuation
-	float DistToLightNorm = 1.0 - saturate(DistToLight * PointLightRangeRcp.x);
+	float DistToLightNorm = 1.0 - saturate(DistToLight * light.PointLightRangeRcp);
 	float Attn = DistToLightNorm * DistToLightNorm;
-	finalColor *= PointColor.rgb * Attn;
+	finalColor *= light.PointColor * Attn;
 
 	return finalColor;
 }
@@ -222,7 +237,7 @@ float4 PointLightCommonPS(DS_OUTPUT In, bool bUseShadow) : SV_TARGET
 	float3 position = CalcWorldPos(In.cpPos, gbd.LinearDepth);
 
 	// Calculate the light contribution
-	float3 finalColor = CalcPoint(position, mat, bUseShadow);
+	float3 finalColor = CalcPoint(position, mat, PointLights[In.LightIdx], bUseShadow);
 
 	// return the final color
 	return float4(finalColor, 1.0);
@@ -20,27 +20,37 @@ cbuffer cbGBufferUnpack : register(b7)
 	matrix ViewInv;
 }
 
-cbuffer cbSpotLight : register(b8)
+// one record per light, all lights rendered by one instanced draw
+struct SpotLightData
 {
-	float4 SpotLightPos;
-	float4 SpotLightRangeRcp;
-	float4 SpotDirToLight;
-	float4 SpotCosOuterCone;
-	float4 SpotColor;
-	float4 SpotCosConeAttRange;
-
+	float3 SpotLightPos;
+	float SpotLightRangeRcp;
+	float3 SpotDirToLight;
+	float SpotCosOuterCone;
+	float3 SpotColor;
+	float SpotCosConeAttRange;
+	float SinAngle;
+	float CosAngle;
+	float2 Pad;
 	matrix LightProjection;
-	float4 SinAngle;
-	float4 CosAngle;
-}
+};
+
+StructuredBuffer<SpotLightData> SpotLights : register(t8);
 
 
 /////////////////////////////////////////////////////////////////////////////
 // Vertex shader
 /////////////////////////////////////////////////////////////////////////////
-float4 VS() : SV_Position
+struct VS_OUTPUT
 {
-	return float4(0.0, 0.0, 0.0, 1.0);
+	uint LightIdx : TEXCOORD0;
+};
+
+VS_OUTPUT VS(uint instID : SV_InstanceID)
+{
+	VS_OUTPUT Output;
+	Output.LightIdx = instID;
+	return Output;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -66,6 +76,7 @@ HS_CONSTANT_DATA_OUTPUT SpotLightConstantHS()
 struct HS_OUTPUT
 {
 	float3 Position : POSITION;
+	uint LightIdx : TEXCOORD0;
 };
 
 
@@ -74,11 +85,12 @@ struct HS_OUTPUT
 [outputtopology("triangle_ccw")]
 [outputcontrolpoints(4)]
 [patchconstantfunc("SpotLightConstantHS")]
-HS_OUTPUT SpotLightHS(uint PatchID : SV_PrimitiveID)
+HS_OUTPUT SpotLightHS(InputPatch<VS_OUTPUT, 1> patch, uint PatchID : SV_PrimitiveID)
 {
 	HS_OUTPUT Output;
 
 	Output.Position = float3(0.0, 0.0, 0.0);
+	Output.LightIdx = patch[0].LightIdx;
 
 	return Output;
 }
@@ -90,6 +102,7 @@ struct DS_OUTPUT
 {
 	float4 Position : SV_POSITION;
 	float2 cpPos	: TEXCOORD0;
+	nointerpolation uint LightIdx : TEXCOORD1;
 };
 
 #define CylinderPortion 0.2f
@@ -99,6 +112,8 @@ struct DS_OUTPUT
 DS_OUTPUT SpotLightDS(HS_CONSTANT_DATA_OUTPUT input, float2 UV : SV_DomainLocation
 	, const OutputPatch<HS_OUTPUT, 4> quad)
 {
+	const SpotLightData light = SpotLights[quad[0].LightIdx];
+
 	// Transform the UV's into clip-space
 	float2 posClipSpace = UV.xy * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f);
 
@@ -115,18 +130,19 @@ DS_OUTPUT SpotLightDS(HS_CONSTANT_DATA_OUTPUT input, float2 UV : SV_DomainLocati
 	float3 halfSpherePos = normalize(float3(posClipSpaceNoCyl.xy, 1.0f - maxLenNoCapsule));
 
 	// Scale the sphere to the size of the cones rounded base
-	halfSpherePos = normalize(float3(halfSpherePos.xy * SinAngle.x, CosAngle.x));
+	halfSpherePos = normalize(float3(halfSpherePos.xy * light.SinAngle, light.CosAngle));
 
 	// Find the offsets for the cone vertices (0 for cone base)
 	float cylinderOffsetZ = saturate((maxLen * ExpendAmount - 1.0f) / CylinderPortion);
 
 	// Offset the cone vertices to thier final position
-	float4 posLS = float4(halfSpherePos.xy * (1.0f - cylinderOffsetZ), halfSpherePos.z - cylinderOffsetZ * CosAngle.x, 1.0f);
+	float4 posLS = float4(halfSpherePos.xy * (1.0f - cylinderOffsetZ), halfSpherePos.z - cylinderOffsetZ * light.CosAngle, 1.0f);
 
 	// Transform all the way to projected space and generate the UV coordinates
 	DS_OUTPUT Output;
-	Output.Position = mul(posLS, LightProjection);
+	Output.Position = mul(posLS, light.LightProjection);
 	Output.cpPos = Output.Position.xy / Output.Position.w;
+	Output.LightIdx = quad[0].LightIdx;
 
 	return Output;
 }
@@ -198,9 +214,9 @@ SURFACE_DATA UnpackGBuffer_Loc(int2 location)
 }
 
 
-float3 CalcSpot(float3 position, Material material, bool bUseShadow)
+float3 CalcSpot(float3 position, Material material, SpotLightData light, bool bUseShadow)
 {
-	float3 ToLight = SpotLightPos.xyz - position;
+	float3 ToLight = light.SpotLightPos - position;
 	float3 ToEye = EyePosition - position;
 	float DistToLight = length(ToLight);
 
@@ -216,14 +232,14 @@ float3 CalcSpot(float3 position, Material material, bool bUseShadow)
 	finalColor += pow(NDotH, material.specPow) * material.specIntensity;
 
 	// Cone attenuation
-	float cosAng = dot(SpotDirToLight.xyz, ToLight);
-	float conAtt = saturate((cosAng - SpotCosOuterCone.x) / SpotCosConeAttRange.x);
+	float cosAng = dot(light.SpotDirToLight, ToLight);
+	float conAtt = saturate((cosAng - light.SpotCosOuterCone) / light.SpotCosConeAttRange);
 	conAtt *= conAtt;
 
 	// Attenuation
-	float DistToLightNorm = 1.0 - saturate(DistToLight * SpotLightRangeRcp.x);
+	float DistToLightNorm = 1.0 - saturate(DistToLight * light.SpotLightRangeRcp);
 	float Attn = DistToLightNorm * DistToLightNorm;
-	finalColor *= SpotColor.rgb * Attn * conAtt;
+	finalColor *= light.SpotColor * Attn * conAtt;
 
 	return finalColor;
 }
@@ -242,7 +258,7 @@ float4 SpotLightCommonPS(DS_OUTPUT In, bool bUseShadow) : SV_TARGET
 	float3 position = CalcWorldPos(In.cpPos, gbd.LinearDepth);
 
 	// Calculate the light contribution
-	float3 finalColor = CalcSpot(position, mat, bUseShadow);
+	float3 finalColor = CalcSpot(position, mat, SpotLights[In.LightIdx], bUseShadow);
 
 	// return the final color
 	return float4(finalColor, 1.0);
@@ -1,5 +1,7 @@
 
 #include "../common.fx"
+#include "vertexdecode.fx"
+#include "permutation.fx"
 
 static const float2 g_SpecPowerRange = { 10.0, 250.0 };
 
@@ -25,11 +27,14 @@ VSOUT_DIRLIGHT VS(float4 Pos : POSITION
 	, float3 Normal : NORMAL
 	, float2 Tex : TEXCOORD0
 	, uint instID : SV_InstanceID
-	, uniform bool IsInstancing
 )
 {
 	VSOUT_DIRLIGHT output = (VSOUT_DIRLIGHT)0;
-	const matrix mWorld = IsInstancing ? gWorldInst[instID] : gWorld;
+#if INSTANCING
+	const matrix mWorld = gWorldInst[instID];
+#else
+	const matrix mWorld = gWorld;
+#endif
 
 	float4 PosW = mul(Pos, mWorld);
 	output.Pos = mul(PosW, gView);
@@ -44,6 +49,44 @@ VSOUT_DIRLIGHT VS(float4 Pos : POSITION
 	return output;
 }
 
+// compressed vertex, cVertexCodec
+VSOUT_DIRLIGHT PackedVertex(float4 PosQ, float2 NormalOct, float2 Tex, matrix mWorld)
+{
+	VSOUT_DIRLIGHT output = (VSOUT_DIRLIGHT)0;
+	const float4 Pos = DecodePosition(PosQ);
+	const float3 Normal = DecodeOctNormal(NormalOct);
+
+	float4 PosW = mul(Pos, mWorld);
+	output.Pos = mul(PosW, gView);
+	output.Pos = mul(output.Pos, gProjection);
+	output.Normal = normalize(mul(Normal, (float3x3)mWorld));
+	output.Tex = Tex;
+	output.PosH = output.Pos;
+	output.PosW = PosW.xyz;
+	output.toEye = normalize(float4(gEyePosW, 1) - PosW).xyz;
+	output.clip = dot(PosW, gClipPlane);
+
+	return output;
+}
+
+VSOUT_DIRLIGHT VS_Packed(float4 PosQ : POSITION
+	, float2 NormalOct : NORMAL
+	, float2 Tex : TEXCOORD0
+)
+{
+	return PackedVertex(PosQ, NormalOct, Tex, gWorld);
+}
+
+// compressed vertex, cbPerFrameInstancing world (cMeshLod::RenderInstanced)
+VSOUT_DIRLIGHT VS_Packed_Instancing(float4 PosQ : POSITION
+	, float2 NormalOct : NORMAL
+	, float2 Tex : TEXCOORD0
+	, uint instID : SV_InstanceID
+)
+{
+	return PackedVertex(PosQ, NormalOct, Tex, gWorldInst[instID]);
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // Pixel shader
 /////////////////////////////////////////////////////////////////////////////
@@ -64,7 +107,7 @@ PS_GBUFFER_OUT PackGBuffer(float3 BaseColor, float3 Normal, float SpecIntensity,
 
 	// Pack all the data into the GBuffer structure
 	Out.ColorSpecInt = float4(BaseColor.rgb, SpecIntensity);
-	Out.Normal = float4(Normal * 0.5 + 0.5, 1.0);
+	Out.Normal = float4(EncodeGBufferNormal(Normal), 1.0);
 	Out.SpecPow = float4(SpecPowerNorm, 0.0, 0.0, 1.0);
 
 	return Out;
@@ -85,7 +128,33 @@ technique11 Unlit
 {
 	pass P0
 	{
-		SetVertexShader(CompileShader(vs_5_0, VS(NotInstancing)));
+		SetVertexShader(CompileShader(vs_5_0, VS()));
+		SetGeometryShader(NULL);
+		SetHullShader(NULL);
+		SetDomainShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS()));
+	}
+}
+
+
+technique11 Unlit_Packed
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_5_0, VS_Packed()));
+		SetGeometryShader(NULL);
+		SetHullShader(NULL);
+		SetDomainShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS()));
+	}
+}
+
+
+technique11 Unlit_Packed_Instancing
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_5_0, VS_Packed_Instancing()));
 		SetGeometryShader(NULL);
 		SetHullShader(NULL);
 		SetDomainShader(NULL);
@@ -1,5 +1,6 @@
 
 #include "../common.fx"
+#include "permutation.fx"
 
 Texture2D<float> DepthTexture         : register(t0);
 Texture2D<float4> ColorSpecIntTexture : register(t1);
@@ -144,8 +145,7 @@ SURFACE_DATA UnpackGBuffer_Loc(int2 location)
 	float4 baseColorSpecInt = ColorSpecIntTexture.Load(location3);
 	Out.Color = baseColorSpecInt.xyz;
 	Out.SpecIntensity = baseColorSpecInt.w;
-	Out.Normal = NormalTexture.Load(location3).xyz;
-	Out.Normal = normalize(Out.Normal * 2.0 - 1.0);
+	Out.Normal = DecodeGBufferNormal(NormalTexture.Load(location3).xyz);
 	Out.SpecPow = SpecPowTexture.Load(location3).x;
 
 	return Out;
@@ -0,0 +1,35 @@
+
+// draw call benchmark, cDrawBenchmark
+// no effect variable, constant buffer update by UpdateSubresource()
+
+cbuffer cbDrawBench : register(b0)
+{
+	matrix gBenchWorld;
+	matrix gBenchViewProj;
+};
+
+
+float4 VS(float4 Pos : POSITION) : SV_POSITION
+{
+	float4 PosW = mul(Pos, gBenchWorld);
+	return mul(PosW, gBenchViewProj);
+}
+
+
+float4 PS(float4 Pos : SV_POSITION) : SV_Target
+{
+	return float4(1, 1, 1, 1);
+}
+
+
+technique11 Unlit
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_5_0, VS()));
+		SetGeometryShader(NULL);
+		SetHullShader(NULL);
+		SetDomainShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS()));
+	}
+}
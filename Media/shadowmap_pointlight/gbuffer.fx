@@ -1,5 +1,6 @@
 
 #include "../common.fx"
+#include "permutation.fx"
 
 Texture2D<float> DepthTexture         : register(t0);
 Texture2D<float4> ColorSpecIntTexture : register(t1);
@@ -94,8 +95,7 @@ SURFACE_DATA UnpackGBuffer(float2 UV)
 	float4 baseColorSpecInt = ColorSpecIntTexture.Sample(samPoint, UV.xy);
 	Out.Color = baseColorSpecInt.xyz;
 	Out.SpecIntensity = baseColorSpecInt.w;
-	Out.Normal = NormalTexture.Sample(samPoint, UV.xy).xyz;
-	Out.Normal = normalize(Out.Normal * 2.0 - 1.0);
+	Out.Normal = DecodeGBufferNormal(NormalTexture.Sample(samPoint, UV.xy).xyz);
 	Out.SpecPow = SpecPowTexture.Sample(samPoint, UV.xy).x;
 
 	return Out;
@@ -1,5 +1,6 @@
 
 #include "../common.fx"
+#include "permutation.fx"
 
 Texture2D<float> DepthTexture         : register(t0);
 Texture2D<float4> ColorSpecIntTexture : register(t1);
@@ -195,8 +196,7 @@ SURFACE_DATA UnpackGBuffer_Loc(int2 location)
 	float4 baseColorSpecInt = ColorSpecIntTexture.Load(location3);
 	Out.Color = baseColorSpecInt.xyz;
 	Out.SpecIntensity = baseColorSpecInt.w;
-	Out.Normal = NormalTexture.Load(location3).xyz;
-	Out.Normal = normalize(Out.Normal * 2.0 - 1.0);
+	Out.Normal = DecodeGBufferNormal(NormalTexture.Load(location3).xyz);
 	Out.SpecPow = SpecPowTexture.Load(location3).x;
 
 	return Out;
@@ -213,7 +213,7 @@ float PointShadowPCF(float3 ToPixel)
 }
 
 
-float3 CalcPoint(float3 position, Material material, bool bUseShadow)
+float3 CalcPoint(float3 position, Material material)
 {
 	float3 ToLight = PointLightPos - position;
 	float3 ToEye = EyePosition - position;
@@ -231,7 +231,12 @@ float3 CalcPoint(float3 position, Material material, bool bUseShadow)
 	finalColor += pow(NDotH, material.specPow) * material.specIntensity;
 
 	// Find the shadow attenuation for the pixels world position
+	// SHADOW 0 variant, no shadow map sampling
+#if SHADOW
 	float shadowAtt = PointShadowPCF(position - PointLightPos);
+#else
+	float shadowAtt = 1.0;
+#endif
 
 	// Attenuation
 	float DistToLightNorm = 1.0 - saturate(DistToLight * PointLightRangeRcp);
@@ -242,7 +247,7 @@ float3 CalcPoint(float3 position, Material material, bool bUseShadow)
 }
 
 
-float4 PointLightCommonPS(DS_OUTPUT In, bool bUseShadow) : SV_TARGET
+float4 PS(DS_OUTPUT In) : SV_TARGET
 {
 	// Unpack the GBuffer
 	SURFACE_DATA gbd = UnpackGBuffer_Loc(In.Position.xy);
@@ -255,22 +260,12 @@ float4 PointLightCommonPS(DS_OUTPUT In, bool bUseShadow) : SV_TARGET
 	float3 position = CalcWorldPos(In.PositionXYW.xy / In.PositionXYW.z, gbd.LinearDepth);
 
 	// Calculate the light contribution
-	float3 finalColor = CalcPoint(position, mat, bUseShadow);
+	float3 finalColor = CalcPoint(position, mat);
 
 	// return the final color
 	return float4(finalColor, 1.0);
 }
 
-float4 PS(DS_OUTPUT In) : SV_TARGET
-{
-	return PointLightCommonPS(In, false);
-}
-
-float4 PointLightShadowPS(DS_OUTPUT In) : SV_TARGET
-{
-	return PointLightCommonPS(In, true);
-}
-
 
 technique11 Unlit
 {
@@ -0,0 +1,105 @@
+// GPU driven culling, cIndirectDraw
+// no effect variable, resource bind by register
+
+struct sInstance
+{
+	float4 Bound; // xyz: center, w: radius
+	row_major float4x4 World;
+};
+
+cbuffer cbCull : register(b0)
+{
+	float4 gPlanes[6]; // frustum plane, dot(plane, (p,1)) >= 0 inside
+	uint gInstanceCount;
+	uint3 gPad;
+};
+
+cbuffer cbDraw : register(b1)
+{
+	matrix gViewProj;
+	uint gInstanceIndex; // DrawSingle technique
+	uint3 gPad2;
+};
+
+StructuredBuffer<sInstance> gInstances : register(t0);
+StructuredBuffer<uint> gVisibleIndices : register(t1);
+RWStructuredBuffer<uint> gVisibleOut : register(u0);
+RWByteAddressBuffer gDrawArgs : register(u1); // DrawIndexedInstancedIndirect argument
+
+
+// sphere vs frustum, same test with cFrustumCuller
+[numthreads(64, 1, 1)]
+void CS_Cull(uint3 id : SV_DispatchThreadID)
+{
+	if (id.x >= gInstanceCount)
+		return;
+
+	const float4 bound = gInstances[id.x].Bound;
+	[unroll]
+	for (int i = 0; i < 6; ++i)
+		if ((dot(gPlanes[i].xyz, bound.xyz) + gPlanes[i].w) < -bound.w)
+			return;
+
+	// InstanceCount, byte offset 4
+	uint slot;
+	gDrawArgs.InterlockedAdd(4, 1, slot);
+	gVisibleOut[slot] = id.x;
+}
+
+
+float4 VS(float4 Pos : POSITION, uint InstanceID : SV_InstanceID) : SV_POSITION
+{
+	const uint idx = gVisibleIndices[InstanceID];
+	float4 PosW = mul(Pos, gInstances[idx].World);
+	return mul(PosW, gViewProj);
+}
+
+
+float4 VS_Single(float4 Pos : POSITION) : SV_POSITION
+{
+	float4 PosW = mul(Pos, gInstances[gInstanceIndex].World);
+	return mul(PosW, gViewProj);
+}
+
+
+float4 PS(float4 Pos : SV_POSITION) : SV_Target
+{
+	return float4(1, 1, 1, 1);
+}
+
+
+technique11 Cull
+{
+	pass P0
+	{
+		SetVertexShader(NULL);
+		SetPixelShader(NULL);
+		SetComputeShader(CompileShader(cs_5_0, CS_Cull()));
+	}
+}
+
+
+technique11 Draw
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_5_0, VS()));
+		SetGeometryShader(NULL);
+		SetHullShader(NULL);
+		SetDomainShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS()));
+	}
+}
+
+
+technique11 DrawSingle
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_5_0, VS_Single()));
+		SetGeometryShader(NULL);
+		SetHullShader(NULL);
+		SetDomainShader(NULL);
+		SetPixelShader(CompileShader(ps_5_0, PS()));
+	}
+}
@@ -0,0 +1,9 @@
+// deferred light pass, permutation root (cShaderPermutation)
+// LIGHT_TYPE select light shader, technique Unlit
+#include "permutation.fx"
+
+#if LIGHT_TYPE == LIGHT_TYPE_DIRECTIONAL
+	#include "dirlight.fx"
+#else
+	#include "hlsl.fx"
+#endif
@@ -0,0 +1,56 @@
+// shader permutation define, cShaderPermutation
+// not defined: hand compiled .fxo default
+#ifndef PERMUTATION_FX
+#define PERMUTATION_FX
+
+#define LIGHT_TYPE_DIRECTIONAL 0
+#define LIGHT_TYPE_POINT 1
+
+#define GBUFFER_LAYOUT_RGB 0 // normal xyz * 0.5 + 0.5
+#define GBUFFER_LAYOUT_OCT 1 // normal octahedral xy, R11G11B10 precision
+
+#ifndef LIGHT_TYPE
+#define LIGHT_TYPE LIGHT_TYPE_POINT
+#endif
+
+#ifndef SHADOW
+#define SHADOW 1
+#endif
+
+#ifndef INSTANCING
+#define INSTANCING 0
+#endif
+
+#ifndef GBUFFER_LAYOUT
+#define GBUFFER_LAYOUT GBUFFER_LAYOUT_RGB
+#endif
+
+
+// GBuffer normal write, 0 ~ 1
+float3 EncodeGBufferNormal(float3 n)
+{
+#if GBUFFER_LAYOUT == GBUFFER_LAYOUT_OCT
+	n /= (abs(n.x) + abs(n.y) + abs(n.z));
+	const float2 s = (n.xy >= 0.0) ? 1.0 : -1.0;
+	const float2 oct = (n.z >= 0.0) ? n.xy : ((1.0 - abs(n.yx)) * s);
+	return float3(oct * 0.5 + 0.5, 0.0);
+#else
+	return n * 0.5 + 0.5;
+#endif
+}
+
+// GBuffer normal read, EncodeGBufferNormal() inverse
+float3 DecodeGBufferNormal(float3 v)
+{
+#if GBUFFER_LAYOUT == GBUFFER_LAYOUT_OCT
+	const float2 f = v.xy * 2.0 - 1.0;
+	float3 n = float3(f, 1.0 - abs(f.x) - abs(f.y));
+	const float t = saturate(-n.z);
+	n.xy += (n.xy >= 0.0) ? -t : t;
+	return normalize(n);
+#else
+	return normalize(v * 2.0 - 1.0);
+#endif
+}
+
+#endif // PERMUTATION_FX
@@ -1,5 +1,6 @@
 
 #include "../common.fx"
+#include "vertexdecode.fx"
 
 cbuffer cbuffercbShadowMapCubeGS : register(b6)
 {
@@ -26,6 +27,13 @@ float4 VS(float4 Pos : POSITION) : SV_Position
 }
 
 
+// compressed vertex, position stream only
+float4 VS_Packed(float4 PosQ : POSITION) : SV_Position
+{
+	return mul(DecodePosition(PosQ), gWorld);
+}
+
+
 [maxvertexcount(18)]
 void GS(triangle float4 InPos[3] : SV_Position
 	, inout TriangleStream<GS_OUTPUT> OutStream)
@@ -57,3 +65,16 @@ technique11 Unlit
 		SetPixelShader(NULL);
 	}
 }
+
+
+technique11 Unlit_Packed
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_5_0, VS_Packed()));
+		SetGeometryShader(CompileShader(gs_5_0, GS()));
+		SetHullShader(NULL);
+		SetDomainShader(NULL);
+		SetPixelShader(NULL);
+	}
+}
@@ -0,0 +1,25 @@
+// compressed vertex decode, cVertexCodec
+// stream 0: position R16G16B16A16_UNORM
+// stream 1: normal R16G16_SNORM (octahedral), uv R16G16_FLOAT
+
+cbuffer cbVertexDecode : register(b9)
+{
+	float4 gPosOffset; // xyz: mesh bound min
+	float4 gPosScale; // xyz: mesh bound size
+};
+
+
+float4 DecodePosition(float4 PosQ)
+{
+	return float4(gPosOffset.xyz + PosQ.xyz * gPosScale.xyz, 1);
+}
+
+
+// octahedral, [-1,1]^2 -> unit vector
+float3 DecodeOctNormal(float2 Oct)
+{
+	float3 n = float3(Oct.xy, 1.0 - abs(Oct.x) - abs(Oct.y));
+	const float t = saturate(-n.z);
+	n.xy += (n.xy >= 0.0) ? -t : t;
+	return normalize(n);
+}
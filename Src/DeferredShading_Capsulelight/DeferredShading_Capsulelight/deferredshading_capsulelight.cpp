@@ -9,7 +9,9 @@
 using namespace common;
 #include "../../../../../Common/Graphic11/graphic11.h"
 #include "../../../../../Common/Framework11/framework11.h"
+#include "../../Shared/benchmarkrunner.h"
 #include "gbuffer.h"
+#include "structuredbuffer.h"
 
 using namespace graphic;
 
@@ -20,16 +22,17 @@ struct sCbDirightPS
 	XMVECTOR AmbientRange;
 };
 
-struct sCbCapsuleLight
+// hlsl.fx, StructuredBuffer<CapsuleLightData> CapsuleLights : register(t8)
+struct sCapsuleLightData
 {
-	XMVECTOR CapsuleLightPos;
-	XMVECTOR CapsuleLightRangeRcp;
-	XMVECTOR CapsuleLightDir;
-	XMVECTOR CapsuleLightLen;
-	XMVECTOR CapsuleColor;
-
-	XMVECTOR HalfSegmentLen;
-	XMVECTOR CapsuleRange;
+	XMFLOAT3 CapsuleLightPos;
+	float CapsuleLightRangeRcp;
+	XMFLOAT3 CapsuleLightDir;
+	float CapsuleLightLen;
+	XMFLOAT3 CapsuleColor;
+	float HalfSegmentLen;
+	float CapsuleRange;
+	float Pad[3];
 	XMMATRIX LightProjection;
 };
 
@@ -55,18 +58,19 @@ public:
 
 protected:
 	void RenderDirectionalLight();
-	void RenderCapsuleLight(const int lightIdx);
+	void RenderCapsuleLights();
 
 
 public:
 	cCamera3D m_camera;
+	cBenchmarkRunner m_benchmark;
 	cGridLine m_ground;
 	cModel m_model[64];
 	cImGui m_gui;
 	cGBuffer m_gbuff;
 
 	cConstantBuffer<sCbDirightPS> m_cbDirLight;
-	cConstantBuffer<sCbCapsuleLight> m_cbCapsuleLight;
+	cStructuredBuffer m_capsuleLights;
 	Vector3 m_ambientDown;
 	Vector3 m_ambientUp;
 	ID3D11RasterizerState* m_pNoDepthClipFrontRS;
@@ -146,7 +150,7 @@ bool cViewer::OnInit()
 	m_gui.Init(m_hWnd, m_renderer.GetDevice(), m_renderer.GetDevContext(), NULL);
 
 	m_cbDirLight.Create(m_renderer);
-	m_cbCapsuleLight.Create(m_renderer);
+	m_capsuleLights.Create(m_renderer, sizeof(sCapsuleLightData), ARRAYSIZE(m_capsuleLightPos));
 
 	GetMainLight().Init(cLight::LIGHT_DIRECTIONAL,
 		Vector4(0.f, 0.f, 0.f, 1), Vector4(0.f, 0.f, 0.f, 1),
@@ -230,6 +234,14 @@ bool cViewer::OnInit()
 	if (FAILED(m_renderer.GetDevice()->CreateBlendState(&descBlend, &m_pAdditiveBlendState)))
 		return false;
 
+	// benchmark mode, scripted camera orbit, no input
+	if (m_benchmark.Init(GetCommandLineA(), "DeferredShading_Capsulelight"))
+	{
+		m_isAnimate = true;
+		const float center[3] = { 0, 0, 0 };
+		m_benchmark.AddOrbit(center, 10.f, 6.f, 10.f);
+	}
+
 	return true;
 }
 
@@ -251,6 +263,16 @@ void cViewer::OnRender(const float deltaSeconds)
 {
 	cAutoCam cam(&m_camera);
 
+	// benchmark mode, fixed delta time
+	const float dt = m_benchmark.m_isRun ? m_benchmark.GetDeltaSeconds() : deltaSeconds;
+	if (m_benchmark.m_isRun)
+	{
+		float eyePos[3], lookAt[3];
+		m_benchmark.GetCamera(eyePos, lookAt);
+		m_camera.SetCamera(Vector3(eyePos[0], eyePos[1], eyePos[2])
+			, Vector3(lookAt[0], lookAt[1], lookAt[2]), Vector3(0, 1, 0));
+	}
+
 	m_gui.NewFrame();
 
 	if (ImGui::Begin("Information", NULL, ImVec2(300, 600)))
@@ -287,7 +309,7 @@ void cViewer::OnRender(const float deltaSeconds)
 	{
 		GetMainCamera().Bind(m_renderer);
 
-		const float angle = deltaSeconds * 1.f * (m_isAnimate ? 1.0f : 0.f);
+		const float angle = dt * 1.f * (m_isAnimate ? 1.0f : 0.f);
 		Matrix44 tm;
 		tm.SetRotationY(angle);
 
@@ -345,8 +367,7 @@ void cViewer::OnRender(const float deltaSeconds)
 		devContext->OMGetBlendState(&pPrevBlendState, prevBlendFactor, &prevSampleMask);
 		devContext->OMSetBlendState(m_pAdditiveBlendState, prevBlendFactor, prevSampleMask);
 		
-		for (int i = 0; i < 4; ++i)
-			RenderCapsuleLight(i);
+		RenderCapsuleLights();
 
 		devContext->OMSetBlendState(pPrevBlendState, prevBlendFactor, prevSampleMask);
 		SAFE_RELEASE(pPrevBlendState);
@@ -365,6 +386,13 @@ void cViewer::OnRender(const float deltaSeconds)
 	m_gui.Render();
 	m_renderer.RenderFPS();
 	m_renderer.Present();
+
+	if (m_benchmark.m_isRun)
+	{
+		m_benchmark.EndFrame();
+		if (!m_benchmark.m_isRun) // finish, json written
+			PostMessage(m_hWnd, WM_CLOSE, 0, 0);
+	}
 }
 
 
@@ -411,14 +439,14 @@ void cViewer::RenderDirectionalLight()
 }
 
 
-void cViewer::RenderCapsuleLight(const int lightIdx)
+// render all capsule light volume with one instanced draw
+// light records packed to structured buffer with one Map/Unmap
+void cViewer::RenderCapsuleLights()
 {
 	const float lightRange = m_pointLightRange;
 	const float lightLen = 2.f;
-	const Vector3 lightPos = m_capsuleLightPos[lightIdx];
-	const Vector3 lightDir = m_capsuleLightDir[lightIdx];
 	const Vector3 lightScale(lightRange, lightRange, lightRange);
-	const Vector3 lightColor = m_pointLightColor[lightIdx];
+	const UINT lightCount = ARRAYSIZE(m_capsuleLightPos);
 
 	ID3D11DeviceContext *devContext = m_renderer.GetDevContext();
 	cShader11 *hlslShader = m_renderer.m_shaderMgr.LoadShader(m_renderer, g_hlslPath, 0, false);
@@ -445,32 +473,47 @@ void cViewer::RenderCapsuleLight(const int lightIdx)
 	m_cbDirLight.Update(m_renderer, 6);
 	m_gbuff.m_cbGBuffer.Update(m_renderer, 7);
 
-	m_cbCapsuleLight.m_v->CapsuleLightPos = lightPos.GetVectorXM();
-	m_cbCapsuleLight.m_v->CapsuleLightDir = lightDir.GetVectorXM();
-	m_cbCapsuleLight.m_v->CapsuleLightRangeRcp = (Vector3(1, 1, 1) / lightRange).GetVectorXM();
-	m_cbCapsuleLight.m_v->CapsuleLightLen = (Vector3(1, 1, 1)*lightLen).GetVectorXM();
-	m_cbCapsuleLight.m_v->CapsuleColor = GammaToLinear(lightColor).GetVectorXM();
-	m_cbCapsuleLight.m_v->HalfSegmentLen = (Vector3(1, 1, 1) * (lightLen * 0.5f)).GetVectorXM();
-	m_cbCapsuleLight.m_v->CapsuleRange = (Vector3(1, 1, 1) * lightRange).GetVectorXM();
-
-	Matrix44 lightProj;
-	Transform lightTfm;
-	lightTfm.scale = lightScale;
-	lightTfm.pos = lightPos;
-	lightTfm.rot.SetRotationArc(Vector3(0,0,1), lightDir);
-	lightProj = lightTfm.GetMatrix() * GetMainCamera().GetViewProjectionMatrix();
-	m_cbCapsuleLight.m_v->LightProjection = XMMatrixTranspose(lightProj.GetMatrixXM());
-	m_cbCapsuleLight.Update(m_renderer, 8);
+	if (sCapsuleLightData *lights = (sCapsuleLightData*)m_capsuleLights.Lock(m_renderer))
+	{
+		const Matrix44 viewProj = GetMainCamera().GetViewProjectionMatrix();
+		for (UINT i = 0; i < lightCount; ++i)
+		{
+			const Vector3 lightPos = m_capsuleLightPos[i];
+			const Vector3 lightDir = m_capsuleLightDir[i];
+			const Vector3 lightColor = GammaToLinear(m_pointLightColor[i]);
+
+			sCapsuleLightData &light = lights[i];
+			light.CapsuleLightPos = XMFLOAT3(lightPos.x, lightPos.y, lightPos.z);
+			light.CapsuleLightRangeRcp = 1.f / lightRange;
+			light.CapsuleLightDir = XMFLOAT3(lightDir.x, lightDir.y, lightDir.z);
+			light.CapsuleLightLen = lightLen;
+			light.CapsuleColor = XMFLOAT3(lightColor.x, lightColor.y, lightColor.z);
+			light.HalfSegmentLen = lightLen * 0.5f;
+			light.CapsuleRange = lightRange;
+			light.Pad[0] = light.Pad[1] = light.Pad[2] = 0.f;
+
+			Transform lightTfm;
+			lightTfm.scale = lightScale;
+			lightTfm.pos = lightPos;
+			lightTfm.rot.SetRotationArc(Vector3(0, 0, 1), lightDir);
+			const Matrix44 lightProj = lightTfm.GetMatrix() * viewProj;
+			light.LightProjection = XMMatrixTranspose(lightProj.GetMatrixXM());
+		}
+		m_capsuleLights.Unlock(m_renderer);
+		m_capsuleLights.Bind(m_renderer, 8);
 
-	devContext->IASetInputLayout(NULL);
-	devContext->IASetVertexBuffers(0, 0, NULL, NULL, NULL);
-	devContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_1_CONTROL_POINT_PATCHLIST);
+		devContext->IASetInputLayout(NULL);
+		devContext->IASetVertexBuffers(0, 0, NULL, NULL, NULL);
+		devContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_1_CONTROL_POINT_PATCHLIST);
 
-	devContext->Draw(2, 0);
+		// 2 capsule half patch per light, light index = SV_InstanceID
+		devContext->DrawInstanced(2, lightCount, 0, 0);
+	}
 
 	devContext->RSSetState(pPrevRSState);
 	SAFE_RELEASE(pPrevRSState);
 
+	m_capsuleLights.Unbind(m_renderer, 8);
 	ID3D11ShaderResourceView *arrRV[1] = { NULL };
 	devContext->PSSetShaderResources(4, 1, arrRV);
 	ZeroMemory(arrViews, sizeof(arrViews));
@@ -527,6 +570,9 @@ void cViewer::UpdateLookAt()
 
 void cViewer::OnMessageProc(UINT message, WPARAM wParam, LPARAM lParam)
 {
+	if (m_benchmark.m_isRun) // scripted camera, ignore input
+		return;
+
 	m_gui.WndProcHandler(m_hWnd, message, wParam, lParam);
 	if (ImGui::IsAnyItemHovered())
 	{
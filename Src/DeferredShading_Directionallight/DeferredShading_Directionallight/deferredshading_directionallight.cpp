@@ -9,6 +9,7 @@
 using namespace common;
 #include "../../../../../Common/Graphic11/graphic11.h"
 #include "../../../../../Common/Framework11/framework11.h"
+#include "../../Shared/benchmarkrunner.h"
 #include "gbuffer.h"
 
 using namespace graphic;
@@ -42,6 +43,7 @@ public:
 
 public:
 	cCamera3D m_camera;
+	cBenchmarkRunner m_benchmark;
 	cGridLine m_ground;
 	cModel m_model[64];
 	cImGui m_gui;
@@ -153,6 +155,14 @@ bool cViewer::OnInit()
 	if (FAILED(m_renderer.GetDevice()->CreateDepthStencilState(&descDepth, &m_pNoDepthWriteLessStencilMaskState)))
 		return false;
 
+	// benchmark mode, scripted camera orbit, no input
+	if (m_benchmark.Init(GetCommandLineA(), "DeferredShading_Directionallight"))
+	{
+		m_isAnimate = true;
+		const float center[3] = { 0, 0, 0 };
+		m_benchmark.AddOrbit(center, 10.f, 6.f, 10.f);
+	}
+
 	return true;
 }
 
@@ -174,6 +184,16 @@ void cViewer::OnRender(const float deltaSeconds)
 {
 	cAutoCam cam(&m_camera);
 
+	// benchmark mode, fixed delta time
+	const float dt = m_benchmark.m_isRun ? m_benchmark.GetDeltaSeconds() : deltaSeconds;
+	if (m_benchmark.m_isRun)
+	{
+		float eyePos[3], lookAt[3];
+		m_benchmark.GetCamera(eyePos, lookAt);
+		m_camera.SetCamera(Vector3(eyePos[0], eyePos[1], eyePos[2])
+			, Vector3(lookAt[0], lookAt[1], lookAt[2]), Vector3(0, 1, 0));
+	}
+
 	m_gui.NewFrame();
 
 	if (ImGui::Begin("Information", NULL, ImVec2(300, 500)))
@@ -204,7 +224,7 @@ void cViewer::OnRender(const float deltaSeconds)
 	{
 		GetMainCamera().Bind(m_renderer);
 
-		const float angle = deltaSeconds * 1.f * (m_isAnimate ? 1.0f : 0.f);
+		const float angle = dt * 1.f * (m_isAnimate ? 1.0f : 0.f);
 		Matrix44 tm;
 		tm.SetRotationY(angle);
 		const Vector3 lightPos = m_lightPos * tm;
@@ -298,6 +318,13 @@ void cViewer::OnRender(const float deltaSeconds)
 	m_gui.Render();
 	m_renderer.RenderFPS();
 	m_renderer.Present();
+
+	if (m_benchmark.m_isRun)
+	{
+		m_benchmark.EndFrame();
+		if (!m_benchmark.m_isRun) // finish, json written
+			PostMessage(m_hWnd, WM_CLOSE, 0, 0);
+	}
 }
 
 
@@ -349,6 +376,9 @@ void cViewer::UpdateLookAt()
 
 void cViewer::OnMessageProc(UINT message, WPARAM wParam, LPARAM lParam)
 {
+	if (m_benchmark.m_isRun) // scripted camera, ignore input
+		return;
+
 	m_gui.WndProcHandler(m_hWnd, message, wParam, lParam);
 	if (ImGui::IsAnyItemHovered())
 	{
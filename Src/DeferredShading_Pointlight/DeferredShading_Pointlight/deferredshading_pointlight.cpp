@@ -9,7 +9,9 @@
 using namespace common;
 #include "../../../../../Common/Graphic11/graphic11.h"
 #include "../../../../../Common/Framework11/framework11.h"
+#include "../../Shared/benchmarkrunner.h"
 #include "gbuffer.h"
+#include "structuredbuffer.h"
 
 using namespace graphic;
 
@@ -20,12 +22,13 @@ struct sCbDirightPS
 	XMVECTOR AmbientRange;
 };
 
-struct sCbPointLight
+// hlsl.fx, StructuredBuffer<PointLightData> PointLights : register(t8)
+struct sPointLightData
 {
-	XMVECTOR PointLightPos;
-	XMVECTOR PointLightRangeRcp;
-	XMVECTOR PointColor;
-	XMVECTOR LightPerspectiveValues;
+	XMFLOAT3 PointLightPos;
+	float PointLightRangeRcp;
+	XMFLOAT3 PointColor;
+	float Pad;
 	XMMATRIX LightProjection;
 };
 
@@ -52,18 +55,19 @@ public:
 
 protected:
 	void RenderDirectionalLight();
-	void RenderPointLight(const int lightIdx);
+	void RenderPointLights();
 
 
 public:
 	cCamera3D m_camera;
+	cBenchmarkRunner m_benchmark;
 	cGridLine m_ground;
 	cModel m_model[64];
 	cImGui m_gui;
 	cGBuffer m_gbuff;
 
 	cConstantBuffer<sCbDirightPS> m_cbDirLight;
-	cConstantBuffer<sCbPointLight> m_cbPointLight;	
+	cStructuredBuffer m_pointLights;
 	Vector3 m_ambientDown;
 	Vector3 m_ambientUp;
 	ID3D11RasterizerState* m_pNoDepthClipFrontRS;
@@ -142,7 +146,7 @@ bool cViewer::OnInit()
 	m_gui.Init(m_hWnd, m_renderer.GetDevice(), m_renderer.GetDevContext(), NULL);
 
 	m_cbDirLight.Create(m_renderer);
-	m_cbPointLight.Create(m_renderer);
+	m_pointLights.Create(m_renderer, sizeof(sPointLightData), ARRAYSIZE(m_pointLightPos));
 
 	GetMainLight().Init(cLight::LIGHT_DIRECTIONAL,
 		Vector4(0.f, 0.f, 0.f, 1), Vector4(0.f, 0.f, 0.f, 1),
@@ -226,6 +230,14 @@ bool cViewer::OnInit()
 	if (FAILED(m_renderer.GetDevice()->CreateBlendState(&descBlend, &m_pAdditiveBlendState)))
 		return false;
 
+	// benchmark mode, scripted camera orbit, no input
+	if (m_benchmark.Init(GetCommandLineA(), "DeferredShading_Pointlight"))
+	{
+		m_isAnimate = true;
+		const float center[3] = { 0, 0, 0 };
+		m_benchmark.AddOrbit(center, 10.f, 6.f, 10.f);
+	}
+
 	return true;
 }
 
@@ -247,6 +259,16 @@ void cViewer::OnRender(const float deltaSeconds)
 {
 	cAutoCam cam(&m_camera);
 
+	// benchmark mode, fixed delta time
+	const float dt = m_benchmark.m_isRun ? m_benchmark.GetDeltaSeconds() : deltaSeconds;
+	if (m_benchmark.m_isRun)
+	{
+		float eyePos[3], lookAt[3];
+		m_benchmark.GetCamera(eyePos, lookAt);
+		m_camera.SetCamera(Vector3(eyePos[0], eyePos[1], eyePos[2])
+			, Vector3(lookAt[0], lookAt[1], lookAt[2]), Vector3(0, 1, 0));
+	}
+
 	m_gui.NewFrame();
 
 	if (ImGui::Begin("Information", NULL, ImVec2(300, 600)))
@@ -283,7 +305,7 @@ void cViewer::OnRender(const float deltaSeconds)
 	{
 		GetMainCamera().Bind(m_renderer);
 
-		const float angle = deltaSeconds * 1.f * (m_isAnimate ? 1.0f : 0.f);
+		const float angle = dt * 1.f * (m_isAnimate ? 1.0f : 0.f);
 		Matrix44 tm;
 		tm.SetRotationY(angle);
 
@@ -342,8 +364,7 @@ void cViewer::OnRender(const float deltaSeconds)
 		devContext->OMGetBlendState(&pPrevBlendState, prevBlendFactor, &prevSampleMask);
 		devContext->OMSetBlendState(m_pAdditiveBlendState, prevBlendFactor, prevSampleMask);
 
-		for (int i=0; i < 4; ++i)
-			RenderPointLight(i);
+		RenderPointLights();
 		//devContext->OMSetBlendState(state.NonPremultiplied(), factor, 0xffffffff);
 
 		devContext->OMSetBlendState(pPrevBlendState, prevBlendFactor, prevSampleMask);
@@ -363,6 +384,13 @@ void cViewer::OnRender(const float deltaSeconds)
 	m_gui.Render();
 	m_renderer.RenderFPS();
 	m_renderer.Present();
+
+	if (m_benchmark.m_isRun)
+	{
+		m_benchmark.EndFrame();
+		if (!m_benchmark.m_isRun) // finish, json written
+			PostMessage(m_hWnd, WM_CLOSE, 0, 0);
+	}
 }
 
 
@@ -409,12 +437,13 @@ void cViewer::RenderDirectionalLight()
 }
 
 
-void cViewer::RenderPointLight(const int lightIdx)
+// render all point light volume with one instanced draw
+// light records packed to structured buffer with one Map/Unmap
+void cViewer::RenderPointLights()
 {
 	const float lightRange = m_pointLightRange;
-	const Vector3 lightPos = m_pointLightPos[lightIdx];
 	const Vector3 lightScale(lightRange, lightRange, lightRange);
-	const Vector3 lightColor = m_pointLightColor[lightIdx];
+	const UINT lightCount = ARRAYSIZE(m_pointLightPos);
 
 	ID3D11DeviceContext *devContext = m_renderer.GetDevContext();
 	cShader11 *hlslShader = m_renderer.m_shaderMgr.LoadShader(m_renderer, g_hlslPath, 0, false);
@@ -441,29 +470,42 @@ void cViewer::RenderPointLight(const int lightIdx)
 	m_cbDirLight.Update(m_renderer, 6);
 	m_gbuff.m_cbGBuffer.Update(m_renderer, 7);
 
-	m_cbPointLight.m_v->PointLightPos = lightPos.GetVectorXM();
-	m_cbPointLight.m_v->PointLightRangeRcp = (Vector3(1, 1, 1) / lightRange).GetVectorXM();
-	m_cbPointLight.m_v->PointColor = GammaToLinear(lightColor).GetVectorXM();
-	m_cbPointLight.m_v->LightPerspectiveValues = Vector3(0, 0, 0).GetVectorXM();
+	if (sPointLightData *lights = (sPointLightData*)m_pointLights.Lock(m_renderer))
+	{
+		const Matrix44 viewProj = GetMainCamera().GetViewProjectionMatrix();
+		for (UINT i = 0; i < lightCount; ++i)
+		{
+			const Vector3 lightPos = m_pointLightPos[i];
+			const Vector3 lightColor = GammaToLinear(m_pointLightColor[i]);
+
+			sPointLightData &light = lights[i];
+			light.PointLightPos = XMFLOAT3(lightPos.x, lightPos.y, lightPos.z);
+			light.PointLightRangeRcp = 1.f / lightRange;
+			light.PointColor = XMFLOAT3(lightColor.x, lightColor.y, lightColor.z);
+			light.Pad = 0.f;
+
+			Matrix44 S;
+			S.SetScale(lightScale);
+			Matrix44 T;
+			T.SetTranslate(lightPos);
+			const Matrix44 lightProj = S * T * viewProj;
+			light.LightProjection = XMMatrixTranspose(lightProj.GetMatrixXM());
+		}
+		m_pointLights.Unlock(m_renderer);
+		m_pointLights.Bind(m_renderer, 8);
 
-	Matrix44 lightProj;
-	Matrix44 S;
-	S.SetScale(lightScale);
-	Matrix44 T;
-	T.SetTranslate(lightPos);
-	lightProj = S * T * GetMainCamera().GetViewProjectionMatrix();
-	m_cbPointLight.m_v->LightProjection = XMMatrixTranspose(lightProj.GetMatrixXM());
-	m_cbPointLight.Update(m_renderer, 8);
+		devContext->IASetInputLayout(NULL);
+		devContext->IASetVertexBuffers(0, 0, NULL, NULL, NULL);
+		devContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_1_CONTROL_POINT_PATCHLIST);
 
-	devContext->IASetInputLayout(NULL);
-	devContext->IASetVertexBuffers(0, 0, NULL, NULL, NULL);
-	devContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_1_CONTROL_POINT_PATCHLIST);
-
-	devContext->Draw(2, 0);
+		// 2 hemisphere patch per light, light index = SV_InstanceID
+		devContext->DrawInstanced(2, lightCount, 0, 0);
+	}
 
 	devContext->RSSetState(pPrevRSState);
 	SAFE_RELEASE(pPrevRSState);
 
+	m_pointLights.Unbind(m_renderer, 8);
 	ID3D11ShaderResourceView *arrRV[1] = { NULL };
 	devContext->PSSetShaderResources(4, 1, arrRV);
 	ZeroMemory(arrViews, sizeof(arrViews));
@@ -520,6 +562,9 @@ void cViewer::UpdateLookAt()
 
 void cViewer::OnMessageProc(UINT message, WPARAM wParam, LPARAM lParam)
 {
+	if (m_benchmark.m_isRun) // scripted camera, ignore input
+		return;
+
 	m_gui.WndProcHandler(m_hWnd, message, wParam, lParam);
 	if (ImGui::IsAnyItemHovered())
 	{
@@ -0,0 +1,33 @@
+//
+// 2018-05-02, jjuiddong
+// Dynamic StructuredBuffer
+// - CPU write once per frame (Map/Unmap), Shader Read (DS, PS)
+//
+#pragma once
+
+
+namespace graphic
+{
+
+	class cStructuredBuffer
+	{
+	public:
+		cStructuredBuffer();
+		virtual ~cStructuredBuffer();
+
+		bool Create(cRenderer &renderer, const UINT stride, const UINT count);
+		void* Lock(cRenderer &renderer);
+		void Unlock(cRenderer &renderer);
+		void Bind(cRenderer &renderer, const int stage = 0);
+		void Unbind(cRenderer &renderer, const int stage = 0);
+		void Clear();
+
+
+	public:
+		UINT m_stride;
+		UINT m_count;
+		ID3D11Buffer *m_buff;
+		ID3D11ShaderResourceView *m_srv;
+	};
+
+}
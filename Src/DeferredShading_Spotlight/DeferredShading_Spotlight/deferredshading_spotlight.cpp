@@ -9,7 +9,9 @@
 using namespace common;
 #include "../../../../../Common/Graphic11/graphic11.h"
 #include "../../../../../Common/Framework11/framework11.h"
+#include "../../Shared/benchmarkrunner.h"
 #include "gbuffer.h"
+#include "structuredbuffer.h"
 
 using namespace graphic;
 
@@ -20,18 +22,19 @@ struct sCbDirightPS
 	XMVECTOR AmbientRange;
 };
 
-struct sCbSpotLight
+// hlsl.fx, StructuredBuffer<SpotLightData> SpotLights : register(t8)
+struct sSpotLightData
 {
-	XMVECTOR SpotLightPos;
-	XMVECTOR SpotLightRangeRcp;
-	XMVECTOR SpotDirToLight;
-	XMVECTOR SpotCosOuterCone;
-	XMVECTOR SpotColor;
-	XMVECTOR SpotCosConeAttRange;
-
+	XMFLOAT3 SpotLightPos;
+	float SpotLightRangeRcp;
+	XMFLOAT3 SpotDirToLight;
+	float SpotCosOuterCone;
+	XMFLOAT3 SpotColor;
+	float SpotCosConeAttRange;
+	float SinAngle;
+	float CosAngle;
+	float Pad[2];
 	XMMATRIX LightProjection;
-	XMVECTOR SinAngle;
-	XMVECTOR CosAngle;
 };
 
 
@@ -56,18 +59,19 @@ public:
 
 protected:
 	void RenderDirectionalLight();
-	void RenderSpotLight(const int lightIdx);
+	void RenderSpotLights();
 
 
 public:
 	cCamera3D m_camera;
+	cBenchmarkRunner m_benchmark;
 	cGridLine m_ground;
 	cModel m_model[64];
 	cImGui m_gui;
 	cGBuffer m_gbuff;
 
 	cConstantBuffer<sCbDirightPS> m_cbDirLight;
-	cConstantBuffer<sCbSpotLight> m_cbSpotLight;
+	cStructuredBuffer m_spotLights;
 	Vector3 m_ambientDown;
 	Vector3 m_ambientUp;
 	ID3D11RasterizerState* m_pNoDepthClipFrontRS;
@@ -142,7 +146,7 @@ bool cViewer::OnInit()
 	m_gui.Init(m_hWnd, m_renderer.GetDevice(), m_renderer.GetDevContext(), NULL);
 
 	m_cbDirLight.Create(m_renderer);
-	m_cbSpotLight.Create(m_renderer);
+	m_spotLights.Create(m_renderer, sizeof(sSpotLightData), ARRAYSIZE(m_SpotLightPos));
 
 	GetMainLight().Init(cLight::LIGHT_DIRECTIONAL,
 		Vector4(0.f, 0.f, 0.f, 1), Vector4(0.f, 0.f, 0.f, 1),
@@ -229,6 +233,14 @@ bool cViewer::OnInit()
 	if (FAILED(m_renderer.GetDevice()->CreateBlendState(&descBlend, &m_pAdditiveBlendState)))
 		return false;
 
+	// benchmark mode, scripted camera orbit, no input
+	if (m_benchmark.Init(GetCommandLineA(), "DeferredShading_Spotlight"))
+	{
+		m_isAnimate = true;
+		const float center[3] = { 0, 0, 0 };
+		m_benchmark.AddOrbit(center, 10.f, 6.f, 10.f);
+	}
+
 	return true;
 }
 
@@ -250,6 +262,16 @@ void cViewer::OnRender(const float deltaSeconds)
 {
 	cAutoCam cam(&m_camera);
 
+	// benchmark mode, fixed delta time
+	const float dt = m_benchmark.m_isRun ? m_benchmark.GetDeltaSeconds() : deltaSeconds;
+	if (m_benchmark.m_isRun)
+	{
+		float eyePos[3], lookAt[3];
+		m_benchmark.GetCamera(eyePos, lookAt);
+		m_camera.SetCamera(Vector3(eyePos[0], eyePos[1], eyePos[2])
+			, Vector3(lookAt[0], lookAt[1], lookAt[2]), Vector3(0, 1, 0));
+	}
+
 	m_gui.NewFrame();
 
 	if (ImGui::Begin("Information", NULL, ImVec2(300, 600)))
@@ -286,7 +308,7 @@ void cViewer::OnRender(const float deltaSeconds)
 	{
 		GetMainCamera().Bind(m_renderer);
 
-		const float angle = deltaSeconds * 1.f * (m_isAnimate ? 1.0f : 0.f);
+		const float angle = dt * 1.f * (m_isAnimate ? 1.0f : 0.f);
 		Matrix44 tm;
 		tm.SetRotationY(angle);
 
@@ -340,8 +362,7 @@ void cViewer::OnRender(const float deltaSeconds)
 		devContext->OMGetBlendState(&pPrevBlendState, prevBlendFactor, &prevSampleMask);
 		devContext->OMSetBlendState(m_pAdditiveBlendState, prevBlendFactor, prevSampleMask);
 
-		for (int i = 0; i < 4; ++i)
-			RenderSpotLight(i);
+		RenderSpotLights();
 
 		devContext->OMSetBlendState(pPrevBlendState, prevBlendFactor, prevSampleMask);
 		SAFE_RELEASE(pPrevBlendState);
@@ -360,6 +381,13 @@ void cViewer::OnRender(const float deltaSeconds)
 	m_gui.Render();
 	m_renderer.RenderFPS();
 	m_renderer.Present();
+
+	if (m_benchmark.m_isRun)
+	{
+		m_benchmark.EndFrame();
+		if (!m_benchmark.m_isRun) // finish, json written
+			PostMessage(m_hWnd, WM_CLOSE, 0, 0);
+	}
 }
 
 
@@ -406,17 +434,17 @@ void cViewer::RenderDirectionalLight()
 }
 
 
-void cViewer::RenderSpotLight(const int lightIdx)
+// render all spot light volume with one instanced draw
+// light records packed to structured buffer with one Map/Unmap
+void cViewer::RenderSpotLights()
 {
 	const float fCosInnerAngle = cosf(m_innerAngle);
 	const float fSinOuterAngle = sinf(m_outerAngle);
 	const float fCosOuterAngle = cosf(m_outerAngle);
 
 	const float lightRange = m_spotLightRange;
-	const Vector3 lightPos = m_SpotLightPos[lightIdx];
-	const Vector3 lightDir = m_SpotLightDir[lightIdx];
 	const Vector3 lightScale(lightRange, lightRange, lightRange);
-	const Vector3 lightColor = m_pointLightColor[lightIdx];
+	const UINT lightCount = ARRAYSIZE(m_SpotLightPos);
 
 	ID3D11DeviceContext *devContext = m_renderer.GetDevContext();
 	cShader11 *hlslShader = m_renderer.m_shaderMgr.LoadShader(m_renderer, g_hlslPath, 0, false);
@@ -443,34 +471,48 @@ void cViewer::RenderSpotLight(const int lightIdx)
 	m_cbDirLight.Update(m_renderer, 6);
 	m_gbuff.m_cbGBuffer.Update(m_renderer, 7);
 
-	m_cbSpotLight.m_v->SpotLightPos = lightPos.GetVectorXM();
-	m_cbSpotLight.m_v->SpotDirToLight = -lightDir.GetVectorXM();
-	m_cbSpotLight.m_v->SpotLightRangeRcp = (Vector3(1, 1, 1) * (1.f/lightRange)).GetVectorXM();
-	m_cbSpotLight.m_v->SpotColor = GammaToLinear(lightColor).GetVectorXM();
-	m_cbSpotLight.m_v->SpotCosOuterCone = (Vector3(1, 1, 1) * fCosOuterAngle).GetVectorXM();
-	m_cbSpotLight.m_v->SpotCosConeAttRange = (Vector3(1, 1, 1) * (fCosInnerAngle - fCosOuterAngle)).GetVectorXM();
-
-	m_cbSpotLight.m_v->CosAngle = (Vector3(1, 1, 1) * fCosOuterAngle).GetVectorXM();
-	m_cbSpotLight.m_v->SinAngle = (Vector3(1, 1, 1) * fSinOuterAngle).GetVectorXM();
-
-	Matrix44 lightProj;
-	Transform lightTfm;
-	lightTfm.scale = lightScale;
-	lightTfm.pos = lightPos;
-	lightTfm.rot.SetRotationArc(Vector3(0, 0, 1), lightDir);
-	lightProj = lightTfm.GetMatrix() * GetMainCamera().GetViewProjectionMatrix();
-	m_cbSpotLight.m_v->LightProjection = XMMatrixTranspose(lightProj.GetMatrixXM());
-	m_cbSpotLight.Update(m_renderer, 8);
+	if (sSpotLightData *lights = (sSpotLightData*)m_spotLights.Lock(m_renderer))
+	{
+		const Matrix44 viewProj = GetMainCamera().GetViewProjectionMatrix();
+		for (UINT i = 0; i < lightCount; ++i)
+		{
+			const Vector3 lightPos = m_SpotLightPos[i];
+			const Vector3 lightDir = m_SpotLightDir[i];
+			const Vector3 lightColor = GammaToLinear(m_pointLightColor[i]);
+
+			sSpotLightData &light = lights[i];
+			light.SpotLightPos = XMFLOAT3(lightPos.x, lightPos.y, lightPos.z);
+			light.SpotLightRangeRcp = 1.f / lightRange;
+			light.SpotDirToLight = XMFLOAT3(-lightDir.x, -lightDir.y, -lightDir.z);
+			light.SpotCosOuterCone = fCosOuterAngle;
+			light.SpotColor = XMFLOAT3(lightColor.x, lightColor.y, lightColor.z);
+			light.SpotCosConeAttRange = fCosInnerAngle - fCosOuterAngle;
+			light.SinAngle = fSinOuterAngle;
+			light.CosAngle = fCosOuterAngle;
+			light.Pad[0] = light.Pad[1] = 0.f;
+
+			Transform lightTfm;
+			lightTfm.scale = lightScale;
+			lightTfm.pos = lightPos;
+			lightTfm.rot.SetRotationArc(Vector3(0, 0, 1), lightDir);
+			const Matrix44 lightProj = lightTfm.GetMatrix() * viewProj;
+			light.LightProjection = XMMatrixTranspose(lightProj.GetMatrixXM());
+		}
+		m_spotLights.Unlock(m_renderer);
+		m_spotLights.Bind(m_renderer, 8);
 
-	devContext->IASetInputLayout(NULL);
-	devContext->IASetVertexBuffers(0, 0, NULL, NULL, NULL);
-	devContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_1_CONTROL_POINT_PATCHLIST);
+		devContext->IASetInputLayout(NULL);
+		devContext->IASetVertexBuffers(0, 0, NULL, NULL, NULL);
+		devContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_1_CONTROL_POINT_PATCHLIST);
 
-	devContext->Draw(1, 0);
+		// 1 cone patch per light, light index = SV_InstanceID
+		devContext->DrawInstanced(1, lightCount, 0, 0);
+	}
 
 	devContext->RSSetState(pPrevRSState);
 	SAFE_RELEASE(pPrevRSState);
 
+	m_spotLights.Unbind(m_renderer, 8);
 	ID3D11ShaderResourceView *arrRV[1] = { NULL };
 	devContext->PSSetShaderResources(4, 1, arrRV);
 	ZeroMemory(arrViews, sizeof(arrViews));
@@ -527,6 +569,9 @@ void cViewer::UpdateLookAt()
 
 void cViewer::OnMessageProc(UINT message, WPARAM wParam, LPARAM lParam)
 {
+	if (m_benchmark.m_isRun) // scripted camera, ignore input
+		return;
+
 	m_gui.WndProcHandler(m_hWnd, message, wParam, lParam);
 	if (ImGui::IsAnyItemHovered())
 	{
@@ -0,0 +1,106 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "structuredbuffer.h"
+
+using namespace graphic;
+
+
+cStructuredBuffer::cStructuredBuffer()
+	: m_stride(0)
+	, m_count(0)
+	, m_buff(NULL)
+	, m_srv(NULL)
+{
+}
+
+cStructuredBuffer::~cStructuredBuffer()
+{
+	Clear();
+}
+
+
+bool cStructuredBuffer::Create(cRenderer &renderer, const UINT stride, const UINT count)
+{
+	Clear();
+
+	m_stride = stride;
+	m_count = count;
+
+	D3D11_BUFFER_DESC bd;
+	ZeroMemory(&bd, sizeof(bd));
+	bd.ByteWidth = stride * count;
+	bd.Usage = D3D11_USAGE_DYNAMIC;
+	bd.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	bd.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	bd.StructureByteStride = stride;
+
+	HRESULT hr = renderer.GetDevice()->CreateBuffer(&bd, NULL, &m_buff);
+	RETV2(FAILED(hr), false);
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC descSRV;
+	ZeroMemory(&descSRV, sizeof(descSRV));
+	descSRV.Format = DXGI_FORMAT_UNKNOWN;
+	descSRV.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	descSRV.Buffer.FirstElement = 0;
+	descSRV.Buffer.NumElements = count;
+	hr = renderer.GetDevice()->CreateShaderResourceView(m_buff, &descSRV, &m_srv);
+	RETV2(FAILED(hr), false);
+
+	return true;
+}
+
+
+// Map whole buffer with WRITE_DISCARD
+// return element array pointer, NULL if fail
+void* cStructuredBuffer::Lock(cRenderer &renderer)
+{
+	if (!m_buff)
+		return NULL;
+
+	D3D11_MAPPED_SUBRESOURCE res;
+	if (FAILED(renderer.GetDevContext()->Map(m_buff, 0, D3D11_MAP_WRITE_DISCARD, 0, &res)))
+		return NULL;
+	return res.pData;
+}
+
+
+void cStructuredBuffer::Unlock(cRenderer &renderer)
+{
+	if (m_buff)
+		renderer.GetDevContext()->Unmap(m_buff, 0);
+}
+
+
+// light volume records are read from Domain Shader and Pixel Shader
+void cStructuredBuffer::Bind(cRenderer &renderer
+	, const int stage //= 0
+)
+{
+	ID3D11DeviceContext *devContext = renderer.GetDevContext();
+	devContext->DSSetShaderResources(stage, 1, &m_srv);
+	devContext->PSSetShaderResources(stage, 1, &m_srv);
+}
+
+
+void cStructuredBuffer::Unbind(cRenderer &renderer
+	, const int stage //= 0
+)
+{
+	ID3D11DeviceContext *devContext = renderer.GetDevContext();
+	ID3D11ShaderResourceView *srvs[1] = { NULL };
+	devContext->DSSetShaderResources(stage, 1, srvs);
+	devContext->PSSetShaderResources(stage, 1, srvs);
+}
+
+
+void cStructuredBuffer::Clear()
+{
+	SAFE_RELEASE(m_srv);
+	SAFE_RELEASE(m_buff);
+	m_stride = 0;
+	m_count = 0;
+}
@@ -9,6 +9,7 @@
 using namespace common;
 #include "../../../../../Common/Graphic11/graphic11.h"
 #include "../../../../../Common/Framework11/framework11.h"
+#include "../../Shared/benchmarkrunner.h"
 
 using namespace graphic;
 
@@ -38,6 +39,7 @@ public:
 
 public:
 	cCamera3D m_camera;
+	cBenchmarkRunner m_benchmark;
 	cGridLine m_ground;
 	cModel m_model;
 	cConstantBuffer<sCBDirLightPS> m_cbDirLight;
@@ -100,6 +102,13 @@ bool cViewer::OnInit()
 
 	m_cbDirLight.Create(m_renderer);
 
+	// benchmark mode, scripted camera orbit, no input
+	if (m_benchmark.Init(GetCommandLineA(), "ForwardLight_PointLight"))
+	{
+		const float center[3] = { 0, 0, 0 };
+		m_benchmark.AddOrbit(center, 10.f, 6.f, 10.f);
+	}
+
 	return true;
 }
 
@@ -121,6 +130,15 @@ void cViewer::OnRender(const float deltaSeconds)
 {
 	cAutoCam cam(&m_camera);
 
+	// benchmark mode, scripted camera
+	if (m_benchmark.m_isRun)
+	{
+		float eyePos[3], lookAt[3];
+		m_benchmark.GetCamera(eyePos, lookAt);
+		m_camera.SetCamera(Vector3(eyePos[0], eyePos[1], eyePos[2])
+			, Vector3(lookAt[0], lookAt[1], lookAt[2]), Vector3(0, 1, 0));
+	}
+
 	if (m_model.IsLoadFinish())
 	{
 		for (auto &mesh : m_model.m_model->m_meshes)
@@ -160,6 +178,13 @@ void cViewer::OnRender(const float deltaSeconds)
 		m_renderer.EndScene();
 		m_renderer.Present();
 	}
+
+	if (m_benchmark.m_isRun)
+	{
+		m_benchmark.EndFrame();
+		if (!m_benchmark.m_isRun) // finish, json written
+			PostMessage(m_hWnd, WM_CLOSE, 0, 0);
+	}
 }
 
 
@@ -210,6 +235,9 @@ void cViewer::UpdateLookAt()
 
 void cViewer::OnMessageProc(UINT message, WPARAM wParam, LPARAM lParam)
 {
+	if (m_benchmark.m_isRun) // scripted camera, ignore input
+		return;
+
 	static bool maximizeWnd = false;
 	switch (message)
 	{
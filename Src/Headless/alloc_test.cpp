@@ -0,0 +1,103 @@
+//
+// 2018-05-26, jjuiddong
+// Zero Allocation Test
+//	- headless frame loop, frame graph compile, ParallelFor job
+//	- after warm up, heap allocation count delta must be zero
+//	  (cAllocTracker::GetThreadCount(): caller thread, GetCount(): all thread)
+//
+
+#include "../Shared/platform.h"
+#include "alloctracker.h"
+#include "jobsystem.h"
+#include "deferredgraph.h"
+#include <cstdio>
+
+using namespace graphic;
+
+
+int main()
+{
+	const int warmupFrames = 10;
+	const int frameCount = 200;
+	const int objectCount = 10000;
+
+	cJobSystem jobs;
+	jobs.Create(3);
+
+	cFrameArena arena;
+	arena.Create();
+
+	cFrameGraph graph;
+	graph.m_arena = &arena;
+	sDeferredGraph ids;
+	CreateDeferredGraph(graph, 1280, 720, ids);
+
+	std::vector<float> x(objectCount), y(objectCount), z(objectCount), r(objectCount);
+	std::vector<int> visible(objectCount);
+	std::vector<int> workerVisible(jobs.GetWorkerCount());
+	for (int i = 0; i < objectCount; ++i)
+	{
+		x[i] = (float)(i % 100);
+		y[i] = (float)(i / 100);
+		z[i] = (float)(i % 7);
+		r[i] = 1.f;
+	}
+
+	cAllocTracker tracker;
+	tracker.m_warmupFrames = warmupFrames;
+
+	int failFrames = 0;
+	for (int frame = 0; frame < frameCount; ++frame)
+	{
+		tracker.BeginFrame();
+
+		arena.Reset();
+		graph.SetOutput(ids.gbufferView, (frame % 2) == 0);
+		graph.Compile();
+		graph.Execute(NULL);
+
+		// lambda capture larger than std::function small buffer
+		// ParallelFor() must not copy it to heap
+		const float cx = 50.f, cy = 50.f, cz = 3.f, range = 30.f;
+		std::fill(workerVisible.begin(), workerVisible.end(), 0);
+		jobs.ParallelFor(objectCount, 512, [&x, &y, &z, &r, &visible, &workerVisible, cx, cy, cz, range](
+			const int begin, const int end, const int workerIdx)
+		{
+			int n = 0;
+			for (int i = begin; i < end; ++i)
+			{
+				const float dx = x[i] - cx, dy = y[i] - cy, dz = z[i] - cz;
+				const float d = range + r[i];
+				visible[i] = (dx * dx + dy * dy + dz * dz) < (d * d);
+				n += visible[i];
+			}
+			workerVisible[workerIdx] += n;
+		});
+
+		const __int64 threadBegin = tracker.m_frameBegin;
+		const __int64 allBegin = tracker.m_frameBeginAll;
+		tracker.EndFrame();
+
+		if (frame < warmupFrames)
+			continue;
+
+		const __int64 threadDelta = cAllocTracker::GetThreadCount() - threadBegin;
+		const __int64 allDelta = cAllocTracker::GetCount() - allBegin;
+		if ((threadDelta != 0) || (allDelta != 0))
+		{
+			++failFrames;
+			printf("alloc_test: frame %d, thread alloc %lld, all thread alloc %lld\n"
+				, frame, (long long)threadDelta, (long long)allDelta);
+		}
+	}
+
+	jobs.Clear();
+
+	if ((failFrames > 0) || !tracker.IsSteadyState() || (arena.m_overflowCount > 0))
+	{
+		printf("alloc_test: FAIL, %d frame allocate after warm up\n", failFrames);
+		return 1;
+	}
+	printf("alloc_test: ok, %d frame zero allocation\n", tracker.m_steadyFrames);
+	return 0;
+}
@@ -0,0 +1,134 @@
+//
+// 2018-05-26, jjuiddong
+// Frame Graph Test
+//	- deferred graph pass order, culling, transient aliasing
+//	- cNullFrameGraphExecutor, no GPU
+//
+
+#include "../Shared/platform.h"
+#include "deferredgraph.h"
+#include <cstdio>
+
+using namespace graphic;
+
+
+namespace
+{
+	int g_failCount = 0;
+
+	void Check(const bool cond, const char *expr, const int line)
+	{
+		if (cond)
+			return;
+		++g_failCount;
+		printf("framegraph_test.cpp(%d): FAIL %s\n", line, expr);
+	}
+}
+
+#define CHECK(expr) Check((expr), #expr, __LINE__)
+
+
+// Shadow -> GBuffer -> Lighting -> Composite
+// GBuffer Debug culled, output not requested
+void TestDeferredOrder()
+{
+	cFrameGraph graph;
+	sDeferredGraph ids;
+	CreateDeferredGraph(graph, 1280, 720, ids);
+	graph.SetOutput(ids.gbufferView, false);
+	CHECK(graph.Compile());
+
+	cNullFrameGraphExecutor executor;
+	graph.Execute(&executor);
+
+	const char *expect[] = { "Shadow", "GBuffer", "Lighting", "Composite" };
+	CHECK(executor.m_passes.size() == 4);
+	for (int i = 0; (i < 4) && (i < (int)executor.m_passes.size()); ++i)
+		CHECK(executor.m_passes[i] == expect[i]);
+
+	CHECK(graph.m_culledCount == 1);
+	CHECK(graph.m_passes[ids.debugPass].isCulled);
+	CHECK(!graph.m_passes[ids.lightPass].isCulled);
+
+	// Lighting read slot 0~4, unbind after execute
+	CHECK(executor.m_unbinds.size() == 5);
+}
+
+
+// GBuffer Debug execute after Lighting if output requested
+void TestDeferredDebugOutput()
+{
+	cFrameGraph graph;
+	sDeferredGraph ids;
+	CreateDeferredGraph(graph, 1280, 720, ids);
+	graph.SetOutput(ids.gbufferView, true);
+	CHECK(graph.Compile());
+
+	cNullFrameGraphExecutor executor;
+	graph.Execute(&executor);
+
+	CHECK(graph.m_culledCount == 0);
+	CHECK(executor.m_passes.size() == 5);
+	if (executor.m_passes.size() == 5)
+	{
+		CHECK(executor.m_passes[3] == "GBuffer Debug");
+		CHECK(executor.m_passes[4] == "Composite");
+	}
+}
+
+
+// A: pass0 -> pass1, B: pass2 -> pass3, lifetime not overlap
+// B reuse A memory slot
+void TestAliasing()
+{
+	cFrameArena arena;
+	CHECK(arena.Create(64 * 1024));
+
+	cFrameGraph graph;
+	graph.m_arena = &arena;
+	const int a = graph.AddResource("A", 4096);
+	const int b = graph.AddResource("B", 4096);
+	const int out = graph.AddResource("Out", 0, false);
+	graph.SetOutput(out);
+
+	const int p0 = graph.AddPass("WriteA");
+	graph.Write(p0, a);
+	const int p1 = graph.AddPass("ReadA");
+	graph.Read(p1, a, 0);
+	graph.Write(p1, out);
+	const int p2 = graph.AddPass("WriteB");
+	graph.Write(p2, b);
+	const int p3 = graph.AddPass("ReadB");
+	graph.Read(p3, b, 0);
+	graph.Write(p3, out);
+	CHECK(graph.Compile());
+
+	CHECK(graph.m_culledCount == 0);
+	CHECK(graph.m_transientBytes == 8192);
+	CHECK(graph.m_aliasBytes < graph.m_transientBytes);
+	CHECK(graph.m_aliasBytes == 4096);
+	CHECK(graph.m_resources[a].memSlot == graph.m_resources[b].memSlot);
+	CHECK(arena.m_overflowCount == 0);
+
+	// deferred graph, every transient alive at Lighting, no aliasing
+	sDeferredGraph ids;
+	CreateDeferredGraph(graph, 1280, 720, ids);
+	CHECK(graph.Compile());
+	CHECK(graph.m_aliasBytes == graph.m_transientBytes);
+}
+
+
+int main()
+{
+	TestDeferredOrder();
+	TestDeferredDebugOutput();
+	TestAliasing();
+
+	if (g_failCount > 0)
+	{
+		printf("framegraph_test: %d failed\n", g_failCount);
+		return 1;
+	}
+	printf("framegraph_test: ok\n");
+	return 0;
+}
@@ -0,0 +1,211 @@
+//
+// 2018-05-26, jjuiddong
+// Headless Benchmark
+//	- Shadowmap_Pointlight frame CPU work without GPU (Linux CI)
+//	- frustum culling -> render queue sort, batch -> frame graph compile (null executor)
+//	  -> constant packing (instancing world matrix)
+//	- cBenchmarkRunner camera path, fixed delta, percentile json
+//	- command line: [-warmup=N] [-frames=M] [-out=file.json] [-objects=K]
+//
+
+#include "../Shared/platform.h"
+#include "../Shared/benchmarkrunner.h"
+#include "../Shared/steadytimer.h"
+#include "alloctracker.h"
+#include "jobsystem.h"
+#include "frustumculler.h"
+#include "renderqueue.h"
+#include "deferredgraph.h"
+#include "constantpacker.h"
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace graphic;
+
+
+namespace
+{
+	// common.fx cbPerFrame, cbPerFrameInstancing size
+	const UINT PER_FRAME_SIZE = 64 * 3;
+	const UINT INSTANCE_SIZE = 64; // world matrix
+
+	struct sScene
+	{
+		std::vector<float> x, y, z, r; // bounding sphere
+		std::vector<float> world; // 16 float per object
+		std::vector<int> mesh, material, pipeline;
+	};
+
+	// grid, same as Shadowmap_Pointlight model layout
+	void CreateScene(const int count, OUT sScene &scene)
+	{
+		scene.x.resize(count);
+		scene.y.resize(count);
+		scene.z.resize(count);
+		scene.r.resize(count);
+		scene.world.resize(count * 16);
+		scene.mesh.resize(count);
+		scene.material.resize(count);
+		scene.pipeline.resize(count);
+
+		const int side = (int)ceil(sqrt((float)count));
+		for (int i = 0; i < count; ++i)
+		{
+			scene.x[i] = (float)(i % side) * 2.f - side;
+			scene.y[i] = 0.5f;
+			scene.z[i] = (float)(i / side) * 2.f - side;
+			scene.r[i] = 0.8f;
+
+			float *m = &scene.world[i * 16];
+			for (int k = 0; k < 16; ++k)
+				m[k] = (k % 5) ? 0.f : 1.f;
+			m[12] = scene.x[i];
+			m[13] = scene.y[i];
+			m[14] = scene.z[i];
+
+			scene.mesh[i] = i % 4; // lod
+			scene.material[i] = i % 16; // texture
+			scene.pipeline[i] = i % 2; // gbuffer, gbuffer instancing
+		}
+	}
+}
+
+
+int main(int argc, char **argv)
+{
+	std::string commandLine = "-benchmark";
+	for (int i = 1; i < argc; ++i)
+		commandLine += std::string(" ") + argv[i];
+
+	cBenchmarkRunner bench;
+	bench.m_warmupFrames = 30;
+	bench.m_measureFrames = 300;
+	bench.Init(commandLine.c_str(), "Headless");
+
+	int objectCount = 20000;
+	const char *objectsOpt = strstr(commandLine.c_str(), "-objects=");
+	if (objectsOpt)
+		objectCount = std::max(1, atoi(objectsOpt + 9));
+
+	const float center[3] = { 0, 0, 0 };
+	bench.AddOrbit(center, 60.f, 10.f, 30.f);
+
+	cJobSystem jobs;
+	jobs.Create();
+
+	sScene scene;
+	CreateScene(objectCount, scene);
+
+	cFrustumCuller culler;
+	std::vector<int> visible(objectCount);
+
+	cRenderQueue queue;
+	queue.Reserve(objectCount);
+
+	cFrameArena arena;
+	arena.Create();
+	cFrameGraph graph;
+	graph.m_arena = &arena;
+	sDeferredGraph ids;
+	CreateDeferredGraph(graph, 1280, 960, ids);
+	cNullFrameGraphExecutor executor;
+
+	cConstantPacker packer;
+	const UINT packSize = cConstantPacker::GetAlignSize(PER_FRAME_SIZE)
+		+ cConstantPacker::GetAlignSize(INSTANCE_SIZE * cRenderQueue::MAX_INSTANCE)
+		* ((objectCount + cRenderQueue::MAX_INSTANCE - 1) / cRenderQueue::MAX_INSTANCE + 16);
+	BYTE *packBuffer = (BYTE*)_aligned_malloc(packSize, 16);
+	std::vector<float> perFrame(PER_FRAME_SIZE / 4, 0.f);
+	std::vector<float> instances(16 * cRenderQueue::MAX_INSTANCE);
+
+	int visibleSum = 0;
+	int batchSum = 0;
+	while (bench.m_isRun)
+	{
+		const __int64 allocBegin = cAllocTracker::GetThreadCount();
+
+		float eyePos[3], lookAt[3], viewProj[16];
+		bench.GetCamera(eyePos, lookAt);
+		cFrustumCuller::MakeViewProj(eyePos, lookAt, 3.141592654f / 4.f, 1280.f / 960.f
+			, 0.1f, 10000.f, viewProj);
+
+		// culling
+		double t0 = GetSteadyTimeMs();
+		culler.SetFrustum(viewProj);
+		const int visibleCount = culler.Cull(jobs, &scene.x[0], &scene.y[0], &scene.z[0]
+			, &scene.r[0], objectCount, &visible[0]);
+		const float cullMs = (float)(GetSteadyTimeMs() - t0);
+
+		// sort, batch
+		t0 = GetSteadyTimeMs();
+		queue.Reset();
+		for (int k = 0; k < visibleCount; ++k)
+		{
+			const int i = visible[k];
+			const float dx = scene.x[i] - eyePos[0];
+			const float dy = scene.y[i] - eyePos[1];
+			const float dz = scene.z[i] - eyePos[2];
+			queue.Add(cRenderQueue::MakeKey(1, scene.pipeline[i], scene.material[i]
+				, scene.mesh[i], sqrt(dx * dx + dy * dy + dz * dz)), (UINT)i);
+		}
+		queue.Sort(&jobs);
+		const int batchCount = queue.Batch();
+		const float sortMs = (float)(GetSteadyTimeMs() - t0);
+
+		// frame graph
+		t0 = GetSteadyTimeMs();
+		arena.Reset();
+		executor.Clear();
+		graph.SetOutput(ids.gbufferView, false);
+		graph.Compile();
+		graph.Execute(&executor);
+		const float graphMs = (float)(GetSteadyTimeMs() - t0);
+
+		// constant packing, per frame + batch instancing
+		t0 = GetSteadyTimeMs();
+		packer.Begin(packBuffer, packSize);
+		memcpy(&perFrame[0], viewProj, sizeof(viewProj));
+		packer.Alloc(&perFrame[0], PER_FRAME_SIZE);
+		for (auto &batch : queue.m_batches)
+		{
+			for (UINT k = 0; k < batch.count; ++k)
+				memcpy(&instances[k * 16], &scene.world[queue.m_items[batch.first + k].index * 16]
+					, INSTANCE_SIZE);
+			packer.Alloc(&instances[0], INSTANCE_SIZE * batch.count);
+		}
+		packer.End();
+		const float packMs = (float)(GetSteadyTimeMs() - t0);
+
+		visibleSum += visibleCount;
+		batchSum += batchCount;
+
+		if (bench.IsMeasureFrame())
+		{
+			bench.AddPassSample("Culling", cullMs, 0.f);
+			bench.AddPassSample("Sort Batch", sortMs, 0.f);
+			bench.AddPassSample("Frame Graph", graphMs, 0.f);
+			bench.AddPassSample("Constant Packing", packMs, 0.f);
+		}
+		bench.EndFrame((int)(cAllocTracker::GetThreadCount() - allocBegin));
+	}
+
+	jobs.Clear();
+	_aligned_free(packBuffer);
+
+	std::vector<float> frameMs = bench.m_frameMs;
+	printf("headless_benchmark: %d object, %d frame, avg visible %d, avg batch %d\n"
+		, objectCount, bench.m_frame, visibleSum / std::max(1, bench.m_frame)
+		, batchSum / std::max(1, bench.m_frame));
+	printf("frame p50 %.3f ms, p99 %.3f ms -> %s\n"
+		, cBenchmarkRunner::Percentile(frameMs, 0.5f)
+		, cBenchmarkRunner::Percentile(frameMs, 0.99f), bench.m_outFileName.c_str());
+
+	if (!bench.m_isWrite)
+	{
+		printf("headless_benchmark: json write fail, %s\n", bench.m_outFileName.c_str());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,62 @@
+//
+// 2018-05-27, jjuiddong
+// Job System Test
+//	- back to back ParallelFor(), chunk size change every call
+//	  (cluster cull 4, GBuffer batch 1, shadow chunk 8)
+//	- every index visit exactly once, late worker never run next job
+//
+
+#include "../Shared/platform.h"
+#include "jobsystem.h"
+#include <atomic>
+#include <cstdio>
+
+using namespace graphic;
+
+
+int main()
+{
+	const int runCount = 20000;
+	const int chunkSizes[] = { 4, 1, 8, 3 };
+
+	cJobSystem jobs;
+	jobs.Create(8); // more worker than core, late wake up
+
+	std::vector<std::atomic<int>> visits(256);
+	int failRuns = 0;
+	for (int run = 0; run < runCount; ++run)
+	{
+		// count change too, stale count visit out of range
+		// small count, caller finish before worker wake up
+		const int count = (run % 2) ? (1 + run % 16) : (1 + (run * 37) % (int)visits.size());
+		const int chunkSize = chunkSizes[run % (sizeof(chunkSizes) / sizeof(chunkSizes[0]))];
+		for (auto &v : visits)
+			v = 0;
+
+		jobs.ParallelFor(count, chunkSize, [&](const int begin, const int end, const int) {
+			for (int i = begin; i < end; ++i)
+				++visits[i];
+		});
+
+		for (int i = 0; i < (int)visits.size(); ++i)
+		{
+			const int expect = (i < count) ? 1 : 0;
+			if (visits[i] == expect)
+				continue;
+			++failRuns;
+			printf("jobsystem_test: run %d, count %d, chunk %d, index %d visit %d\n"
+				, run, count, chunkSize, i, (int)visits[i]);
+			break;
+		}
+	}
+
+	jobs.Clear();
+
+	if (failRuns > 0)
+	{
+		printf("jobsystem_test: FAIL, %d / %d run\n", failRuns, runCount);
+		return 1;
+	}
+	printf("jobsystem_test: ok, %d run\n", runCount);
+	return 0;
+}
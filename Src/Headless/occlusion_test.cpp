@@ -0,0 +1,94 @@
+//
+// 2018-05-27, jjuiddong
+// Occlusion Culler Test
+//	- occluder box rasterize, sphere behind box culled, unobstructed sphere kept
+//	- single thread, band per worker thread same result
+//
+
+#include "../Shared/platform.h"
+#include "occlusionculler.h"
+#include "frustumculler.h"
+#include <cstdio>
+
+using namespace graphic;
+
+
+namespace
+{
+	int g_failCount = 0;
+
+	void Check(const bool cond, const char *expr, const int line)
+	{
+		if (cond)
+			return;
+		++g_failCount;
+		printf("occlusion_test.cpp(%d): FAIL %s\n", line, expr);
+	}
+}
+
+#define CHECK(expr) Check((expr), #expr, __LINE__)
+
+
+// camera (0,0,-10) look at origin, occluder box 4 x 4 x 1 at origin
+void TestOccludee(cJobSystem *jobs)
+{
+	const float eyePos[3] = { 0, 0, -10.f };
+	const float lookAt[3] = { 0, 0, 0 };
+	float viewProj[16];
+	cFrustumCuller::MakeViewProj(eyePos, lookAt, 3.141592654f / 4.f
+		, (float)cOcclusionCuller::WIDTH / (float)cOcclusionCuller::HEIGHT, 0.1f, 100.f
+		, viewProj);
+
+	const float world[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	const float center[3] = { 0, 0, 0 };
+	const float halfSize[3] = { 2.f, 2.f, 0.5f };
+
+	cOcclusionCuller culler;
+	culler.Create();
+	culler.Begin(viewProj);
+	culler.AddBox(world, center, halfSize);
+	if (jobs)
+		culler.Rasterize(*jobs);
+	else
+		culler.Rasterize();
+
+	CHECK(culler.m_triangleCount == 12);
+	CHECK(culler.m_skipTriangleCount == 0);
+
+	CHECK(!culler.IsVisible(0, 0, 5.f, 0.5f)); // behind box
+	CHECK(!culler.IsVisible(1.f, -1.f, 3.f, 0.5f)); // behind box, off center
+	CHECK(culler.IsVisible(6.f, 0, 5.f, 0.5f)); // beside box
+	CHECK(culler.IsVisible(0, 0, -3.f, 0.5f)); // in front of box
+	CHECK(culler.IsVisible(0, 0, -9.95f, 0.5f)); // cross near plane
+	CHECK(culler.IsVisible(0, 3.f, 5.f, 0.5f)); // partly above box
+
+	// SoA Cull(), compact visible index
+	const float x[3] = { 0, 6.f, 0 };
+	const float y[3] = { 0, 0, 0 };
+	const float z[3] = { 5.f, 5.f, -3.f };
+	const float r[3] = { 0.5f, 0.5f, 0.5f };
+	int indices[3] = { 0, 1, 2 };
+	const int count = culler.Cull(x, y, z, r, indices, 3, indices);
+	CHECK(count == 2);
+	CHECK((indices[0] == 1) && (indices[1] == 2));
+	CHECK(culler.m_occludedCount == 1);
+}
+
+
+int main()
+{
+	cJobSystem jobs;
+	jobs.Create(3);
+
+	TestOccludee(NULL);
+	TestOccludee(&jobs);
+	jobs.Clear();
+
+	if (g_failCount > 0)
+	{
+		printf("occlusion_test: %d failed\n", g_failCount);
+		return 1;
+	}
+	printf("occlusion_test: ok\n");
+	return 0;
+}
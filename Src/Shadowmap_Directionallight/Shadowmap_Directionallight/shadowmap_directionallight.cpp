@@ -9,6 +9,7 @@
 using namespace common;
 #include "../../../../../Common/Graphic11/graphic11.h"
 #include "../../../../../Common/Framework11/framework11.h"
+#include "../../Shared/benchmarkrunner.h"
 #include "gbuffer.h"
 #include "depthbufferarray.h"
 #include "cascadedshadowmap2.h"
@@ -58,6 +59,7 @@ protected:
 
 public:
 	cCamera3D m_camera;
+	cBenchmarkRunner m_benchmark;
 	cGridLine m_ground;
 	cModel m_model[64];
 	cQuad m_quad;
@@ -234,6 +236,14 @@ bool cViewer::OnInit()
 	if (FAILED(m_renderer.GetDevice()->CreateBlendState(&descBlend, &m_pAdditiveBlendState)))
 		return false;
 
+	// benchmark mode, scripted camera orbit, no input
+	if (m_benchmark.Init(GetCommandLineA(), "Shadowmap_Directionallight"))
+	{
+		m_isAnimate = true;
+		const float center[3] = { 0, 0, 0 };
+		m_benchmark.AddOrbit(center, 10.f, 6.f, 10.f);
+	}
+
 	return true;
 }
 
@@ -253,6 +263,17 @@ const Vector3 GammaToLinear(const Vector3& color)
 void cViewer::OnRender(const float deltaSeconds)
 {
 	cAutoCam cam(&m_camera);
+
+	// benchmark mode, fixed delta time
+	const float dt = m_benchmark.m_isRun ? m_benchmark.GetDeltaSeconds() : deltaSeconds;
+	if (m_benchmark.m_isRun)
+	{
+		float eyePos[3], lookAt[3];
+		m_benchmark.GetCamera(eyePos, lookAt);
+		m_camera.SetCamera(Vector3(eyePos[0], eyePos[1], eyePos[2])
+			, Vector3(lookAt[0], lookAt[1], lookAt[2]), Vector3(0, 1, 0));
+	}
+
 	ID3D11DeviceContext *devContext = m_renderer.GetDevContext();
 
 	m_gui.NewFrame();
@@ -272,7 +293,7 @@ void cViewer::OnRender(const float deltaSeconds)
 
 	// Animation
 	{
-		//const float angle = deltaSeconds * 1.f * (m_isAnimate ? 1.0f : 0.f);
+		//const float angle = dt * 1.f * (m_isAnimate ? 1.0f : 0.f);
 		//Matrix44 tm;
 		//tm.SetRotationY(angle);
 
@@ -360,6 +381,13 @@ void cViewer::OnRender(const float deltaSeconds)
 	m_renderer.RenderFPS();
 	m_renderer.EndScene();
 	m_renderer.Present();
+
+	if (m_benchmark.m_isRun)
+	{
+		m_benchmark.EndFrame();
+		if (!m_benchmark.m_isRun) // finish, json written
+			PostMessage(m_hWnd, WM_CLOSE, 0, 0);
+	}
 }
 
 
@@ -528,6 +556,9 @@ void cViewer::UpdateLookAt()
 
 void cViewer::OnMessageProc(UINT message, WPARAM wParam, LPARAM lParam)
 {
+	if (m_benchmark.m_isRun) // scripted camera, ignore input
+		return;
+
 	m_gui.WndProcHandler(m_hWnd, message, wParam, lParam);
 	if (ImGui::IsAnyItemHovered())
 	{
@@ -0,0 +1,85 @@
+//
+// 2018-05-26, jjuiddong
+// Constant Buffer Layout Check
+//	- Shadowmap_Pointlight custom build step, run after fxc compile
+//	- compare cbstruct.h, gbuffer.h structure with .fxo reflection
+//	- mismatch: print MSBuild error with field name, return 1, build fail
+//
+//	usage: CBLayoutCheck.exe hlsl.fxo shadowgen.fxo
+//
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "../Shadowmap_Pointlight/gbuffer.h"
+#include "../Shadowmap_Pointlight/cbstruct.h"
+#include "cbufferlayout.h"
+
+using namespace graphic;
+
+
+int main(int argc, char *argv[])
+{
+	if (argc < 3)
+	{
+		printf("usage: CBLayoutCheck.exe hlsl.fxo shadowgen.fxo\n");
+		return 1;
+	}
+
+	const char *hlslPath = argv[1];
+	const char *shadowShaderPath = argv[2];
+
+	// reflection only, no render, WARP device always available
+	ID3D11Device *device = NULL;
+	HRESULT hr = D3D11CreateDevice(NULL, D3D_DRIVER_TYPE_WARP, NULL, 0, NULL, 0
+		, D3D11_SDK_VERSION, &device, NULL, NULL);
+	if (FAILED(hr))
+	{
+		printf("CBLayoutCheck : error CB0000: D3D11CreateDevice fail\n");
+		return 1;
+	}
+
+	cCBufferLayout layout;
+	layout.Load(device, hlslPath);
+	layout.Load(device, shadowShaderPath);
+
+	const cCBufferLayout::sField dirLight[] = {
+		CB_FIELD(sCbDirightPS, AmbientDown)
+		, CB_FIELD(sCbDirightPS, AmbientRange)
+	};
+	const cCBufferLayout::sField gbuffer[] = {
+		CB_FIELD(sCbGBuffer, perspectiveValue)
+		, CB_FIELD(sCbGBuffer, invView)
+	};
+	const cCBufferLayout::sField pointLight[] = {
+		CB_FIELD(sCbPointLight, PointLightPos)
+		, CB_FIELD(sCbPointLight, PointLightRangeRcp)
+		, CB_FIELD(sCbPointLight, PointColor)
+		, CB_FIELD(sCbPointLight, LightProjection)
+		, CB_FIELD(sCbPointLight, LightPerspectiveValues)
+	};
+	const cCBufferLayout::sField shadowCube[] = {
+		CB_FIELD(sCbShadowmapCube, cubeViewProj)
+	};
+
+	if (layout.m_errorCount == 0)
+	{
+		layout.Validate(hlslPath, "cbDirLight", "sCbDirightPS"
+			, dirLight, ARRAYSIZE(dirLight), sizeof(sCbDirightPS));
+		layout.Validate(hlslPath, "cbGBufferUnpack", "sCbGBuffer"
+			, gbuffer, ARRAYSIZE(gbuffer), sizeof(sCbGBuffer));
+		layout.Validate(hlslPath, "cbPointLight", "sCbPointLight"
+			, pointLight, ARRAYSIZE(pointLight), sizeof(sCbPointLight));
+		layout.Validate(shadowShaderPath, "cbuffercbShadowMapCubeGS", "sCbShadowmapCube"
+			, shadowCube, ARRAYSIZE(shadowCube), sizeof(sCbShadowmapCube));
+	}
+
+	SAFE_RELEASE(device);
+
+	if (layout.m_errorCount > 0)
+		return 1;
+
+	printf("CBLayoutCheck : constant buffer layout ok\n");
+	return 0;
+}
@@ -0,0 +1,176 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "cbufferlayout.h"
+
+using namespace graphic;
+
+
+namespace
+{
+	// MSBuild error format, Visual Studio error list show this line
+	void PrintError(const char *fmt, ...)
+	{
+		char buff[512];
+		va_list args;
+		va_start(args, fmt);
+		vsprintf_s(buff, fmt, args);
+		va_end(args);
+		printf("CBLayoutCheck : error CB0001: %s\n", buff);
+	}
+}
+
+
+cCBufferLayout::cCBufferLayout()
+	: m_errorCount(0)
+{
+}
+
+cCBufferLayout::~cCBufferLayout()
+{
+	Clear();
+}
+
+
+// read cbuffer layout of effect file
+bool cCBufferLayout::Load(ID3D11Device *device, const char *fxoFileName)
+{
+	std::vector<sCBuffer> cbuffers;
+	if (!Reflect(device, fxoFileName, cbuffers))
+	{
+		PrintError("%s load fail", fxoFileName);
+		++m_errorCount;
+		return false;
+	}
+	m_cbuffers.insert(m_cbuffers.end(), cbuffers.begin(), cbuffers.end());
+	return true;
+}
+
+
+bool cCBufferLayout::Reflect(ID3D11Device *device, const char *fxoFileName
+	, OUT std::vector<sCBuffer> &out)
+{
+	std::vector<BYTE> data;
+	{
+		FILE *fp = NULL;
+		if (fopen_s(&fp, fxoFileName, "rb") || !fp)
+			return false;
+		fseek(fp, 0, SEEK_END);
+		data.resize(max(0L, ftell(fp)));
+		fseek(fp, 0, SEEK_SET);
+		const size_t readSize = data.empty() ? 0 : fread(&data[0], 1, data.size(), fp);
+		fclose(fp);
+		RETV2(data.empty() || (readSize != data.size()), false);
+	}
+
+	ID3DX11Effect *effect = NULL;
+	HRESULT hr = D3DX11CreateEffectFromMemory(&data[0], data.size(), 0
+		, device, &effect);
+	RETV2(FAILED(hr), false);
+
+	D3DX11_EFFECT_DESC effectDesc;
+	effect->GetDesc(&effectDesc);
+
+	for (UINT i = 0; i < effectDesc.ConstantBuffers; ++i)
+	{
+		ID3DX11EffectConstantBuffer *cb = effect->GetConstantBufferByIndex(i);
+		D3DX11_EFFECT_VARIABLE_DESC cbDesc;
+		D3DX11_EFFECT_TYPE_DESC cbTypeDesc;
+		if (FAILED(cb->GetDesc(&cbDesc)) || FAILED(cb->GetType()->GetDesc(&cbTypeDesc)))
+			continue;
+
+		sCBuffer cbuffer;
+		cbuffer.fileName = fxoFileName;
+		cbuffer.name = cbDesc.Name;
+		cbuffer.slot = cbDesc.ExplicitBindPoint;
+		cbuffer.size = 0;
+
+		for (UINT m = 0; m < cbTypeDesc.Members; ++m)
+		{
+			ID3DX11EffectVariable *var = cb->GetMemberByIndex(m);
+			D3DX11_EFFECT_VARIABLE_DESC varDesc;
+			D3DX11_EFFECT_TYPE_DESC typeDesc;
+			if (FAILED(var->GetDesc(&varDesc)) || FAILED(var->GetType()->GetDesc(&typeDesc)))
+				continue;
+
+			sField field;
+			field.name = varDesc.Name;
+			field.offset = varDesc.BufferOffset;
+			field.size = typeDesc.UnpackedSize;
+			cbuffer.fields.push_back(field);
+			cbuffer.size = max(cbuffer.size, field.offset + field.size);
+		}
+
+		cbuffer.size = (cbuffer.size + 15) & ~15;
+		out.push_back(cbuffer);
+	}
+
+	SAFE_RELEASE(effect);
+	return true;
+}
+
+
+const cCBufferLayout::sCBuffer* cCBufferLayout::Find(const char *fxoFileName
+	, const char *cbName) const
+{
+	for (auto &cb : m_cbuffers)
+		if ((cb.fileName == fxoFileName) && (cb.name == cbName))
+			return &cb;
+	return NULL;
+}
+
+
+// compare C++ structure with cbuffer layout
+// fields: C++ field, same order with cbuffer member (CB_FIELD macro)
+bool cCBufferLayout::Validate(const char *fxoFileName, const char *cbName
+	, const char *structName, const sField *fields, const int fieldCount
+	, const UINT structSize)
+{
+	const sCBuffer *cb = Find(fxoFileName, cbName);
+	if (!cb)
+	{
+		PrintError("%s not found in %s", cbName, fxoFileName);
+		++m_errorCount;
+		return false;
+	}
+
+	bool result = true;
+	if (fieldCount != (int)cb->fields.size())
+	{
+		PrintError("%s has %d field, %s::%s has %d member"
+			, structName, fieldCount, fxoFileName, cbName, (int)cb->fields.size());
+		result = false;
+	}
+
+	for (int i = 0; i < min(fieldCount, (int)cb->fields.size()); ++i)
+	{
+		const sField &hlsl = cb->fields[i];
+		if ((fields[i].offset != hlsl.offset) || (fields[i].size < hlsl.size))
+		{
+			PrintError("%s::%s (offset %d, size %d) != %s::%s (offset %d, size %d)"
+				, structName, fields[i].name.c_str(), fields[i].offset, fields[i].size
+				, cbName, hlsl.name.c_str(), hlsl.offset, hlsl.size);
+			result = false;
+		}
+	}
+
+	if (structSize < cb->size)
+	{
+		PrintError("sizeof(%s) = %d, %s = %d"
+			, structName, structSize, cbName, cb->size);
+		result = false;
+	}
+
+	if (!result)
+		++m_errorCount;
+	return result;
+}
+
+
+void cCBufferLayout::Clear()
+{
+	m_cbuffers.clear();
+	m_errorCount = 0;
+}
@@ -0,0 +1,60 @@
+//
+// 2018-05-06, jjuiddong
+// Constant Buffer Layout Reflection
+//	- read cbuffer layout from compiled effect (.fxo) reflection
+//	- validate C++ constant buffer structure offset
+//	- used by CBLayoutCheck, build step after fxc compile
+//	  mismatch: build error with C++ field name
+//
+#pragma once
+
+#include <cstddef>
+
+
+// C++ field description for cCBufferLayout::Validate()
+#define CB_FIELD(type, field) { #field, (UINT)offsetof(type, field), (UINT)sizeof(((type*)0)->field) }
+
+
+namespace graphic
+{
+
+	class cCBufferLayout
+	{
+	public:
+		struct sField
+		{
+			std::string name;
+			UINT offset;
+			UINT size;
+		};
+
+		struct sCBuffer
+		{
+			std::string fileName; // .fxo file name
+			std::string name;
+			UINT slot;
+			UINT size; // 16 byte aligned
+			std::vector<sField> fields;
+		};
+
+		cCBufferLayout();
+		virtual ~cCBufferLayout();
+
+		bool Load(ID3D11Device *device, const char *fxoFileName);
+		const sCBuffer* Find(const char *fxoFileName, const char *cbName) const;
+		bool Validate(const char *fxoFileName, const char *cbName, const char *structName
+			, const sField *fields, const int fieldCount, const UINT structSize);
+		void Clear();
+
+
+	protected:
+		bool Reflect(ID3D11Device *device, const char *fxoFileName
+			, OUT std::vector<sCBuffer> &out);
+
+
+	public:
+		std::vector<sCBuffer> m_cbuffers;
+		int m_errorCount;
+	};
+
+}
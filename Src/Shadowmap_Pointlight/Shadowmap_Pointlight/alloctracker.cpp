@@ -0,0 +1,145 @@
+
+#include "../../Shared/platform.h"
+#include "alloctracker.h"
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+using namespace graphic;
+
+
+namespace
+{
+	std::atomic<__int64> g_allocCount(0);
+	std::atomic<__int64> g_allocBytes(0);
+	thread_local __int64 t_allocCount = 0;
+}
+
+
+//---------------------------------------------------------------------------------
+// global operator new/delete, every module linked to this executable
+void* operator new(size_t size)
+{
+	cAllocTracker::OnAlloc(size);
+	void *p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	cAllocTracker::OnAlloc(size);
+	void *p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	cAllocTracker::OnAlloc(size);
+	return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	cAllocTracker::OnAlloc(size);
+	return malloc(size ? size : 1);
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+void operator delete(void *p, const std::nothrow_t&) noexcept { free(p); }
+void operator delete[](void *p, const std::nothrow_t&) noexcept { free(p); }
+//---------------------------------------------------------------------------------
+
+
+cAllocTracker::cAllocTracker()
+	: m_warmupFrames(120)
+	, m_frameIdx(0)
+	, m_frameBegin(0)
+	, m_frameBeginAll(0)
+	, m_frameAllocs(0)
+	, m_frameAllocsAll(0)
+	, m_steadyFrames(0)
+	, m_steadyAllocFrames(0)
+	, m_steadyMaxAllocs(0)
+{
+}
+
+cAllocTracker::~cAllocTracker()
+{
+}
+
+
+// call from render thread
+void cAllocTracker::BeginFrame()
+{
+	m_frameBegin = GetThreadCount();
+	m_frameBeginAll = GetCount();
+}
+
+
+void cAllocTracker::EndFrame()
+{
+	m_frameAllocs = (int)(GetThreadCount() - m_frameBegin);
+	m_frameAllocsAll = (int)(GetCount() - m_frameBeginAll);
+
+	if (m_frameIdx++ < m_warmupFrames)
+		return;
+
+	++m_steadyFrames;
+	if (m_frameAllocs > 0)
+	{
+		++m_steadyAllocFrames;
+		m_steadyMaxAllocs = std::max(m_steadyMaxAllocs, m_frameAllocs);
+	}
+}
+
+
+// true if render thread not allocate heap after warm up
+bool cAllocTracker::IsSteadyState() const
+{
+	return (m_steadyFrames > 0) && (0 == m_steadyAllocFrames);
+}
+
+
+// restart warm up, after resize, resource load, UI action
+void cAllocTracker::ResetSteadyState()
+{
+	m_frameIdx = 0;
+	m_steadyFrames = 0;
+	m_steadyAllocFrames = 0;
+	m_steadyMaxAllocs = 0;
+}
+
+
+void cAllocTracker::OnAlloc(const size_t size)
+{
+	g_allocCount.fetch_add(1, std::memory_order_relaxed);
+	g_allocBytes.fetch_add((__int64)size, std::memory_order_relaxed);
+	++t_allocCount;
+}
+
+
+__int64 cAllocTracker::GetCount()
+{
+	return g_allocCount.load(std::memory_order_relaxed);
+}
+
+
+__int64 cAllocTracker::GetBytes()
+{
+	return g_allocBytes.load(std::memory_order_relaxed);
+}
+
+
+// calling thread allocation count
+__int64 cAllocTracker::GetThreadCount()
+{
+	return t_allocCount;
+}
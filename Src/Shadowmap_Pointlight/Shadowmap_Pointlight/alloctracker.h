@@ -0,0 +1,45 @@
+//
+// 2018-05-12, jjuiddong
+// Heap Allocation Tracker
+//	- replace global operator new/delete, count allocation
+//	- total count (all thread), thread count (profile scope, render thread)
+//	- per frame count, steady state check (zero allocation after warm up)
+//	- malloc() direct call not counted
+//	- no Common dependency (Shared/platform.h)
+//
+#pragma once
+
+
+namespace graphic
+{
+
+	class cAllocTracker
+	{
+	public:
+		cAllocTracker();
+		virtual ~cAllocTracker();
+
+		void BeginFrame();
+		void EndFrame();
+		bool IsSteadyState() const;
+		void ResetSteadyState();
+
+		static void OnAlloc(const size_t size);
+		static __int64 GetCount();
+		static __int64 GetBytes();
+		static __int64 GetThreadCount();
+
+
+	public:
+		int m_warmupFrames; // steady state check start frame
+		int m_frameIdx;
+		__int64 m_frameBegin; // GetThreadCount() at frame begin
+		__int64 m_frameBeginAll; // GetCount() at frame begin
+		int m_frameAllocs; // render thread, last frame
+		int m_frameAllocsAll; // all thread, last frame
+		int m_steadyFrames; // frame count after warm up
+		int m_steadyAllocFrames; // frame count that heap allocate after warm up
+		int m_steadyMaxAllocs;
+	};
+
+}
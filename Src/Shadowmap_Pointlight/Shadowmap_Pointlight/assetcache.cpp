@@ -0,0 +1,316 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "assetcache.h"
+#include <algorithm>
+
+using namespace graphic;
+
+
+namespace
+{
+	// xxHash64
+	// https://github.com/Cyan4973/xxHash
+	const unsigned __int64 PRIME64_1 = 11400714785074694791ULL;
+	const unsigned __int64 PRIME64_2 = 14029467366897019727ULL;
+	const unsigned __int64 PRIME64_3 = 1609587929392839161ULL;
+	const unsigned __int64 PRIME64_4 = 9650029242287828579ULL;
+	const unsigned __int64 PRIME64_5 = 2870177450012600261ULL;
+
+	inline unsigned __int64 Rotl64(const unsigned __int64 x, const int r) {
+		return (x << r) | (x >> (64 - r));
+	}
+
+	inline unsigned __int64 Read64(const BYTE *p) {
+		unsigned __int64 v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	inline unsigned __int64 Read32(const BYTE *p) {
+		DWORD v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	inline unsigned __int64 Round64(unsigned __int64 acc, const unsigned __int64 input) {
+		acc += input * PRIME64_2;
+		acc = Rotl64(acc, 31);
+		return acc * PRIME64_1;
+	}
+
+	inline unsigned __int64 Merge64(unsigned __int64 acc, const unsigned __int64 val) {
+		acc ^= Round64(0, val);
+		return acc * PRIME64_1 + PRIME64_4;
+	}
+
+	// last write time used to LRU order, Trim() protect
+	void Touch(const char *fileName)
+	{
+		HANDLE hFile = CreateFileA(fileName, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ
+			, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (INVALID_HANDLE_VALUE == hFile)
+			return;
+		FILETIME now;
+		GetSystemTimeAsFileTime(&now);
+		SetFileTime(hFile, NULL, NULL, &now);
+		CloseHandle(hFile);
+	}
+
+	struct sCacheFile
+	{
+		std::string fileName;
+		unsigned __int64 size;
+		FILETIME lastWrite;
+	};
+}
+
+
+cAssetCache::cAssetCache()
+	: m_maxSize(0)
+	, m_hitCount(0)
+	, m_missCount(0)
+{
+	ZeroMemory(&m_trimTime, sizeof(m_trimTime));
+}
+
+cAssetCache::~cAssetCache()
+{
+	Clear();
+}
+
+
+bool cAssetCache::Create(const char *directory
+	, const unsigned __int64 maxSize //= 256 * 1024 * 1024
+)
+{
+	Clear();
+
+	m_directory = directory;
+	m_maxSize = maxSize;
+
+	if (!CreateDirectoryA(directory, NULL) && (ERROR_ALREADY_EXISTS != GetLastError()))
+		return false;
+
+	Trim();
+	return true;
+}
+
+
+// return cache key from source file contents
+// empty string if fail to read source file
+std::string cAssetCache::GetKey(const char *srcFileName, const char *converter
+	, const int version)
+{
+	FILE *fp = NULL;
+	if (fopen_s(&fp, srcFileName, "rb") || !fp)
+		return "";
+
+	fseek(fp, 0, SEEK_END);
+	const long size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	std::vector<BYTE> src(max(0L, size));
+	const size_t readSize = src.empty() ? 0 : fread(&src[0], 1, src.size(), fp);
+	fclose(fp);
+	if (readSize != src.size())
+		return "";
+
+	// converter version change invalidate all key
+	const unsigned __int64 seed = Hash64(converter, strlen(converter), (unsigned __int64)version);
+	const unsigned __int64 hash = Hash64(src.empty() ? NULL : &src[0], src.size(), seed);
+
+	char key[128];
+	sprintf_s(key, "%016llx_%s_%d", hash, converter, version);
+	return key;
+}
+
+
+// return cached file name, and mark recently used
+// exist check and touch with m_mutex, Trim() never remove between them
+bool cAssetCache::Find(const std::string &key, OUT std::string &outFileName)
+{
+	if (key.empty() || m_directory.empty())
+		return false;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const std::string fileName = m_directory + "/" + key;
+	const DWORD attr = GetFileAttributesA(fileName.c_str());
+	if ((INVALID_FILE_ATTRIBUTES == attr) || (attr & FILE_ATTRIBUTE_DIRECTORY))
+	{
+		++m_missCount;
+		return false;
+	}
+
+	Touch(fileName.c_str());
+	++m_hitCount;
+	outFileName = fileName;
+	return true;
+}
+
+
+// converter write to temporary file, and then move to cache
+bool cAssetCache::Store(const std::string &key, const char *tmpFileName
+	, OUT std::string &outFileName)
+{
+	RETV2(key.empty() || m_directory.empty(), false);
+
+	const std::string fileName = m_directory + "/" + key;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!MoveFileExA(tmpFileName, fileName.c_str(), MOVEFILE_REPLACE_EXISTING))
+		{
+			DeleteFileA(tmpFileName);
+			return false;
+		}
+		Touch(fileName.c_str()); // converter write time can be older than last Trim()
+	}
+
+	outFileName = fileName;
+	Trim();
+	return true;
+}
+
+
+// temporary file name, unique per thread
+std::string cAssetCache::GetTempFileName(const std::string &key)
+{
+	char name[64];
+	sprintf_s(name, "_%u.tmp", GetCurrentThreadId());
+	return m_directory + "/" + key + name;
+}
+
+
+// remove least recently used file until total size <= m_maxSize
+// file touched (Find(), Store()) after previous Trim() start is skipped
+// caller may not open it yet, total can exceed m_maxSize until next Trim()
+// return total cache size
+unsigned __int64 cAssetCache::Trim()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_directory.empty())
+		return 0;
+
+	const FILETIME protectTime = m_trimTime;
+	GetSystemTimeAsFileTime(&m_trimTime);
+
+	std::vector<sCacheFile> files;
+	unsigned __int64 total = 0;
+	{
+		WIN32_FIND_DATAA fd;
+		const std::string findPath = m_directory + "/*.*";
+		HANDLE hFind = FindFirstFileA(findPath.c_str(), &fd);
+		if (INVALID_HANDLE_VALUE == hFind)
+			return 0;
+		do
+		{
+			if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+				continue;
+			if (strstr(fd.cFileName, ".tmp")) // writing now
+				continue;
+
+			sCacheFile file;
+			file.fileName = m_directory + "/" + fd.cFileName;
+			file.size = ((unsigned __int64)fd.nFileSizeHigh << 32) | fd.nFileSizeLow;
+			file.lastWrite = fd.ftLastWriteTime;
+			files.push_back(file);
+			total += file.size;
+		} while (FindNextFileA(hFind, &fd));
+		FindClose(hFind);
+	}
+
+	if ((0 == m_maxSize) || (total <= m_maxSize))
+		return total;
+
+	std::sort(files.begin(), files.end(), [](const sCacheFile &a, const sCacheFile &b) {
+		return CompareFileTime(&a.lastWrite, &b.lastWrite) < 0; });
+
+	for (auto &file : files)
+	{
+		if (total <= m_maxSize)
+			break;
+		if (CompareFileTime(&file.lastWrite, &protectTime) >= 0)
+			continue; // returned after previous Trim(), maybe not opened yet
+		if (DeleteFileA(file.fileName.c_str()))
+			total -= file.size;
+	}
+
+	return total;
+}
+
+
+void cAssetCache::Clear()
+{
+	m_directory.clear();
+	m_hitCount = 0;
+	m_missCount = 0;
+	ZeroMemory(&m_trimTime, sizeof(m_trimTime));
+}
+
+
+// xxHash64
+unsigned __int64 cAssetCache::Hash64(const void *data, const size_t size
+	, const unsigned __int64 seed //= 0
+)
+{
+	const BYTE *p = (const BYTE*)data;
+	const BYTE *end = p + size;
+	unsigned __int64 h;
+
+	if (size >= 32)
+	{
+		const BYTE *limit = end - 32;
+		unsigned __int64 v1 = seed + PRIME64_1 + PRIME64_2;
+		unsigned __int64 v2 = seed + PRIME64_2;
+		unsigned __int64 v3 = seed;
+		unsigned __int64 v4 = seed - PRIME64_1;
+		do
+		{
+			v1 = Round64(v1, Read64(p)); p += 8;
+			v2 = Round64(v2, Read64(p)); p += 8;
+			v3 = Round64(v3, Read64(p)); p += 8;
+			v4 = Round64(v4, Read64(p)); p += 8;
+		} while (p <= limit);
+
+		h = Rotl64(v1, 1) + Rotl64(v2, 7) + Rotl64(v3, 12) + Rotl64(v4, 18);
+		h = Merge64(h, v1);
+		h = Merge64(h, v2);
+		h = Merge64(h, v3);
+		h = Merge64(h, v4);
+	}
+	else
+	{
+		h = seed + PRIME64_5;
+	}
+
+	h += (unsigned __int64)size;
+
+	while (p + 8 <= end)
+	{
+		h ^= Round64(0, Read64(p));
+		h = Rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+		p += 8;
+	}
+
+	if (p + 4 <= end)
+	{
+		h ^= Read32(p) * PRIME64_1;
+		h = Rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+		p += 4;
+	}
+
+	while (p < end)
+	{
+		h ^= (*p) * PRIME64_5;
+		h = Rotl64(h, 11) * PRIME64_1;
+		++p;
+	}
+
+	h ^= h >> 33;
+	h *= PRIME64_2;
+	h ^= h >> 29;
+	h *= PRIME64_3;
+	h ^= h >> 32;
+	return h;
+}
@@ -0,0 +1,45 @@
+//
+// 2018-05-05, jjuiddong
+// Content Addressed Asset Cache
+//	- key = hash(source bytes) + converter name + converter version
+//	- write temporary file and rename, never read half written file
+//	- least recently used file removed when exceed maximum size
+//	  Find(), Store() file after previous Trim() never removed
+//	  (caller open returned file name later, texture loader worker)
+//
+#pragma once
+
+#include <mutex>
+
+
+namespace graphic
+{
+
+	class cAssetCache
+	{
+	public:
+		cAssetCache();
+		virtual ~cAssetCache();
+
+		bool Create(const char *directory, const unsigned __int64 maxSize = 256 * 1024 * 1024);
+		std::string GetKey(const char *srcFileName, const char *converter, const int version);
+		bool Find(const std::string &key, OUT std::string &outFileName);
+		bool Store(const std::string &key, const char *tmpFileName, OUT std::string &outFileName);
+		std::string GetTempFileName(const std::string &key);
+		unsigned __int64 Trim();
+		void Clear();
+
+		static unsigned __int64 Hash64(const void *data, const size_t size
+			, const unsigned __int64 seed = 0);
+
+
+	public:
+		std::string m_directory;
+		unsigned __int64 m_maxSize; // bytes
+		int m_hitCount;
+		int m_missCount;
+		FILETIME m_trimTime; // m_mutex, last Trim() start, newer file protect
+		std::mutex m_mutex; // Find() touch, Trim()
+	};
+
+}
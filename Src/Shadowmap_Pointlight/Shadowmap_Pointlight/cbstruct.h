@@ -0,0 +1,40 @@
+//
+// 2018-05-26, jjuiddong
+// Constant Buffer Structure
+//	- C++ side of .fx cbuffer, sample, tool shared
+//	- sCbGBuffer : gbuffer.h
+//
+#pragma once
+
+#include "renderqueue.h"
+
+
+// hlsl.fx, dirlight.fx cbDirLight, register(b6)
+struct sCbDirightPS
+{
+	XMVECTOR AmbientDown;
+	XMVECTOR AmbientRange;
+};
+
+// hlsl.fx cbPointLight, register(b8)
+struct sCbPointLight
+{
+	XMVECTOR PointLightPos;
+	XMVECTOR PointLightRangeRcp;
+	XMVECTOR PointColor;
+
+	XMMATRIX LightProjection;
+	XMVECTOR LightPerspectiveValues;
+};
+
+// shadowgen.fx cbShadowMapCubeGS, register(b6)
+struct sCbShadowmapCube
+{
+	XMMATRIX cubeViewProj[6];
+};
+
+// common.fx cbPerFrameInstancing, register(b3)
+struct sCbInstancing
+{
+	XMMATRIX worldInst[graphic::cRenderQueue::MAX_INSTANCE];
+};
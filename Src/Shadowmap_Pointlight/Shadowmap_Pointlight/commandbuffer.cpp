@@ -0,0 +1,300 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "commandbuffer.h"
+
+using namespace graphic;
+
+
+namespace
+{
+	struct sSetVertexBuffer
+	{
+		UINT count;
+		ID3D11Buffer *buffs[cCommandBuffer::MAX_STREAM];
+		UINT strides[cCommandBuffer::MAX_STREAM];
+	};
+
+	struct sSetIndexBuffer
+	{
+		ID3D11Buffer *buff;
+		DXGI_FORMAT format;
+	};
+
+	struct sUpdateBuffer
+	{
+		ID3D11Buffer *buff;
+		bool isDynamic; // Map(WRITE_DISCARD), else UpdateSubresource()
+		UINT size; // data follow
+	};
+
+	struct sSetVSConstantBuffer
+	{
+		UINT slot;
+		ID3D11Buffer *buff;
+	};
+
+	struct sDrawIndexedInstanced
+	{
+		UINT indexCount;
+		UINT instanceCount;
+		UINT startIndex;
+		int baseVertex;
+	};
+
+	struct sDrawIndexed
+	{
+		UINT indexCount;
+		UINT startIndex;
+		int baseVertex;
+	};
+
+	// command alignment, pointer size
+	inline UINT Align(const UINT size) {
+		return (size + sizeof(void*) - 1) & ~(UINT)(sizeof(void*) - 1);
+	}
+}
+
+
+cCommandBuffer::cCommandBuffer()
+	: m_size(0)
+	, m_commandCount(0)
+{
+}
+
+cCommandBuffer::~cCommandBuffer()
+{
+}
+
+
+// return command data pointer (after header)
+BYTE* cCommandBuffer::Push(const eCommand::Enum cmd, const UINT size)
+{
+	const UINT cmdSize = Align(sizeof(sHeader)) + Align(size);
+	if (m_size + cmdSize > m_stream.size())
+		m_stream.resize(max((size_t)(m_size + cmdSize), m_stream.size() * 2));
+
+	sHeader *header = (sHeader*)&m_stream[m_size];
+	header->cmd = cmd;
+	header->size = cmdSize;
+	BYTE *data = &m_stream[m_size + Align(sizeof(sHeader))];
+	m_size += cmdSize;
+	++m_commandCount;
+	return data;
+}
+
+
+void cCommandBuffer::SetVertexBuffer(ID3D11Buffer *buff, const UINT stride)
+{
+	SetVertexBuffers(1, &buff, &stride);
+}
+
+
+// slot 0 ~ count-1, offset 0
+void cCommandBuffer::SetVertexBuffers(const UINT count, ID3D11Buffer *const *buffs
+	, const UINT *strides)
+{
+	sSetVertexBuffer *cmd = (sSetVertexBuffer*)Push(eCommand::SET_VERTEXBUFFER
+		, sizeof(sSetVertexBuffer));
+	cmd->count = min(count, (UINT)MAX_STREAM);
+	for (UINT i = 0; i < cmd->count; ++i)
+	{
+		cmd->buffs[i] = buffs[i];
+		cmd->strides[i] = strides[i];
+	}
+}
+
+
+void cCommandBuffer::SetIndexBuffer(ID3D11Buffer *buff, const DXGI_FORMAT format)
+{
+	sSetIndexBuffer *cmd = (sSetIndexBuffer*)Push(eCommand::SET_INDEXBUFFER
+		, sizeof(sSetIndexBuffer));
+	cmd->buff = buff;
+	cmd->format = format;
+}
+
+
+void cCommandBuffer::SetInputLayout(ID3D11InputLayout *layout)
+{
+	ID3D11InputLayout **cmd = (ID3D11InputLayout**)Push(eCommand::SET_INPUTLAYOUT
+		, sizeof(ID3D11InputLayout*));
+	*cmd = layout;
+}
+
+
+void cCommandBuffer::SetVertexShader(ID3D11VertexShader *vs)
+{
+	ID3D11VertexShader **cmd = (ID3D11VertexShader**)Push(eCommand::SET_VERTEXSHADER
+		, sizeof(ID3D11VertexShader*));
+	*cmd = vs;
+}
+
+
+void cCommandBuffer::SetVSConstantBuffer(const UINT slot, ID3D11Buffer *buff)
+{
+	sSetVSConstantBuffer *cmd = (sSetVSConstantBuffer*)Push(eCommand::SET_VS_CONSTANTBUFFER
+		, sizeof(sSetVSConstantBuffer));
+	cmd->slot = slot;
+	cmd->buff = buff;
+}
+
+
+void cCommandBuffer::SetTopology(const D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	D3D11_PRIMITIVE_TOPOLOGY *cmd = (D3D11_PRIMITIVE_TOPOLOGY*)Push(eCommand::SET_TOPOLOGY
+		, sizeof(D3D11_PRIMITIVE_TOPOLOGY));
+	*cmd = topology;
+}
+
+
+// data copy to command stream, return stream data pointer
+// data NULL: caller write returned pointer, valid until next record
+// default usage buffer: size must be buffer size (UpdateSubresource, no box)
+BYTE* cCommandBuffer::UpdateBuffer(ID3D11Buffer *buff, const void *data, const UINT size)
+{
+	D3D11_BUFFER_DESC desc;
+	buff->GetDesc(&desc);
+
+	sUpdateBuffer *cmd = (sUpdateBuffer*)Push(eCommand::UPDATE_BUFFER
+		, sizeof(sUpdateBuffer) + size);
+	cmd->buff = buff;
+	cmd->isDynamic = (D3D11_USAGE_DYNAMIC == desc.Usage);
+	cmd->size = size;
+	if (data)
+		memcpy(cmd + 1, data, size);
+	return (BYTE*)(cmd + 1);
+}
+
+
+void cCommandBuffer::DrawIndexed(const UINT indexCount
+	, const UINT startIndex //= 0
+	, const int baseVertex //= 0
+)
+{
+	sDrawIndexed *cmd = (sDrawIndexed*)Push(eCommand::DRAW_INDEXED, sizeof(sDrawIndexed));
+	cmd->indexCount = indexCount;
+	cmd->startIndex = startIndex;
+	cmd->baseVertex = baseVertex;
+}
+
+
+void cCommandBuffer::DrawIndexedInstanced(const UINT indexCount, const UINT instanceCount
+	, const UINT startIndex //= 0
+	, const int baseVertex //= 0
+)
+{
+	sDrawIndexedInstanced *cmd = (sDrawIndexedInstanced*)Push(eCommand::DRAW_INDEXED_INSTANCED
+		, sizeof(sDrawIndexedInstanced));
+	cmd->indexCount = indexCount;
+	cmd->instanceCount = instanceCount;
+	cmd->startIndex = startIndex;
+	cmd->baseVertex = baseVertex;
+}
+
+
+// replay recorded command
+void cCommandBuffer::Execute(ID3D11DeviceContext *devContext)
+{
+	UINT offset = 0;
+	while (offset < m_size)
+	{
+		const sHeader *header = (const sHeader*)&m_stream[offset];
+		const BYTE *data = &m_stream[offset + Align(sizeof(sHeader))];
+
+		switch (header->cmd)
+		{
+		case eCommand::SET_VERTEXBUFFER:
+		{
+			const sSetVertexBuffer *cmd = (const sSetVertexBuffer*)data;
+			const UINT vtxOffsets[MAX_STREAM] = { 0, };
+			devContext->IASetVertexBuffers(0, cmd->count, cmd->buffs, cmd->strides, vtxOffsets);
+		}
+		break;
+
+		case eCommand::SET_INDEXBUFFER:
+		{
+			const sSetIndexBuffer *cmd = (const sSetIndexBuffer*)data;
+			devContext->IASetIndexBuffer(cmd->buff, cmd->format, 0);
+		}
+		break;
+
+		case eCommand::UPDATE_BUFFER:
+		{
+			const sUpdateBuffer *cmd = (const sUpdateBuffer*)data;
+			if (cmd->isDynamic)
+			{
+				D3D11_MAPPED_SUBRESOURCE res;
+				if (SUCCEEDED(devContext->Map(cmd->buff, 0, D3D11_MAP_WRITE_DISCARD, 0, &res)))
+				{
+					memcpy(res.pData, cmd + 1, cmd->size);
+					devContext->Unmap(cmd->buff, 0);
+				}
+			}
+			else
+			{
+				devContext->UpdateSubresource(cmd->buff, 0, NULL, cmd + 1, 0, 0);
+			}
+		}
+		break;
+
+		case eCommand::SET_INPUTLAYOUT:
+			devContext->IASetInputLayout(*(ID3D11InputLayout*const*)data);
+			break;
+
+		case eCommand::SET_VERTEXSHADER:
+			devContext->VSSetShader(*(ID3D11VertexShader*const*)data, NULL, 0);
+			break;
+
+		case eCommand::SET_VS_CONSTANTBUFFER:
+		{
+			const sSetVSConstantBuffer *cmd = (const sSetVSConstantBuffer*)data;
+			devContext->VSSetConstantBuffers(cmd->slot, 1, &cmd->buff);
+		}
+		break;
+
+		case eCommand::SET_TOPOLOGY:
+			devContext->IASetPrimitiveTopology(*(const D3D11_PRIMITIVE_TOPOLOGY*)data);
+			break;
+
+		case eCommand::DRAW_INDEXED:
+		{
+			const sDrawIndexed *cmd = (const sDrawIndexed*)data;
+			devContext->DrawIndexed(cmd->indexCount, cmd->startIndex, cmd->baseVertex);
+		}
+		break;
+
+		case eCommand::DRAW_INDEXED_INSTANCED:
+		{
+			const sDrawIndexedInstanced *cmd = (const sDrawIndexedInstanced*)data;
+			devContext->DrawIndexedInstanced(cmd->indexCount, cmd->instanceCount
+				, cmd->startIndex, cmd->baseVertex, 0);
+		}
+		break;
+		}
+
+		offset += header->size;
+	}
+}
+
+
+// keep memory, reuse next record
+void cCommandBuffer::Reset()
+{
+	m_size = 0;
+	m_commandCount = 0;
+}
+
+
+// bound constant buffer, UpdateBuffer() target
+// ex) cConstantBuffer::Update(renderer, slot) -> GetVSConstantBuffer(devContext, slot)
+// return pointer not AddRef, owner keep reference
+ID3D11Buffer* cCommandBuffer::GetVSConstantBuffer(ID3D11DeviceContext *devContext, const UINT slot)
+{
+	ID3D11Buffer *buff = NULL;
+	devContext->VSGetConstantBuffers(slot, 1, &buff);
+	if (buff)
+		buff->Release();
+	return buff;
+}
@@ -0,0 +1,64 @@
+//
+// 2018-05-09, jjuiddong
+// Portable Command Buffer
+//	- record draw command to CPU memory, any thread
+//	- Execute() replay to device context, render thread
+//	- D3D11 deferred context alternative, command stream can be
+//	  translated other backend
+//	- replay inherit device context state (effect pass, pipeline state),
+//	  recorded command override vertex stage, input assembler only
+//
+#pragma once
+
+
+namespace graphic
+{
+
+	class cCommandBuffer
+	{
+	public:
+		enum { MAX_STREAM = 2 };
+
+		struct eCommand {
+			enum Enum { SET_VERTEXBUFFER, SET_INDEXBUFFER, UPDATE_BUFFER, DRAW_INDEXED
+				, SET_INPUTLAYOUT, SET_VERTEXSHADER, SET_VS_CONSTANTBUFFER, SET_TOPOLOGY
+				, DRAW_INDEXED_INSTANCED };
+		};
+
+		struct sHeader
+		{
+			eCommand::Enum cmd;
+			UINT size; // command size, include header
+		};
+
+		cCommandBuffer();
+		virtual ~cCommandBuffer();
+
+		void SetVertexBuffer(ID3D11Buffer *buff, const UINT stride);
+		void SetVertexBuffers(const UINT count, ID3D11Buffer *const *buffs, const UINT *strides);
+		void SetIndexBuffer(ID3D11Buffer *buff, const DXGI_FORMAT format);
+		void SetInputLayout(ID3D11InputLayout *layout);
+		void SetVertexShader(ID3D11VertexShader *vs);
+		void SetVSConstantBuffer(const UINT slot, ID3D11Buffer *buff);
+		void SetTopology(const D3D11_PRIMITIVE_TOPOLOGY topology);
+		BYTE* UpdateBuffer(ID3D11Buffer *buff, const void *data, const UINT size);
+		void DrawIndexed(const UINT indexCount, const UINT startIndex = 0, const int baseVertex = 0);
+		void DrawIndexedInstanced(const UINT indexCount, const UINT instanceCount
+			, const UINT startIndex = 0, const int baseVertex = 0);
+		void Execute(ID3D11DeviceContext *devContext);
+		void Reset();
+
+		static ID3D11Buffer* GetVSConstantBuffer(ID3D11DeviceContext *devContext, const UINT slot);
+
+
+	protected:
+		BYTE* Push(const eCommand::Enum cmd, const UINT size);
+
+
+	public:
+		std::vector<BYTE> m_stream;
+		UINT m_size; // used stream size
+		int m_commandCount;
+	};
+
+}
@@ -0,0 +1,118 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "constantallocator.h"
+
+using namespace graphic;
+
+
+cConstantAllocator::cConstantAllocator()
+	: m_size(0)
+	, m_buff(NULL)
+	, m_devContext1(NULL)
+{
+}
+
+cConstantAllocator::~cConstantAllocator()
+{
+	Clear();
+}
+
+
+// size: maximum constant bytes per frame
+// return false if device not support constant buffer offset
+bool cConstantAllocator::Create(cRenderer &renderer
+	, const UINT size //= 64 * 1024
+)
+{
+	Clear();
+
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+	ZeroMemory(&options, sizeof(options));
+	HRESULT hr = renderer.GetDevice()->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS
+		, &options, sizeof(options));
+	RETV2(FAILED(hr) || !options.ConstantBufferOffsetting, false);
+
+	hr = renderer.GetDevContext()->QueryInterface(__uuidof(ID3D11DeviceContext1)
+		, (void**)&m_devContext1);
+	RETV2(FAILED(hr), false);
+
+	m_size = cConstantPacker::GetAlignSize(size);
+
+	D3D11_BUFFER_DESC bd;
+	ZeroMemory(&bd, sizeof(bd));
+	bd.ByteWidth = m_size;
+	bd.Usage = D3D11_USAGE_DYNAMIC;
+	bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	hr = renderer.GetDevice()->CreateBuffer(&bd, NULL, &m_buff);
+	RETV2(FAILED(hr), false);
+
+	return true;
+}
+
+
+// start frame allocation, discard previous frame
+bool cConstantAllocator::Begin(cRenderer &renderer)
+{
+	RETV2(!m_buff, false);
+	RETV2(m_packer.IsBegin(), false); // already begin
+
+	D3D11_MAPPED_SUBRESOURCE res;
+	HRESULT hr = renderer.GetDevContext()->Map(m_buff, 0, D3D11_MAP_WRITE_DISCARD, 0, &res);
+	RETV2(FAILED(hr), false);
+
+	return m_packer.Begin(res.pData, m_size);
+}
+
+
+// copy constant data, return buffer offset
+// return INVALID if buffer full or not Begin()
+UINT cConstantAllocator::Alloc(const void *data, const UINT size)
+{
+	return m_packer.Alloc(data, size);
+}
+
+
+void cConstantAllocator::End(cRenderer &renderer)
+{
+	if (!m_packer.IsBegin())
+		return;
+	renderer.GetDevContext()->Unmap(m_buff, 0);
+	m_packer.End();
+}
+
+
+// bind allocated range to all shader stage
+void cConstantAllocator::Bind(cRenderer &renderer, const int slot
+	, const UINT offset, const UINT size)
+{
+	if (!m_devContext1 || (INVALID == offset))
+		return;
+
+	// unit: shader constant (16 byte), count multiple of 16
+	const UINT firstConstant = offset / 16;
+	const UINT numConstants = cConstantPacker::GetAlignSize(size) / 16;
+	m_devContext1->VSSetConstantBuffers1(slot, 1, &m_buff, &firstConstant, &numConstants);
+	m_devContext1->HSSetConstantBuffers1(slot, 1, &m_buff, &firstConstant, &numConstants);
+	m_devContext1->DSSetConstantBuffers1(slot, 1, &m_buff, &firstConstant, &numConstants);
+	m_devContext1->GSSetConstantBuffers1(slot, 1, &m_buff, &firstConstant, &numConstants);
+	m_devContext1->PSSetConstantBuffers1(slot, 1, &m_buff, &firstConstant, &numConstants);
+}
+
+
+bool cConstantAllocator::IsSupport() const
+{
+	return m_buff && m_devContext1;
+}
+
+
+void cConstantAllocator::Clear()
+{
+	m_packer.End();
+	SAFE_RELEASE(m_buff);
+	SAFE_RELEASE(m_devContext1);
+	m_size = 0;
+}
@@ -0,0 +1,43 @@
+//
+// 2018-05-07, jjuiddong
+// Per Frame Linear Constant Buffer Allocator
+//	- one large dynamic constant buffer, Map(WRITE_DISCARD) once per frame
+//	  (driver rename buffer every discard, previous frame data not overwrite)
+//	- 256 byte aligned suballocation, bind with offset (D3D11.1 ConstantBufferOffsetting)
+//	- Begin() ~ Alloc() ~ End() before draw call, Bind() in render pass
+//	- suballocation, copy: cConstantPacker
+//
+#pragma once
+
+#include <d3d11_1.h>
+#include "constantpacker.h"
+
+
+namespace graphic
+{
+
+	class cConstantAllocator
+	{
+	public:
+		enum { ALIGN = cConstantPacker::ALIGN, INVALID = cConstantPacker::INVALID };
+
+		cConstantAllocator();
+		virtual ~cConstantAllocator();
+
+		bool Create(cRenderer &renderer, const UINT size = 64 * 1024);
+		bool Begin(cRenderer &renderer);
+		UINT Alloc(const void *data, const UINT size);
+		void End(cRenderer &renderer);
+		void Bind(cRenderer &renderer, const int slot, const UINT offset, const UINT size);
+		bool IsSupport() const;
+		void Clear();
+
+
+	public:
+		UINT m_size;
+		ID3D11Buffer *m_buff;
+		ID3D11DeviceContext1 *m_devContext1;
+		cConstantPacker m_packer; // mapped buffer, Begin() ~ End()
+	};
+
+}
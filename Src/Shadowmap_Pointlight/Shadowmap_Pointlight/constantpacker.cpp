@@ -0,0 +1,73 @@
+
+#include "../../Shared/platform.h"
+#include "constantpacker.h"
+#include <cstring>
+
+using namespace graphic;
+
+
+cConstantPacker::cConstantPacker()
+	: m_dest(NULL)
+	, m_size(0)
+	, m_offset(0)
+	, m_uploadBytes(0)
+	, m_allocCount(0)
+{
+}
+
+cConstantPacker::~cConstantPacker()
+{
+}
+
+
+// dest: size byte, 16 byte aligned
+bool cConstantPacker::Begin(void *dest, const UINT size)
+{
+	if (!dest || m_dest)
+		return false; // already begin
+
+	m_dest = (BYTE*)dest;
+	m_size = size;
+	m_offset = 0;
+	m_uploadBytes = 0;
+	m_allocCount = 0;
+	return true;
+}
+
+
+// copy constant data, return offset
+// return INVALID if buffer full or not Begin()
+UINT cConstantPacker::Alloc(const void *data, const UINT size)
+{
+	if (!m_dest)
+		return INVALID;
+
+	const UINT alignSize = GetAlignSize(size);
+	if (m_offset + alignSize > m_size)
+		return INVALID;
+
+	const UINT offset = m_offset;
+	memcpy(m_dest + offset, data, size);
+	m_offset += alignSize;
+	m_uploadBytes += size;
+	++m_allocCount;
+	return offset;
+}
+
+
+void cConstantPacker::End()
+{
+	m_dest = NULL;
+}
+
+
+bool cConstantPacker::IsBegin() const
+{
+	return m_dest != NULL;
+}
+
+
+UINT cConstantPacker::GetAlignSize(const UINT size)
+{
+	return (size + ALIGN - 1) & ~(ALIGN - 1);
+}
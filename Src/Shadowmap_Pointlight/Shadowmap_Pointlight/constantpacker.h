@@ -0,0 +1,39 @@
+//
+// 2018-05-26, jjuiddong
+// Constant Packer
+//	- linear 256 byte aligned constant suballocation to CPU memory
+//	  (mapped constant buffer, headless benchmark buffer)
+//	- Begin(dest) ~ Alloc() ~ End(), return offset
+//	- no D3D dependency, cConstantAllocator pack to mapped buffer
+//
+#pragma once
+
+
+namespace graphic
+{
+
+	class cConstantPacker
+	{
+	public:
+		enum { ALIGN = 256, INVALID = 0xffffffff };
+
+		cConstantPacker();
+		virtual ~cConstantPacker();
+
+		bool Begin(void *dest, const UINT size);
+		UINT Alloc(const void *data, const UINT size);
+		void End();
+		bool IsBegin() const;
+
+		static UINT GetAlignSize(const UINT size);
+
+
+	public:
+		BYTE *m_dest; // not NULL between Begin() ~ End()
+		UINT m_size;
+		UINT m_offset; // next allocation offset
+		UINT m_uploadBytes; // this frame, data bytes
+		UINT m_allocCount; // this frame
+	};
+
+}
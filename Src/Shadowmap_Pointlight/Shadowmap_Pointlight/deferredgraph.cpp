@@ -0,0 +1,51 @@
+
+#include "../../Shared/platform.h"
+#include "deferredgraph.h"
+
+using namespace graphic;
+
+
+// frame graph pass, resource, declare once
+// execute order = AddPass() order
+void graphic::CreateDeferredGraph(cFrameGraph &graph, const UINT width, const UINT height
+	, OUT sDeferredGraph &out)
+{
+	graph.Clear();
+
+	const UINT gbuffSize = width * height * 4;
+	const int shadowCube = graph.AddResource("ShadowCube", 1024 * 1024 * 6 * 4);
+	const int depth = graph.AddResource("GBuffer Depth", gbuffSize);
+	const int colorSpec = graph.AddResource("GBuffer ColorSpec", gbuffSize);
+	const int normal = graph.AddResource("GBuffer Normal", gbuffSize);
+	const int specPow = graph.AddResource("GBuffer SpecPow", gbuffSize);
+	out.backBuffer = graph.AddResource("BackBuffer", 0, false);
+	out.gbufferView = graph.AddResource("GBuffer View", 0, false);
+	graph.SetOutput(out.backBuffer);
+
+	out.shadowPass = graph.AddPass("Shadow");
+	graph.Write(out.shadowPass, shadowCube);
+
+	out.gbuffPass = graph.AddPass("GBuffer");
+	graph.Write(out.gbuffPass, depth);
+	graph.Write(out.gbuffPass, colorSpec);
+	graph.Write(out.gbuffPass, normal);
+	graph.Write(out.gbuffPass, specPow);
+
+	out.lightPass = graph.AddPass("Lighting");
+	graph.Read(out.lightPass, depth, 0);
+	graph.Read(out.lightPass, colorSpec, 1);
+	graph.Read(out.lightPass, normal, 2);
+	graph.Read(out.lightPass, specPow, 3);
+	graph.Read(out.lightPass, shadowCube, 4);
+	graph.Write(out.lightPass, out.backBuffer);
+
+	out.debugPass = graph.AddPass("GBuffer Debug");
+	graph.Read(out.debugPass, depth, 0);
+	graph.Read(out.debugPass, colorSpec, 1);
+	graph.Read(out.debugPass, normal, 2);
+	graph.Read(out.debugPass, specPow, 3);
+	graph.Write(out.debugPass, out.gbufferView);
+
+	out.compositePass = graph.AddPass("Composite");
+	graph.Write(out.compositePass, out.backBuffer);
+}
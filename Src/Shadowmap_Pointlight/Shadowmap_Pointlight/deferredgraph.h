@@ -0,0 +1,31 @@
+//
+// 2018-05-26, jjuiddong
+// Deferred Frame Graph
+//	- Shadow -> GBuffer -> Lighting -> (GBuffer Debug) -> Composite
+//	- pass, resource declare only, no D3D dependency
+//	- sample set pass function by cFrameGraph::SetExecute()
+//	- headless test, benchmark use same declaration
+//
+#pragma once
+
+#include "framegraph.h"
+
+
+namespace graphic
+{
+
+	struct sDeferredGraph
+	{
+		int shadowPass;
+		int gbuffPass;
+		int lightPass;
+		int debugPass; // culled if gbufferView not output
+		int compositePass;
+		int backBuffer;
+		int gbufferView;
+	};
+
+	void CreateDeferredGraph(cFrameGraph &graph, const UINT width, const UINT height
+		, OUT sDeferredGraph &out);
+
+}
@@ -0,0 +1,402 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "drawbenchmark.h"
+#include "../../Shared/steadytimer.h"
+
+using namespace graphic;
+
+
+namespace
+{
+	const UINT TARGET_SIZE = 256;
+	const UINT CUBE_INDEX_COUNT = 36;
+
+	struct sCbDrawBench
+	{
+		XMMATRIX world;
+		XMMATRIX viewProj;
+	};
+
+	// immediate context state, restore after benchmark
+	struct sStateBackup
+	{
+		ID3D11RenderTargetView *rtv;
+		ID3D11DepthStencilView *dsv;
+		D3D11_VIEWPORT viewport;
+		UINT viewportCount;
+		ID3D11InputLayout *layout;
+		D3D11_PRIMITIVE_TOPOLOGY topology;
+		ID3D11Buffer *vtxBuff;
+		UINT stride;
+		UINT offset;
+		ID3D11Buffer *idxBuff;
+		DXGI_FORMAT idxFormat;
+		UINT idxOffset;
+		ID3D11VertexShader *vs;
+		ID3D11PixelShader *ps;
+		ID3D11Buffer *vsCb;
+		ID3D11Buffer *psCb;
+
+		void Backup(ID3D11DeviceContext *devContext) {
+			devContext->OMGetRenderTargets(1, &rtv, &dsv);
+			viewportCount = 1;
+			devContext->RSGetViewports(&viewportCount, &viewport);
+			devContext->IAGetInputLayout(&layout);
+			devContext->IAGetPrimitiveTopology(&topology);
+			devContext->IAGetVertexBuffers(0, 1, &vtxBuff, &stride, &offset);
+			devContext->IAGetIndexBuffer(&idxBuff, &idxFormat, &idxOffset);
+			devContext->VSGetShader(&vs, NULL, NULL);
+			devContext->PSGetShader(&ps, NULL, NULL);
+			devContext->VSGetConstantBuffers(0, 1, &vsCb);
+			devContext->PSGetConstantBuffers(0, 1, &psCb);
+		}
+
+		void Restore(ID3D11DeviceContext *devContext) {
+			devContext->OMSetRenderTargets(1, &rtv, dsv);
+			if (viewportCount > 0)
+				devContext->RSSetViewports(1, &viewport);
+			devContext->IASetInputLayout(layout);
+			devContext->IASetPrimitiveTopology(topology);
+			devContext->IASetVertexBuffers(0, 1, &vtxBuff, &stride, &offset);
+			devContext->IASetIndexBuffer(idxBuff, idxFormat, idxOffset);
+			devContext->VSSetShader(vs, NULL, 0);
+			devContext->PSSetShader(ps, NULL, 0);
+			devContext->VSSetConstantBuffers(0, 1, &vsCb);
+			devContext->PSSetConstantBuffers(0, 1, &psCb);
+			SAFE_RELEASE(rtv);
+			SAFE_RELEASE(dsv);
+			SAFE_RELEASE(layout);
+			SAFE_RELEASE(vtxBuff);
+			SAFE_RELEASE(idxBuff);
+			SAFE_RELEASE(vs);
+			SAFE_RELEASE(ps);
+			SAFE_RELEASE(vsCb);
+			SAFE_RELEASE(psCb);
+		}
+	};
+
+	// drawIdx -> cube grid position
+	inline void GetDrawConstant(const int drawIdx, OUT sCbDrawBench &cb) {
+		const float x = (float)(drawIdx % 100) - 50.f;
+		const float z = (float)((drawIdx / 100) % 100) - 50.f;
+		const float y = (float)(drawIdx / 10000);
+		cb.world = XMMatrixTranspose(XMMatrixScaling(0.4f, 0.4f, 0.4f)
+			* XMMatrixTranslation(x, y, z));
+	}
+}
+
+
+cDrawBenchmark::cDrawBenchmark()
+	: m_effect(NULL)
+	, m_vs(NULL)
+	, m_ps(NULL)
+	, m_layout(NULL)
+	, m_vtxBuff(NULL)
+	, m_idxBuff(NULL)
+	, m_cbuffer(NULL)
+	, m_rtTex(NULL)
+	, m_rtv(NULL)
+	, m_dsTex(NULL)
+	, m_dsv(NULL)
+	, m_isDriverCommandList(false)
+{
+}
+
+cDrawBenchmark::~cDrawBenchmark()
+{
+	Clear();
+}
+
+
+// workerCount: cJobSystem::GetWorkerCount(), deferred context count
+bool cDrawBenchmark::Create(cRenderer &renderer, const int workerCount)
+{
+	Clear();
+
+	ID3D11Device *device = renderer.GetDevice();
+
+	// shader, extract from effect, no effect Apply() in worker thread
+	{
+		std::vector<BYTE> data;
+		FILE *fp = NULL;
+		if (fopen_s(&fp, "../Media/shadowmap_pointlight/drawbench.fxo", "rb") || !fp)
+			return false;
+		fseek(fp, 0, SEEK_END);
+		data.resize(max(0L, ftell(fp)));
+		fseek(fp, 0, SEEK_SET);
+		const size_t readSize = data.empty() ? 0 : fread(&data[0], 1, data.size(), fp);
+		fclose(fp);
+		RETV2(data.empty() || (readSize != data.size()), false);
+
+		HRESULT hr = D3DX11CreateEffectFromMemory(&data[0], data.size(), 0, device, &m_effect);
+		RETV2(FAILED(hr), false);
+
+		ID3DX11EffectPass *pass = m_effect->GetTechniqueByName("Unlit")->GetPassByIndex(0);
+		RETV2(!pass->IsValid(), false);
+
+		D3DX11_PASS_DESC passDesc;
+		D3DX11_PASS_SHADER_DESC vsDesc, psDesc;
+		pass->GetDesc(&passDesc);
+		pass->GetVertexShaderDesc(&vsDesc);
+		pass->GetPixelShaderDesc(&psDesc);
+		vsDesc.pShaderVariable->GetVertexShader(vsDesc.ShaderIndex, &m_vs);
+		psDesc.pShaderVariable->GetPixelShader(psDesc.ShaderIndex, &m_ps);
+		RETV2(!m_vs || !m_ps, false);
+
+		const D3D11_INPUT_ELEMENT_DESC elems[] = {
+			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		};
+		hr = device->CreateInputLayout(elems, ARRAYSIZE(elems), passDesc.pIAInputSignature
+			, passDesc.IAInputSignatureSize, &m_layout);
+		RETV2(FAILED(hr), false);
+	}
+
+	// cube
+	{
+		const float vertices[] = {
+			-1,-1,-1,  -1,1,-1,  1,1,-1,  1,-1,-1,
+			-1,-1,1,  -1,1,1,  1,1,1,  1,-1,1,
+		};
+		const WORD indices[CUBE_INDEX_COUNT] = {
+			0,1,2, 0,2,3, 4,6,5, 4,7,6, 4,5,1, 4,1,0,
+			3,2,6, 3,6,7, 1,5,6, 1,6,2, 4,0,3, 4,3,7,
+		};
+
+		D3D11_BUFFER_DESC bd;
+		ZeroMemory(&bd, sizeof(bd));
+		bd.Usage = D3D11_USAGE_IMMUTABLE;
+		D3D11_SUBRESOURCE_DATA initData;
+		ZeroMemory(&initData, sizeof(initData));
+
+		bd.ByteWidth = sizeof(vertices);
+		bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		initData.pSysMem = vertices;
+		RETV2(FAILED(device->CreateBuffer(&bd, &initData, &m_vtxBuff)), false);
+
+		bd.ByteWidth = sizeof(indices);
+		bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		initData.pSysMem = indices;
+		RETV2(FAILED(device->CreateBuffer(&bd, &initData, &m_idxBuff)), false);
+
+		// UpdateSubresource() every draw, DEFAULT usage
+		bd.Usage = D3D11_USAGE_DEFAULT;
+		bd.ByteWidth = sizeof(sCbDrawBench);
+		bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		RETV2(FAILED(device->CreateBuffer(&bd, NULL, &m_cbuffer)), false);
+	}
+
+	// offscreen target
+	{
+		D3D11_TEXTURE2D_DESC td;
+		ZeroMemory(&td, sizeof(td));
+		td.Width = TARGET_SIZE;
+		td.Height = TARGET_SIZE;
+		td.MipLevels = 1;
+		td.ArraySize = 1;
+		td.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		td.SampleDesc.Count = 1;
+		td.Usage = D3D11_USAGE_DEFAULT;
+		td.BindFlags = D3D11_BIND_RENDER_TARGET;
+		RETV2(FAILED(device->CreateTexture2D(&td, NULL, &m_rtTex)), false);
+		RETV2(FAILED(device->CreateRenderTargetView(m_rtTex, NULL, &m_rtv)), false);
+
+		td.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+		td.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+		RETV2(FAILED(device->CreateTexture2D(&td, NULL, &m_dsTex)), false);
+		RETV2(FAILED(device->CreateDepthStencilView(m_dsTex, NULL, &m_dsv)), false);
+	}
+
+	// deferred context, runtime emulate if driver not support command list
+	{
+		D3D11_FEATURE_DATA_THREADING threading;
+		ZeroMemory(&threading, sizeof(threading));
+		device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading));
+		m_isDriverCommandList = threading.DriverCommandLists ? true : false;
+
+		for (int i = 0; i < max(1, workerCount); ++i)
+		{
+			ID3D11DeviceContext *devContext = NULL;
+			RETV2(FAILED(device->CreateDeferredContext(0, &devContext)), false);
+			m_deferredContexts.push_back(devContext);
+		}
+	}
+
+	return true;
+}
+
+
+bool cDrawBenchmark::Run(cRenderer &renderer, cJobSystem &jobs, OUT sResult &out
+	, const int drawCount //= 10000
+)
+{
+	// deferred context per worker, not shared between thread
+	RETV2(!m_cbuffer || (jobs.GetWorkerCount() > (int)m_deferredContexts.size()), false);
+
+	ID3D11DeviceContext *devContext = renderer.GetDevContext();
+	const int workerCount = jobs.GetWorkerCount();
+	const int chunkCount = workerCount;
+	const int chunkSize = (drawCount + chunkCount - 1) / chunkCount;
+
+	ZeroMemory(&out, sizeof(out));
+	out.drawCount = drawCount;
+	out.threadCount = workerCount;
+	out.chunkCount = chunkCount;
+	out.isDriverCommandList = m_isDriverCommandList;
+
+	sStateBackup state;
+	state.Backup(devContext);
+
+	const float clearColor[4] = { 0, 0, 0, 1 };
+	devContext->ClearRenderTargetView(m_rtv, clearColor);
+	devContext->ClearDepthStencilView(m_dsv, D3D11_CLEAR_DEPTH, 1.f, 0);
+
+	// 1. immediate context, single thread
+	{
+		const double t0 = GetSteadyTimeMs();
+		SetState(devContext);
+		Record(devContext, 0, drawCount);
+		out.immediateMs = GetSteadyTimeMs() - t0;
+	}
+
+	// 2. deferred context, chunk per worker, execute chunk order
+	{
+		m_cmdLists.resize(chunkCount, NULL);
+
+		const double t0 = GetSteadyTimeMs();
+		jobs.ParallelFor(drawCount, chunkSize
+			, [&](const int begin, const int end, const int workerIdx)
+		{
+			ID3D11DeviceContext *deferred = m_deferredContexts[workerIdx];
+			SetState(deferred);
+			Record(deferred, begin, end);
+			deferred->FinishCommandList(FALSE, &m_cmdLists[begin / chunkSize]);
+		});
+		const double t1 = GetSteadyTimeMs();
+
+		for (auto &cmdList : m_cmdLists)
+		{
+			if (cmdList)
+				devContext->ExecuteCommandList(cmdList, TRUE);
+			SAFE_RELEASE(cmdList);
+		}
+		out.deferredRecordMs = t1 - t0;
+		out.deferredExecuteMs = GetSteadyTimeMs() - t1;
+	}
+
+	// 3. portable command buffer, parallel record, replay chunk order
+	{
+		m_cmdBuffers.resize(chunkCount);
+
+		double t0 = GetSteadyTimeMs();
+		for (int i = 0; i < chunkCount; ++i)
+		{
+			m_cmdBuffers[i].Reset();
+			Record(m_cmdBuffers[i], i * chunkSize, min(drawCount, (i + 1) * chunkSize));
+		}
+		out.recorderSingleMs = GetSteadyTimeMs() - t0;
+
+		t0 = GetSteadyTimeMs();
+		jobs.ParallelFor(drawCount, chunkSize
+			, [&](const int begin, const int end, const int workerIdx)
+		{
+			cCommandBuffer &cmdBuff = m_cmdBuffers[begin / chunkSize];
+			cmdBuff.Reset();
+			Record(cmdBuff, begin, end);
+		});
+		const double t1 = GetSteadyTimeMs();
+
+		SetState(devContext);
+		for (auto &cmdBuff : m_cmdBuffers)
+			cmdBuff.Execute(devContext);
+		out.recorderRecordMs = t1 - t0;
+		out.recorderReplayMs = GetSteadyTimeMs() - t1;
+	}
+
+	state.Restore(devContext);
+	return true;
+}
+
+
+// pipeline state, every command list start from default state
+void cDrawBenchmark::SetState(ID3D11DeviceContext *devContext)
+{
+	D3D11_VIEWPORT vp;
+	vp.TopLeftX = 0;
+	vp.TopLeftY = 0;
+	vp.Width = (float)TARGET_SIZE;
+	vp.Height = (float)TARGET_SIZE;
+	vp.MinDepth = 0;
+	vp.MaxDepth = 1;
+
+	const UINT stride = sizeof(float) * 3;
+	const UINT offset = 0;
+	devContext->OMSetRenderTargets(1, &m_rtv, m_dsv);
+	devContext->RSSetViewports(1, &vp);
+	devContext->IASetInputLayout(m_layout);
+	devContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	devContext->IASetVertexBuffers(0, 1, &m_vtxBuff, &stride, &offset);
+	devContext->IASetIndexBuffer(m_idxBuff, DXGI_FORMAT_R16_UINT, 0);
+	devContext->VSSetShader(m_vs, NULL, 0);
+	devContext->PSSetShader(m_ps, NULL, 0);
+	devContext->VSSetConstantBuffers(0, 1, &m_cbuffer);
+}
+
+
+void cDrawBenchmark::Record(ID3D11DeviceContext *devContext, const int begin, const int end)
+{
+	sCbDrawBench cb;
+	cb.viewProj = XMMatrixTranspose(
+		XMMatrixLookAtLH(XMVectorSet(0, 60, -80, 1), XMVectorSet(0, 0, 0, 1), XMVectorSet(0, 1, 0, 0))
+		* XMMatrixPerspectiveFovLH(MATH_PI / 4.f, 1.f, 0.1f, 1000.f));
+
+	for (int i = begin; i < end; ++i)
+	{
+		GetDrawConstant(i, cb);
+		devContext->UpdateSubresource(m_cbuffer, 0, NULL, &cb, 0, 0);
+		devContext->DrawIndexed(CUBE_INDEX_COUNT, 0, 0);
+	}
+}
+
+
+// same command with Record(devContext), replay state set by SetState()
+void cDrawBenchmark::Record(cCommandBuffer &cmdBuff, const int begin, const int end)
+{
+	sCbDrawBench cb;
+	cb.viewProj = XMMatrixTranspose(
+		XMMatrixLookAtLH(XMVectorSet(0, 60, -80, 1), XMVectorSet(0, 0, 0, 1), XMVectorSet(0, 1, 0, 0))
+		* XMMatrixPerspectiveFovLH(MATH_PI / 4.f, 1.f, 0.1f, 1000.f));
+
+	for (int i = begin; i < end; ++i)
+	{
+		GetDrawConstant(i, cb);
+		cmdBuff.UpdateBuffer(m_cbuffer, &cb, sizeof(cb));
+		cmdBuff.DrawIndexed(CUBE_INDEX_COUNT, 0, 0);
+	}
+}
+
+
+void cDrawBenchmark::Clear()
+{
+	for (auto &cmdList : m_cmdLists)
+		SAFE_RELEASE(cmdList);
+	m_cmdLists.clear();
+	for (auto &devContext : m_deferredContexts)
+		SAFE_RELEASE(devContext);
+	m_deferredContexts.clear();
+	m_cmdBuffers.clear();
+
+	SAFE_RELEASE(m_dsv);
+	SAFE_RELEASE(m_dsTex);
+	SAFE_RELEASE(m_rtv);
+	SAFE_RELEASE(m_rtTex);
+	SAFE_RELEASE(m_cbuffer);
+	SAFE_RELEASE(m_idxBuff);
+	SAFE_RELEASE(m_vtxBuff);
+	SAFE_RELEASE(m_layout);
+	SAFE_RELEASE(m_ps);
+	SAFE_RELEASE(m_vs);
+	SAFE_RELEASE(m_effect);
+}
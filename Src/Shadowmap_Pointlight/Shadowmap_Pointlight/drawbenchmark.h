@@ -0,0 +1,68 @@
+//
+// 2018-05-09, jjuiddong
+// Draw Call Benchmark
+//	- N cube draw, per draw constant buffer update
+//	- immediate context vs deferred context (job system, parallel record)
+//	  vs portable command buffer (parallel record, ordered replay)
+//	- render to offscreen target, CPU submission time only
+//
+#pragma once
+
+#include "jobsystem.h"
+#include "commandbuffer.h"
+
+
+namespace graphic
+{
+
+	class cDrawBenchmark
+	{
+	public:
+		struct sResult
+		{
+			int drawCount;
+			int threadCount;
+			int chunkCount;
+			bool isDriverCommandList; // false = runtime emulated command list
+			double immediateMs;
+			double deferredRecordMs;
+			double deferredExecuteMs;
+			double recorderSingleMs; // record 1 thread
+			double recorderRecordMs; // record all thread
+			double recorderReplayMs;
+		};
+
+		cDrawBenchmark();
+		virtual ~cDrawBenchmark();
+
+		bool Create(cRenderer &renderer, const int workerCount);
+		bool Run(cRenderer &renderer, cJobSystem &jobs, OUT sResult &out
+			, const int drawCount = 10000);
+		void Clear();
+
+
+	protected:
+		void SetState(ID3D11DeviceContext *devContext);
+		void Record(ID3D11DeviceContext *devContext, const int begin, const int end);
+		void Record(cCommandBuffer &cmdBuff, const int begin, const int end);
+
+
+	public:
+		ID3DX11Effect *m_effect;
+		ID3D11VertexShader *m_vs;
+		ID3D11PixelShader *m_ps;
+		ID3D11InputLayout *m_layout;
+		ID3D11Buffer *m_vtxBuff;
+		ID3D11Buffer *m_idxBuff;
+		ID3D11Buffer *m_cbuffer; // world, viewproj
+		ID3D11Texture2D *m_rtTex;
+		ID3D11RenderTargetView *m_rtv;
+		ID3D11Texture2D *m_dsTex;
+		ID3D11DepthStencilView *m_dsv;
+		std::vector<ID3D11DeviceContext*> m_deferredContexts; // one per worker
+		std::vector<ID3D11CommandList*> m_cmdLists; // one per chunk
+		std::vector<cCommandBuffer> m_cmdBuffers; // one per chunk
+		bool m_isDriverCommandList;
+	};
+
+}
@@ -0,0 +1,131 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "filewatcher.h"
+
+using namespace graphic;
+
+
+cFileWatcher::cFileWatcher()
+	: m_isRecursive(true)
+	, m_dir(INVALID_HANDLE_VALUE)
+	, m_event(NULL)
+	, m_cancelEvent(NULL)
+	, m_isPending(false)
+{
+	ZeroMemory(&m_overlapped, sizeof(m_overlapped));
+}
+
+cFileWatcher::~cFileWatcher()
+{
+	Clear();
+}
+
+
+bool cFileWatcher::Create(const char *directory
+	, const bool isRecursive //= true
+)
+{
+	Clear();
+
+	m_directory = directory;
+	m_isRecursive = isRecursive;
+	m_dir = CreateFileA(directory, FILE_LIST_DIRECTORY
+		, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING
+		, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+	RETV2(INVALID_HANDLE_VALUE == m_dir, false);
+
+	m_event = CreateEvent(NULL, TRUE, FALSE, NULL);
+	m_cancelEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	RETV2(!m_event || !m_cancelEvent, false);
+	return true;
+}
+
+
+// fileNames: changed file, clear and write
+// return changed file count, 0: timeout, -1: cancel or error
+// buffer overflow: fileNames = { "*" }, unknown change
+int cFileWatcher::Wait(const DWORD timeoutMs, OUT std::vector<std::string> &fileNames)
+{
+	fileNames.clear();
+	RETV2(INVALID_HANDLE_VALUE == m_dir, -1);
+
+	if (!m_isPending)
+	{
+		ZeroMemory(&m_overlapped, sizeof(m_overlapped));
+		m_overlapped.hEvent = m_event;
+		ResetEvent(m_event);
+		const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME;
+		RETV2(!ReadDirectoryChangesW(m_dir, m_buffer, sizeof(m_buffer), m_isRecursive
+			, filter, NULL, &m_overlapped, NULL), -1);
+		m_isPending = true;
+	}
+
+	HANDLE handles[2] = { m_event, m_cancelEvent };
+	const DWORD ret = WaitForMultipleObjects(2, handles, FALSE, timeoutMs);
+	if (WAIT_TIMEOUT == ret)
+		return 0;
+	RETV2(WAIT_OBJECT_0 != ret, -1);
+
+	DWORD bytes = 0;
+	m_isPending = false;
+	RETV2(!GetOverlappedResult(m_dir, &m_overlapped, &bytes, FALSE), -1);
+	if (0 == bytes)
+	{
+		fileNames.push_back("*");
+		return 1;
+	}
+
+	const BYTE *ptr = (const BYTE*)m_buffer;
+	while (1)
+	{
+		const FILE_NOTIFY_INFORMATION *info = (const FILE_NOTIFY_INFORMATION*)ptr;
+		char name[MAX_PATH];
+		const int len = WideCharToMultiByte(CP_ACP, 0, info->FileName
+			, info->FileNameLength / sizeof(WCHAR), name, sizeof(name) - 1, NULL, NULL);
+		name[max(0, len)] = '\0';
+		fileNames.push_back(name);
+
+		if (0 == info->NextEntryOffset)
+			break;
+		ptr += info->NextEntryOffset;
+	}
+	return (int)fileNames.size();
+}
+
+
+// wake up Wait(), another thread
+void cFileWatcher::Cancel()
+{
+	if (m_cancelEvent)
+		SetEvent(m_cancelEvent);
+}
+
+
+void cFileWatcher::Clear()
+{
+	if (m_isPending)
+	{
+		DWORD bytes = 0;
+		CancelIo(m_dir);
+		GetOverlappedResult(m_dir, &m_overlapped, &bytes, TRUE);
+		m_isPending = false;
+	}
+	if (INVALID_HANDLE_VALUE != m_dir)
+	{
+		CloseHandle(m_dir);
+		m_dir = INVALID_HANDLE_VALUE;
+	}
+	if (m_event)
+	{
+		CloseHandle(m_event);
+		m_event = NULL;
+	}
+	if (m_cancelEvent)
+	{
+		CloseHandle(m_cancelEvent);
+		m_cancelEvent = NULL;
+	}
+}
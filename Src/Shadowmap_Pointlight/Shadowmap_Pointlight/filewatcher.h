@@ -0,0 +1,37 @@
+//
+// 2018-05-23, jjuiddong
+// File Watcher
+//	- directory change notify, ReadDirectoryChangesW, overlapped io
+//	- Wait() block caller thread until change, timeout or Cancel()
+//	- changed file name relative to watch directory
+//
+#pragma once
+
+
+namespace graphic
+{
+
+	class cFileWatcher
+	{
+	public:
+		cFileWatcher();
+		virtual ~cFileWatcher();
+
+		bool Create(const char *directory, const bool isRecursive = true);
+		int Wait(const DWORD timeoutMs, OUT std::vector<std::string> &fileNames);
+		void Cancel();
+		void Clear();
+
+
+	public:
+		std::string m_directory;
+		bool m_isRecursive;
+		HANDLE m_dir;
+		HANDLE m_event; // overlapped io complete
+		HANDLE m_cancelEvent;
+		OVERLAPPED m_overlapped;
+		bool m_isPending; // ReadDirectoryChangesW() requested
+		DWORD m_buffer[4096]; // FILE_NOTIFY_INFORMATION, DWORD align
+	};
+
+}
@@ -0,0 +1,83 @@
+
+#include "../../Shared/platform.h"
+#include "framearena.h"
+#include <algorithm>
+
+using namespace graphic;
+
+
+cFrameArena::cFrameArena()
+	: m_buffer(NULL)
+	, m_size(0)
+	, m_offset(0)
+	, m_peak(0)
+	, m_overflowCount(0)
+{
+}
+
+cFrameArena::~cFrameArena()
+{
+	Clear();
+}
+
+
+bool cFrameArena::Create(
+	const UINT size //= 1024 * 1024
+)
+{
+	Clear();
+
+	m_buffer = (BYTE*)_aligned_malloc(size, 64);
+	if (!m_buffer)
+		return false;
+	m_size = size;
+	return true;
+}
+
+
+// return NULL if arena full
+// align: power of 2
+void* cFrameArena::Alloc(const UINT size
+	, const UINT align //= 16
+)
+{
+	if (!m_buffer)
+		return NULL;
+
+	const UINT offset = (m_offset + align - 1) & ~(align - 1);
+	if ((offset + size > m_size) || (offset + size < offset))
+	{
+		++m_overflowCount;
+		return NULL;
+	}
+
+	m_offset = offset + size;
+	m_peak = std::max(m_peak, m_offset);
+	return m_buffer + offset;
+}
+
+
+bool cFrameArena::IsOwner(const void *ptr) const
+{
+	return (ptr >= m_buffer) && (ptr < m_buffer + m_size);
+}
+
+
+// every frame begin, previous frame memory invalid
+void cFrameArena::Reset()
+{
+	m_offset = 0;
+	m_overflowCount = 0;
+}
+
+
+void cFrameArena::Clear()
+{
+	if (m_buffer)
+		_aligned_free(m_buffer);
+	m_buffer = NULL;
+	m_size = 0;
+	m_offset = 0;
+	m_peak = 0;
+	m_overflowCount = 0;
+}
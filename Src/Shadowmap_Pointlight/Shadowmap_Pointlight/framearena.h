@@ -0,0 +1,65 @@
+//
+// 2018-05-12, jjuiddong
+// Frame Arena
+//	- per frame bump allocator, Reset() every frame begin
+//	- no free, memory valid until next Reset()
+//	- cArenaAllocator, STL allocator, heap fallback if arena full
+//	- no Common dependency (Shared/platform.h)
+//
+#pragma once
+
+
+namespace graphic
+{
+
+	class cFrameArena
+	{
+	public:
+		cFrameArena();
+		virtual ~cFrameArena();
+
+		bool Create(const UINT size = 1024 * 1024);
+		void* Alloc(const UINT size, const UINT align = 16);
+		template<class T> T* Alloc(const UINT count) {
+			return (T*)Alloc(sizeof(T) * count, (UINT)__alignof(T));
+		}
+		bool IsOwner(const void *ptr) const;
+		void Reset();
+		void Clear();
+
+
+	public:
+		BYTE *m_buffer;
+		UINT m_size;
+		UINT m_offset; // used size
+		UINT m_peak; // maximum used size
+		int m_overflowCount; // Alloc() fail count, reset every frame
+	};
+
+
+	// std::vector<int, cArenaAllocator<int>> v(cArenaAllocator<int>(&arena));
+	template<class T>
+	class cArenaAllocator
+	{
+	public:
+		typedef T value_type;
+
+		cArenaAllocator(cFrameArena *arena = NULL) : m_arena(arena) {}
+		template<class U> cArenaAllocator(const cArenaAllocator<U> &rhs) : m_arena(rhs.m_arena) {}
+
+		T* allocate(const size_t n) {
+			void *p = m_arena ? m_arena->Alloc((UINT)(sizeof(T) * n), (UINT)__alignof(T)) : NULL;
+			return p ? (T*)p : (T*)::operator new(sizeof(T) * n);
+		}
+		void deallocate(T *p, const size_t) {
+			if (!m_arena || !m_arena->IsOwner(p))
+				::operator delete(p);
+		}
+
+		template<class U> bool operator==(const cArenaAllocator<U> &rhs) const { return m_arena == rhs.m_arena; }
+		template<class U> bool operator!=(const cArenaAllocator<U> &rhs) const { return m_arena != rhs.m_arena; }
+
+		cFrameArena *m_arena;
+	};
+
+}
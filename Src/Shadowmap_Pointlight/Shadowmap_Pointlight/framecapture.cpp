@@ -0,0 +1,1217 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "framecapture.h"
+#include <d3d11_1.h>
+
+using namespace graphic;
+
+
+namespace
+{
+	// ID3D11DeviceContext, ID3D11DeviceContext1 vtable index
+	// (d3d11.h, d3d11_1.h declaration order)
+	enum {
+		VT_VSSetConstantBuffers = 7
+		, VT_PSSetShaderResources = 8
+		, VT_PSSetShader = 9
+		, VT_PSSetSamplers = 10
+		, VT_VSSetShader = 11
+		, VT_DrawIndexed = 12
+		, VT_Draw = 13
+		, VT_Map = 14
+		, VT_Unmap = 15
+		, VT_PSSetConstantBuffers = 16
+		, VT_IASetInputLayout = 17
+		, VT_IASetVertexBuffers = 18
+		, VT_IASetIndexBuffer = 19
+		, VT_DrawIndexedInstanced = 20
+		, VT_DrawInstanced = 21
+		, VT_GSSetConstantBuffers = 22
+		, VT_GSSetShader = 23
+		, VT_IASetPrimitiveTopology = 24
+		, VT_VSSetShaderResources = 25
+		, VT_VSSetSamplers = 26
+		, VT_SetPredication = 30
+		, VT_GSSetShaderResources = 31
+		, VT_GSSetSamplers = 32
+		, VT_OMSetRenderTargets = 33
+		, VT_OMSetRenderTargetsAndUnorderedAccessViews = 34
+		, VT_OMSetBlendState = 35
+		, VT_OMSetDepthStencilState = 36
+		, VT_SOSetTargets = 37
+		, VT_DrawAuto = 38
+		, VT_DrawIndexedInstancedIndirect = 39
+		, VT_DrawInstancedIndirect = 40
+		, VT_Dispatch = 41
+		, VT_DispatchIndirect = 42
+		, VT_RSSetState = 43
+		, VT_RSSetViewports = 44
+		, VT_RSSetScissorRects = 45
+		, VT_CopySubresourceRegion = 46
+		, VT_CopyResource = 47
+		, VT_UpdateSubresource = 48
+		, VT_CopyStructureCount = 49
+		, VT_ClearRenderTargetView = 50
+		, VT_ClearUnorderedAccessViewUint = 51
+		, VT_ClearUnorderedAccessViewFloat = 52
+		, VT_ClearDepthStencilView = 53
+		, VT_GenerateMips = 54
+		, VT_SetResourceMinLOD = 55
+		, VT_ResolveSubresource = 57
+		, VT_ExecuteCommandList = 58
+		, VT_HSSetShaderResources = 59
+		, VT_HSSetShader = 60
+		, VT_HSSetSamplers = 61
+		, VT_HSSetConstantBuffers = 62
+		, VT_DSSetShaderResources = 63
+		, VT_DSSetShader = 64
+		, VT_DSSetSamplers = 65
+		, VT_DSSetConstantBuffers = 66
+		, VT_CSSetShaderResources = 67
+		, VT_CSSetUnorderedAccessViews = 68
+		, VT_CSSetShader = 69
+		, VT_CSSetSamplers = 70
+		, VT_CSSetConstantBuffers = 71
+		, VT_CONTEXT_MAX = 115 // ID3D11DeviceContext method count
+		, VT_CopySubresourceRegion1 = 115
+		, VT_UpdateSubresource1 = 116
+		, VT_VSSetConstantBuffers1 = 119
+		, VT_HSSetConstantBuffers1 = 120
+		, VT_DSSetConstantBuffers1 = 121
+		, VT_GSSetConstantBuffers1 = 122
+		, VT_PSSetConstantBuffers1 = 123
+		, VT_CSSetConstantBuffers1 = 124
+		, VT_ClearView = 132
+		, VT_MAX
+	};
+
+	cFrameCapture *g_capture = NULL;
+	void *g_orig[VT_MAX]; // original method
+	void **g_vtable = NULL;
+	int g_vtableSize = 0; // VT_CONTEXT_MAX or VT_MAX (ID3D11DeviceContext1)
+
+	template<class Fn> inline Fn Orig(const int idx) { return (Fn)g_orig[idx]; }
+
+	// record only hooked immediate context, deferred context share same vtable
+	inline bool IsRecord(ID3D11DeviceContext *ctx) {
+		return g_capture && (g_capture->m_devContext == ctx) && g_capture->IsCapture();
+	}
+
+	// start, count, object id array
+	template<class T>
+	void WriteSlot(const eCaptureCmd::Enum cmd, const UINT start, const UINT num
+		, T *const *objs, const eCaptureObject::Enum type)
+	{
+		UINT data[2 + D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+		const UINT count = min(num, (UINT)D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT);
+		data[0] = start;
+		data[1] = count;
+		for (UINT i = 0; i < count; ++i)
+			data[2 + i] = objs ? g_capture->GetObjectId(objs[i], type) : 0;
+		g_capture->Write(cmd, data, sizeof(UINT) * (2 + count));
+	}
+
+
+	//---------------------------------------------------------------------------------
+	// context hook
+	void STDMETHODCALLTYPE VSSetConstantBuffers(ID3D11DeviceContext *ctx, UINT start, UINT num
+		, ID3D11Buffer *const *buffs)
+	{
+		if (IsRecord(ctx))
+			WriteSlot(eCaptureCmd::VS_SET_CB, start, num, buffs, eCaptureObject::BUFFER);
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, UINT, ID3D11Buffer *const *);
+		Orig<Fn>(VT_VSSetConstantBuffers)(ctx, start, num, buffs);
+	}
+
+	void STDMETHODCALLTYPE PSSetConstantBuffers(ID3D11DeviceContext *ctx, UINT start, UINT num
+		, ID3D11Buffer *const *buffs)
+	{
+		if (IsRecord(ctx))
+			WriteSlot(eCaptureCmd::PS_SET_CB, start, num, buffs, eCaptureObject::BUFFER);
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, UINT, ID3D11Buffer *const *);
+		Orig<Fn>(VT_PSSetConstantBuffers)(ctx, start, num, buffs);
+	}
+
+	void STDMETHODCALLTYPE GSSetConstantBuffers(ID3D11DeviceContext *ctx, UINT start, UINT num
+		, ID3D11Buffer *const *buffs)
+	{
+		if (IsRecord(ctx))
+			WriteSlot(eCaptureCmd::GS_SET_CB, start, num, buffs, eCaptureObject::BUFFER);
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, UINT, ID3D11Buffer *const *);
+		Orig<Fn>(VT_GSSetConstantBuffers)(ctx, start, num, buffs);
+	}
+
+	void STDMETHODCALLTYPE PSSetShaderResources(ID3D11DeviceContext *ctx, UINT start, UINT num
+		, ID3D11ShaderResourceView *const *views)
+	{
+		if (IsRecord(ctx))
+			WriteSlot(eCaptureCmd::PS_SET_SRV, start, num, views, eCaptureObject::OTHER);
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, UINT, ID3D11ShaderResourceView *const *);
+		Orig<Fn>(VT_PSSetShaderResources)(ctx, start, num, views);
+	}
+
+	void STDMETHODCALLTYPE PSSetSamplers(ID3D11DeviceContext *ctx, UINT start, UINT num
+		, ID3D11SamplerState *const *samplers)
+	{
+		if (IsRecord(ctx))
+			WriteSlot(eCaptureCmd::PS_SET_SAMPLER, start, num, samplers, eCaptureObject::OTHER);
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, UINT, ID3D11SamplerState *const *);
+		Orig<Fn>(VT_PSSetSamplers)(ctx, start, num, samplers);
+	}
+
+	void STDMETHODCALLTYPE VSSetShader(ID3D11DeviceContext *ctx, ID3D11VertexShader *shader
+		, ID3D11ClassInstance *const *insts, UINT num)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT id = g_capture->GetObjectId(shader, eCaptureObject::OTHER);
+			g_capture->Write(eCaptureCmd::VS_SET_SHADER, &id, sizeof(id));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11VertexShader*, ID3D11ClassInstance *const *, UINT);
+		Orig<Fn>(VT_VSSetShader)(ctx, shader, insts, num);
+	}
+
+	void STDMETHODCALLTYPE PSSetShader(ID3D11DeviceContext *ctx, ID3D11PixelShader *shader
+		, ID3D11ClassInstance *const *insts, UINT num)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT id = g_capture->GetObjectId(shader, eCaptureObject::OTHER);
+			g_capture->Write(eCaptureCmd::PS_SET_SHADER, &id, sizeof(id));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11PixelShader*, ID3D11ClassInstance *const *, UINT);
+		Orig<Fn>(VT_PSSetShader)(ctx, shader, insts, num);
+	}
+
+	void STDMETHODCALLTYPE GSSetShader(ID3D11DeviceContext *ctx, ID3D11GeometryShader *shader
+		, ID3D11ClassInstance *const *insts, UINT num)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT id = g_capture->GetObjectId(shader, eCaptureObject::OTHER);
+			g_capture->Write(eCaptureCmd::GS_SET_SHADER, &id, sizeof(id));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11GeometryShader*, ID3D11ClassInstance *const *, UINT);
+		Orig<Fn>(VT_GSSetShader)(ctx, shader, insts, num);
+	}
+
+	void STDMETHODCALLTYPE DrawIndexed(ID3D11DeviceContext *ctx, UINT indexCount, UINT startIndex
+		, INT baseVertex)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT data[3] = { indexCount, startIndex, (UINT)baseVertex };
+			g_capture->Write(eCaptureCmd::DRAW_INDEXED, data, sizeof(data));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, UINT, INT);
+		Orig<Fn>(VT_DrawIndexed)(ctx, indexCount, startIndex, baseVertex);
+	}
+
+	void STDMETHODCALLTYPE Draw(ID3D11DeviceContext *ctx, UINT vertexCount, UINT startVertex)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT data[2] = { vertexCount, startVertex };
+			g_capture->Write(eCaptureCmd::DRAW, data, sizeof(data));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, UINT);
+		Orig<Fn>(VT_Draw)(ctx, vertexCount, startVertex);
+	}
+
+	void STDMETHODCALLTYPE DrawIndexedInstanced(ID3D11DeviceContext *ctx, UINT indexCount
+		, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT data[5] = { indexCount, instanceCount, startIndex, (UINT)baseVertex, startInstance };
+			g_capture->Write(eCaptureCmd::DRAW_INDEXED_INSTANCED, data, sizeof(data));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, UINT, UINT, INT, UINT);
+		Orig<Fn>(VT_DrawIndexedInstanced)(ctx, indexCount, instanceCount, startIndex, baseVertex, startInstance);
+	}
+
+	void STDMETHODCALLTYPE DrawInstanced(ID3D11DeviceContext *ctx, UINT vertexCount
+		, UINT instanceCount, UINT startVertex, UINT startInstance)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT data[4] = { vertexCount, instanceCount, startVertex, startInstance };
+			g_capture->Write(eCaptureCmd::DRAW_INSTANCED, data, sizeof(data));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, UINT, UINT, UINT);
+		Orig<Fn>(VT_DrawInstanced)(ctx, vertexCount, instanceCount, startVertex, startInstance);
+	}
+
+	HRESULT STDMETHODCALLTYPE Map(ID3D11DeviceContext *ctx, ID3D11Resource *res, UINT sub
+		, D3D11_MAP mapType, UINT flags, D3D11_MAPPED_SUBRESOURCE *mapped)
+	{
+		typedef HRESULT (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11Resource*, UINT, D3D11_MAP, UINT, D3D11_MAPPED_SUBRESOURCE*);
+		const HRESULT hr = Orig<Fn>(VT_Map)(ctx, res, sub, mapType, flags, mapped);
+		if (IsRecord(ctx) && SUCCEEDED(hr))
+		{
+			const UINT data[3] = { g_capture->GetResourceId(res), sub, (UINT)mapType };
+			g_capture->Write(eCaptureCmd::MAP, data, sizeof(data));
+
+			// constant buffer contents write at Unmap
+			D3D11_RESOURCE_DIMENSION dim;
+			res->GetType(&dim);
+			if (D3D11_RESOURCE_DIMENSION_BUFFER == dim)
+			{
+				D3D11_BUFFER_DESC desc;
+				((ID3D11Buffer*)res)->GetDesc(&desc);
+				if ((desc.BindFlags & D3D11_BIND_CONSTANT_BUFFER) && mapped)
+					g_capture->m_mapped[res] = std::make_pair(mapped->pData, desc.ByteWidth);
+			}
+		}
+		return hr;
+	}
+
+	void STDMETHODCALLTYPE Unmap(ID3D11DeviceContext *ctx, ID3D11Resource *res, UINT sub)
+	{
+		if (IsRecord(ctx))
+		{
+			UINT data[3] = { g_capture->GetResourceId(res), sub, 0 };
+			auto it = g_capture->m_mapped.find(res);
+			if (g_capture->m_mapped.end() != it)
+			{
+				data[2] = it->second.second;
+				g_capture->Write(eCaptureCmd::UNMAP, data, sizeof(data), it->second.first, data[2]);
+				g_capture->m_mapped.erase(it);
+			}
+			else
+			{
+				g_capture->Write(eCaptureCmd::UNMAP, data, sizeof(data));
+			}
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11Resource*, UINT);
+		Orig<Fn>(VT_Unmap)(ctx, res, sub);
+	}
+
+	void STDMETHODCALLTYPE UpdateSubresource(ID3D11DeviceContext *ctx, ID3D11Resource *res
+		, UINT sub, const D3D11_BOX *box, const void *src, UINT rowPitch, UINT depthPitch)
+	{
+		if (IsRecord(ctx))
+		{
+			// id, subresource, box(6), data size, data (constant buffer only)
+			UINT data[9] = { g_capture->GetResourceId(res), sub, 0, 0, 0, 0, 0, 0, 0 };
+			if (box)
+				memcpy(&data[2], box, sizeof(D3D11_BOX));
+
+			D3D11_RESOURCE_DIMENSION dim;
+			res->GetType(&dim);
+			if (D3D11_RESOURCE_DIMENSION_BUFFER == dim)
+			{
+				D3D11_BUFFER_DESC desc;
+				((ID3D11Buffer*)res)->GetDesc(&desc);
+				if (desc.BindFlags & D3D11_BIND_CONSTANT_BUFFER)
+					data[8] = box ? (box->right - box->left) : desc.ByteWidth;
+			}
+			g_capture->Write(eCaptureCmd::UPDATE_SUBRESOURCE, data, sizeof(data), src, data[8]);
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11Resource*, UINT, const D3D11_BOX*, const void*, UINT, UINT);
+		Orig<Fn>(VT_UpdateSubresource)(ctx, res, sub, box, src, rowPitch, depthPitch);
+	}
+
+	void STDMETHODCALLTYPE IASetInputLayout(ID3D11DeviceContext *ctx, ID3D11InputLayout *layout)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT id = g_capture->GetObjectId(layout, eCaptureObject::OTHER);
+			g_capture->Write(eCaptureCmd::IA_SET_LAYOUT, &id, sizeof(id));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11InputLayout*);
+		Orig<Fn>(VT_IASetInputLayout)(ctx, layout);
+	}
+
+	void STDMETHODCALLTYPE IASetVertexBuffers(ID3D11DeviceContext *ctx, UINT start, UINT num
+		, ID3D11Buffer *const *buffs, const UINT *strides, const UINT *offsets)
+	{
+		if (IsRecord(ctx))
+		{
+			// start, count, (id, stride, offset) x count
+			UINT data[2 + D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT * 3];
+			const UINT count = min(num, (UINT)D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT);
+			data[0] = start;
+			data[1] = count;
+			for (UINT i = 0; i < count; ++i)
+			{
+				data[2 + i * 3] = buffs ? g_capture->GetObjectId(buffs[i], eCaptureObject::BUFFER) : 0;
+				data[2 + i * 3 + 1] = strides ? strides[i] : 0;
+				data[2 + i * 3 + 2] = offsets ? offsets[i] : 0;
+			}
+			g_capture->Write(eCaptureCmd::IA_SET_VB, data, sizeof(UINT) * (2 + count * 3));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, UINT, ID3D11Buffer *const *, const UINT*, const UINT*);
+		Orig<Fn>(VT_IASetVertexBuffers)(ctx, start, num, buffs, strides, offsets);
+	}
+
+	void STDMETHODCALLTYPE IASetIndexBuffer(ID3D11DeviceContext *ctx, ID3D11Buffer *buff
+		, DXGI_FORMAT format, UINT offset)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT data[3] = { g_capture->GetObjectId(buff, eCaptureObject::BUFFER)
+				, (UINT)format, offset };
+			g_capture->Write(eCaptureCmd::IA_SET_IB, data, sizeof(data));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11Buffer*, DXGI_FORMAT, UINT);
+		Orig<Fn>(VT_IASetIndexBuffer)(ctx, buff, format, offset);
+	}
+
+	void STDMETHODCALLTYPE IASetPrimitiveTopology(ID3D11DeviceContext *ctx
+		, D3D11_PRIMITIVE_TOPOLOGY topology)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT data = (UINT)topology;
+			g_capture->Write(eCaptureCmd::IA_SET_TOPOLOGY, &data, sizeof(data));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, D3D11_PRIMITIVE_TOPOLOGY);
+		Orig<Fn>(VT_IASetPrimitiveTopology)(ctx, topology);
+	}
+
+	void STDMETHODCALLTYPE OMSetRenderTargets(ID3D11DeviceContext *ctx, UINT num
+		, ID3D11RenderTargetView *const *rtvs, ID3D11DepthStencilView *dsv)
+	{
+		if (IsRecord(ctx))
+		{
+			// dsv, count, rtv x count
+			UINT data[2 + D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
+			const UINT count = min(num, (UINT)D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT);
+			data[0] = g_capture->GetObjectId(dsv, eCaptureObject::OTHER);
+			data[1] = count;
+			for (UINT i = 0; i < count; ++i)
+				data[2 + i] = rtvs ? g_capture->GetObjectId(rtvs[i], eCaptureObject::OTHER) : 0;
+			g_capture->Write(eCaptureCmd::OM_SET_RT, data, sizeof(UINT) * (2 + count));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, ID3D11RenderTargetView *const *, ID3D11DepthStencilView*);
+		Orig<Fn>(VT_OMSetRenderTargets)(ctx, num, rtvs, dsv);
+	}
+
+	void STDMETHODCALLTYPE OMSetBlendState(ID3D11DeviceContext *ctx, ID3D11BlendState *state
+		, const FLOAT factor[4], UINT sampleMask)
+	{
+		if (IsRecord(ctx))
+		{
+			UINT data[6] = { g_capture->GetObjectId(state, eCaptureObject::BLEND), 0, 0, 0, 0, sampleMask };
+			if (factor)
+				memcpy(&data[1], factor, sizeof(FLOAT) * 4);
+			g_capture->Write(eCaptureCmd::OM_SET_BLEND, data, sizeof(data));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11BlendState*, const FLOAT[4], UINT);
+		Orig<Fn>(VT_OMSetBlendState)(ctx, state, factor, sampleMask);
+	}
+
+	void STDMETHODCALLTYPE OMSetDepthStencilState(ID3D11DeviceContext *ctx
+		, ID3D11DepthStencilState *state, UINT stencilRef)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT data[2] = { g_capture->GetObjectId(state, eCaptureObject::DEPTHSTENCIL), stencilRef };
+			g_capture->Write(eCaptureCmd::OM_SET_DEPTH, data, sizeof(data));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11DepthStencilState*, UINT);
+		Orig<Fn>(VT_OMSetDepthStencilState)(ctx, state, stencilRef);
+	}
+
+	void STDMETHODCALLTYPE RSSetState(ID3D11DeviceContext *ctx, ID3D11RasterizerState *state)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT id = g_capture->GetObjectId(state, eCaptureObject::RASTERIZER);
+			g_capture->Write(eCaptureCmd::RS_SET_STATE, &id, sizeof(id));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11RasterizerState*);
+		Orig<Fn>(VT_RSSetState)(ctx, state);
+	}
+
+	void STDMETHODCALLTYPE RSSetViewports(ID3D11DeviceContext *ctx, UINT num
+		, const D3D11_VIEWPORT *viewports)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT count = viewports ? min(num, (UINT)D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE) : 0;
+			g_capture->Write(eCaptureCmd::RS_SET_VIEWPORT, &count, sizeof(count)
+				, viewports, sizeof(D3D11_VIEWPORT) * count);
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, const D3D11_VIEWPORT*);
+		Orig<Fn>(VT_RSSetViewports)(ctx, num, viewports);
+	}
+
+	void STDMETHODCALLTYPE ClearRenderTargetView(ID3D11DeviceContext *ctx
+		, ID3D11RenderTargetView *rtv, const FLOAT color[4])
+	{
+		if (IsRecord(ctx))
+		{
+			UINT data[5] = { g_capture->GetObjectId(rtv, eCaptureObject::OTHER), 0, 0, 0, 0 };
+			memcpy(&data[1], color, sizeof(FLOAT) * 4);
+			g_capture->Write(eCaptureCmd::CLEAR_RTV, data, sizeof(data));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11RenderTargetView*, const FLOAT[4]);
+		Orig<Fn>(VT_ClearRenderTargetView)(ctx, rtv, color);
+	}
+
+	void STDMETHODCALLTYPE ClearDepthStencilView(ID3D11DeviceContext *ctx
+		, ID3D11DepthStencilView *dsv, UINT flags, FLOAT depth, UINT8 stencil)
+	{
+		if (IsRecord(ctx))
+		{
+			UINT data[4] = { g_capture->GetObjectId(dsv, eCaptureObject::OTHER), flags, 0, stencil };
+			memcpy(&data[2], &depth, sizeof(depth));
+			g_capture->Write(eCaptureCmd::CLEAR_DSV, data, sizeof(data));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11DepthStencilView*, UINT, FLOAT, UINT8);
+		Orig<Fn>(VT_ClearDepthStencilView)(ctx, dsv, flags, depth, stencil);
+	}
+
+	//---------------------------------------------------------------------------------
+	// other stage, same signature
+	// xxSetShaderResources, xxSetSamplers, xxSetConstantBuffers
+	template<int VT, eCaptureCmd::Enum CMD, class T, eCaptureObject::Enum TYPE>
+	void STDMETHODCALLTYPE SetSlot(ID3D11DeviceContext *ctx, UINT start, UINT num
+		, T *const *objs)
+	{
+		if (IsRecord(ctx))
+			WriteSlot(CMD, start, num, objs, TYPE);
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, UINT, T *const *);
+		Orig<Fn>(VT)(ctx, start, num, objs);
+	}
+
+	// xxSetShader
+	template<int VT, eCaptureCmd::Enum CMD, class T>
+	void STDMETHODCALLTYPE SetShader(ID3D11DeviceContext *ctx, T *shader
+		, ID3D11ClassInstance *const *insts, UINT num)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT id = g_capture->GetObjectId(shader, eCaptureObject::OTHER);
+			g_capture->Write(CMD, &id, sizeof(id));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, T*, ID3D11ClassInstance *const *, UINT);
+		Orig<Fn>(VT)(ctx, shader, insts, num);
+	}
+
+	// xxSetConstantBuffers1, ID3D11DeviceContext1 (cConstantAllocator)
+	// start, count, isRange, (id, first constant, constant count) x count
+	template<int VT, eCaptureCmd::Enum CMD>
+	void STDMETHODCALLTYPE SetConstantBuffers1(ID3D11DeviceContext1 *ctx, UINT start, UINT num
+		, ID3D11Buffer *const *buffs, const UINT *firsts, const UINT *nums)
+	{
+		if (IsRecord(ctx))
+		{
+			UINT data[3 + D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT * 3];
+			const UINT count = min(num, (UINT)D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+			data[0] = start;
+			data[1] = count;
+			data[2] = (firsts && nums) ? 1 : 0;
+			for (UINT i = 0; i < count; ++i)
+			{
+				data[3 + i * 3] = buffs ? g_capture->GetObjectId(buffs[i], eCaptureObject::BUFFER) : 0;
+				data[3 + i * 3 + 1] = firsts ? firsts[i] : 0;
+				data[3 + i * 3 + 2] = nums ? nums[i] : 0;
+			}
+			g_capture->Write(CMD, data, sizeof(UINT) * (3 + count * 3));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext1*, UINT, UINT, ID3D11Buffer *const *, const UINT*, const UINT*);
+		Orig<Fn>(VT)(ctx, start, num, buffs, firsts, nums);
+	}
+
+	// start, count, (id, initial count) x count
+	void STDMETHODCALLTYPE CSSetUnorderedAccessViews(ID3D11DeviceContext *ctx, UINT start, UINT num
+		, ID3D11UnorderedAccessView *const *uavs, const UINT *initialCounts)
+	{
+		if (IsRecord(ctx))
+		{
+			UINT data[2 + D3D11_1_UAV_SLOT_COUNT * 2];
+			const UINT count = min(num, (UINT)D3D11_1_UAV_SLOT_COUNT);
+			data[0] = start;
+			data[1] = count;
+			for (UINT i = 0; i < count; ++i)
+			{
+				data[2 + i * 2] = uavs ? g_capture->GetObjectId(uavs[i], eCaptureObject::OTHER) : 0;
+				data[2 + i * 2 + 1] = initialCounts ? initialCounts[i] : (UINT)-1;
+			}
+			g_capture->Write(eCaptureCmd::CS_SET_UAV, data, sizeof(UINT) * (2 + count * 2));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, UINT, ID3D11UnorderedAccessView *const *, const UINT*);
+		Orig<Fn>(VT_CSSetUnorderedAccessViews)(ctx, start, num, uavs, initialCounts);
+	}
+
+	// indirect argument read back, staging buffer copy (CPU stall)
+	// original method call, not recorded
+	bool ReadBuffer(ID3D11DeviceContext *ctx, ID3D11Buffer *buff, const UINT offset
+		, const UINT size, OUT void *dst)
+	{
+		RETV2(!buff, false);
+		ID3D11Device *device = NULL;
+		ctx->GetDevice(&device);
+
+		D3D11_BUFFER_DESC bd;
+		ZeroMemory(&bd, sizeof(bd));
+		bd.ByteWidth = size;
+		bd.Usage = D3D11_USAGE_STAGING;
+		bd.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+		ID3D11Buffer *staging = NULL;
+		const HRESULT hr = device->CreateBuffer(&bd, NULL, &staging);
+		device->Release();
+		RETV2(FAILED(hr), false);
+
+		typedef void (STDMETHODCALLTYPE *CopyFn)(ID3D11DeviceContext*, ID3D11Resource*, UINT, UINT, UINT, UINT, ID3D11Resource*, UINT, const D3D11_BOX*);
+		typedef HRESULT (STDMETHODCALLTYPE *MapFn)(ID3D11DeviceContext*, ID3D11Resource*, UINT, D3D11_MAP, UINT, D3D11_MAPPED_SUBRESOURCE*);
+		typedef void (STDMETHODCALLTYPE *UnmapFn)(ID3D11DeviceContext*, ID3D11Resource*, UINT);
+		const D3D11_BOX box = { offset, 0, 0, offset + size, 1, 1 };
+		Orig<CopyFn>(VT_CopySubresourceRegion)(ctx, staging, 0, 0, 0, 0, buff, 0, &box);
+
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		const bool isRead = SUCCEEDED(Orig<MapFn>(VT_Map)(ctx, staging, 0, D3D11_MAP_READ, 0, &mapped));
+		if (isRead)
+		{
+			memcpy(dst, mapped.pData, size);
+			Orig<UnmapFn>(VT_Unmap)(ctx, staging, 0);
+		}
+		staging->Release();
+		return isRead;
+	}
+
+	// argument buffer id, offset, argument (read back)
+	// argCount: UINT count, DrawIndexedInstanced 5, DrawInstanced 4, Dispatch 3
+	void WriteIndirect(ID3D11DeviceContext *ctx, const eCaptureCmd::Enum cmd, const char *method
+		, ID3D11Buffer *args, const UINT offset, const UINT argCount)
+	{
+		UINT data[2 + 5] = { g_capture->GetObjectId(args, eCaptureObject::BUFFER), offset, };
+		if (ReadBuffer(ctx, args, offset, sizeof(UINT) * argCount, &data[2]))
+			g_capture->Write(cmd, data, sizeof(UINT) * (2 + argCount));
+		else
+			g_capture->Fail(method);
+	}
+
+	void STDMETHODCALLTYPE DrawIndexedInstancedIndirect(ID3D11DeviceContext *ctx
+		, ID3D11Buffer *args, UINT offset)
+	{
+		if (IsRecord(ctx))
+			WriteIndirect(ctx, eCaptureCmd::DRAW_INDEXED_INSTANCED_INDIRECT
+				, "DrawIndexedInstancedIndirect", args, offset, 5);
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11Buffer*, UINT);
+		Orig<Fn>(VT_DrawIndexedInstancedIndirect)(ctx, args, offset);
+	}
+
+	void STDMETHODCALLTYPE DrawInstancedIndirect(ID3D11DeviceContext *ctx
+		, ID3D11Buffer *args, UINT offset)
+	{
+		if (IsRecord(ctx))
+			WriteIndirect(ctx, eCaptureCmd::DRAW_INSTANCED_INDIRECT
+				, "DrawInstancedIndirect", args, offset, 4);
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11Buffer*, UINT);
+		Orig<Fn>(VT_DrawInstancedIndirect)(ctx, args, offset);
+	}
+
+	void STDMETHODCALLTYPE Dispatch(ID3D11DeviceContext *ctx, UINT x, UINT y, UINT z)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT data[3] = { x, y, z };
+			g_capture->Write(eCaptureCmd::DISPATCH, data, sizeof(data));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, UINT, UINT);
+		Orig<Fn>(VT_Dispatch)(ctx, x, y, z);
+	}
+
+	void STDMETHODCALLTYPE DispatchIndirect(ID3D11DeviceContext *ctx
+		, ID3D11Buffer *args, UINT offset)
+	{
+		if (IsRecord(ctx))
+			WriteIndirect(ctx, eCaptureCmd::DISPATCH_INDIRECT, "DispatchIndirect", args, offset, 3);
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11Buffer*, UINT);
+		Orig<Fn>(VT_DispatchIndirect)(ctx, args, offset);
+	}
+
+	void STDMETHODCALLTYPE OMSetRenderTargetsAndUnorderedAccessViews(ID3D11DeviceContext *ctx
+		, UINT numRTV, ID3D11RenderTargetView *const *rtvs, ID3D11DepthStencilView *dsv
+		, UINT uavStart, UINT numUAV, ID3D11UnorderedAccessView *const *uavs
+		, const UINT *initialCounts)
+	{
+		if (IsRecord(ctx))
+		{
+			// rtv count (KEEP), dsv, rtv x count, uav start, uav count (KEEP)
+			// , (uav, initial count) x count
+			UINT data[2 + D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT + 2 + D3D11_1_UAV_SLOT_COUNT * 2];
+			const UINT rtvCount = (D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL == numRTV) ?
+				0 : min(numRTV, (UINT)D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT);
+			const UINT uavCount = (D3D11_KEEP_UNORDERED_ACCESS_VIEWS == numUAV) ?
+				0 : min(numUAV, (UINT)D3D11_1_UAV_SLOT_COUNT);
+			UINT n = 0;
+			data[n++] = (D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL == numRTV) ? numRTV : rtvCount;
+			data[n++] = g_capture->GetObjectId(dsv, eCaptureObject::OTHER);
+			for (UINT i = 0; i < rtvCount; ++i)
+				data[n++] = rtvs ? g_capture->GetObjectId(rtvs[i], eCaptureObject::OTHER) : 0;
+			data[n++] = uavStart;
+			data[n++] = (D3D11_KEEP_UNORDERED_ACCESS_VIEWS == numUAV) ? numUAV : uavCount;
+			for (UINT i = 0; i < uavCount; ++i)
+			{
+				data[n++] = uavs ? g_capture->GetObjectId(uavs[i], eCaptureObject::OTHER) : 0;
+				data[n++] = initialCounts ? initialCounts[i] : (UINT)-1;
+			}
+			g_capture->Write(eCaptureCmd::OM_SET_RT_UAV, data, sizeof(UINT) * n);
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, ID3D11RenderTargetView *const *
+			, ID3D11DepthStencilView*, UINT, UINT, ID3D11UnorderedAccessView *const *, const UINT*);
+		Orig<Fn>(VT_OMSetRenderTargetsAndUnorderedAccessViews)(ctx, numRTV, rtvs, dsv
+			, uavStart, numUAV, uavs, initialCounts);
+	}
+
+	void STDMETHODCALLTYPE RSSetScissorRects(ID3D11DeviceContext *ctx, UINT num
+		, const D3D11_RECT *rects)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT count = rects ? min(num, (UINT)D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE) : 0;
+			g_capture->Write(eCaptureCmd::RS_SET_SCISSOR, &count, sizeof(count)
+				, rects, sizeof(D3D11_RECT) * count);
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, const D3D11_RECT*);
+		Orig<Fn>(VT_RSSetScissorRects)(ctx, num, rects);
+	}
+
+	void STDMETHODCALLTYPE CopyResource(ID3D11DeviceContext *ctx, ID3D11Resource *dst
+		, ID3D11Resource *src)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT data[2] = { g_capture->GetResourceId(dst), g_capture->GetResourceId(src) };
+			g_capture->Write(eCaptureCmd::COPY_RESOURCE, data, sizeof(data));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11Resource*, ID3D11Resource*);
+		Orig<Fn>(VT_CopyResource)(ctx, dst, src);
+	}
+
+	void STDMETHODCALLTYPE CopySubresourceRegion(ID3D11DeviceContext *ctx, ID3D11Resource *dst
+		, UINT dstSub, UINT x, UINT y, UINT z, ID3D11Resource *src, UINT srcSub
+		, const D3D11_BOX *box)
+	{
+		if (IsRecord(ctx))
+		{
+			// dst id, dst subresource, x, y, z, src id, src subresource, box(6), 0 box: NULL
+			UINT data[13] = { g_capture->GetResourceId(dst), dstSub, x, y, z
+				, g_capture->GetResourceId(src), srcSub, 0, 0, 0, 0, 0, 0 };
+			if (box)
+				memcpy(&data[7], box, sizeof(D3D11_BOX));
+			g_capture->Write(eCaptureCmd::COPY_SUBRESOURCE_REGION, data, sizeof(data));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11Resource*, UINT, UINT, UINT, UINT, ID3D11Resource*, UINT, const D3D11_BOX*);
+		Orig<Fn>(VT_CopySubresourceRegion)(ctx, dst, dstSub, x, y, z, src, srcSub, box);
+	}
+
+	void STDMETHODCALLTYPE CopyStructureCount(ID3D11DeviceContext *ctx, ID3D11Buffer *dst
+		, UINT offset, ID3D11UnorderedAccessView *src)
+	{
+		if (IsRecord(ctx))
+		{
+			const UINT data[3] = { g_capture->GetObjectId(dst, eCaptureObject::BUFFER), offset
+				, g_capture->GetObjectId(src, eCaptureObject::OTHER) };
+			g_capture->Write(eCaptureCmd::COPY_STRUCTURE_COUNT, data, sizeof(data));
+		}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11Buffer*, UINT, ID3D11UnorderedAccessView*);
+		Orig<Fn>(VT_CopyStructureCount)(ctx, dst, offset, src);
+	}
+
+
+	//---------------------------------------------------------------------------------
+	// not recorded state change, resource write, capture stop (cFrameCapture::Fail)
+	void STDMETHODCALLTYPE SetPredication(ID3D11DeviceContext *ctx, ID3D11Predicate *pred
+		, BOOL value)
+	{
+		if (IsRecord(ctx) && pred)
+			g_capture->Fail("SetPredication");
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11Predicate*, BOOL);
+		Orig<Fn>(VT_SetPredication)(ctx, pred, value);
+	}
+
+	void STDMETHODCALLTYPE SOSetTargets(ID3D11DeviceContext *ctx, UINT num
+		, ID3D11Buffer *const *buffs, const UINT *offsets)
+	{
+		if (IsRecord(ctx) && buffs)
+			for (UINT i = 0; i < num; ++i)
+				if (buffs[i])
+				{
+					g_capture->Fail("SOSetTargets");
+					break;
+				}
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, UINT, ID3D11Buffer *const *, const UINT*);
+		Orig<Fn>(VT_SOSetTargets)(ctx, num, buffs, offsets);
+	}
+
+	void STDMETHODCALLTYPE DrawAuto(ID3D11DeviceContext *ctx)
+	{
+		if (IsRecord(ctx))
+			g_capture->Fail("DrawAuto");
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*);
+		Orig<Fn>(VT_DrawAuto)(ctx);
+	}
+
+	void STDMETHODCALLTYPE ClearUnorderedAccessViewUint(ID3D11DeviceContext *ctx
+		, ID3D11UnorderedAccessView *uav, const UINT values[4])
+	{
+		if (IsRecord(ctx))
+			g_capture->Fail("ClearUnorderedAccessViewUint");
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11UnorderedAccessView*, const UINT[4]);
+		Orig<Fn>(VT_ClearUnorderedAccessViewUint)(ctx, uav, values);
+	}
+
+	void STDMETHODCALLTYPE ClearUnorderedAccessViewFloat(ID3D11DeviceContext *ctx
+		, ID3D11UnorderedAccessView *uav, const FLOAT values[4])
+	{
+		if (IsRecord(ctx))
+			g_capture->Fail("ClearUnorderedAccessViewFloat");
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11UnorderedAccessView*, const FLOAT[4]);
+		Orig<Fn>(VT_ClearUnorderedAccessViewFloat)(ctx, uav, values);
+	}
+
+	void STDMETHODCALLTYPE GenerateMips(ID3D11DeviceContext *ctx, ID3D11ShaderResourceView *srv)
+	{
+		if (IsRecord(ctx))
+			g_capture->Fail("GenerateMips");
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11ShaderResourceView*);
+		Orig<Fn>(VT_GenerateMips)(ctx, srv);
+	}
+
+	void STDMETHODCALLTYPE SetResourceMinLOD(ID3D11DeviceContext *ctx, ID3D11Resource *res
+		, FLOAT minLod)
+	{
+		if (IsRecord(ctx))
+			g_capture->Fail("SetResourceMinLOD");
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11Resource*, FLOAT);
+		Orig<Fn>(VT_SetResourceMinLOD)(ctx, res, minLod);
+	}
+
+	void STDMETHODCALLTYPE ResolveSubresource(ID3D11DeviceContext *ctx, ID3D11Resource *dst
+		, UINT dstSub, ID3D11Resource *src, UINT srcSub, DXGI_FORMAT format)
+	{
+		if (IsRecord(ctx))
+			g_capture->Fail("ResolveSubresource");
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11Resource*, UINT, ID3D11Resource*, UINT, DXGI_FORMAT);
+		Orig<Fn>(VT_ResolveSubresource)(ctx, dst, dstSub, src, srcSub, format);
+	}
+
+	// deferred context command not recorded
+	void STDMETHODCALLTYPE ExecuteCommandList(ID3D11DeviceContext *ctx, ID3D11CommandList *cmdList
+		, BOOL restoreState)
+	{
+		if (IsRecord(ctx))
+			g_capture->Fail("ExecuteCommandList");
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext*, ID3D11CommandList*, BOOL);
+		Orig<Fn>(VT_ExecuteCommandList)(ctx, cmdList, restoreState);
+	}
+
+	void STDMETHODCALLTYPE CopySubresourceRegion1(ID3D11DeviceContext1 *ctx, ID3D11Resource *dst
+		, UINT dstSub, UINT x, UINT y, UINT z, ID3D11Resource *src, UINT srcSub
+		, const D3D11_BOX *box, UINT flags)
+	{
+		if (IsRecord(ctx))
+			g_capture->Fail("CopySubresourceRegion1");
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext1*, ID3D11Resource*, UINT, UINT, UINT, UINT, ID3D11Resource*, UINT, const D3D11_BOX*, UINT);
+		Orig<Fn>(VT_CopySubresourceRegion1)(ctx, dst, dstSub, x, y, z, src, srcSub, box, flags);
+	}
+
+	void STDMETHODCALLTYPE UpdateSubresource1(ID3D11DeviceContext1 *ctx, ID3D11Resource *res
+		, UINT sub, const D3D11_BOX *box, const void *src, UINT rowPitch, UINT depthPitch
+		, UINT flags)
+	{
+		if (IsRecord(ctx))
+			g_capture->Fail("UpdateSubresource1");
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext1*, ID3D11Resource*, UINT, const D3D11_BOX*, const void*, UINT, UINT, UINT);
+		Orig<Fn>(VT_UpdateSubresource1)(ctx, res, sub, box, src, rowPitch, depthPitch, flags);
+	}
+
+	void STDMETHODCALLTYPE ClearView(ID3D11DeviceContext1 *ctx, ID3D11View *view
+		, const FLOAT color[4], const D3D11_RECT *rects, UINT num)
+	{
+		if (IsRecord(ctx))
+			g_capture->Fail("ClearView");
+		typedef void (STDMETHODCALLTYPE *Fn)(ID3D11DeviceContext1*, ID3D11View*, const FLOAT[4], const D3D11_RECT*, UINT);
+		Orig<Fn>(VT_ClearView)(ctx, view, color, rects, num);
+	}
+
+	const struct sHook {
+		int idx;
+		void *func;
+	} g_hooks[] = {
+		{ VT_VSSetConstantBuffers, (void*)&VSSetConstantBuffers }
+		, { VT_PSSetShaderResources, (void*)&PSSetShaderResources }
+		, { VT_PSSetShader, (void*)&PSSetShader }
+		, { VT_PSSetSamplers, (void*)&PSSetSamplers }
+		, { VT_VSSetShader, (void*)&VSSetShader }
+		, { VT_DrawIndexed, (void*)&DrawIndexed }
+		, { VT_Draw, (void*)&Draw }
+		, { VT_Map, (void*)&Map }
+		, { VT_Unmap, (void*)&Unmap }
+		, { VT_PSSetConstantBuffers, (void*)&PSSetConstantBuffers }
+		, { VT_IASetInputLayout, (void*)&IASetInputLayout }
+		, { VT_IASetVertexBuffers, (void*)&IASetVertexBuffers }
+		, { VT_IASetIndexBuffer, (void*)&IASetIndexBuffer }
+		, { VT_DrawIndexedInstanced, (void*)&DrawIndexedInstanced }
+		, { VT_DrawInstanced, (void*)&DrawInstanced }
+		, { VT_GSSetConstantBuffers, (void*)&GSSetConstantBuffers }
+		, { VT_GSSetShader, (void*)&GSSetShader }
+		, { VT_IASetPrimitiveTopology, (void*)&IASetPrimitiveTopology }
+		, { VT_OMSetRenderTargets, (void*)&OMSetRenderTargets }
+		, { VT_OMSetBlendState, (void*)&OMSetBlendState }
+		, { VT_OMSetDepthStencilState, (void*)&OMSetDepthStencilState }
+		, { VT_RSSetState, (void*)&RSSetState }
+		, { VT_RSSetViewports, (void*)&RSSetViewports }
+		, { VT_UpdateSubresource, (void*)&UpdateSubresource }
+		, { VT_ClearRenderTargetView, (void*)&ClearRenderTargetView }
+		, { VT_ClearDepthStencilView, (void*)&ClearDepthStencilView }
+		, { VT_VSSetShaderResources, (void*)&SetSlot<VT_VSSetShaderResources, eCaptureCmd::VS_SET_SRV, ID3D11ShaderResourceView, eCaptureObject::OTHER> }
+		, { VT_GSSetShaderResources, (void*)&SetSlot<VT_GSSetShaderResources, eCaptureCmd::GS_SET_SRV, ID3D11ShaderResourceView, eCaptureObject::OTHER> }
+		, { VT_HSSetShaderResources, (void*)&SetSlot<VT_HSSetShaderResources, eCaptureCmd::HS_SET_SRV, ID3D11ShaderResourceView, eCaptureObject::OTHER> }
+		, { VT_DSSetShaderResources, (void*)&SetSlot<VT_DSSetShaderResources, eCaptureCmd::DS_SET_SRV, ID3D11ShaderResourceView, eCaptureObject::OTHER> }
+		, { VT_CSSetShaderResources, (void*)&SetSlot<VT_CSSetShaderResources, eCaptureCmd::CS_SET_SRV, ID3D11ShaderResourceView, eCaptureObject::OTHER> }
+		, { VT_VSSetSamplers, (void*)&SetSlot<VT_VSSetSamplers, eCaptureCmd::VS_SET_SAMPLER, ID3D11SamplerState, eCaptureObject::OTHER> }
+		, { VT_GSSetSamplers, (void*)&SetSlot<VT_GSSetSamplers, eCaptureCmd::GS_SET_SAMPLER, ID3D11SamplerState, eCaptureObject::OTHER> }
+		, { VT_HSSetSamplers, (void*)&SetSlot<VT_HSSetSamplers, eCaptureCmd::HS_SET_SAMPLER, ID3D11SamplerState, eCaptureObject::OTHER> }
+		, { VT_DSSetSamplers, (void*)&SetSlot<VT_DSSetSamplers, eCaptureCmd::DS_SET_SAMPLER, ID3D11SamplerState, eCaptureObject::OTHER> }
+		, { VT_CSSetSamplers, (void*)&SetSlot<VT_CSSetSamplers, eCaptureCmd::CS_SET_SAMPLER, ID3D11SamplerState, eCaptureObject::OTHER> }
+		, { VT_HSSetConstantBuffers, (void*)&SetSlot<VT_HSSetConstantBuffers, eCaptureCmd::HS_SET_CB, ID3D11Buffer, eCaptureObject::BUFFER> }
+		, { VT_DSSetConstantBuffers, (void*)&SetSlot<VT_DSSetConstantBuffers, eCaptureCmd::DS_SET_CB, ID3D11Buffer, eCaptureObject::BUFFER> }
+		, { VT_CSSetConstantBuffers, (void*)&SetSlot<VT_CSSetConstantBuffers, eCaptureCmd::CS_SET_CB, ID3D11Buffer, eCaptureObject::BUFFER> }
+		, { VT_HSSetShader, (void*)&SetShader<VT_HSSetShader, eCaptureCmd::HS_SET_SHADER, ID3D11HullShader> }
+		, { VT_DSSetShader, (void*)&SetShader<VT_DSSetShader, eCaptureCmd::DS_SET_SHADER, ID3D11DomainShader> }
+		, { VT_CSSetShader, (void*)&SetShader<VT_CSSetShader, eCaptureCmd::CS_SET_SHADER, ID3D11ComputeShader> }
+		, { VT_CSSetUnorderedAccessViews, (void*)&CSSetUnorderedAccessViews }
+		, { VT_DrawIndexedInstancedIndirect, (void*)&DrawIndexedInstancedIndirect }
+		, { VT_DrawInstancedIndirect, (void*)&DrawInstancedIndirect }
+		, { VT_Dispatch, (void*)&Dispatch }
+		, { VT_DispatchIndirect, (void*)&DispatchIndirect }
+		, { VT_OMSetRenderTargetsAndUnorderedAccessViews, (void*)&OMSetRenderTargetsAndUnorderedAccessViews }
+		, { VT_RSSetScissorRects, (void*)&RSSetScissorRects }
+		, { VT_CopyResource, (void*)&CopyResource }
+		, { VT_CopySubresourceRegion, (void*)&CopySubresourceRegion }
+		, { VT_CopyStructureCount, (void*)&CopyStructureCount }
+		, { VT_SetPredication, (void*)&SetPredication }
+		, { VT_SOSetTargets, (void*)&SOSetTargets }
+		, { VT_DrawAuto, (void*)&DrawAuto }
+		, { VT_ClearUnorderedAccessViewUint, (void*)&ClearUnorderedAccessViewUint }
+		, { VT_ClearUnorderedAccessViewFloat, (void*)&ClearUnorderedAccessViewFloat }
+		, { VT_GenerateMips, (void*)&GenerateMips }
+		, { VT_SetResourceMinLOD, (void*)&SetResourceMinLOD }
+		, { VT_ResolveSubresource, (void*)&ResolveSubresource }
+		, { VT_ExecuteCommandList, (void*)&ExecuteCommandList }
+		// ID3D11DeviceContext1, hook if supported
+		, { VT_CopySubresourceRegion1, (void*)&CopySubresourceRegion1 }
+		, { VT_UpdateSubresource1, (void*)&UpdateSubresource1 }
+		, { VT_VSSetConstantBuffers1, (void*)&SetConstantBuffers1<VT_VSSetConstantBuffers1, eCaptureCmd::VS_SET_CB1> }
+		, { VT_HSSetConstantBuffers1, (void*)&SetConstantBuffers1<VT_HSSetConstantBuffers1, eCaptureCmd::HS_SET_CB1> }
+		, { VT_DSSetConstantBuffers1, (void*)&SetConstantBuffers1<VT_DSSetConstantBuffers1, eCaptureCmd::DS_SET_CB1> }
+		, { VT_GSSetConstantBuffers1, (void*)&SetConstantBuffers1<VT_GSSetConstantBuffers1, eCaptureCmd::GS_SET_CB1> }
+		, { VT_PSSetConstantBuffers1, (void*)&SetConstantBuffers1<VT_PSSetConstantBuffers1, eCaptureCmd::PS_SET_CB1> }
+		, { VT_CSSetConstantBuffers1, (void*)&SetConstantBuffers1<VT_CSSetConstantBuffers1, eCaptureCmd::CS_SET_CB1> }
+		, { VT_ClearView, (void*)&ClearView }
+	};
+}
+
+
+cFrameCapture::cFrameCapture()
+	: m_devContext(NULL)
+	, m_fp(NULL)
+	, m_bufferSize(0)
+	, m_frameIdx(0)
+	, m_callCount(0)
+	, m_fileBytes(0)
+	, m_error(NULL)
+{
+}
+
+cFrameCapture::~cFrameCapture()
+{
+	End();
+}
+
+
+// start capture, immediate context call record to fileName
+// bufferSize: write buffer size, flush to file if full
+bool cFrameCapture::Begin(cRenderer &renderer, const char *fileName
+	, const UINT bufferSize //= 1024 * 1024
+)
+{
+	End();
+	RETV2(g_capture, false); // only one capture at a time
+	m_error = NULL;
+
+	if (fopen_s(&m_fp, fileName, "wb") || !m_fp)
+		return false;
+
+	const sFileHeader header = { FILE_MAGIC, VERSION };
+	fwrite(&header, sizeof(header), 1, m_fp);
+	m_fileBytes = sizeof(header);
+	m_buffer.resize(max((UINT)4096, bufferSize));
+	m_bufferSize = 0;
+	m_frameIdx = 0;
+	m_callCount = 0;
+
+	if (!Hook(renderer.GetDevContext()))
+	{
+		End();
+		return false;
+	}
+	return true;
+}
+
+
+void cFrameCapture::BeginFrame()
+{
+	if (!IsCapture())
+		return;
+	const UINT frameIdx = (UINT)m_frameIdx;
+	Write(eCaptureCmd::FRAME_BEGIN, &frameIdx, sizeof(frameIdx));
+}
+
+
+void cFrameCapture::EndFrame()
+{
+	if (!IsCapture())
+		return;
+	Write(eCaptureCmd::FRAME_END, NULL, 0);
+	++m_frameIdx;
+}
+
+
+void cFrameCapture::End()
+{
+	Unhook();
+	if (m_fp)
+	{
+		Flush();
+		fclose(m_fp);
+		m_fp = NULL;
+	}
+	m_buffer.clear();
+	m_bufferSize = 0;
+	m_objects.clear();
+	m_mapped.clear();
+}
+
+
+bool cFrameCapture::IsCapture() const
+{
+	return m_fp ? true : false;
+}
+
+
+// return object id, declare object if first seen (OBJECT command)
+UINT cFrameCapture::GetObjectId(ID3D11DeviceChild *obj, const eCaptureObject::Enum type)
+{
+	if (!obj)
+		return 0;
+
+	auto it = m_objects.find(obj);
+	if (m_objects.end() != it)
+		return it->second;
+
+	const UINT id = (UINT)m_objects.size() + 1;
+	m_objects[obj] = id;
+
+	// id, type, description
+	UINT header[2] = { id, (UINT)type };
+	switch (type)
+	{
+	case eCaptureObject::BUFFER:
+	{
+		D3D11_BUFFER_DESC desc;
+		((ID3D11Buffer*)obj)->GetDesc(&desc);
+		Write(eCaptureCmd::OBJECT, header, sizeof(header), &desc, sizeof(desc));
+	}
+	break;
+	case eCaptureObject::BLEND:
+	{
+		D3D11_BLEND_DESC desc;
+		((ID3D11BlendState*)obj)->GetDesc(&desc);
+		Write(eCaptureCmd::OBJECT, header, sizeof(header), &desc, sizeof(desc));
+	}
+	break;
+	case eCaptureObject::DEPTHSTENCIL:
+	{
+		D3D11_DEPTH_STENCIL_DESC desc;
+		((ID3D11DepthStencilState*)obj)->GetDesc(&desc);
+		Write(eCaptureCmd::OBJECT, header, sizeof(header), &desc, sizeof(desc));
+	}
+	break;
+	case eCaptureObject::RASTERIZER:
+	{
+		D3D11_RASTERIZER_DESC desc;
+		((ID3D11RasterizerState*)obj)->GetDesc(&desc);
+		Write(eCaptureCmd::OBJECT, header, sizeof(header), &desc, sizeof(desc));
+	}
+	break;
+	default:
+		Write(eCaptureCmd::OBJECT, header, sizeof(header));
+		break;
+	}
+	return id;
+}
+
+
+// buffer or texture
+UINT cFrameCapture::GetResourceId(ID3D11Resource *res)
+{
+	if (!res)
+		return 0;
+	D3D11_RESOURCE_DIMENSION dim;
+	res->GetType(&dim);
+	return GetObjectId(res, (D3D11_RESOURCE_DIMENSION_BUFFER == dim) ?
+		eCaptureObject::BUFFER : eCaptureObject::OTHER);
+}
+
+
+// command header + data + data2
+void cFrameCapture::Write(const eCaptureCmd::Enum cmd, const void *data, const UINT size
+	, const void *data2 //= NULL
+	, const UINT size2 //= 0
+)
+{
+	if (!m_fp)
+		return;
+
+	const UINT payload = size + (data2 ? size2 : 0);
+	if (payload >= (1 << 24))
+		return; // too large, not support
+
+	const UINT header = (UINT)cmd | (payload << 8);
+	const UINT total = sizeof(header) + payload;
+	if (m_bufferSize + total > m_buffer.size())
+		Flush();
+
+	if (total > m_buffer.size())
+	{
+		// larger than write buffer, direct write
+		fwrite(&header, sizeof(header), 1, m_fp);
+		if (size > 0)
+			fwrite(data, 1, size, m_fp);
+		if (data2 && (size2 > 0))
+			fwrite(data2, 1, size2, m_fp);
+		m_fileBytes += total;
+	}
+	else
+	{
+		BYTE *dst = &m_buffer[m_bufferSize];
+		memcpy(dst, &header, sizeof(header));
+		if (size > 0)
+			memcpy(dst + sizeof(header), data, size);
+		if (data2 && (size2 > 0))
+			memcpy(dst + sizeof(header) + size, data2, size2);
+		m_bufferSize += total;
+	}
+
+	if (cmd > eCaptureCmd::OBJECT)
+		++m_callCount;
+}
+
+
+// not recorded call, stop capture (vtable restore)
+// file end with UNSUPPORTED command, cFrameReplay reject
+void cFrameCapture::Fail(const char *method)
+{
+	if (!IsCapture())
+		return;
+	Write(eCaptureCmd::UNSUPPORTED, method, (UINT)strlen(method) + 1);
+	End();
+	m_error = method; // tool panel show
+}
+
+
+void cFrameCapture::Flush()
+{
+	if (!m_fp || (0 == m_bufferSize))
+		return;
+	fwrite(&m_buffer[0], 1, m_bufferSize, m_fp);
+	m_fileBytes += m_bufferSize;
+	m_bufferSize = 0;
+}
+
+
+// patch context vtable, restore at Unhook()
+bool cFrameCapture::Hook(ID3D11DeviceContext *devContext)
+{
+	RETV2(!devContext || g_vtable, false);
+
+	// ID3D11DeviceContext1 method, same vtable
+	ID3D11DeviceContext1 *devContext1 = NULL;
+	devContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&devContext1);
+	const int vtableSize = devContext1 ? VT_MAX : VT_CONTEXT_MAX;
+	SAFE_RELEASE(devContext1);
+
+	void **vtable = *(void***)devContext;
+	DWORD oldProtect;
+	if (!VirtualProtect(vtable, sizeof(void*) * vtableSize, PAGE_READWRITE, &oldProtect))
+		return false;
+
+	for (auto &hook : g_hooks)
+	{
+		if (hook.idx >= vtableSize)
+			continue;
+		g_orig[hook.idx] = vtable[hook.idx];
+		vtable[hook.idx] = hook.func;
+	}
+	VirtualProtect(vtable, sizeof(void*) * vtableSize, oldProtect, &oldProtect);
+
+	g_vtable = vtable;
+	g_vtableSize = vtableSize;
+	g_capture = this;
+	m_devContext = devContext;
+	return true;
+}
+
+
+void cFrameCapture::Unhook()
+{
+	if (!g_vtable || (g_capture != this))
+		return;
+
+	DWORD oldProtect;
+	if (VirtualProtect(g_vtable, sizeof(void*) * g_vtableSize, PAGE_READWRITE, &oldProtect))
+	{
+		for (auto &hook : g_hooks)
+			if (hook.idx < g_vtableSize)
+				g_vtable[hook.idx] = g_orig[hook.idx];
+		VirtualProtect(g_vtable, sizeof(void*) * g_vtableSize, oldProtect, &oldProtect);
+	}
+
+	g_vtable = NULL;
+	g_vtableSize = 0;
+	g_capture = NULL;
+	m_devContext = NULL;
+}
+
+
+const char* cFrameCapture::GetCommandName(const eCaptureCmd::Enum cmd)
+{
+	static const char *names[] = {
+		"FrameBegin", "FrameEnd", "Object"
+		, "VSSetConstantBuffers", "PSSetConstantBuffers", "GSSetConstantBuffers"
+		, "PSSetShaderResources", "PSSetSamplers"
+		, "VSSetShader", "PSSetShader", "GSSetShader"
+		, "DrawIndexed", "Draw", "DrawIndexedInstanced", "DrawInstanced"
+		, "Map", "Unmap", "UpdateSubresource"
+		, "IASetInputLayout", "IASetVertexBuffers", "IASetIndexBuffer", "IASetPrimitiveTopology"
+		, "OMSetRenderTargets", "OMSetBlendState", "OMSetDepthStencilState"
+		, "RSSetState", "RSSetViewports"
+		, "ClearRenderTargetView", "ClearDepthStencilView"
+		, "VSSetShaderResources", "GSSetShaderResources", "HSSetShaderResources"
+		, "DSSetShaderResources", "CSSetShaderResources"
+		, "VSSetSamplers", "GSSetSamplers", "HSSetSamplers", "DSSetSamplers", "CSSetSamplers"
+		, "HSSetConstantBuffers", "DSSetConstantBuffers", "CSSetConstantBuffers"
+		, "VSSetConstantBuffers1", "PSSetConstantBuffers1", "GSSetConstantBuffers1"
+		, "HSSetConstantBuffers1", "DSSetConstantBuffers1", "CSSetConstantBuffers1"
+		, "HSSetShader", "DSSetShader", "CSSetShader"
+		, "CSSetUnorderedAccessViews"
+		, "DrawIndexedInstancedIndirect", "DrawInstancedIndirect"
+		, "Dispatch", "DispatchIndirect"
+		, "OMSetRenderTargetsAndUnorderedAccessViews", "RSSetScissorRects"
+		, "CopyResource", "CopySubresourceRegion", "CopyStructureCount"
+		, "Unsupported"
+	};
+	static_assert(ARRAYSIZE(names) == eCaptureCmd::MAX, "command name mismatch");
+	return ((cmd >= 0) && (cmd < eCaptureCmd::MAX)) ? names[cmd] : "Unknown";
+}
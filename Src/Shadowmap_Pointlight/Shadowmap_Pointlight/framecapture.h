@@ -0,0 +1,109 @@
+//
+// 2018-05-11, jjuiddong
+// Frame Capture
+//	- hook immediate context method (vtable patch), record call to binary stream
+//	- state object description, constant buffer contents, draw argument
+//	- stream to file, fixed size write buffer (bounded memory)
+//	- replay with cFrameReplay
+//	- not recorded: shader bytecode, view, texture contents, non constant buffer data
+//	  (replay bind NULL), query Begin/End/GetData (no render result)
+//	- state change not recorded (predication, stream out, UAV clear, mip generate,
+//	  resolve, command list, ...) : capture stop, m_error = method name (Fail())
+//	- indirect draw, dispatch : argument buffer read back at call (CPU stall)
+//
+// file format
+//	- sFileHeader
+//	- command: UINT header (command 8bit | payload size 24bit), payload
+//	- object id declared once (OBJECT command), 0 = NULL
+//
+#pragma once
+
+#include <map>
+
+
+namespace graphic
+{
+
+	struct eCaptureCmd {
+		enum Enum {
+			FRAME_BEGIN, FRAME_END, OBJECT
+			, VS_SET_CB, PS_SET_CB, GS_SET_CB
+			, PS_SET_SRV, PS_SET_SAMPLER
+			, VS_SET_SHADER, PS_SET_SHADER, GS_SET_SHADER
+			, DRAW_INDEXED, DRAW, DRAW_INDEXED_INSTANCED, DRAW_INSTANCED
+			, MAP, UNMAP, UPDATE_SUBRESOURCE
+			, IA_SET_LAYOUT, IA_SET_VB, IA_SET_IB, IA_SET_TOPOLOGY
+			, OM_SET_RT, OM_SET_BLEND, OM_SET_DEPTH
+			, RS_SET_STATE, RS_SET_VIEWPORT
+			, CLEAR_RTV, CLEAR_DSV
+			, VS_SET_SRV, GS_SET_SRV, HS_SET_SRV, DS_SET_SRV, CS_SET_SRV
+			, VS_SET_SAMPLER, GS_SET_SAMPLER, HS_SET_SAMPLER, DS_SET_SAMPLER, CS_SET_SAMPLER
+			, HS_SET_CB, DS_SET_CB, CS_SET_CB
+			, VS_SET_CB1, PS_SET_CB1, GS_SET_CB1, HS_SET_CB1, DS_SET_CB1, CS_SET_CB1
+			, HS_SET_SHADER, DS_SET_SHADER, CS_SET_SHADER
+			, CS_SET_UAV
+			, DRAW_INDEXED_INSTANCED_INDIRECT, DRAW_INSTANCED_INDIRECT
+			, DISPATCH, DISPATCH_INDIRECT
+			, OM_SET_RT_UAV, RS_SET_SCISSOR
+			, COPY_RESOURCE, COPY_SUBRESOURCE_REGION, COPY_STRUCTURE_COUNT
+			, UNSUPPORTED // method name, last command
+			, MAX
+		};
+	};
+
+	struct eCaptureObject {
+		enum Enum { OTHER, BUFFER, BLEND, DEPTHSTENCIL, RASTERIZER };
+	};
+
+
+	class cFrameCapture
+	{
+	public:
+		enum { FILE_MAGIC = 0x50414346 }; // 'FCAP'
+		enum { VERSION = 2 };
+
+		struct sFileHeader
+		{
+			UINT magic;
+			UINT version;
+		};
+
+		cFrameCapture();
+		virtual ~cFrameCapture();
+
+		bool Begin(cRenderer &renderer, const char *fileName
+			, const UINT bufferSize = 1024 * 1024);
+		void BeginFrame();
+		void EndFrame();
+		void End();
+		bool IsCapture() const;
+		static const char* GetCommandName(const eCaptureCmd::Enum cmd);
+
+		// call from context hook
+		UINT GetObjectId(ID3D11DeviceChild *obj, const eCaptureObject::Enum type);
+		UINT GetResourceId(ID3D11Resource *res);
+		void Write(const eCaptureCmd::Enum cmd, const void *data, const UINT size
+			, const void *data2 = NULL, const UINT size2 = 0);
+		void Fail(const char *method);
+
+
+	protected:
+		bool Hook(ID3D11DeviceContext *devContext);
+		void Unhook();
+		void Flush();
+
+
+	public:
+		ID3D11DeviceContext *m_devContext; // hooked immediate context
+		FILE *m_fp;
+		std::vector<BYTE> m_buffer; // write buffer, flush to file if full
+		UINT m_bufferSize; // used size
+		std::map<void*, UINT> m_objects; // object pointer -> id
+		std::map<ID3D11Resource*, std::pair<void*, UINT>> m_mapped; // map pointer, size
+		int m_frameIdx;
+		int m_callCount;
+		__int64 m_fileBytes;
+		const char *m_error; // unsupported method name, capture stopped, NULL: success
+	};
+
+}
@@ -0,0 +1,235 @@
+
+#include "../../Shared/platform.h"
+#include "framegraph.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace graphic;
+
+
+cFrameGraph::cFrameGraph()
+	: m_transientBytes(0)
+	, m_aliasBytes(0)
+	, m_culledCount(0)
+	, m_arena(NULL)
+{
+}
+
+cFrameGraph::~cFrameGraph()
+{
+	Clear();
+}
+
+
+// return resource id
+int cFrameGraph::AddResource(const char *name, const UINT size
+	, const bool isTransient //= true
+)
+{
+	sResource res;
+	res.name = name;
+	res.size = size;
+	res.isTransient = isTransient;
+	res.isOutput = false;
+	res.firstPass = -1;
+	res.lastPass = -1;
+	res.memSlot = -1;
+	m_resources.push_back(res);
+	return (int)m_resources.size() - 1;
+}
+
+
+// return pass id, execute order = AddPass() order
+int cFrameGraph::AddPass(const char *name
+	, const std::function<void()> &execute //= nullptr
+)
+{
+	sPass pass;
+	pass.name = name;
+	pass.execute = execute;
+	pass.isCulled = false;
+	m_passes.push_back(pass);
+	return (int)m_passes.size() - 1;
+}
+
+
+// graph declare without backend, execute function set later
+void cFrameGraph::SetExecute(const int pass, const std::function<void()> &execute)
+{
+	m_passes[pass].execute = execute;
+}
+
+
+void cFrameGraph::Read(const int pass, const int res
+	, const int slot //= -1
+)
+{
+	m_passes[pass].reads.push_back({ res, slot });
+}
+
+
+void cFrameGraph::Write(const int pass, const int res)
+{
+	m_passes[pass].writes.push_back(res);
+}
+
+
+void cFrameGraph::SetOutput(const int res
+	, const bool isOutput //= true
+)
+{
+	m_resources[res].isOutput = isOutput;
+}
+
+
+// cull pass, calc resource lifetime, aliasing
+bool cFrameGraph::Compile()
+{
+	// cull, back to front
+	// pass needed if write output or resource read by needed pass
+	typedef std::vector<int, cArenaAllocator<int>> IntArray;
+	const cArenaAllocator<int> alloc(m_arena);
+
+	std::vector<bool, cArenaAllocator<bool>> isNeed(m_resources.size(), false, alloc);
+	for (UINT i = 0; i < m_resources.size(); ++i)
+		isNeed[i] = m_resources[i].isOutput;
+
+	m_culledCount = 0;
+	for (int i = (int)m_passes.size() - 1; i >= 0; --i)
+	{
+		sPass &pass = m_passes[i];
+		pass.isCulled = true;
+		for (auto res : pass.writes)
+			if (isNeed[res])
+				pass.isCulled = false;
+
+		if (pass.isCulled)
+		{
+			++m_culledCount;
+			continue;
+		}
+
+		for (auto &read : pass.reads)
+			isNeed[read.res] = true;
+	}
+
+	// resource lifetime
+	for (auto &res : m_resources)
+	{
+		res.firstPass = -1;
+		res.lastPass = -1;
+		res.memSlot = -1;
+	}
+
+	for (int i = 0; i < (int)m_passes.size(); ++i)
+	{
+		sPass &pass = m_passes[i];
+		if (pass.isCulled)
+			continue;
+
+		IntArray access(pass.writes.begin(), pass.writes.end(), alloc);
+		for (auto &read : pass.reads)
+			access.push_back(read.res);
+
+		for (auto id : access)
+		{
+			sResource &res = m_resources[id];
+			if (res.firstPass < 0)
+				res.firstPass = i;
+			res.lastPass = i;
+		}
+	}
+
+	// aliasing, first use order, greedy best fit
+	// memory slot reuse if previous resource lifetime end
+	IntArray sorted(alloc);
+	for (UINT i = 0; i < m_resources.size(); ++i)
+		if (m_resources[i].isTransient && (m_resources[i].firstPass >= 0))
+			sorted.push_back(i);
+	std::sort(sorted.begin(), sorted.end(), [&](const int a, const int b) {
+		return m_resources[a].firstPass < m_resources[b].firstPass; });
+
+	m_memSlots.clear();
+	IntArray slotLastPass(alloc);
+	m_transientBytes = 0;
+	for (auto id : sorted)
+	{
+		sResource &res = m_resources[id];
+		m_transientBytes += res.size;
+
+		int best = -1;
+		for (UINT k = 0; k < m_memSlots.size(); ++k)
+		{
+			if (slotLastPass[k] >= res.firstPass)
+				continue;
+			if ((best < 0) || (abs((int)m_memSlots[k] - (int)res.size)
+				< abs((int)m_memSlots[best] - (int)res.size)))
+				best = (int)k;
+		}
+
+		if (best < 0)
+		{
+			m_memSlots.push_back(res.size);
+			slotLastPass.push_back(res.lastPass);
+			best = (int)m_memSlots.size() - 1;
+		}
+		else
+		{
+			m_memSlots[best] = std::max(m_memSlots[best], res.size);
+			slotLastPass[best] = res.lastPass;
+		}
+		res.memSlot = best;
+	}
+
+	m_aliasBytes = 0;
+	for (auto size : m_memSlots)
+		m_aliasBytes += size;
+
+	return true;
+}
+
+
+// execute not culled pass
+// unbind shader resource read by pass, after pass execute
+// executor = NULL : null backend, record order only
+void cFrameGraph::Execute(cFrameGraphExecutor *executor)
+{
+	m_order.clear();
+	for (int i = 0; i < (int)m_passes.size(); ++i)
+	{
+		sPass &pass = m_passes[i];
+		if (pass.isCulled)
+			continue;
+
+		m_order.push_back(i);
+		if (!executor)
+			continue;
+
+		executor->ExecutePass(pass.name.c_str(), pass.execute);
+		for (auto &read : pass.reads)
+			if (read.slot >= 0)
+				executor->UnbindShaderResource(read.slot);
+	}
+}
+
+
+// return pass id, -1 = not found
+int cFrameGraph::FindPass(const char *name) const
+{
+	for (UINT i = 0; i < m_passes.size(); ++i)
+		if (m_passes[i].name == name)
+			return (int)i;
+	return -1;
+}
+
+
+void cFrameGraph::Clear()
+{
+	m_resources.clear();
+	m_passes.clear();
+	m_order.clear();
+	m_memSlots.clear();
+	m_transientBytes = 0;
+	m_aliasBytes = 0;
+	m_culledCount = 0;
+}
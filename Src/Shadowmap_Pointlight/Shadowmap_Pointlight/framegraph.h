@@ -0,0 +1,111 @@
+//
+// 2018-05-08, jjuiddong
+// Frame Graph
+//	- pass declare read/write resource, execute by declaration order
+//	- pass not contribute to output resource culled
+//	- shader resource read by pass unbind after pass execute
+//	- transient resource lifetime -> memory aliasing estimate
+//	- Execute(NULL) : null backend, only record pass order
+//	- Compile() temporary from m_arena (frame arena)
+//	- no D3D dependency, backend = cFrameGraphExecutor
+//	  (cD3DFrameGraphExecutor: framegraphd3d.h, cNullFrameGraphExecutor: headless test)
+//
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "framearena.h"
+
+
+namespace graphic
+{
+
+	class cFrameGraph;
+
+	// frame graph backend, execute pass, unbind pass input
+	class cFrameGraphExecutor
+	{
+	public:
+		virtual ~cFrameGraphExecutor() {}
+		virtual void ExecutePass(const char *name, const std::function<void()> &execute) = 0;
+		virtual void UnbindShaderResource(const int slot) = 0;
+	};
+
+
+	// no GPU, record pass name, unbind slot
+	class cNullFrameGraphExecutor : public cFrameGraphExecutor
+	{
+	public:
+		virtual void ExecutePass(const char *name, const std::function<void()> &) override {
+			m_passes.push_back(name);
+		}
+		virtual void UnbindShaderResource(const int slot) override {
+			m_unbinds.push_back(slot);
+		}
+		void Clear() {
+			m_passes.clear();
+			m_unbinds.clear();
+		}
+
+		std::vector<std::string> m_passes; // executed pass name
+		std::vector<int> m_unbinds; // unbind shader resource slot
+	};
+
+
+	class cFrameGraph
+	{
+	public:
+		struct sResource
+		{
+			std::string name;
+			UINT size; // bytes
+			bool isTransient; // false: imported (backbuffer..)
+			bool isOutput; // frame result, pass write this never culled
+			int firstPass; // lifetime, m_passes index, -1 = unused
+			int lastPass;
+			int memSlot; // aliasing memory slot, -1 = not transient
+		};
+
+		struct sRead
+		{
+			int res;
+			int slot; // pixel shader resource slot, -1 = not bind
+		};
+
+		struct sPass
+		{
+			std::string name;
+			std::vector<sRead> reads;
+			std::vector<int> writes;
+			std::function<void()> execute;
+			bool isCulled;
+		};
+
+		cFrameGraph();
+		virtual ~cFrameGraph();
+
+		int AddResource(const char *name, const UINT size, const bool isTransient = true);
+		int AddPass(const char *name, const std::function<void()> &execute = nullptr);
+		void SetExecute(const int pass, const std::function<void()> &execute);
+		void Read(const int pass, const int res, const int slot = -1);
+		void Write(const int pass, const int res);
+		void SetOutput(const int res, const bool isOutput = true);
+		bool Compile();
+		void Execute(cFrameGraphExecutor *executor);
+		int FindPass(const char *name) const;
+		void Clear();
+
+
+	public:
+		std::vector<sResource> m_resources;
+		std::vector<sPass> m_passes;
+		std::vector<int> m_order; // last executed pass index
+		std::vector<UINT> m_memSlots; // aliasing memory slot size
+		UINT m_transientBytes; // without aliasing
+		UINT m_aliasBytes; // with aliasing
+		int m_culledCount;
+		cFrameArena *m_arena; // Compile() temporary, NULL = heap
+	};
+
+}
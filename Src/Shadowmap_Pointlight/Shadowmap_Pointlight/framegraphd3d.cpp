@@ -0,0 +1,28 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "framegraphd3d.h"
+
+using namespace graphic;
+
+
+cD3DFrameGraphExecutor::cD3DFrameGraphExecutor(cRenderer &renderer)
+	: m_renderer(renderer)
+{
+}
+
+
+void cD3DFrameGraphExecutor::ExecutePass(const char *name, const std::function<void()> &execute)
+{
+	if (execute)
+		execute();
+}
+
+
+void cD3DFrameGraphExecutor::UnbindShaderResource(const int slot)
+{
+	ID3D11ShaderResourceView *nullSRV[1] = { NULL };
+	m_renderer.GetDevContext()->PSSetShaderResources(slot, 1, nullSRV);
+}
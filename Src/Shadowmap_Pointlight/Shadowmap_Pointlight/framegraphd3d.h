@@ -0,0 +1,28 @@
+//
+// 2018-05-26, jjuiddong
+// Frame Graph D3D11 Executor
+//	- cFrameGraph backend, execute pass function
+//	- unbind pixel shader resource read by pass
+//
+#pragma once
+
+#include "framegraph.h"
+
+
+namespace graphic
+{
+
+	class cD3DFrameGraphExecutor : public cFrameGraphExecutor
+	{
+	public:
+		cD3DFrameGraphExecutor(cRenderer &renderer);
+
+		virtual void ExecutePass(const char *name, const std::function<void()> &execute) override;
+		virtual void UnbindShaderResource(const int slot) override;
+
+
+	public:
+		cRenderer &m_renderer;
+	};
+
+}
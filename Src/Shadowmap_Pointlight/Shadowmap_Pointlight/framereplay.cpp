@@ -0,0 +1,479 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include <d3d11_1.h>
+#include "framereplay.h"
+#include "../../Shared/steadytimer.h"
+
+using namespace graphic;
+
+
+cFrameReplay::cFrameReplay()
+	: m_device(NULL)
+	, m_devContext(NULL)
+	, m_devContext1(NULL)
+{
+}
+
+cFrameReplay::~cFrameReplay()
+{
+	Clear();
+}
+
+
+// read capture file 1 frame at a time, execute and measure frame time
+bool cFrameReplay::Replay(const char *fileName, const eBackend::Enum backend
+	, OUT sResult &out)
+{
+	Clear();
+	ZeroMemory(&out, sizeof(out));
+
+	if ((eBackend::WARP == backend) && !CreateDevice())
+		return false;
+
+	FILE *fp = NULL;
+	if (fopen_s(&fp, fileName, "rb") || !fp)
+		return false;
+
+	cFrameCapture::sFileHeader fileHeader;
+	if ((1 != fread(&fileHeader, sizeof(fileHeader), 1, fp))
+		|| (cFrameCapture::FILE_MAGIC != fileHeader.magic)
+		|| (cFrameCapture::VERSION != fileHeader.version))
+	{
+		fclose(fp);
+		return false;
+	}
+
+	out.fileBytes = sizeof(fileHeader);
+	m_objects.resize(1, NULL); // id 0 = NULL
+
+	bool isEof = false;
+	while (!isEof)
+	{
+		// read 1 frame
+		m_payload.clear();
+		while (1)
+		{
+			UINT header;
+			if (1 != fread(&header, sizeof(header), 1, fp))
+			{
+				isEof = true;
+				break;
+			}
+
+			const UINT size = header >> 8;
+			const size_t offset = m_payload.size();
+			m_payload.resize(offset + sizeof(header) + size);
+			memcpy(&m_payload[offset], &header, sizeof(header));
+			if (size > 0)
+			{
+				if (size != fread(&m_payload[offset + sizeof(header)], 1, size, fp))
+				{
+					m_payload.resize(offset);
+					isEof = true;
+					break;
+				}
+			}
+			out.fileBytes += sizeof(header) + size;
+
+			if (eCaptureCmd::FRAME_END == (header & 0xff))
+				break;
+		}
+
+		if (m_payload.empty())
+			break;
+
+		// execute frame
+		const double t0 = GetSteadyTimeMs();
+		size_t offset = 0;
+		while (offset < m_payload.size())
+		{
+			const UINT header = *(const UINT*)&m_payload[offset];
+			const eCaptureCmd::Enum cmd = (eCaptureCmd::Enum)(header & 0xff);
+			const UINT size = header >> 8;
+			const BYTE *data = &m_payload[offset + sizeof(header)];
+			offset += sizeof(header) + size;
+
+			if (cmd >= eCaptureCmd::MAX)
+				continue;
+			++out.calls[cmd];
+
+			switch (cmd)
+			{
+			case eCaptureCmd::FRAME_BEGIN:
+			case eCaptureCmd::FRAME_END:
+				break;
+			case eCaptureCmd::OBJECT:
+				CreateObject((const UINT*)data, size);
+				++out.objectCount;
+				break;
+			case eCaptureCmd::UNSUPPORTED: // incomplete capture
+				strncpy_s(out.unsupported, (const char*)data, _TRUNCATE);
+				fclose(fp);
+				return false;
+			default:
+				++out.callCount;
+				if (m_devContext)
+					Execute(cmd, data, size);
+				break;
+			}
+		}
+		if (m_devContext)
+			m_devContext->Flush();
+
+		const double frameMs = GetSteadyTimeMs() - t0;
+		out.replayMs += frameMs;
+		out.maxFrameMs = max(out.maxFrameMs, frameMs);
+	}
+
+	out.frameCount = out.calls[eCaptureCmd::FRAME_END];
+	fclose(fp);
+	return true;
+}
+
+
+bool cFrameReplay::CreateDevice()
+{
+	const D3D_FEATURE_LEVEL featureLevel = D3D_FEATURE_LEVEL_11_0;
+	HRESULT hr = D3D11CreateDevice(NULL, D3D_DRIVER_TYPE_WARP, NULL, 0
+		, &featureLevel, 1, D3D11_SDK_VERSION, &m_device, NULL, &m_devContext);
+	RETV2(FAILED(hr), false);
+	m_devContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&m_devContext1);
+	return true;
+}
+
+
+// id, type, description
+void cFrameReplay::CreateObject(const UINT *data, const UINT size)
+{
+	if (size < sizeof(UINT) * 2)
+		return;
+
+	const UINT id = data[0];
+	const eCaptureObject::Enum type = (eCaptureObject::Enum)data[1];
+	const void *desc = &data[2];
+	const UINT descSize = size - sizeof(UINT) * 2;
+	if (m_objects.size() <= id)
+		m_objects.resize(id + 1, NULL);
+	if (!m_device)
+		return;
+
+	ID3D11DeviceChild *obj = NULL;
+	switch (type)
+	{
+	case eCaptureObject::BUFFER:
+		if (descSize >= sizeof(D3D11_BUFFER_DESC))
+		{
+			// no initial data, immutable -> default
+			D3D11_BUFFER_DESC bd = *(const D3D11_BUFFER_DESC*)desc;
+			if (D3D11_USAGE_IMMUTABLE == bd.Usage)
+				bd.Usage = D3D11_USAGE_DEFAULT;
+			bd.MiscFlags &= ~(D3D11_RESOURCE_MISC_SHARED | D3D11_RESOURCE_MISC_SHARED_KEYEDMUTEX);
+			if (D3D11_USAGE_STAGING != bd.Usage)
+				m_device->CreateBuffer(&bd, NULL, (ID3D11Buffer**)&obj);
+		}
+		break;
+	case eCaptureObject::BLEND:
+		if (descSize >= sizeof(D3D11_BLEND_DESC))
+			m_device->CreateBlendState((const D3D11_BLEND_DESC*)desc, (ID3D11BlendState**)&obj);
+		break;
+	case eCaptureObject::DEPTHSTENCIL:
+		if (descSize >= sizeof(D3D11_DEPTH_STENCIL_DESC))
+			m_device->CreateDepthStencilState((const D3D11_DEPTH_STENCIL_DESC*)desc
+				, (ID3D11DepthStencilState**)&obj);
+		break;
+	case eCaptureObject::RASTERIZER:
+		if (descSize >= sizeof(D3D11_RASTERIZER_DESC))
+			m_device->CreateRasterizerState((const D3D11_RASTERIZER_DESC*)desc
+				, (ID3D11RasterizerState**)&obj);
+		break;
+	default:
+		break; // shader, view, input layout, not captured
+	}
+
+	SAFE_RELEASE(m_objects[id]);
+	m_objects[id] = obj;
+}
+
+
+template<class T>
+T* cFrameReplay::GetObj(const UINT id) const
+{
+	return (id < m_objects.size()) ? (T*)m_objects[id] : NULL;
+}
+
+
+// WARP backend
+void cFrameReplay::Execute(const eCaptureCmd::Enum cmd, const BYTE *data, const UINT size)
+{
+	const UINT *v = (const UINT*)data;
+
+	switch (cmd)
+	{
+	case eCaptureCmd::VS_SET_CB:
+	case eCaptureCmd::PS_SET_CB:
+	case eCaptureCmd::GS_SET_CB:
+	case eCaptureCmd::HS_SET_CB:
+	case eCaptureCmd::DS_SET_CB:
+	case eCaptureCmd::CS_SET_CB:
+	{
+		ID3D11Buffer *buffs[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+		const UINT count = min(v[1], (UINT)D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+		for (UINT i = 0; i < count; ++i)
+			buffs[i] = GetObj<ID3D11Buffer>(v[2 + i]);
+		switch (cmd)
+		{
+		case eCaptureCmd::VS_SET_CB: m_devContext->VSSetConstantBuffers(v[0], count, buffs); break;
+		case eCaptureCmd::PS_SET_CB: m_devContext->PSSetConstantBuffers(v[0], count, buffs); break;
+		case eCaptureCmd::GS_SET_CB: m_devContext->GSSetConstantBuffers(v[0], count, buffs); break;
+		case eCaptureCmd::HS_SET_CB: m_devContext->HSSetConstantBuffers(v[0], count, buffs); break;
+		case eCaptureCmd::DS_SET_CB: m_devContext->DSSetConstantBuffers(v[0], count, buffs); break;
+		default: m_devContext->CSSetConstantBuffers(v[0], count, buffs); break;
+		}
+	}
+	break;
+
+	// start, count, isRange, (id, first constant, constant count) x count
+	case eCaptureCmd::VS_SET_CB1:
+	case eCaptureCmd::PS_SET_CB1:
+	case eCaptureCmd::GS_SET_CB1:
+	case eCaptureCmd::HS_SET_CB1:
+	case eCaptureCmd::DS_SET_CB1:
+	case eCaptureCmd::CS_SET_CB1:
+	{
+		ID3D11Buffer *buffs[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+		UINT firsts[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+		UINT nums[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+		const UINT count = min(v[1], (UINT)D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
+		for (UINT i = 0; i < count; ++i)
+		{
+			buffs[i] = GetObj<ID3D11Buffer>(v[3 + i * 3]);
+			firsts[i] = v[3 + i * 3 + 1];
+			nums[i] = v[3 + i * 3 + 2];
+		}
+		if (!m_devContext1)
+			break; // no constant buffer offset, skip
+		const UINT *f = v[2] ? firsts : NULL;
+		const UINT *n = v[2] ? nums : NULL;
+		switch (cmd)
+		{
+		case eCaptureCmd::VS_SET_CB1: m_devContext1->VSSetConstantBuffers1(v[0], count, buffs, f, n); break;
+		case eCaptureCmd::PS_SET_CB1: m_devContext1->PSSetConstantBuffers1(v[0], count, buffs, f, n); break;
+		case eCaptureCmd::GS_SET_CB1: m_devContext1->GSSetConstantBuffers1(v[0], count, buffs, f, n); break;
+		case eCaptureCmd::HS_SET_CB1: m_devContext1->HSSetConstantBuffers1(v[0], count, buffs, f, n); break;
+		case eCaptureCmd::DS_SET_CB1: m_devContext1->DSSetConstantBuffers1(v[0], count, buffs, f, n); break;
+		default: m_devContext1->CSSetConstantBuffers1(v[0], count, buffs, f, n); break;
+		}
+	}
+	break;
+
+	case eCaptureCmd::PS_SET_SRV:
+	case eCaptureCmd::VS_SET_SRV:
+	case eCaptureCmd::GS_SET_SRV:
+	case eCaptureCmd::HS_SET_SRV:
+	case eCaptureCmd::DS_SET_SRV:
+	case eCaptureCmd::CS_SET_SRV:
+	{
+		ID3D11ShaderResourceView *views[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = { NULL, };
+		const UINT count = min(v[1], (UINT)D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT);
+		switch (cmd)
+		{
+		case eCaptureCmd::PS_SET_SRV: m_devContext->PSSetShaderResources(v[0], count, views); break;
+		case eCaptureCmd::VS_SET_SRV: m_devContext->VSSetShaderResources(v[0], count, views); break;
+		case eCaptureCmd::GS_SET_SRV: m_devContext->GSSetShaderResources(v[0], count, views); break;
+		case eCaptureCmd::HS_SET_SRV: m_devContext->HSSetShaderResources(v[0], count, views); break;
+		case eCaptureCmd::DS_SET_SRV: m_devContext->DSSetShaderResources(v[0], count, views); break;
+		default: m_devContext->CSSetShaderResources(v[0], count, views); break;
+		}
+	}
+	break;
+
+	case eCaptureCmd::PS_SET_SAMPLER:
+	case eCaptureCmd::VS_SET_SAMPLER:
+	case eCaptureCmd::GS_SET_SAMPLER:
+	case eCaptureCmd::HS_SET_SAMPLER:
+	case eCaptureCmd::DS_SET_SAMPLER:
+	case eCaptureCmd::CS_SET_SAMPLER:
+	{
+		ID3D11SamplerState *samplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT] = { NULL, };
+		const UINT count = min(v[1], (UINT)D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT);
+		switch (cmd)
+		{
+		case eCaptureCmd::PS_SET_SAMPLER: m_devContext->PSSetSamplers(v[0], count, samplers); break;
+		case eCaptureCmd::VS_SET_SAMPLER: m_devContext->VSSetSamplers(v[0], count, samplers); break;
+		case eCaptureCmd::GS_SET_SAMPLER: m_devContext->GSSetSamplers(v[0], count, samplers); break;
+		case eCaptureCmd::HS_SET_SAMPLER: m_devContext->HSSetSamplers(v[0], count, samplers); break;
+		case eCaptureCmd::DS_SET_SAMPLER: m_devContext->DSSetSamplers(v[0], count, samplers); break;
+		default: m_devContext->CSSetSamplers(v[0], count, samplers); break;
+		}
+	}
+	break;
+
+	case eCaptureCmd::CS_SET_UAV: // view not captured, unbind
+	{
+		ID3D11UnorderedAccessView *uavs[D3D11_1_UAV_SLOT_COUNT] = { NULL, };
+		m_devContext->CSSetUnorderedAccessViews(v[0]
+			, min(v[1], (UINT)D3D11_PS_CS_UAV_REGISTER_COUNT), uavs, NULL);
+	}
+	break;
+
+	case eCaptureCmd::VS_SET_SHADER: m_devContext->VSSetShader(NULL, NULL, 0); break;
+	case eCaptureCmd::PS_SET_SHADER: m_devContext->PSSetShader(NULL, NULL, 0); break;
+	case eCaptureCmd::GS_SET_SHADER: m_devContext->GSSetShader(NULL, NULL, 0); break;
+	case eCaptureCmd::HS_SET_SHADER: m_devContext->HSSetShader(NULL, NULL, 0); break;
+	case eCaptureCmd::DS_SET_SHADER: m_devContext->DSSetShader(NULL, NULL, 0); break;
+	case eCaptureCmd::CS_SET_SHADER: m_devContext->CSSetShader(NULL, NULL, 0); break;
+	case eCaptureCmd::IA_SET_LAYOUT: m_devContext->IASetInputLayout(NULL); break;
+
+	case eCaptureCmd::DRAW_INDEXED:
+		m_devContext->DrawIndexed(v[0], v[1], (INT)v[2]);
+		break;
+	case eCaptureCmd::DRAW:
+		m_devContext->Draw(v[0], v[1]);
+		break;
+	case eCaptureCmd::DRAW_INDEXED_INSTANCED:
+		m_devContext->DrawIndexedInstanced(v[0], v[1], v[2], (INT)v[3], v[4]);
+		break;
+	case eCaptureCmd::DRAW_INSTANCED:
+		m_devContext->DrawInstanced(v[0], v[1], v[2], v[3]);
+		break;
+
+	// argument buffer id, offset, argument
+	case eCaptureCmd::DRAW_INDEXED_INSTANCED_INDIRECT:
+		m_devContext->DrawIndexedInstanced(v[2], v[3], v[4], (INT)v[5], v[6]);
+		break;
+	case eCaptureCmd::DRAW_INSTANCED_INDIRECT:
+		m_devContext->DrawInstanced(v[2], v[3], v[4], v[5]);
+		break;
+	case eCaptureCmd::DISPATCH:
+		m_devContext->Dispatch(v[0], v[1], v[2]);
+		break;
+	case eCaptureCmd::DISPATCH_INDIRECT:
+		m_devContext->Dispatch(v[2], v[3], v[4]);
+		break;
+
+	case eCaptureCmd::UNMAP: // id, subresource, data size, data
+	{
+		ID3D11Buffer *buff = GetObj<ID3D11Buffer>(v[0]);
+		if (!buff || (0 == v[2]))
+			break;
+
+		D3D11_BUFFER_DESC desc;
+		buff->GetDesc(&desc);
+		if (D3D11_USAGE_DYNAMIC == desc.Usage)
+		{
+			D3D11_MAPPED_SUBRESOURCE mapped;
+			if (SUCCEEDED(m_devContext->Map(buff, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+			{
+				memcpy(mapped.pData, &v[3], min(v[2], desc.ByteWidth));
+				m_devContext->Unmap(buff, 0);
+			}
+		}
+		else if (D3D11_USAGE_DEFAULT == desc.Usage)
+		{
+			m_devContext->UpdateSubresource(buff, 0, NULL, &v[3], 0, 0);
+		}
+	}
+	break;
+
+	case eCaptureCmd::UPDATE_SUBRESOURCE: // id, subresource, box(6), data size, data
+	{
+		ID3D11Buffer *buff = GetObj<ID3D11Buffer>(v[0]);
+		if (!buff || (0 == v[8]))
+			break;
+		const D3D11_BOX *box = (const D3D11_BOX*)&v[2];
+		m_devContext->UpdateSubresource(buff, v[1], (box->right > box->left) ? box : NULL
+			, &v[9], 0, 0);
+	}
+	break;
+
+	case eCaptureCmd::IA_SET_VB:
+	{
+		ID3D11Buffer *buffs[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+		UINT strides[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+		UINT offsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+		const UINT count = min(v[1], (UINT)D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT);
+		for (UINT i = 0; i < count; ++i)
+		{
+			buffs[i] = GetObj<ID3D11Buffer>(v[2 + i * 3]);
+			strides[i] = v[2 + i * 3 + 1];
+			offsets[i] = v[2 + i * 3 + 2];
+		}
+		m_devContext->IASetVertexBuffers(v[0], count, buffs, strides, offsets);
+	}
+	break;
+
+	case eCaptureCmd::IA_SET_IB:
+		m_devContext->IASetIndexBuffer(GetObj<ID3D11Buffer>(v[0]), (DXGI_FORMAT)v[1], v[2]);
+		break;
+	case eCaptureCmd::IA_SET_TOPOLOGY:
+		m_devContext->IASetPrimitiveTopology((D3D11_PRIMITIVE_TOPOLOGY)v[0]);
+		break;
+
+	case eCaptureCmd::OM_SET_RT: // view not captured, unbind
+		m_devContext->OMSetRenderTargets(0, NULL, NULL);
+		break;
+	case eCaptureCmd::OM_SET_RT_UAV: // rtv count, ..., view not captured, unbind
+		if (D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL != v[0])
+			m_devContext->OMSetRenderTargets(0, NULL, NULL);
+		break;
+	case eCaptureCmd::OM_SET_BLEND:
+		m_devContext->OMSetBlendState(GetObj<ID3D11BlendState>(v[0]), (const FLOAT*)&v[1], v[5]);
+		break;
+	case eCaptureCmd::OM_SET_DEPTH:
+		m_devContext->OMSetDepthStencilState(GetObj<ID3D11DepthStencilState>(v[0]), v[1]);
+		break;
+	case eCaptureCmd::RS_SET_STATE:
+		m_devContext->RSSetState(GetObj<ID3D11RasterizerState>(v[0]));
+		break;
+	case eCaptureCmd::RS_SET_VIEWPORT:
+		m_devContext->RSSetViewports(min(v[0], (UINT)D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE)
+			, (const D3D11_VIEWPORT*)&v[1]);
+		break;
+	case eCaptureCmd::RS_SET_SCISSOR:
+		m_devContext->RSSetScissorRects(min(v[0], (UINT)D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE)
+			, (const D3D11_RECT*)&v[1]);
+		break;
+
+	// buffer only, texture not created
+	case eCaptureCmd::COPY_RESOURCE:
+	{
+		ID3D11Buffer *dst = GetObj<ID3D11Buffer>(v[0]);
+		ID3D11Buffer *src = GetObj<ID3D11Buffer>(v[1]);
+		if (dst && src)
+			m_devContext->CopyResource(dst, src);
+	}
+	break;
+
+	// dst id, dst subresource, x, y, z, src id, src subresource, box(6)
+	case eCaptureCmd::COPY_SUBRESOURCE_REGION:
+	{
+		ID3D11Buffer *dst = GetObj<ID3D11Buffer>(v[0]);
+		ID3D11Buffer *src = GetObj<ID3D11Buffer>(v[5]);
+		const D3D11_BOX *box = (const D3D11_BOX*)&v[7];
+		if (dst && src)
+			m_devContext->CopySubresourceRegion(dst, v[1], v[2], v[3], v[4], src, v[6]
+				, (box->right > box->left) ? box : NULL);
+	}
+	break;
+
+	default:
+		break; // MAP (contents at UNMAP), CLEAR_RTV, CLEAR_DSV, COPY_STRUCTURE_COUNT (view not captured)
+	}
+}
+
+
+void cFrameReplay::Clear()
+{
+	for (auto &obj : m_objects)
+		SAFE_RELEASE(obj);
+	m_objects.clear();
+	m_payload.clear();
+	if (m_devContext)
+		m_devContext->ClearState();
+	SAFE_RELEASE(m_devContext1);
+	SAFE_RELEASE(m_devContext);
+	SAFE_RELEASE(m_device);
+}
@@ -0,0 +1,60 @@
+//
+// 2018-05-11, jjuiddong
+// Frame Replay
+//	- replay cFrameCapture file, stream read (bounded memory)
+//	- NULL backend: decode only, API call count, CPU decode time
+//	- WARP backend: software device, state object, buffer, constant update, draw
+//	  (shader, view not captured, bind NULL)
+//	- indirect draw, dispatch : captured argument, direct call
+//	- UNSUPPORTED command (capture stopped by not recorded call) : Replay() fail
+//
+#pragma once
+
+#include "framecapture.h"
+
+
+namespace graphic
+{
+
+	class cFrameReplay
+	{
+	public:
+		struct eBackend {
+			enum Enum { NONE, WARP };
+		};
+
+		struct sResult
+		{
+			int frameCount;
+			int objectCount;
+			int callCount; // exclude frame marker, object declare
+			int calls[eCaptureCmd::MAX];
+		char unsupported[64]; // UNSUPPORTED command method name
+			__int64 fileBytes;
+			double replayMs; // total, frame begin ~ frame end
+			double maxFrameMs;
+		};
+
+		cFrameReplay();
+		virtual ~cFrameReplay();
+
+		bool Replay(const char *fileName, const eBackend::Enum backend, OUT sResult &out);
+		void Clear();
+
+
+	protected:
+		bool CreateDevice();
+		void CreateObject(const UINT *data, const UINT size);
+		void Execute(const eCaptureCmd::Enum cmd, const BYTE *data, const UINT size);
+		template<class T> T* GetObj(const UINT id) const;
+
+
+	public:
+		ID3D11Device *m_device; // WARP device, NULL = null backend
+		ID3D11DeviceContext *m_devContext;
+		ID3D11DeviceContext1 *m_devContext1; // xxSetConstantBuffers1, NULL: offset ignore
+		std::vector<ID3D11DeviceChild*> m_objects; // object id -> replay object
+		std::vector<BYTE> m_payload; // reuse
+	};
+
+}
@@ -0,0 +1,254 @@
+
+#include "../../Shared/platform.h"
+#include "frustumculler.h"
+#include "../../Shared/steadytimer.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace graphic;
+
+
+namespace
+{
+	// append set bit index, base + bit
+	inline int WriteMask(int mask, const int base, OUT int *visible)
+	{
+		int n = 0;
+		while (mask)
+		{
+			int bit = 0;
+			while (!(mask & (1 << bit)))
+				++bit;
+			visible[n++] = base + bit;
+			mask &= mask - 1;
+		}
+		return n;
+	}
+}
+
+
+cFrustumCuller::cFrustumCuller()
+{
+	ZeroMemory(m_planes, sizeof(m_planes));
+}
+
+cFrustumCuller::~cFrustumCuller()
+{
+}
+
+
+// extract plane from view projection matrix, row vector, D3D clip space (0 <= z <= w)
+// viewProj: float[16], Matrix44::m
+void cFrustumCuller::SetFrustum(const float *viewProj)
+{
+	const float (*m)[4] = (const float (*)[4])viewProj;
+	for (int i = 0; i < 4; ++i)
+	{
+		m_planes[0][i] = m[i][3] + m[i][0]; // left
+		m_planes[1][i] = m[i][3] - m[i][0]; // right
+		m_planes[2][i] = m[i][3] + m[i][1]; // bottom
+		m_planes[3][i] = m[i][3] - m[i][1]; // top
+		m_planes[4][i] = m[i][2]; // near
+		m_planes[5][i] = m[i][3] - m[i][2]; // far
+	}
+
+	for (int k = 0; k < 6; ++k)
+	{
+		float *p = m_planes[k];
+		const float len = sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+		if (len > 0.f)
+			for (int i = 0; i < 4; ++i)
+				p[i] /= len;
+	}
+}
+
+
+// visible: output index array, size >= count
+// return visible count
+int cFrustumCuller::Cull(const float *x, const float *y, const float *z, const float *r
+	, const int count, OUT int *visible) const
+{
+	int i = 0;
+	int n = 0;
+
+	// 8 wide, AVX CPU only
+	if (cSimdCpu::IsAvx())
+		i = cSimdCpu::CullSpheresAvx(m_planes, x, y, z, r, count, visible, n);
+
+#ifdef SIMD_MATH_SSE
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 vx = _mm_loadu_ps(x + i);
+		const __m128 vy = _mm_loadu_ps(y + i);
+		const __m128 vz = _mm_loadu_ps(z + i);
+		const __m128 negR = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(r + i));
+		__m128 inside;
+		for (int k = 0; k < 6; ++k)
+		{
+			const float *p = m_planes[k];
+			const __m128 d = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(vx, _mm_set1_ps(p[0])), _mm_mul_ps(vy, _mm_set1_ps(p[1])))
+				, _mm_add_ps(_mm_mul_ps(vz, _mm_set1_ps(p[2])), _mm_set1_ps(p[3])));
+			const __m128 in = _mm_cmpge_ps(d, negR);
+			inside = (k == 0) ? in : _mm_and_ps(inside, in);
+		}
+		n += WriteMask(_mm_movemask_ps(inside), i, visible + n);
+	}
+#endif
+
+	// remainder, scalar return index from i
+	if (i < count)
+	{
+		const int m = CullScalar(x + i, y + i, z + i, r + i, count - i, visible + n);
+		for (int k = n; k < n + m; ++k)
+			visible[k] += i;
+		n += m;
+	}
+	return n;
+}
+
+
+// multi thread, chunk cull to visible + chunk begin, then compact
+int cFrustumCuller::Cull(cJobSystem &jobs, const float *x, const float *y, const float *z
+	, const float *r, const int count, OUT int *visible)
+{
+	const int chunkCount = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	if (chunkCount <= 1)
+		return Cull(x, y, z, r, count, visible);
+
+	if ((int)m_chunkCounts.size() < chunkCount)
+		m_chunkCounts.resize(chunkCount);
+
+	jobs.ParallelFor(count, CHUNK_SIZE, [&](const int begin, const int end, const int) {
+		const int n = Cull(x + begin, y + begin, z + begin, r + begin, end - begin
+			, visible + begin);
+		for (int k = 0; k < n; ++k)
+			visible[begin + k] += begin;
+		m_chunkCounts[begin / CHUNK_SIZE] = n;
+	});
+
+	// chunk result always at or after write position, forward move safe
+	int n = m_chunkCounts[0];
+	for (int c = 1; c < chunkCount; ++c)
+	{
+		memmove(visible + n, visible + c * CHUNK_SIZE, sizeof(int) * m_chunkCounts[c]);
+		n += m_chunkCounts[c];
+	}
+	return n;
+}
+
+
+int cFrustumCuller::CullScalar(const float *x, const float *y, const float *z, const float *r
+	, const int count, OUT int *visible) const
+{
+	int n = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		bool inside = true;
+		for (int k = 0; inside && (k < 6); ++k)
+		{
+			const float *p = m_planes[k];
+			inside = (x[i] * p[0] + y[i] * p[1] + z[i] * p[2] + p[3]) >= -r[i];
+		}
+		if (inside)
+			visible[n++] = i;
+	}
+	return n;
+}
+
+
+// random sphere, scalar vs simd vs multi thread simd
+void cFrustumCuller::Benchmark(cJobSystem &jobs, const int count, OUT sBenchmark &out)
+{
+	ZeroMemory(&out, sizeof(out));
+	out.count = count;
+	out.threadCount = jobs.GetWorkerCount();
+	out.isAvx = cSimdCpu::IsAvx();
+	if (count <= 0)
+		return;
+
+	const float eyePos[3] = { 0, 10, -50 };
+	const float lookAt[3] = { 0, 9.8f, -49 };
+	float viewProj[16];
+	MakeViewProj(eyePos, lookAt, 3.141592654f / 4.f, 1.f, 0.1f, 100.f, viewProj);
+	cFrustumCuller culler;
+	culler.SetFrustum(viewProj);
+
+	std::vector<float> x(count), y(count), z(count), r(count);
+	srand(0);
+	for (int i = 0; i < count; ++i)
+	{
+		x[i] = (float)(rand() % 2000) * 0.1f - 100.f;
+		y[i] = (float)(rand() % 200) * 0.1f;
+		z[i] = (float)(rand() % 2000) * 0.1f - 100.f;
+		r[i] = (float)(rand() % 20) * 0.1f;
+	}
+
+	std::vector<int> scalarOut(count), simdOut(count), parallelOut(count);
+	double t0 = GetSteadyTimeMs();
+	const int n0 = culler.CullScalar(&x[0], &y[0], &z[0], &r[0], count, &scalarOut[0]);
+	out.scalarMs = GetSteadyTimeMs() - t0;
+
+	t0 = GetSteadyTimeMs();
+	const int n1 = culler.Cull(&x[0], &y[0], &z[0], &r[0], count, &simdOut[0]);
+	out.simdMs = GetSteadyTimeMs() - t0;
+
+	t0 = GetSteadyTimeMs();
+	const int n2 = culler.Cull(jobs, &x[0], &y[0], &z[0], &r[0], count, &parallelOut[0]);
+	out.parallelMs = GetSteadyTimeMs() - t0;
+
+	out.visibleCount = n0;
+	out.isMatch = (n0 == n1) && (n0 == n2)
+		&& std::equal(scalarOut.begin(), scalarOut.begin() + n0, simdOut.begin())
+		&& std::equal(scalarOut.begin(), scalarOut.begin() + n0, parallelOut.begin());
+}
+
+
+// left hand look at * perspective fov, row vector (Matrix44 SetView(), SetProjection())
+// viewProj: float[16]
+void cFrustumCuller::MakeViewProj(const float *eyePos, const float *lookAt, const float fov
+	, const float aspect, const float nearPlane, const float farPlane
+	, OUT float *viewProj)
+{
+	float z[3] = { lookAt[0] - eyePos[0], lookAt[1] - eyePos[1], lookAt[2] - eyePos[2] };
+	const float zLen = sqrt(z[0] * z[0] + z[1] * z[1] + z[2] * z[2]);
+	for (int i = 0; i < 3; ++i)
+		z[i] /= (zLen > 0.f) ? zLen : 1.f;
+
+	// x = up(0,1,0) cross z, y = z cross x
+	float x[3] = { z[2], 0, -z[0] };
+	const float xLen = sqrt(x[0] * x[0] + x[2] * x[2]);
+	if (xLen > 0.f)
+	{
+		x[0] /= xLen;
+		x[2] /= xLen;
+	}
+	else
+	{
+		x[0] = 1.f; // look straight up, down
+	}
+	const float y[3] = { z[1] * x[2] - z[2] * x[1], z[2] * x[0] - z[0] * x[2]
+		, z[0] * x[1] - z[1] * x[0] };
+
+	const float view[4][4] = {
+		{ x[0], y[0], z[0], 0 }
+		, { x[1], y[1], z[1], 0 }
+		, { x[2], y[2], z[2], 0 }
+		, { -(x[0] * eyePos[0] + x[1] * eyePos[1] + x[2] * eyePos[2])
+			, -(y[0] * eyePos[0] + y[1] * eyePos[1] + y[2] * eyePos[2])
+			, -(z[0] * eyePos[0] + z[1] * eyePos[1] + z[2] * eyePos[2]), 1 } };
+
+	const float yScale = 1.f / tan(fov / 2.f);
+	const float xScale = yScale / aspect;
+	const float q = farPlane / (farPlane - nearPlane);
+
+	// view * proj, proj non zero: [0][0], [1][1], [2][2], [2][3] = 1, [3][2]
+	for (int r = 0; r < 4; ++r)
+	{
+		float *out = viewProj + r * 4;
+		out[0] = view[r][0] * xScale;
+		out[1] = view[r][1] * yScale;
+		out[2] = view[r][2] * q + view[r][3] * (-nearPlane * q);
+		out[3] = view[r][2];
+	}
+}
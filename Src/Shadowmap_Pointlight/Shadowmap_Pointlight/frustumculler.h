@@ -0,0 +1,59 @@
+//
+// 2018-05-15, jjuiddong
+// Frustum Culler
+//	- bounding sphere vs 6 frustum plane, SoA input (cTransformHierarchy bound array)
+//	- AVX 8 object (runtime dispatch, simdavx.cpp), SSE 4 object per iteration
+//	  scalar remainder
+//	- output compact visible index list
+//	- Cull(jobs, ..) split by chunk, multi thread
+//	- no Common dependency (Shared/platform.h), matrix = float[16] row major
+//
+#pragma once
+
+#include "simdcpu.h"
+#include "jobsystem.h"
+
+
+namespace graphic
+{
+
+	class cFrustumCuller
+	{
+	public:
+		struct sBenchmark
+		{
+			int count;
+			int threadCount;
+			int visibleCount;
+			double scalarMs;
+			double simdMs;
+			double parallelMs;
+			bool isMatch; // scalar, simd, parallel same result
+			bool isAvx; // simd = AVX kernel, else SSE
+		};
+
+		cFrustumCuller();
+		virtual ~cFrustumCuller();
+
+		void SetFrustum(const float *viewProj);
+		int Cull(const float *x, const float *y, const float *z, const float *r
+			, const int count, OUT int *visible) const;
+		int Cull(cJobSystem &jobs, const float *x, const float *y, const float *z
+			, const float *r, const int count, OUT int *visible);
+		int CullScalar(const float *x, const float *y, const float *z, const float *r
+			, const int count, OUT int *visible) const;
+		void Benchmark(cJobSystem &jobs, const int count, OUT sBenchmark &out);
+
+		static void MakeViewProj(const float *eyePos, const float *lookAt, const float fov
+			, const float aspect, const float nearPlane, const float farPlane
+			, OUT float *viewProj);
+
+
+	public:
+		enum { CHUNK_SIZE = 4096 };
+
+		float m_planes[6][4]; // normalized, dot(plane, (p,1)) >= 0 inside
+		std::vector<int> m_chunkCounts; // Cull(jobs, ..) visible count per chunk
+	};
+
+}
@@ -189,7 +189,14 @@ void cGBuffer::End(cRenderer &renderer)
 
 void cGBuffer::PrepareForUnpack(cRenderer &renderer)
 {
-	ID3D11DeviceContext *devContext = renderer.GetDevContext();
+	SetUnpackValue();
+	m_cbGBuffer.Update(renderer, 7);
+}
+
+
+// update unpack constant value, no upload
+void cGBuffer::SetUnpackValue()
+{
 	cCamera &cam = GetMainCamera();
 
 	const Matrix44 proj = cam.GetProjectionMatrix();
@@ -200,7 +207,6 @@ void cGBuffer::PrepareForUnpack(cRenderer &renderer)
 
 	m_cbGBuffer.m_v->perspectiveValue = XMLoadFloat4((XMFLOAT4*)&v1);
 	m_cbGBuffer.m_v->invView = XMMatrixTranspose(cam.GetViewMatrix().Inverse().GetMatrixXM());
-	m_cbGBuffer.Update(renderer, 7);
 }
 
 
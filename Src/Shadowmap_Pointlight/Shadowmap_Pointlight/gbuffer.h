@@ -23,6 +23,7 @@ public:
 	bool Begin(graphic::cRenderer &renderer);
 	void End(graphic::cRenderer &renderer);
 	void PrepareForUnpack(graphic::cRenderer &renderer);
+	void SetUnpackValue();
 	void Render(graphic::cRenderer &renderer);
 	void Clear();
 
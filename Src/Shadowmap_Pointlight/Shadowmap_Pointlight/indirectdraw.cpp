@@ -0,0 +1,486 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "indirectdraw.h"
+#include "../../Shared/steadytimer.h"
+
+using namespace graphic;
+
+
+namespace
+{
+	const UINT TARGET_SIZE = 256;
+	const UINT CUBE_INDEX_COUNT = 36;
+	const UINT CULL_GROUP_SIZE = 64; // indirectdraw.fx, CS_Cull numthreads
+
+	struct sCbCull
+	{
+		XMFLOAT4 planes[6];
+		UINT instanceCount;
+		UINT pad[3];
+	};
+
+	struct sCbDraw
+	{
+		XMFLOAT4X4 viewProj; // transposed
+		UINT instanceIndex;
+		UINT pad[3];
+	};
+}
+
+
+cIndirectDraw::cIndirectDraw()
+	: m_instanceCount(0)
+	, m_effect(NULL)
+	, m_cs(NULL)
+	, m_vs(NULL)
+	, m_vsSingle(NULL)
+	, m_ps(NULL)
+	, m_layout(NULL)
+	, m_vtxBuff(NULL)
+	, m_idxBuff(NULL)
+	, m_cbCull(NULL)
+	, m_cbDraw(NULL)
+	, m_instBuff(NULL)
+	, m_instSRV(NULL)
+	, m_visibleBuff(NULL)
+	, m_visibleSRV(NULL)
+	, m_visibleUAV(NULL)
+	, m_argsBuff(NULL)
+	, m_argsUAV(NULL)
+	, m_argsStaging(NULL)
+	, m_rtTex(NULL)
+	, m_rtv(NULL)
+	, m_dsTex(NULL)
+	, m_dsv(NULL)
+{
+}
+
+cIndirectDraw::~cIndirectDraw()
+{
+	Clear();
+}
+
+
+// instanceCount: cube grid, 100 x 100 x (instanceCount / 10000)
+bool cIndirectDraw::Create(cRenderer &renderer
+	, const int instanceCount //= 100000
+)
+{
+	Clear();
+
+	RETV2(instanceCount <= 0, false);
+	m_instanceCount = instanceCount;
+
+	// same camera with cDrawBenchmark
+	const XMMATRIX viewProj =
+		XMMatrixLookAtLH(XMVectorSet(0, 60, -80, 1), XMVectorSet(0, 0, 0, 1), XMVectorSet(0, 1, 0, 0))
+		* XMMatrixPerspectiveFovLH(MATH_PI / 4.f, 1.f, 0.1f, 1000.f);
+	XMStoreFloat4x4((XMFLOAT4X4*)&m_viewProj.m[0][0], viewProj);
+	m_culler.SetFrustum(&m_viewProj.m[0][0]);
+
+	ID3D11Device *device = renderer.GetDevice();
+	RETV2(!CreateShader(device), false);
+	RETV2(!CreateBuffer(device), false);
+	return true;
+}
+
+
+// shader, extract from effect, bind by register
+bool cIndirectDraw::CreateShader(ID3D11Device *device)
+{
+	std::vector<BYTE> data;
+	FILE *fp = NULL;
+	if (fopen_s(&fp, "../Media/shadowmap_pointlight/indirectdraw.fxo", "rb") || !fp)
+		return false;
+	fseek(fp, 0, SEEK_END);
+	data.resize(max(0L, ftell(fp)));
+	fseek(fp, 0, SEEK_SET);
+	const size_t readSize = data.empty() ? 0 : fread(&data[0], 1, data.size(), fp);
+	fclose(fp);
+	RETV2(data.empty() || (readSize != data.size()), false);
+
+	HRESULT hr = D3DX11CreateEffectFromMemory(&data[0], data.size(), 0, device, &m_effect);
+	RETV2(FAILED(hr), false);
+
+	ID3DX11EffectPass *cullPass = m_effect->GetTechniqueByName("Cull")->GetPassByIndex(0);
+	ID3DX11EffectPass *drawPass = m_effect->GetTechniqueByName("Draw")->GetPassByIndex(0);
+	ID3DX11EffectPass *singlePass = m_effect->GetTechniqueByName("DrawSingle")->GetPassByIndex(0);
+	RETV2(!cullPass->IsValid() || !drawPass->IsValid() || !singlePass->IsValid(), false);
+
+	D3DX11_PASS_SHADER_DESC csDesc, vsDesc, psDesc, singleDesc;
+	cullPass->GetComputeShaderDesc(&csDesc);
+	drawPass->GetVertexShaderDesc(&vsDesc);
+	drawPass->GetPixelShaderDesc(&psDesc);
+	singlePass->GetVertexShaderDesc(&singleDesc);
+	csDesc.pShaderVariable->GetComputeShader(csDesc.ShaderIndex, &m_cs);
+	vsDesc.pShaderVariable->GetVertexShader(vsDesc.ShaderIndex, &m_vs);
+	psDesc.pShaderVariable->GetPixelShader(psDesc.ShaderIndex, &m_ps);
+	singleDesc.pShaderVariable->GetVertexShader(singleDesc.ShaderIndex, &m_vsSingle);
+	RETV2(!m_cs || !m_vs || !m_ps || !m_vsSingle, false);
+
+	D3DX11_PASS_DESC passDesc;
+	drawPass->GetDesc(&passDesc);
+	const D3D11_INPUT_ELEMENT_DESC elems[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	};
+	hr = device->CreateInputLayout(elems, ARRAYSIZE(elems), passDesc.pIAInputSignature
+		, passDesc.IAInputSignatureSize, &m_layout);
+	RETV2(FAILED(hr), false);
+	return true;
+}
+
+
+bool cIndirectDraw::CreateBuffer(ID3D11Device *device)
+{
+	D3D11_BUFFER_DESC bd;
+	D3D11_SUBRESOURCE_DATA initData;
+	ZeroMemory(&initData, sizeof(initData));
+
+	// cube
+	{
+		const float vertices[] = {
+			-1,-1,-1,  -1,1,-1,  1,1,-1,  1,-1,-1,
+			-1,-1,1,  -1,1,1,  1,1,1,  1,-1,1,
+		};
+		const WORD indices[CUBE_INDEX_COUNT] = {
+			0,1,2, 0,2,3, 4,6,5, 4,7,6, 4,5,1, 4,1,0,
+			3,2,6, 3,6,7, 1,5,6, 1,6,2, 4,0,3, 4,3,7,
+		};
+
+		ZeroMemory(&bd, sizeof(bd));
+		bd.Usage = D3D11_USAGE_IMMUTABLE;
+		bd.ByteWidth = sizeof(vertices);
+		bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		initData.pSysMem = vertices;
+		RETV2(FAILED(device->CreateBuffer(&bd, &initData, &m_vtxBuff)), false);
+
+		bd.ByteWidth = sizeof(indices);
+		bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		initData.pSysMem = indices;
+		RETV2(FAILED(device->CreateBuffer(&bd, &initData, &m_idxBuff)), false);
+	}
+
+	// constant buffer, UpdateSubresource()
+	{
+		ZeroMemory(&bd, sizeof(bd));
+		bd.Usage = D3D11_USAGE_DEFAULT;
+		bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		bd.ByteWidth = sizeof(sCbCull);
+		RETV2(FAILED(device->CreateBuffer(&bd, NULL, &m_cbCull)), false);
+		bd.ByteWidth = sizeof(sCbDraw);
+		RETV2(FAILED(device->CreateBuffer(&bd, NULL, &m_cbDraw)), false);
+	}
+
+	// instance, persistent structured buffer
+	{
+		std::vector<sInstance> instances(m_instanceCount);
+		m_boundX.resize(m_instanceCount);
+		m_boundY.resize(m_instanceCount);
+		m_boundZ.resize(m_instanceCount);
+		m_boundR.resize(m_instanceCount);
+		m_visible.resize(m_instanceCount);
+
+		const float scale = 0.4f;
+		for (int i = 0; i < m_instanceCount; ++i)
+		{
+			const float x = (float)(i % 100) - 50.f;
+			const float z = (float)((i / 100) % 100) - 50.f;
+			const float y = (float)(i / 10000);
+
+			sInstance &inst = instances[i];
+			inst.bound = XMFLOAT4(x, y, z, scale * 1.732f);
+			inst.world.SetIdentity();
+			inst.world.m[0][0] = inst.world.m[1][1] = inst.world.m[2][2] = scale;
+			inst.world.m[3][0] = x;
+			inst.world.m[3][1] = y;
+			inst.world.m[3][2] = z;
+
+			m_boundX[i] = x;
+			m_boundY[i] = y;
+			m_boundZ[i] = z;
+			m_boundR[i] = inst.bound.w;
+		}
+
+		ZeroMemory(&bd, sizeof(bd));
+		bd.Usage = D3D11_USAGE_DEFAULT;
+		bd.ByteWidth = sizeof(sInstance) * m_instanceCount;
+		bd.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		bd.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		bd.StructureByteStride = sizeof(sInstance);
+		initData.pSysMem = &instances[0];
+		RETV2(FAILED(device->CreateBuffer(&bd, &initData, &m_instBuff)), false);
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+		ZeroMemory(&srvDesc, sizeof(srvDesc));
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.NumElements = m_instanceCount;
+		RETV2(FAILED(device->CreateShaderResourceView(m_instBuff, &srvDesc, &m_instSRV)), false);
+	}
+
+	// visible instance index, compute shader write, vertex shader read
+	{
+		ZeroMemory(&bd, sizeof(bd));
+		bd.Usage = D3D11_USAGE_DEFAULT;
+		bd.ByteWidth = sizeof(UINT) * m_instanceCount;
+		bd.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
+		bd.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		bd.StructureByteStride = sizeof(UINT);
+		RETV2(FAILED(device->CreateBuffer(&bd, NULL, &m_visibleBuff)), false);
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+		ZeroMemory(&srvDesc, sizeof(srvDesc));
+		srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+		srvDesc.Buffer.NumElements = m_instanceCount;
+		RETV2(FAILED(device->CreateShaderResourceView(m_visibleBuff, &srvDesc, &m_visibleSRV)), false);
+
+		D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc;
+		ZeroMemory(&uavDesc, sizeof(uavDesc));
+		uavDesc.Format = DXGI_FORMAT_UNKNOWN;
+		uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+		uavDesc.Buffer.NumElements = m_instanceCount;
+		RETV2(FAILED(device->CreateUnorderedAccessView(m_visibleBuff, &uavDesc, &m_visibleUAV)), false);
+	}
+
+	// indirect draw argument, raw view for InterlockedAdd()
+	{
+		ZeroMemory(&bd, sizeof(bd));
+		bd.Usage = D3D11_USAGE_DEFAULT;
+		bd.ByteWidth = sizeof(sDrawArgs);
+		bd.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+		bd.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS | D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+		RETV2(FAILED(device->CreateBuffer(&bd, NULL, &m_argsBuff)), false);
+
+		D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc;
+		ZeroMemory(&uavDesc, sizeof(uavDesc));
+		uavDesc.Format = DXGI_FORMAT_R32_TYPELESS;
+		uavDesc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+		uavDesc.Buffer.NumElements = sizeof(sDrawArgs) / sizeof(UINT);
+		uavDesc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+		RETV2(FAILED(device->CreateUnorderedAccessView(m_argsBuff, &uavDesc, &m_argsUAV)), false);
+
+		ZeroMemory(&bd, sizeof(bd));
+		bd.Usage = D3D11_USAGE_STAGING;
+		bd.ByteWidth = sizeof(sDrawArgs);
+		bd.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+		RETV2(FAILED(device->CreateBuffer(&bd, NULL, &m_argsStaging)), false);
+	}
+
+	// offscreen target
+	{
+		D3D11_TEXTURE2D_DESC td;
+		ZeroMemory(&td, sizeof(td));
+		td.Width = TARGET_SIZE;
+		td.Height = TARGET_SIZE;
+		td.MipLevels = 1;
+		td.ArraySize = 1;
+		td.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		td.SampleDesc.Count = 1;
+		td.Usage = D3D11_USAGE_DEFAULT;
+		td.BindFlags = D3D11_BIND_RENDER_TARGET;
+		RETV2(FAILED(device->CreateTexture2D(&td, NULL, &m_rtTex)), false);
+		RETV2(FAILED(device->CreateRenderTargetView(m_rtTex, NULL, &m_rtv)), false);
+
+		td.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+		td.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+		RETV2(FAILED(device->CreateTexture2D(&td, NULL, &m_dsTex)), false);
+		RETV2(FAILED(device->CreateDepthStencilView(m_dsTex, NULL, &m_dsv)), false);
+	}
+
+	return true;
+}
+
+
+// per object draw vs CPU cull + indirect draw vs GPU cull + indirect draw
+// CPU submission time, GPU visible count read back after
+bool cIndirectDraw::Run(cRenderer &renderer, OUT sResult &out)
+{
+	RETV2(!m_argsBuff, false);
+
+	ID3D11DeviceContext *devContext = renderer.GetDevContext();
+	ZeroMemory(&out, sizeof(out));
+	out.instanceCount = m_instanceCount;
+
+	ID3D11RenderTargetView *prevRtv = NULL;
+	ID3D11DepthStencilView *prevDsv = NULL;
+	D3D11_VIEWPORT prevVp;
+	UINT prevVpCount = 1;
+	devContext->OMGetRenderTargets(1, &prevRtv, &prevDsv);
+	devContext->RSGetViewports(&prevVpCount, &prevVp);
+
+	const float clearColor[4] = { 0, 0, 0, 1 };
+	devContext->ClearRenderTargetView(m_rtv, clearColor);
+	devContext->ClearDepthStencilView(m_dsv, D3D11_CLEAR_DEPTH, 1.f, 0);
+
+	sCbDraw cbDraw;
+	ZeroMemory(&cbDraw, sizeof(cbDraw));
+	XMStoreFloat4x4(&cbDraw.viewProj, XMMatrixTranspose(m_viewProj.GetMatrixXM()));
+
+	// 1. CPU cull, draw per visible object
+	{
+		const double t0 = GetSteadyTimeMs();
+		const int count = CullCpu();
+		SetDrawState(devContext, m_vsSingle);
+		for (int i = 0; i < count; ++i)
+		{
+			cbDraw.instanceIndex = (UINT)m_visible[i];
+			devContext->UpdateSubresource(m_cbDraw, 0, NULL, &cbDraw, 0, 0);
+			devContext->DrawIndexed(CUBE_INDEX_COUNT, 0, 0);
+		}
+		out.perObjectMs = GetSteadyTimeMs() - t0;
+		out.cpuVisibleCount = count;
+	}
+
+	// 2. CPU cull, upload visible index, one indirect draw
+	{
+		const double t0 = GetSteadyTimeMs();
+		const int count = CullCpu();
+		if (count > 0)
+		{
+			D3D11_BOX box = { 0, 0, 0, sizeof(UINT) * count, 1, 1 };
+			devContext->UpdateSubresource(m_visibleBuff, 0, &box, &m_visible[0], 0, 0);
+		}
+		ResetDrawArgs(devContext, (UINT)count);
+
+		cbDraw.instanceIndex = 0;
+		devContext->UpdateSubresource(m_cbDraw, 0, NULL, &cbDraw, 0, 0);
+		SetDrawState(devContext, m_vs);
+		devContext->DrawIndexedInstancedIndirect(m_argsBuff, 0);
+		out.cpuCullMs = GetSteadyTimeMs() - t0;
+	}
+
+	// 3. GPU cull, one indirect draw
+	{
+		const double t0 = GetSteadyTimeMs();
+		CullGpu(devContext);
+		SetDrawState(devContext, m_vs);
+		devContext->DrawIndexedInstancedIndirect(m_argsBuff, 0);
+		out.gpuCullMs = GetSteadyTimeMs() - t0;
+	}
+
+	// read back GPU visible count, wait GPU
+	devContext->CopyResource(m_argsStaging, m_argsBuff);
+	D3D11_MAPPED_SUBRESOURCE res;
+	if (SUCCEEDED(devContext->Map(m_argsStaging, 0, D3D11_MAP_READ, 0, &res)))
+	{
+		out.gpuVisibleCount = (int)((sDrawArgs*)res.pData)->instanceCount;
+		devContext->Unmap(m_argsStaging, 0);
+	}
+	out.isMatch = (out.cpuVisibleCount == out.gpuVisibleCount);
+
+	ID3D11ShaderResourceView *nullSRV[2] = { NULL, NULL };
+	devContext->VSSetShaderResources(0, 2, nullSRV);
+	devContext->OMSetRenderTargets(1, &prevRtv, prevDsv);
+	if (prevVpCount > 0)
+		devContext->RSSetViewports(1, &prevVp);
+	SAFE_RELEASE(prevRtv);
+	SAFE_RELEASE(prevDsv);
+	return true;
+}
+
+
+void cIndirectDraw::SetDrawState(ID3D11DeviceContext *devContext, ID3D11VertexShader *vs)
+{
+	D3D11_VIEWPORT vp;
+	vp.TopLeftX = 0;
+	vp.TopLeftY = 0;
+	vp.Width = (float)TARGET_SIZE;
+	vp.Height = (float)TARGET_SIZE;
+	vp.MinDepth = 0;
+	vp.MaxDepth = 1;
+
+	const UINT stride = sizeof(float) * 3;
+	const UINT offset = 0;
+	ID3D11ShaderResourceView *srvs[2] = { m_instSRV, m_visibleSRV };
+	devContext->OMSetRenderTargets(1, &m_rtv, m_dsv);
+	devContext->RSSetViewports(1, &vp);
+	devContext->IASetInputLayout(m_layout);
+	devContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	devContext->IASetVertexBuffers(0, 1, &m_vtxBuff, &stride, &offset);
+	devContext->IASetIndexBuffer(m_idxBuff, DXGI_FORMAT_R16_UINT, 0);
+	devContext->VSSetShader(vs, NULL, 0);
+	devContext->PSSetShader(m_ps, NULL, 0);
+	devContext->VSSetConstantBuffers(1, 1, &m_cbDraw);
+	devContext->VSSetShaderResources(0, 2, srvs);
+}
+
+
+// SIMD frustum cull, same test with CS_Cull
+// return visible count, m_visible
+int cIndirectDraw::CullCpu()
+{
+	return m_culler.Cull(&m_boundX[0], &m_boundY[0], &m_boundZ[0], &m_boundR[0]
+		, m_instanceCount, &m_visible[0]);
+}
+
+
+// compute shader write visible index, InstanceCount of draw argument
+void cIndirectDraw::CullGpu(ID3D11DeviceContext *devContext)
+{
+	sCbCull cb;
+	ZeroMemory(&cb, sizeof(cb));
+	for (int i = 0; i < 6; ++i)
+		cb.planes[i] = XMFLOAT4(m_culler.m_planes[i]);
+	cb.instanceCount = (UINT)m_instanceCount;
+	devContext->UpdateSubresource(m_cbCull, 0, NULL, &cb, 0, 0);
+	ResetDrawArgs(devContext, 0);
+
+	// visible buffer, unbind vertex shader input before UAV bind
+	ID3D11ShaderResourceView *nullSRV[2] = { NULL, NULL };
+	ID3D11UnorderedAccessView *uavs[2] = { m_visibleUAV, m_argsUAV };
+	devContext->VSSetShaderResources(0, 2, nullSRV);
+	devContext->CSSetShader(m_cs, NULL, 0);
+	devContext->CSSetConstantBuffers(0, 1, &m_cbCull);
+	devContext->CSSetShaderResources(0, 1, &m_instSRV);
+	devContext->CSSetUnorderedAccessViews(0, 2, uavs, NULL);
+	devContext->Dispatch((m_instanceCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+	ID3D11UnorderedAccessView *nullUAV[2] = { NULL, NULL };
+	devContext->CSSetUnorderedAccessViews(0, 2, nullUAV, NULL);
+	devContext->CSSetShaderResources(0, 1, nullSRV);
+	devContext->CSSetShader(NULL, NULL, 0);
+}
+
+
+void cIndirectDraw::ResetDrawArgs(ID3D11DeviceContext *devContext, const UINT instanceCount)
+{
+	const sDrawArgs args = { CUBE_INDEX_COUNT, instanceCount, 0, 0, 0 };
+	devContext->UpdateSubresource(m_argsBuff, 0, NULL, &args, 0, 0);
+}
+
+
+void cIndirectDraw::Clear()
+{
+	SAFE_RELEASE(m_dsv);
+	SAFE_RELEASE(m_dsTex);
+	SAFE_RELEASE(m_rtv);
+	SAFE_RELEASE(m_rtTex);
+	SAFE_RELEASE(m_argsStaging);
+	SAFE_RELEASE(m_argsUAV);
+	SAFE_RELEASE(m_argsBuff);
+	SAFE_RELEASE(m_visibleUAV);
+	SAFE_RELEASE(m_visibleSRV);
+	SAFE_RELEASE(m_visibleBuff);
+	SAFE_RELEASE(m_instSRV);
+	SAFE_RELEASE(m_instBuff);
+	SAFE_RELEASE(m_cbDraw);
+	SAFE_RELEASE(m_cbCull);
+	SAFE_RELEASE(m_idxBuff);
+	SAFE_RELEASE(m_vtxBuff);
+	SAFE_RELEASE(m_layout);
+	SAFE_RELEASE(m_ps);
+	SAFE_RELEASE(m_vsSingle);
+	SAFE_RELEASE(m_vs);
+	SAFE_RELEASE(m_cs);
+	SAFE_RELEASE(m_effect);
+	m_boundX.clear();
+	m_boundY.clear();
+	m_boundZ.clear();
+	m_boundR.clear();
+	m_visible.clear();
+	m_instanceCount = 0;
+}
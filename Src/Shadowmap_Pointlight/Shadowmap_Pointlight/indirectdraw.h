@@ -0,0 +1,100 @@
+//
+// 2018-05-17, jjuiddong
+// GPU Driven Culling, Indirect Draw
+//	- instance bound, world matrix in persistent structured buffer
+//	- cull by compute shader -> visible index, DrawIndexedInstancedIndirect argument
+//	- same cull on CPU (cFrustumCuller, SIMD) -> upload argument, for test, fallback
+//	- one indirect draw per mesh, CPU cost not depend on object count
+//	- compare with per object draw, render to offscreen target
+//
+#pragma once
+
+#include "frustumculler.h"
+
+
+namespace graphic
+{
+
+	class cIndirectDraw
+	{
+	public:
+		// DrawIndexedInstancedIndirect argument
+		struct sDrawArgs
+		{
+			UINT indexCountPerInstance;
+			UINT instanceCount;
+			UINT startIndexLocation;
+			INT baseVertexLocation;
+			UINT startInstanceLocation;
+		};
+
+		// structured buffer element, HLSL sInstance
+		struct sInstance
+		{
+			XMFLOAT4 bound; // xyz: center, w: radius
+			Matrix44 world; // row major
+		};
+
+		struct sResult
+		{
+			int instanceCount;
+			int cpuVisibleCount;
+			int gpuVisibleCount; // read back
+			bool isMatch; // cpu, gpu visible count same
+			double perObjectMs; // CPU cull, draw per visible object
+			double cpuCullMs; // CPU cull, upload, one indirect draw
+			double gpuCullMs; // dispatch, one indirect draw
+		};
+
+		cIndirectDraw();
+		virtual ~cIndirectDraw();
+
+		bool Create(cRenderer &renderer, const int instanceCount = 100000);
+		bool Run(cRenderer &renderer, OUT sResult &out);
+		void Clear();
+
+
+	protected:
+		bool CreateShader(ID3D11Device *device);
+		bool CreateBuffer(ID3D11Device *device);
+		void SetDrawState(ID3D11DeviceContext *devContext, ID3D11VertexShader *vs);
+		int CullCpu();
+		void CullGpu(ID3D11DeviceContext *devContext);
+		void ResetDrawArgs(ID3D11DeviceContext *devContext, const UINT instanceCount);
+
+
+	public:
+		int m_instanceCount;
+		ID3DX11Effect *m_effect;
+		ID3D11ComputeShader *m_cs;
+		ID3D11VertexShader *m_vs; // indirect draw
+		ID3D11VertexShader *m_vsSingle; // per object draw
+		ID3D11PixelShader *m_ps;
+		ID3D11InputLayout *m_layout;
+		ID3D11Buffer *m_vtxBuff;
+		ID3D11Buffer *m_idxBuff;
+		ID3D11Buffer *m_cbCull; // frustum plane, instance count
+		ID3D11Buffer *m_cbDraw; // viewproj, instance index
+		ID3D11Buffer *m_instBuff; // sInstance
+		ID3D11ShaderResourceView *m_instSRV;
+		ID3D11Buffer *m_visibleBuff; // visible instance index
+		ID3D11ShaderResourceView *m_visibleSRV;
+		ID3D11UnorderedAccessView *m_visibleUAV;
+		ID3D11Buffer *m_argsBuff; // sDrawArgs
+		ID3D11UnorderedAccessView *m_argsUAV;
+		ID3D11Buffer *m_argsStaging; // read back
+		ID3D11Texture2D *m_rtTex;
+		ID3D11RenderTargetView *m_rtv;
+		ID3D11Texture2D *m_dsTex;
+		ID3D11DepthStencilView *m_dsv;
+
+		cFrustumCuller m_culler;
+		Matrix44 m_viewProj;
+		std::vector<float> m_boundX; // CPU cull, SoA
+		std::vector<float> m_boundY;
+		std::vector<float> m_boundZ;
+		std::vector<float> m_boundR;
+		std::vector<int> m_visible; // CPU cull result
+	};
+
+}
@@ -0,0 +1,129 @@
+
+#include "../../Shared/platform.h"
+#include "jobsystem.h"
+#include <algorithm>
+
+using namespace graphic;
+
+
+cJobSystem::cJobSystem()
+	: m_isLoop(false)
+	, m_job(NULL)
+	, m_generation(0)
+	, m_busyCount(0)
+{
+}
+
+cJobSystem::~cJobSystem()
+{
+	Clear();
+}
+
+
+// threadCount: worker thread count, 0 = core count - 1
+bool cJobSystem::Create(
+	const int threadCount //= 0
+)
+{
+	Clear();
+
+	const int count = (threadCount > 0) ? threadCount
+		: std::max(1, (int)std::thread::hardware_concurrency() - 1);
+
+	m_isLoop = true;
+	for (int i = 0; i < count; ++i)
+		m_threads.push_back(std::thread(&cJobSystem::WorkerThread, this, i + 1));
+	return true;
+}
+
+
+// call func(begin, end, workerIdx) for every chunk, return when all chunk finish
+// ParallelFor() -> Run(), func not copied
+void cJobSystem::Run(const int count, const int chunkSize, JobInvoker invoker, const void *func)
+{
+	if (count <= 0)
+		return;
+
+	sJob job;
+	job.invoker = invoker;
+	job.func = func;
+	job.count = count;
+	job.chunkSize = std::max(1, chunkSize);
+	job.next = 0;
+
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_job = &job;
+		++m_generation;
+	}
+	m_jobCond.notify_all();
+
+	Work(job, 0);
+
+	// wait worker thread, late worker see NULL job after return
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCond.wait(lock, [this]() { return 0 == m_busyCount; });
+	m_job = NULL;
+}
+
+
+// caller thread + worker thread
+int cJobSystem::GetWorkerCount() const
+{
+	return (int)m_threads.size() + 1;
+}
+
+
+void cJobSystem::Work(sJob &job, const int workerIdx)
+{
+	while (1)
+	{
+		const int begin = job.next.fetch_add(job.chunkSize);
+		if (begin >= job.count)
+			break;
+		job.invoker(job.func, begin, std::min(job.count, begin + job.chunkSize), workerIdx);
+	}
+}
+
+
+void cJobSystem::WorkerThread(const int workerIdx)
+{
+	int generation = 0;
+	while (1)
+	{
+		sJob *job = NULL;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobCond.wait(lock, [&]() { return !m_isLoop || (generation != m_generation); });
+			if (!m_isLoop)
+				break;
+			generation = m_generation;
+			job = m_job;
+			if (!job)
+				continue; // woke after Run() return, job already finish
+			++m_busyCount;
+		}
+
+		Work(*job, workerIdx);
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			--m_busyCount;
+		}
+		m_doneCond.notify_one();
+	}
+}
+
+
+void cJobSystem::Clear()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_isLoop = false;
+	}
+	m_jobCond.notify_all();
+	for (auto &th : m_threads)
+		if (th.joinable())
+			th.join();
+	m_threads.clear();
+}
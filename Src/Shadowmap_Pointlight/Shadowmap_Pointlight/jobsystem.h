@@ -0,0 +1,78 @@
+//
+// 2018-05-09, jjuiddong
+// Job System
+//	- fixed worker thread pool
+//	- ParallelFor() split [0, count) by chunk, caller thread also work
+//	- ParallelFor() callable reference + invoker, no copy, no heap allocation
+//	- job parameter, chunk counter per Run() (sJob, caller stack)
+//	  worker take job pointer with m_mutex, never see next job parameter
+//	- no Common dependency (Shared/platform.h)
+//
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+
+namespace graphic
+{
+
+	class cJobSystem
+	{
+	public:
+		// func, begin, end, worker index (0 = caller thread)
+		typedef void(*JobInvoker)(const void *, const int, const int, const int);
+
+		// one ParallelFor() call, Run() stack, valid until all worker done
+		struct sJob
+		{
+			JobInvoker invoker;
+			const void *func; // caller callable
+			int count;
+			int chunkSize;
+			std::atomic<int> next; // next chunk begin
+		};
+
+		cJobSystem();
+		virtual ~cJobSystem();
+
+		bool Create(const int threadCount = 0);
+
+		// func(begin, end, workerIdx), func referenced until return
+		template<class Func>
+		void ParallelFor(const int count, const int chunkSize, const Func &func) {
+			Run(count, chunkSize, &Invoke<Func>, &func);
+		}
+
+		int GetWorkerCount() const;
+		void Clear();
+
+
+	protected:
+		template<class Func>
+		static void Invoke(const void *func, const int begin, const int end, const int workerIdx) {
+			(*(const Func*)func)(begin, end, workerIdx);
+		}
+
+		void Run(const int count, const int chunkSize, JobInvoker invoker, const void *func);
+		void WorkerThread(const int workerIdx);
+		void Work(sJob &job, const int workerIdx);
+
+
+	public:
+		bool m_isLoop;
+		std::vector<std::thread> m_threads;
+		std::mutex m_mutex;
+		std::condition_variable m_jobCond;
+		std::condition_variable m_doneCond;
+
+		// m_mutex
+		sJob *m_job; // current ParallelFor() job, NULL: finish
+		int m_generation; // increase every ParallelFor()
+		int m_busyCount; // worker thread running m_job
+	};
+
+}
@@ -0,0 +1,469 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "meshimporter.h"
+#include "meshsimplifier.h"
+#include "meshoptimizer.h"
+#include "meshlet.h"
+#include "simdmath.h"
+#include <map>
+
+using namespace graphic;
+
+
+namespace
+{
+	const DWORD MESH_MAGIC = 0x4853454d; // 'MESH'
+
+	// DirectX .x text format tokenizer
+	// separator: white space , ;
+	// comment: // or # to end of line
+	struct sXReader
+	{
+		const char *p;
+		const char *end;
+
+		void SkipSeparator() {
+			while (p < end)
+			{
+				if (isspace((BYTE)*p) || (*p == ',') || (*p == ';'))
+				{
+					++p;
+				}
+				else if ((*p == '#') || ((*p == '/') && (p + 1 < end) && (p[1] == '/')))
+				{
+					while ((p < end) && (*p != '\n'))
+						++p;
+				}
+				else
+				{
+					break;
+				}
+			}
+		}
+
+		bool IsEnd() {
+			SkipSeparator();
+			return p >= end;
+		}
+
+		// next character, not consume
+		char Peek() {
+			SkipSeparator();
+			return (p < end) ? *p : 0;
+		}
+
+		bool Expect(const char c) {
+			if (Peek() != c)
+				return false;
+			++p;
+			return true;
+		}
+
+		std::string ReadWord() {
+			SkipSeparator();
+			const char *begin = p;
+			while ((p < end) && !isspace((BYTE)*p) && (*p != ',') && (*p != ';')
+				&& (*p != '{') && (*p != '}'))
+				++p;
+			return std::string(begin, p);
+		}
+
+		float ReadFloat() {
+			SkipSeparator();
+			char *next = NULL;
+			const float v = strtof(p, &next);
+			p = next;
+			return v;
+		}
+
+		int ReadInt() {
+			SkipSeparator();
+			char *next = NULL;
+			const int v = (int)strtol(p, &next, 10);
+			p = next;
+			return v;
+		}
+
+		// skip until matching '}', current block depth 1
+		void SkipBlock() {
+			int depth = 1;
+			while ((p < end) && (depth > 0))
+			{
+				if (*p == '{')
+					++depth;
+				else if (*p == '}')
+					--depth;
+				++p;
+			}
+		}
+
+		// keyword [name] {
+		bool BeginBlock() {
+			if (Peek() != '{')
+				ReadWord();
+			return Expect('{');
+		}
+	};
+
+
+	bool ParseMesh(sXReader &r, const Matrix44 &tm, OUT sMeshData &out)
+	{
+		const int posCount = r.ReadInt();
+		RETV2(posCount <= 0, false);
+		std::vector<Vector3> positions(posCount);
+		for (auto &pos : positions)
+		{
+			pos.x = r.ReadFloat();
+			pos.y = r.ReadFloat();
+			pos.z = r.ReadFloat();
+		}
+
+		// face, triangle fan
+		std::vector<int> faces; // count, index..
+		const int faceCount = r.ReadInt();
+		for (int i = 0; i < faceCount; ++i)
+		{
+			const int n = r.ReadInt();
+			RETV2((n < 3) || (n > 64), false);
+			faces.push_back(n);
+			for (int k = 0; k < n; ++k)
+				faces.push_back(r.ReadInt());
+		}
+
+		std::vector<Vector3> normals;
+		std::vector<int> normalFaces;
+		std::vector<Vector2> uvs;
+		while (!r.IsEnd() && !r.Expect('}'))
+		{
+			const std::string name = r.ReadWord();
+			if (!r.BeginBlock())
+				return false;
+
+			if (name == "MeshNormals")
+			{
+				const int normalCount = r.ReadInt();
+				normals.resize(max(0, normalCount));
+				for (auto &n : normals)
+				{
+					n.x = r.ReadFloat();
+					n.y = r.ReadFloat();
+					n.z = r.ReadFloat();
+				}
+				const int count = r.ReadInt();
+				for (int i = 0; i < count; ++i)
+				{
+					const int n = r.ReadInt();
+					RETV2((n < 3) || (n > 64), false);
+					normalFaces.push_back(n);
+					for (int k = 0; k < n; ++k)
+						normalFaces.push_back(r.ReadInt());
+				}
+			}
+			else if (name == "MeshTextureCoords")
+			{
+				const int uvCount = r.ReadInt();
+				uvs.resize(max(0, uvCount));
+				for (auto &uv : uvs)
+				{
+					uv.x = r.ReadFloat();
+					uv.y = r.ReadFloat();
+				}
+			}
+			r.SkipBlock();
+		}
+
+		const bool hasNormal = (normalFaces.size() == faces.size());
+		const bool hasUV = ((int)uvs.size() == posCount);
+
+		// mirror transform, flip winding
+		const float det = tm.m[0][0] * (tm.m[1][1] * tm.m[2][2] - tm.m[1][2] * tm.m[2][1])
+			- tm.m[0][1] * (tm.m[1][0] * tm.m[2][2] - tm.m[1][2] * tm.m[2][0])
+			+ tm.m[0][2] * (tm.m[1][0] * tm.m[2][1] - tm.m[1][1] * tm.m[2][0]);
+
+		// unique vertex = (position index, normal index)
+		std::map<std::pair<int, int>, UINT> vertexMap;
+		auto getVertex = [&](const int posIdx, const int normalIdx) -> UINT {
+			const auto key = std::make_pair(posIdx, normalIdx);
+			auto it = vertexMap.find(key);
+			if (vertexMap.end() != it)
+				return it->second;
+
+			sMeshVertex vtx;
+			cSimdMath::TransformPoints(&tm.m[0][0], &positions[posIdx], 1, &vtx.pos);
+			vtx.normal = Vector3(0, 1, 0);
+			if (normalIdx >= 0)
+			{
+				const Vector3 &n = normals[normalIdx];
+				vtx.normal = Vector3(
+					n.x * tm.m[0][0] + n.y * tm.m[1][0] + n.z * tm.m[2][0]
+					, n.x * tm.m[0][1] + n.y * tm.m[1][1] + n.z * tm.m[2][1]
+					, n.x * tm.m[0][2] + n.y * tm.m[1][2] + n.z * tm.m[2][2]).Normal();
+			}
+			vtx.uv = hasUV ? uvs[posIdx] : Vector2(0, 0);
+
+			const UINT idx = (UINT)out.vertices.size();
+			out.vertices.push_back(vtx);
+			vertexMap[key] = idx;
+			return idx;
+		};
+
+		for (u_int f = 0; f < faces.size(); )
+		{
+			const int n = faces[f];
+			UINT corner[64];
+			for (int k = 0; k < n; ++k)
+			{
+				const int posIdx = faces[f + 1 + k];
+				const int normalIdx = hasNormal ? normalFaces[f + 1 + k] : -1;
+				RETV2((posIdx < 0) || (posIdx >= posCount), false);
+				RETV2(normalIdx >= (int)normals.size(), false);
+				corner[k] = getVertex(posIdx, normalIdx);
+			}
+
+			for (int k = 1; k < n - 1; ++k)
+			{
+				out.indices.push_back(corner[0]);
+				out.indices.push_back((det < 0.f) ? corner[k + 1] : corner[k]);
+				out.indices.push_back((det < 0.f) ? corner[k] : corner[k + 1]);
+			}
+			f += n + 1;
+		}
+		return true;
+	}
+
+
+	// Frame, Mesh, FrameTransformMatrix, other block skip
+	// parentTm: parent frame world transform
+	bool ParseBlock(sXReader &r, const Matrix44 &parentTm, const bool isRoot
+		, OUT sMeshData &out)
+	{
+		Matrix44 tm = parentTm;
+		while (!r.IsEnd())
+		{
+			if (r.Expect('}'))
+				return !isRoot;
+			if (r.Expect('{')) // data reference, { name }
+			{
+				r.SkipBlock();
+				continue;
+			}
+
+			const std::string name = r.ReadWord();
+			if (name.empty())
+				return false;
+			if (!r.BeginBlock())
+				return false;
+
+			if (name == "Frame")
+			{
+				if (!ParseBlock(r, tm, false, out))
+					return false;
+			}
+			else if (name == "FrameTransformMatrix")
+			{
+				Matrix44 local;
+				for (int i = 0; i < 16; ++i)
+					local.m[i / 4][i % 4] = r.ReadFloat();
+				cSimdMath::Multiply(&local.m[0][0], &parentTm.m[0][0], &tm.m[0][0]);
+				r.SkipBlock();
+			}
+			else if (name == "Mesh")
+			{
+				if (!ParseMesh(r, tm, out))
+					return false;
+			}
+			else
+			{
+				r.SkipBlock(); // template, Material, AnimationSet ..
+			}
+		}
+		return isRoot;
+	}
+
+
+	// is file1 newer than file2?
+	bool IsNewerFile(const char *fileName1, const char *fileName2)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA attr1, attr2;
+		if (!GetFileAttributesExA(fileName1, GetFileExInfoStandard, &attr1))
+			return false;
+		if (!GetFileAttributesExA(fileName2, GetFileExInfoStandard, &attr2))
+			return false;
+		return CompareFileTime(&attr1.ftLastWriteTime, &attr2.ftLastWriteTime) >= 0;
+	}
+}
+
+
+// convert .x to .mesh with LOD chain, optimized index/vertex order
+// outFileName = srcFileName if fail
+bool cMeshImporter::Import(const char *srcFileName, OUT std::string &outFileName
+	, cAssetCache *cache //= NULL
+	, const bool isForce //= false
+)
+{
+	outFileName = srcFileName;
+
+	const std::string key = cache ? cache->GetKey(srcFileName, "mesh", VERSION) : "";
+	const std::string cacheFileName = std::string(srcFileName) + ".mesh";
+	if (!isForce)
+	{
+		if (cache && cache->Find(key, outFileName))
+			return true;
+		if (!cache && IsNewerFile(cacheFileName.c_str(), srcFileName))
+		{
+			outFileName = cacheFileName;
+			return true;
+		}
+	}
+
+	sMeshData src;
+	if (!ReadX(srcFileName, src))
+		return false;
+
+	// LOD1 ~ LOD3, 1/2, 1/4, 1/8 triangle
+	const float ratios[MAX_LOD - 1] = { 0.5f, 0.25f, 0.125f };
+	std::vector<sMeshData> lods(1, src);
+	if (!cMeshSimplifier::Simplify(src, ratios, MAX_LOD - 1, lods))
+		return false;
+
+	// vertex cache, overdraw, vertex fetch order, then cluster
+	for (auto &lod : lods)
+	{
+		cMeshOptimizer::Optimize(lod);
+		cMeshlet::Build(lod, lod.meshlets);
+	}
+
+	// write temporary file and rename, never read half written cache
+	const std::string tmpFileName = cache ? cache->GetTempFileName(key)
+		: (cacheFileName + ".tmp");
+	if (!WriteMesh(tmpFileName.c_str(), lods))
+		return false;
+	if (cache)
+		return cache->Store(key, tmpFileName.c_str(), outFileName);
+	if (!MoveFileExA(tmpFileName.c_str(), cacheFileName.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileA(tmpFileName.c_str());
+		return false;
+	}
+
+	outFileName = cacheFileName;
+	return true;
+}
+
+
+// read DirectX .x text format, all mesh merge to one triangle list
+bool cMeshImporter::ReadX(const char *fileName, OUT sMeshData &out)
+{
+	std::vector<char> data;
+	{
+		FILE *fp = NULL;
+		if (fopen_s(&fp, fileName, "rb") || !fp)
+			return false;
+		fseek(fp, 0, SEEK_END);
+		data.resize(max(0L, ftell(fp)) + 1, 0);
+		fseek(fp, 0, SEEK_SET);
+		const size_t readSize = fread(&data[0], 1, data.size() - 1, fp);
+		fclose(fp);
+		RETV2(readSize != data.size() - 1, false);
+	}
+
+	// header, xof 0303txt 0032
+	RETV2((data.size() < 16) || strncmp(&data[0], "xof ", 4) || strncmp(&data[8], "txt ", 4), false);
+
+	sXReader r;
+	r.p = &data[16];
+	r.end = &data[0] + data.size() - 1;
+
+	Matrix44 identity;
+	identity.SetIdentity();
+	out.vertices.clear();
+	out.indices.clear();
+	RETV2(!ParseBlock(r, identity, true, out), false);
+	return !out.indices.empty();
+}
+
+
+bool cMeshImporter::ReadMesh(const char *fileName, OUT std::vector<sMeshData> &lods)
+{
+	FILE *fp = NULL;
+	if (fopen_s(&fp, fileName, "rb") || !fp)
+		return false;
+
+	DWORD magic = 0;
+	UINT version = 0, lodCount = 0;
+	bool result = (1 == fread(&magic, sizeof(magic), 1, fp))
+		&& (1 == fread(&version, sizeof(version), 1, fp))
+		&& (1 == fread(&lodCount, sizeof(lodCount), 1, fp))
+		&& (MESH_MAGIC == magic) && (VERSION == version)
+		&& (lodCount > 0) && (lodCount <= MAX_LOD);
+
+	lods.clear();
+	for (UINT i = 0; result && (i < lodCount); ++i)
+	{
+		UINT vtxCount = 0, idxCount = 0, meshletCount = 0;
+		result = (1 == fread(&vtxCount, sizeof(vtxCount), 1, fp))
+			&& (1 == fread(&idxCount, sizeof(idxCount), 1, fp))
+			&& (1 == fread(&meshletCount, sizeof(meshletCount), 1, fp))
+			&& (vtxCount > 0) && (idxCount > 0)
+			&& (vtxCount < 0x1000000) && (idxCount < 0x4000000) && (meshletCount <= idxCount / 3);
+		if (!result)
+			break;
+
+		lods.push_back({});
+		sMeshData &mesh = lods.back();
+		mesh.vertices.resize(vtxCount);
+		mesh.indices.resize(idxCount);
+		mesh.meshlets.resize(meshletCount);
+		result = (vtxCount == fread(&mesh.vertices[0], sizeof(sMeshVertex), vtxCount, fp))
+			&& (idxCount == fread(&mesh.indices[0], sizeof(UINT), idxCount, fp))
+			&& ((0 == meshletCount)
+				|| (meshletCount == fread(&mesh.meshlets[0], sizeof(sMeshlet), meshletCount, fp)));
+		for (UINT k = 0; result && (k < idxCount); ++k)
+			result = mesh.indices[k] < vtxCount;
+		for (auto &meshlet : mesh.meshlets)
+			result = result && (meshlet.indexOffset + meshlet.triangleCount * 3 <= idxCount);
+	}
+
+	fclose(fp);
+	if (!result)
+		lods.clear();
+	return result;
+}
+
+
+bool cMeshImporter::WriteMesh(const char *fileName, const std::vector<sMeshData> &lods)
+{
+	RETV2(lods.empty() || (lods.size() > MAX_LOD), false);
+
+	FILE *fp = NULL;
+	if (fopen_s(&fp, fileName, "wb") || !fp)
+		return false;
+
+	const UINT version = VERSION;
+	const UINT lodCount = (UINT)lods.size();
+	fwrite(&MESH_MAGIC, sizeof(MESH_MAGIC), 1, fp);
+	fwrite(&version, sizeof(version), 1, fp);
+	fwrite(&lodCount, sizeof(lodCount), 1, fp);
+	for (auto &mesh : lods)
+	{
+		const UINT vtxCount = (UINT)mesh.vertices.size();
+		const UINT idxCount = (UINT)mesh.indices.size();
+		const UINT meshletCount = (UINT)mesh.meshlets.size();
+		fwrite(&vtxCount, sizeof(vtxCount), 1, fp);
+		fwrite(&idxCount, sizeof(idxCount), 1, fp);
+		fwrite(&meshletCount, sizeof(meshletCount), 1, fp);
+		if (vtxCount > 0)
+			fwrite(&mesh.vertices[0], sizeof(sMeshVertex), vtxCount, fp);
+		if (idxCount > 0)
+			fwrite(&mesh.indices[0], sizeof(UINT), idxCount, fp);
+		if (meshletCount > 0)
+			fwrite(&mesh.meshlets[0], sizeof(sMeshlet), meshletCount, fp);
+	}
+
+	const bool result = !ferror(fp);
+	fclose(fp);
+	return result;
+}
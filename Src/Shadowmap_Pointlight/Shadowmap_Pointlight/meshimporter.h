@@ -0,0 +1,62 @@
+//
+// 2018-05-18, jjuiddong
+// Mesh Importer
+//	- DirectX .x text format reader (Mesh, MeshNormals, MeshTextureCoords)
+//	  frame transform baked into vertex, all mesh merged
+//	- LOD chain generation (cMeshSimplifier), LOD0 = source mesh
+//	- index, vertex reorder per LOD (cMeshOptimizer)
+//	- meshlet per LOD (cMeshlet), contiguous index range
+//	- result cached as .mesh binary in asset cache (source hash key)
+//	  or next to the source file if no cache (xxx.x -> xxx.x.mesh)
+//
+#pragma once
+
+#include "assetcache.h"
+
+
+namespace graphic
+{
+
+	// POSITION | NORMAL | TEXTURE0, 32 bytes
+	struct sMeshVertex
+	{
+		Vector3 pos;
+		Vector3 normal;
+		Vector2 uv;
+	};
+
+	// triangle cluster, indices[indexOffset, indexOffset + triangleCount * 3)
+	struct sMeshlet
+	{
+		UINT indexOffset;
+		UINT triangleCount;
+		Vector3 center; // bounding sphere
+		float radius;
+		Vector3 coneAxis; // average triangle normal
+		float coneCutoff; // sin(cone half angle), > 1 : no cone culling
+	};
+
+	// CPU side triangle list
+	struct sMeshData
+	{
+		std::vector<sMeshVertex> vertices;
+		std::vector<UINT> indices;
+		std::vector<sMeshlet> meshlets;
+	};
+
+
+	class cMeshImporter
+	{
+	public:
+		enum { VERSION = 4 }; // increase when output change, invalidate cache
+		enum { MAX_LOD = 4 };
+
+		static bool Import(const char *srcFileName, OUT std::string &outFileName
+			, cAssetCache *cache = NULL, const bool isForce = false);
+
+		static bool ReadX(const char *fileName, OUT sMeshData &out);
+		static bool ReadMesh(const char *fileName, OUT std::vector<sMeshData> &lods);
+		static bool WriteMesh(const char *fileName, const std::vector<sMeshData> &lods);
+	};
+
+}
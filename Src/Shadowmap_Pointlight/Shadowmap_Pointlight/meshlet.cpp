@@ -0,0 +1,115 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "meshlet.h"
+
+using namespace graphic;
+
+
+// scan index order, new meshlet if vertex or triangle limit over
+void cMeshlet::Build(const sMeshData &mesh, OUT std::vector<sMeshlet> &out)
+{
+	out.clear();
+	const UINT triCount = (UINT)mesh.indices.size() / 3;
+	if (0 == triCount)
+		return;
+
+	// vertex -> meshlet stamp, vertex already in current meshlet
+	std::vector<int> stamps(mesh.vertices.size(), -1);
+	sMeshlet meshlet;
+	ZeroMemory(&meshlet, sizeof(meshlet));
+	int vertexCount = 0;
+
+	for (UINT t = 0; t < triCount; ++t)
+	{
+		const UINT *tri = &mesh.indices[t * 3];
+		const int stamp = (int)out.size();
+		int newVertex = 0;
+		for (int k = 0; k < 3; ++k)
+			if ((stamps[tri[k]] != stamp)
+				&& ((k < 1) || (tri[k] != tri[0]))
+				&& ((k < 2) || (tri[k] != tri[1])))
+				++newVertex;
+
+		if ((vertexCount + newVertex > MAX_VERTEX) || (meshlet.triangleCount >= MAX_TRIANGLE))
+		{
+			CalcBound(mesh, meshlet);
+			out.push_back(meshlet);
+			ZeroMemory(&meshlet, sizeof(meshlet));
+			meshlet.indexOffset = t * 3;
+			vertexCount = 0;
+		}
+
+		for (int k = 0; k < 3; ++k)
+		{
+			if (stamps[tri[k]] != (int)out.size())
+			{
+				stamps[tri[k]] = (int)out.size();
+				++vertexCount;
+			}
+		}
+		++meshlet.triangleCount;
+	}
+
+	CalcBound(mesh, meshlet);
+	out.push_back(meshlet);
+}
+
+
+// bounding sphere: bounding box center, max distance
+// cone: average unit triangle normal, cutoff = sin(max normal angle)
+//       cone angle >= 90 degree -> cutoff 2, never culled
+void cMeshlet::CalcBound(const sMeshData &mesh, sMeshlet &meshlet)
+{
+	const UINT *indices = &mesh.indices[meshlet.indexOffset];
+	const UINT idxCount = meshlet.triangleCount * 3;
+
+	Vector3 bmin = mesh.vertices[indices[0]].pos;
+	Vector3 bmax = bmin;
+	for (UINT i = 1; i < idxCount; ++i)
+	{
+		const Vector3 &p = mesh.vertices[indices[i]].pos;
+		bmin = Vector3(min(bmin.x, p.x), min(bmin.y, p.y), min(bmin.z, p.z));
+		bmax = Vector3(max(bmax.x, p.x), max(bmax.y, p.y), max(bmax.z, p.z));
+	}
+	meshlet.center = (bmin + bmax) * 0.5f;
+	meshlet.radius = 0.f;
+	for (UINT i = 0; i < idxCount; ++i)
+		meshlet.radius = max(meshlet.radius
+			, (mesh.vertices[indices[i]].pos - meshlet.center).Length());
+
+	// front face normal, cross(p1 - p0, p2 - p0), degenerate triangle ignore
+	std::vector<Vector3> normals;
+	normals.reserve(meshlet.triangleCount);
+	Vector3 axis(0, 0, 0);
+	for (UINT t = 0; t < meshlet.triangleCount; ++t)
+	{
+		const Vector3 &p0 = mesh.vertices[indices[t * 3]].pos;
+		const Vector3 &p1 = mesh.vertices[indices[t * 3 + 1]].pos;
+		const Vector3 &p2 = mesh.vertices[indices[t * 3 + 2]].pos;
+		const Vector3 n = (p1 - p0).CrossProduct(p2 - p0);
+		const float len = n.Length();
+		if (len <= 0.f)
+			continue;
+		normals.push_back(n * (1.f / len));
+		axis = axis + normals.back();
+	}
+
+	meshlet.coneAxis = Vector3(0, 0, 0);
+	meshlet.coneCutoff = 2.f;
+	const float len = axis.Length();
+	if (normals.empty() || (len < 0.0001f))
+		return;
+
+	axis = axis * (1.f / len);
+	float minDot = 1.f;
+	for (auto &n : normals)
+		minDot = min(minDot, n.DotProduct(axis));
+	if (minDot <= 0.f)
+		return;
+
+	meshlet.coneAxis = axis;
+	meshlet.coneCutoff = sqrtf(1.f - minDot * minDot);
+}
@@ -0,0 +1,26 @@
+//
+// 2018-05-21, jjuiddong
+// Meshlet
+//	- split triangle list to cluster, max 64 vertex, 126 triangle
+//	- index order scan (cMeshOptimizer order), cluster = contiguous index range
+//	- bounding sphere, normal cone (winding normal, D3D clockwise front face)
+//
+#pragma once
+
+#include "meshimporter.h"
+
+
+namespace graphic
+{
+
+	class cMeshlet
+	{
+	public:
+		enum { MAX_VERTEX = 64 };
+		enum { MAX_TRIANGLE = 126 };
+
+		static void Build(const sMeshData &mesh, OUT std::vector<sMeshlet> &out);
+		static void CalcBound(const sMeshData &mesh, sMeshlet &meshlet);
+	};
+
+}
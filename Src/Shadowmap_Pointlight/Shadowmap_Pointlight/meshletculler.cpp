@@ -0,0 +1,363 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "meshletculler.h"
+#include "../../Shared/steadytimer.h"
+
+using namespace graphic;
+
+
+namespace
+{
+	// cluster index order = index buffer order, merge adjacent range
+	inline void AddRange(const UINT indexOffset, const UINT indexCount
+		, std::vector<cMeshletCuller::sRange> &ranges)
+	{
+		if (!ranges.empty()
+			&& (ranges.back().indexOffset + ranges.back().indexCount == indexOffset))
+		{
+			ranges.back().indexCount += indexCount;
+			return;
+		}
+		cMeshletCuller::sRange range;
+		range.indexOffset = indexOffset;
+		range.indexCount = indexCount;
+		ranges.push_back(range);
+	}
+
+	bool IsEqual(const std::vector<cMeshletCuller::sRange> &a
+		, const std::vector<cMeshletCuller::sRange> &b)
+	{
+		if (a.size() != b.size())
+			return false;
+		for (u_int i = 0; i < a.size(); ++i)
+			if ((a[i].indexOffset != b[i].indexOffset) || (a[i].indexCount != b[i].indexCount))
+				return false;
+		return true;
+	}
+}
+
+
+cMeshletCuller::cMeshletCuller()
+	: m_eyePos(0, 0, 0)
+{
+}
+
+cMeshletCuller::~cMeshletCuller()
+{
+}
+
+
+void cMeshletCuller::CreateClusterSet(const std::vector<sMeshlet> &meshlets
+	, OUT sClusterSet &out)
+{
+	const u_int count = meshlets.size();
+	out.x.resize(count);
+	out.y.resize(count);
+	out.z.resize(count);
+	out.r.resize(count);
+	out.ax.resize(count);
+	out.ay.resize(count);
+	out.az.resize(count);
+	out.cutoff.resize(count);
+	out.indexOffset.resize(count);
+	out.triangleCount.resize(count);
+	out.totalTriangle = 0;
+	for (u_int i = 0; i < count; ++i)
+	{
+		const sMeshlet &m = meshlets[i];
+		out.x[i] = m.center.x;
+		out.y[i] = m.center.y;
+		out.z[i] = m.center.z;
+		out.r[i] = m.radius;
+		out.ax[i] = m.coneAxis.x;
+		out.ay[i] = m.coneAxis.y;
+		out.az[i] = m.coneAxis.z;
+		out.cutoff[i] = m.coneCutoff;
+		out.indexOffset[i] = m.indexOffset;
+		out.triangleCount[i] = m.triangleCount;
+		out.totalTriangle += m.triangleCount;
+	}
+}
+
+
+void cMeshletCuller::AddStats(const sStats &src, sStats &dst)
+{
+	dst.clusterCount += src.clusterCount;
+	dst.visibleCluster += src.visibleCluster;
+	dst.triangleCount += src.triangleCount;
+	dst.visibleTriangle += src.visibleTriangle;
+	dst.frustumTriangle += src.frustumTriangle;
+	dst.coneTriangle += src.coneTriangle;
+}
+
+
+// several Cull() result union (instanced draw, same LOD batch)
+// sort by index offset, merge overlapped, adjacent range
+void cMeshletCuller::MergeRanges(OUT std::vector<sRange> &ranges)
+{
+	if (ranges.size() < 2)
+		return;
+	std::sort(ranges.begin(), ranges.end(), [](const sRange &a, const sRange &b) {
+		return a.indexOffset < b.indexOffset; });
+
+	u_int n = 0;
+	for (u_int i = 1; i < ranges.size(); ++i)
+	{
+		sRange &last = ranges[n];
+		const UINT lastEnd = last.indexOffset + last.indexCount;
+		if (ranges[i].indexOffset <= lastEnd)
+		{
+			last.indexCount = max(lastEnd, ranges[i].indexOffset + ranges[i].indexCount)
+				- last.indexOffset;
+			continue;
+		}
+		ranges[++n] = ranges[i];
+	}
+	ranges.resize(n + 1);
+}
+
+
+// every frame, before Cull()
+void cMeshletCuller::Begin(const Matrix44 &viewProj, const Vector3 &eyePos)
+{
+	m_frustum.SetFrustum(&viewProj.m[0][0]);
+	m_eyePos = eyePos;
+}
+
+
+// world plane -> mesh space plane, dot(plane, (p * world, 1)) = dot(world * plane, (p, 1))
+// normalize again, sphere radius mesh space
+// eye position mesh space, cone test scale invariant (uniform scale)
+void cMeshletCuller::GetLocal(const Matrix44 &world, OUT float planes[6][4]
+	, OUT Vector3 &eyePos) const
+{
+	for (int k = 0; k < 6; ++k)
+	{
+		const float *p = m_frustum.m_planes[k];
+		for (int i = 0; i < 4; ++i)
+			planes[k][i] = world.m[i][0] * p[0] + world.m[i][1] * p[1]
+				+ world.m[i][2] * p[2] + world.m[i][3] * p[3];
+
+		const float len = sqrt(planes[k][0] * planes[k][0] + planes[k][1] * planes[k][1]
+			+ planes[k][2] * planes[k][2]);
+		if (len > 0.f)
+			for (int i = 0; i < 4; ++i)
+				planes[k][i] /= len;
+	}
+	eyePos = m_eyePos * world.Inverse();
+}
+
+
+// ranges: visible index range, clear and write
+// return visible triangle count
+int cMeshletCuller::Cull(const sClusterSet &set, const Matrix44 &world
+	, OUT std::vector<sRange> &ranges, OUT sStats &stats) const
+{
+#ifdef SIMD_MATH_SSE
+	ranges.clear();
+	ZeroMemory(&stats, sizeof(stats));
+	const int count = (int)set.x.size();
+	stats.clusterCount = count;
+	stats.triangleCount = (int)set.totalTriangle;
+
+	float planes[6][4];
+	Vector3 eyePos;
+	GetLocal(world, planes, eyePos);
+	const __m128 ex = _mm_set1_ps(eyePos.x);
+	const __m128 ey = _mm_set1_ps(eyePos.y);
+	const __m128 ez = _mm_set1_ps(eyePos.z);
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 vx = _mm_loadu_ps(&set.x[i]);
+		const __m128 vy = _mm_loadu_ps(&set.y[i]);
+		const __m128 vz = _mm_loadu_ps(&set.z[i]);
+		const __m128 vr = _mm_loadu_ps(&set.r[i]);
+		const __m128 negR = _mm_sub_ps(_mm_setzero_ps(), vr);
+		__m128 inside;
+		for (int k = 0; k < 6; ++k)
+		{
+			const float *p = planes[k];
+			const __m128 d = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(vx, _mm_set1_ps(p[0])), _mm_mul_ps(vy, _mm_set1_ps(p[1])))
+				, _mm_add_ps(_mm_mul_ps(vz, _mm_set1_ps(p[2])), _mm_set1_ps(p[3])));
+			const __m128 in = _mm_cmpge_ps(d, negR);
+			inside = (k == 0) ? in : _mm_and_ps(inside, in);
+		}
+
+		// backface: dot(center - eye, axis) > cutoff * |center - eye| + radius
+		const __m128 dx = _mm_sub_ps(vx, ex);
+		const __m128 dy = _mm_sub_ps(vy, ey);
+		const __m128 dz = _mm_sub_ps(vz, ez);
+		const __m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx)
+			, _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+		const __m128 dp = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(&set.ax[i]))
+			, _mm_mul_ps(dy, _mm_loadu_ps(&set.ay[i]))), _mm_mul_ps(dz, _mm_loadu_ps(&set.az[i])));
+		const __m128 back = _mm_cmpgt_ps(dp
+			, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&set.cutoff[i]), dist), vr));
+
+		const int inMask = _mm_movemask_ps(inside);
+		const int backMask = _mm_movemask_ps(back);
+		for (int b = 0; b < 4; ++b)
+		{
+			const int idx = i + b;
+			const UINT triCount = set.triangleCount[idx];
+			if (!(inMask & (1 << b)))
+			{
+				stats.frustumTriangle += triCount;
+			}
+			else if (backMask & (1 << b))
+			{
+				stats.coneTriangle += triCount;
+			}
+			else
+			{
+				AddRange(set.indexOffset[idx], triCount * 3, ranges);
+				++stats.visibleCluster;
+				stats.visibleTriangle += triCount;
+			}
+		}
+	}
+
+	// remainder, same test with scalar
+	for (; i < count; ++i)
+	{
+		bool inside = true;
+		for (int k = 0; inside && (k < 6); ++k)
+		{
+			const float *p = planes[k];
+			inside = (set.x[i] * p[0] + set.y[i] * p[1] + set.z[i] * p[2] + p[3]) >= -set.r[i];
+		}
+
+		const Vector3 d = Vector3(set.x[i], set.y[i], set.z[i]) - eyePos;
+		const float dp = d.x * set.ax[i] + d.y * set.ay[i] + d.z * set.az[i];
+		const UINT triCount = set.triangleCount[i];
+		if (!inside)
+		{
+			stats.frustumTriangle += triCount;
+		}
+		else if (dp > set.cutoff[i] * d.Length() + set.r[i])
+		{
+			stats.coneTriangle += triCount;
+		}
+		else
+		{
+			AddRange(set.indexOffset[i], triCount * 3, ranges);
+			++stats.visibleCluster;
+			stats.visibleTriangle += triCount;
+		}
+	}
+	return stats.visibleTriangle;
+
+#else
+	return CullScalar(set, world, ranges, stats);
+#endif
+}
+
+
+int cMeshletCuller::CullScalar(const sClusterSet &set, const Matrix44 &world
+	, OUT std::vector<sRange> &ranges, OUT sStats &stats) const
+{
+	ranges.clear();
+	ZeroMemory(&stats, sizeof(stats));
+	const int count = (int)set.x.size();
+	stats.clusterCount = count;
+	stats.triangleCount = (int)set.totalTriangle;
+
+	float planes[6][4];
+	Vector3 eyePos;
+	GetLocal(world, planes, eyePos);
+
+	for (int i = 0; i < count; ++i)
+	{
+		bool inside = true;
+		for (int k = 0; inside && (k < 6); ++k)
+		{
+			const float *p = planes[k];
+			inside = (set.x[i] * p[0] + set.y[i] * p[1] + set.z[i] * p[2] + p[3]) >= -set.r[i];
+		}
+
+		const Vector3 d = Vector3(set.x[i], set.y[i], set.z[i]) - eyePos;
+		const float dp = d.x * set.ax[i] + d.y * set.ay[i] + d.z * set.az[i];
+		const UINT triCount = set.triangleCount[i];
+		if (!inside)
+		{
+			stats.frustumTriangle += triCount;
+		}
+		else if (dp > set.cutoff[i] * d.Length() + set.r[i])
+		{
+			stats.coneTriangle += triCount;
+		}
+		else
+		{
+			AddRange(set.indexOffset[i], triCount * 3, ranges);
+			++stats.visibleCluster;
+			stats.visibleTriangle += triCount;
+		}
+	}
+	return stats.visibleTriangle;
+}
+
+
+// 8x8 object grid, y axis rotation per object
+// scalar vs simd vs multi thread (object per job)
+void cMeshletCuller::Benchmark(cJobSystem &jobs, const sClusterSet &set
+	, const Matrix44 &viewProj, const Vector3 &eyePos, OUT sBenchmark &out)
+{
+	ZeroMemory(&out, sizeof(out));
+	out.objectCount = 64;
+	out.clusterCount = (int)set.x.size();
+	out.threadCount = jobs.GetWorkerCount();
+	if (set.x.empty())
+		return;
+
+	cMeshletCuller culler;
+	culler.Begin(viewProj, eyePos);
+
+	// cluster bound size, object spacing
+	float size = 0.f;
+	for (u_int i = 0; i < set.x.size(); ++i)
+		size = max(size, max(fabsf(set.x[i]), fabsf(set.z[i])) + set.r[i]);
+	const float spacing = size * 2.f;
+
+	const int count = out.objectCount;
+	std::vector<Matrix44> worlds(count);
+	for (int i = 0; i < count; ++i)
+	{
+		worlds[i].SetRotationY((float)i * 0.7f);
+		worlds[i].m[3][0] = ((float)(i % 8) - 3.5f) * spacing;
+		worlds[i].m[3][2] = ((float)(i / 8) - 3.5f) * spacing;
+	}
+
+	std::vector<std::vector<sRange>> scalarOut(count), simdOut(count), parallelOut(count);
+	std::vector<sStats> stats(count);
+
+	double t0 = GetSteadyTimeMs();
+	for (int i = 0; i < count; ++i)
+		culler.CullScalar(set, worlds[i], scalarOut[i], stats[i]);
+	out.scalarMs = GetSteadyTimeMs() - t0;
+
+	for (int i = 0; i < count; ++i)
+		AddStats(stats[i], out.stats);
+
+	t0 = GetSteadyTimeMs();
+	for (int i = 0; i < count; ++i)
+		culler.Cull(set, worlds[i], simdOut[i], stats[i]);
+	out.simdMs = GetSteadyTimeMs() - t0;
+
+	t0 = GetSteadyTimeMs();
+	jobs.ParallelFor(count, 1, [&](const int begin, const int end, const int) {
+		for (int i = begin; i < end; ++i)
+			culler.Cull(set, worlds[i], parallelOut[i], stats[i]);
+	});
+	out.parallelMs = GetSteadyTimeMs() - t0;
+
+	out.isMatch = true;
+	for (int i = 0; i < count; ++i)
+		out.isMatch = out.isMatch && IsEqual(scalarOut[i], simdOut[i])
+			&& IsEqual(scalarOut[i], parallelOut[i]);
+}
@@ -0,0 +1,86 @@
+//
+// 2018-05-21, jjuiddong
+// Meshlet Culler
+//	- per cluster bounding sphere vs frustum, normal cone vs eye (backface)
+//	- frustum plane, eye transform to mesh space, one transform per object
+//	- SSE 4 cluster per iteration, scalar remainder
+//	- visible cluster -> index range, adjacent range merge (DrawIndexed per range)
+//	- Cull() const, thread safe, per object multi thread (cJobSystem)
+//	- MergeRanges() : object range union, same LOD instanced draw
+//
+#pragma once
+
+#include "meshimporter.h"
+#include "frustumculler.h"
+
+
+namespace graphic
+{
+
+	class cMeshletCuller
+	{
+	public:
+		// sMeshlet SoA
+		struct sClusterSet
+		{
+			std::vector<float> x, y, z, r; // bounding sphere, mesh space
+			std::vector<float> ax, ay, az, cutoff; // normal cone, cutoff > 1 : never cull
+			std::vector<UINT> indexOffset;
+			std::vector<UINT> triangleCount;
+			UINT totalTriangle;
+		};
+
+		struct sRange
+		{
+			UINT indexOffset;
+			UINT indexCount;
+		};
+
+		struct sStats
+		{
+			int clusterCount;
+			int visibleCluster;
+			int triangleCount;
+			int visibleTriangle;
+			int frustumTriangle; // culled triangle, off frustum
+			int coneTriangle; // culled triangle, backface cluster
+		};
+
+		struct sBenchmark
+		{
+			int objectCount;
+			int clusterCount; // per object
+			int threadCount;
+			sStats stats; // all object sum
+			double scalarMs;
+			double simdMs;
+			double parallelMs;
+			bool isMatch; // scalar, simd, parallel same range
+		};
+
+		cMeshletCuller();
+		virtual ~cMeshletCuller();
+
+		void Begin(const Matrix44 &viewProj, const Vector3 &eyePos);
+		int Cull(const sClusterSet &set, const Matrix44 &world
+			, OUT std::vector<sRange> &ranges, OUT sStats &stats) const;
+		int CullScalar(const sClusterSet &set, const Matrix44 &world
+			, OUT std::vector<sRange> &ranges, OUT sStats &stats) const;
+		void Benchmark(cJobSystem &jobs, const sClusterSet &set
+			, const Matrix44 &viewProj, const Vector3 &eyePos, OUT sBenchmark &out);
+
+		static void CreateClusterSet(const std::vector<sMeshlet> &meshlets, OUT sClusterSet &out);
+		static void AddStats(const sStats &src, sStats &dst);
+		static void MergeRanges(OUT std::vector<sRange> &ranges);
+
+
+	protected:
+		void GetLocal(const Matrix44 &world, OUT float planes[6][4], OUT Vector3 &eyePos) const;
+
+
+	public:
+		cFrustumCuller m_frustum; // world space plane
+		Vector3 m_eyePos;
+	};
+
+}
@@ -0,0 +1,566 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "meshlod.h"
+
+using namespace graphic;
+
+
+cMeshLod::cMeshLod()
+	: m_center(0, 0, 0)
+	, m_radius(0.f)
+	, m_isPacked(true)
+	, m_cbDecode(NULL)
+	, m_vertexBytes(0)
+	, m_packedBytes(0)
+	, m_recordCb(NULL)
+	, m_recordWorldOffset(0)
+{
+	m_packedEffect[0] = m_packedEffect[1] = NULL;
+	for (int i = 0; i < PACKED_MAX; ++i)
+	{
+		m_packedVS[i] = NULL;
+		m_packedLayout[i] = NULL;
+	}
+	ZeroMemory(&m_decode, sizeof(m_decode));
+	ZeroMemory(&m_codecError, sizeof(m_codecError));
+	// projected diameter (pixel), LOD0 >= 200, LOD1 >= 100, LOD2 >= 50, else LOD3
+	m_lodScreenSize[0] = 200.f;
+	m_lodScreenSize[1] = 100.f;
+	m_lodScreenSize[2] = 50.f;
+	m_lodScreenSize[3] = 0.f;
+	ResetStats();
+}
+
+cMeshLod::~cMeshLod()
+{
+	Clear();
+}
+
+
+// lods: LOD0 ~ LODn, cMeshImporter::ReadMesh() result
+bool cMeshLod::Create(cRenderer &renderer, const std::vector<sMeshData> &lods)
+{
+	Clear();
+	RETV2(lods.empty() || lods[0].vertices.empty(), false);
+
+	// bounding sphere, LOD0 bounding box center
+	Vector3 bmin = lods[0].vertices[0].pos;
+	Vector3 bmax = bmin;
+	for (auto &vtx : lods[0].vertices)
+	{
+		bmin = Vector3(min(bmin.x, vtx.pos.x), min(bmin.y, vtx.pos.y), min(bmin.z, vtx.pos.z));
+		bmax = Vector3(max(bmax.x, vtx.pos.x), max(bmax.y, vtx.pos.y), max(bmax.z, vtx.pos.z));
+	}
+	m_center = (bmin + bmax) * 0.5f;
+	m_radius = 0.f;
+	for (auto &vtx : lods[0].vertices)
+		m_radius = max(m_radius, (vtx.pos - m_center).Length());
+
+	ID3D11Device *device = renderer.GetDevice();
+	D3D11_BUFFER_DESC bd;
+	D3D11_SUBRESOURCE_DATA initData;
+	ZeroMemory(&initData, sizeof(initData));
+
+	const int lodCount = min((int)lods.size(), (int)cMeshImporter::MAX_LOD);
+	for (int i = 0; i < lodCount; ++i)
+	{
+		const sMeshData &mesh = lods[i];
+		if (mesh.vertices.empty() || mesh.indices.empty())
+			break;
+
+		sLod lod;
+		lod.vtxBuff = NULL;
+		lod.posBuff = NULL;
+		lod.attrBuff = NULL;
+		lod.idxBuff = NULL;
+		lod.indexCount = (UINT)mesh.indices.size();
+		cMeshletCuller::CreateClusterSet(mesh.meshlets, lod.clusters);
+
+		ZeroMemory(&bd, sizeof(bd));
+		bd.Usage = D3D11_USAGE_IMMUTABLE;
+		bd.ByteWidth = (UINT)(sizeof(sMeshVertex) * mesh.vertices.size());
+		bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		initData.pSysMem = &mesh.vertices[0];
+		if (FAILED(device->CreateBuffer(&bd, &initData, &lod.vtxBuff)))
+			break;
+
+		bd.ByteWidth = (UINT)(sizeof(UINT) * mesh.indices.size());
+		bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		initData.pSysMem = &mesh.indices[0];
+		if (FAILED(device->CreateBuffer(&bd, &initData, &lod.idxBuff)))
+		{
+			SAFE_RELEASE(lod.vtxBuff);
+			break;
+		}
+
+		m_lods.push_back(lod);
+		m_vertexBytes += (UINT)(sizeof(sMeshVertex) * mesh.vertices.size());
+	}
+
+	// compressed vertex, fallback sMeshVertex if fail (old .fxo)
+	if (!m_lods.empty())
+		CreatePacked(renderer, lods);
+
+	return !m_lods.empty();
+}
+
+
+// encode all LOD with one bound, 2 stream per LOD
+bool cMeshLod::CreatePacked(cRenderer &renderer, const std::vector<sMeshData> &lods)
+{
+	ID3D11Device *device = renderer.GetDevice();
+
+	const D3D11_INPUT_ELEMENT_DESC gbufferElems[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 1, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 1, 4, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	};
+	const D3D11_INPUT_ELEMENT_DESC shadowElems[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	};
+	m_packedEffect[0] = LoadPackedEffect(device, "../Media/shadowmap_pointlight/deferredshading.fxo");
+	m_packedEffect[1] = LoadPackedEffect(device, "../Media/shadowmap_pointlight/shadowgen.fxo");
+	RETV2(!m_packedEffect[0] || !m_packedEffect[1], false);
+	RETV2(!CreatePackedShader(device, m_packedEffect[0], "Unlit_Packed"
+		, gbufferElems, ARRAYSIZE(gbufferElems), PACKED_GBUFFER), false);
+	RETV2(!CreatePackedShader(device, m_packedEffect[1], "Unlit_Packed"
+		, shadowElems, ARRAYSIZE(shadowElems), PACKED_SHADOW), false);
+	// optional, old .fxo without technique: RenderInstanced() sMeshVertex stream
+	CreatePackedShader(device, m_packedEffect[0], "Unlit_Packed_Instancing"
+		, gbufferElems, ARRAYSIZE(gbufferElems), PACKED_GBUFFER_INST);
+
+	m_decode = cVertexCodec::GetBound(lods);
+	cVertexCodec::Validate(lods[0], m_decode, m_codecError);
+
+	D3D11_BUFFER_DESC bd;
+	D3D11_SUBRESOURCE_DATA initData;
+	ZeroMemory(&initData, sizeof(initData));
+
+	ZeroMemory(&bd, sizeof(bd));
+	bd.Usage = D3D11_USAGE_IMMUTABLE;
+	bd.ByteWidth = sizeof(m_decode);
+	bd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	initData.pSysMem = &m_decode;
+	RETV2(FAILED(device->CreateBuffer(&bd, &initData, &m_cbDecode)), false);
+
+	std::vector<cVertexCodec::sPackedPos> positions;
+	std::vector<cVertexCodec::sPackedAttr> attrs;
+	for (u_int i = 0; i < m_lods.size(); ++i)
+	{
+		cVertexCodec::Encode(lods[i], m_decode, positions, attrs);
+
+		ZeroMemory(&bd, sizeof(bd));
+		bd.Usage = D3D11_USAGE_IMMUTABLE;
+		bd.ByteWidth = (UINT)(sizeof(cVertexCodec::sPackedPos) * positions.size());
+		bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		initData.pSysMem = &positions[0];
+		RETV2(FAILED(device->CreateBuffer(&bd, &initData, &m_lods[i].posBuff)), false);
+
+		bd.ByteWidth = (UINT)(sizeof(cVertexCodec::sPackedAttr) * attrs.size());
+		initData.pSysMem = &attrs[0];
+		RETV2(FAILED(device->CreateBuffer(&bd, &initData, &m_lods[i].attrBuff)), false);
+
+		m_packedBytes += (UINT)((sizeof(cVertexCodec::sPackedPos)
+			+ sizeof(cVertexCodec::sPackedAttr)) * positions.size());
+	}
+
+	return true;
+}
+
+
+// compiled effect (.fxo), NULL: fail
+ID3DX11Effect* cMeshLod::LoadPackedEffect(ID3D11Device *device, const char *fileName)
+{
+	std::vector<BYTE> data;
+	FILE *fp = NULL;
+	if (fopen_s(&fp, fileName, "rb") || !fp)
+		return NULL;
+	fseek(fp, 0, SEEK_END);
+	data.resize(max(0L, ftell(fp)));
+	fseek(fp, 0, SEEK_SET);
+	const size_t readSize = data.empty() ? 0 : fread(&data[0], 1, data.size(), fp);
+	fclose(fp);
+	RETV2(data.empty() || (readSize != data.size()), NULL);
+
+	ID3DX11Effect *effect = NULL;
+	const HRESULT hr = D3DX11CreateEffectFromMemory(&data[0], data.size(), 0, device, &effect);
+	RETV2(FAILED(hr), NULL);
+	return effect;
+}
+
+
+// technique vertex shader extract from effect
+// pixel, geometry shader from caller shader BeginPass()
+// idx: PACKED_GBUFFER, PACKED_SHADOW, PACKED_GBUFFER_INST
+bool cMeshLod::CreatePackedShader(ID3D11Device *device, ID3DX11Effect *effect
+	, const char *technique, const D3D11_INPUT_ELEMENT_DESC *elems
+	, const int elemCount, const int idx)
+{
+	ID3DX11EffectPass *pass = effect->GetTechniqueByName(technique)->GetPassByIndex(0);
+	RETV2(!pass->IsValid(), false);
+
+	D3DX11_PASS_DESC passDesc;
+	D3DX11_PASS_SHADER_DESC vsDesc;
+	pass->GetDesc(&passDesc);
+	pass->GetVertexShaderDesc(&vsDesc);
+	vsDesc.pShaderVariable->GetVertexShader(vsDesc.ShaderIndex, &m_packedVS[idx]);
+	RETV2(!m_packedVS[idx], false);
+
+	const HRESULT hr = device->CreateInputLayout(elems, elemCount, passDesc.pIAInputSignature
+		, passDesc.IAInputSignatureSize, &m_packedLayout[idx]);
+	RETV2(FAILED(hr), false);
+	return true;
+}
+
+
+// screenSize: projected bounding sphere diameter (pixel)
+// bias: screen size scale, < 1 coarser LOD
+int cMeshLod::SelectLod(const float screenSize
+	, const float bias //= 1.f
+) const
+{
+	const float size = screenSize * bias;
+	int lod = 0;
+	while ((lod < (int)m_lods.size() - 1) && (size < m_lodScreenSize[lod]))
+		++lod;
+	return lod;
+}
+
+
+// shader Begin(), BeginPass() before call
+// tm: world transform
+// isShadow: shadowgen.fx pass, packed vertex bind position stream only
+// ranges: cMeshletCuller::Cull() result, NULL: draw all
+void cMeshLod::Render(cRenderer &renderer, const int lod, const XMMATRIX &tm
+	, const bool isShadow //= false
+	, const std::vector<cMeshletCuller::sRange> *ranges //= NULL
+)
+{
+	if ((lod < 0) || (lod >= (int)m_lods.size()))
+		return;
+	if (ranges && ranges->empty())
+		return; // all cluster culled
+	const sLod &mesh = m_lods[lod];
+	ID3D11DeviceContext *devContext = renderer.GetDevContext();
+
+	renderer.m_cbPerFrame.m_v->mWorld = XMMatrixTranspose(tm);
+	renderer.m_cbPerFrame.Update(renderer);
+
+	if (m_isPacked && IsPacked())
+	{
+		// override caller vertex shader, input layout
+		const int idx = isShadow ? PACKED_SHADOW : PACKED_GBUFFER;
+		ID3D11Buffer *buffers[2] = { mesh.posBuff, mesh.attrBuff };
+		const UINT strides[2] = { sizeof(cVertexCodec::sPackedPos), sizeof(cVertexCodec::sPackedAttr) };
+		const UINT offsets[2] = { 0, 0 };
+		devContext->IASetInputLayout(m_packedLayout[idx]);
+		devContext->VSSetShader(m_packedVS[idx], NULL, 0);
+		devContext->VSSetConstantBuffers(9, 1, &m_cbDecode);
+		devContext->IASetVertexBuffers(0, isShadow ? 1 : 2, buffers, strides, offsets);
+	}
+	else
+	{
+		const UINT stride = sizeof(sMeshVertex);
+		const UINT offset = 0;
+		devContext->IASetVertexBuffers(0, 1, &mesh.vtxBuff, &stride, &offset);
+	}
+	devContext->IASetIndexBuffer(mesh.idxBuff, DXGI_FORMAT_R32_UINT, 0);
+	devContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	++m_lodDrawCount[lod];
+	if (ranges)
+	{
+		for (auto &range : *ranges)
+		{
+			devContext->DrawIndexed(range.indexCount, range.indexOffset, 0);
+			++m_drawCount;
+			m_triangleCount += range.indexCount / 3;
+		}
+	}
+	else
+	{
+		devContext->DrawIndexed(mesh.indexCount, 0, 0);
+		++m_drawCount;
+		m_triangleCount += mesh.indexCount / 3;
+	}
+}
+
+
+// world matrix from cbPerFrameInstancing (gWorldInst), caller update
+// packed vertex: override caller vertex shader, input layout (Unlit_Packed_Instancing)
+// Unlit_Packed_Instancing not loaded: sMeshVertex stream, caller vertex shader
+// ranges: index range list, one DrawIndexedInstanced per range, NULL: all
+void cMeshLod::RenderInstanced(cRenderer &renderer, const int lod, const UINT instanceCount
+	, const std::vector<cMeshletCuller::sRange> *ranges //= NULL
+)
+{
+	if ((lod < 0) || (lod >= (int)m_lods.size()) || (0 == instanceCount))
+		return;
+	if (ranges && ranges->empty())
+		return; // all cluster culled
+	const sLod &mesh = m_lods[lod];
+	ID3D11DeviceContext *devContext = renderer.GetDevContext();
+
+	renderer.m_cbPerFrame.Update(renderer); // view, projection
+
+	if (m_isPacked && IsPackedInstancing())
+	{
+		ID3D11Buffer *buffers[2] = { mesh.posBuff, mesh.attrBuff };
+		const UINT strides[2] = { sizeof(cVertexCodec::sPackedPos), sizeof(cVertexCodec::sPackedAttr) };
+		const UINT offsets[2] = { 0, 0 };
+		devContext->IASetInputLayout(m_packedLayout[PACKED_GBUFFER_INST]);
+		devContext->VSSetShader(m_packedVS[PACKED_GBUFFER_INST], NULL, 0);
+		devContext->VSSetConstantBuffers(9, 1, &m_cbDecode);
+		devContext->IASetVertexBuffers(0, 2, buffers, strides, offsets);
+	}
+	else
+	{
+		const UINT stride = sizeof(sMeshVertex);
+		const UINT offset = 0;
+		devContext->IASetVertexBuffers(0, 1, &mesh.vtxBuff, &stride, &offset);
+	}
+	devContext->IASetIndexBuffer(mesh.idxBuff, DXGI_FORMAT_R32_UINT, 0);
+	devContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	m_lodDrawCount[lod] += instanceCount;
+	if (ranges)
+	{
+		for (auto &range : *ranges)
+		{
+			devContext->DrawIndexedInstanced(range.indexCount, instanceCount, range.indexOffset, 0, 0);
+			++m_drawCount;
+			m_triangleCount += range.indexCount / 3 * instanceCount;
+		}
+	}
+	else
+	{
+		devContext->DrawIndexedInstanced(mesh.indexCount, instanceCount, 0, 0, 0);
+		++m_drawCount;
+		m_triangleCount += mesh.indexCount / 3 * instanceCount;
+	}
+}
+
+
+// render thread, before Record()
+// upload view, projection, snapshot cbPerFrame for per model world matrix
+bool cMeshLod::BeginRecord(cRenderer &renderer)
+{
+	renderer.m_cbPerFrame.Update(renderer);
+	m_recordCb = cCommandBuffer::GetVSConstantBuffer(renderer.GetDevContext(), 0);
+	RETV2(!m_recordCb, false);
+
+	// UpdateSubresource() copy whole buffer
+	D3D11_BUFFER_DESC desc;
+	m_recordCb->GetDesc(&desc);
+	const BYTE *src = (const BYTE*)renderer.m_cbPerFrame.m_v;
+	const UINT size = sizeof(*renderer.m_cbPerFrame.m_v);
+	m_recordCbData.assign(desc.ByteWidth, 0);
+	memcpy(&m_recordCbData[0], src, min(size, desc.ByteWidth));
+	m_recordWorldOffset = (UINT)((const BYTE*)&renderer.m_cbPerFrame.m_v->mWorld - src);
+	return true;
+}
+
+
+// same command with Render(), any thread
+// replay on render thread, caller state (effect pass, pipeline) bound
+void cMeshLod::Record(cCommandBuffer &cmdBuff, const int lod, const XMMATRIX &tm
+	, const bool isShadow, const std::vector<cMeshletCuller::sRange> *ranges
+	, OUT sDrawStats &stats) const
+{
+	if ((lod < 0) || (lod >= (int)m_lods.size()) || !m_recordCb)
+		return;
+	if (ranges && ranges->empty())
+		return; // all cluster culled
+	const sLod &mesh = m_lods[lod];
+
+	BYTE *cb = cmdBuff.UpdateBuffer(m_recordCb, &m_recordCbData[0], (UINT)m_recordCbData.size());
+	const XMMATRIX world = XMMatrixTranspose(tm);
+	memcpy(cb + m_recordWorldOffset, &world, sizeof(world));
+	cmdBuff.SetVSConstantBuffer(0, m_recordCb); // effect Apply() rebind own buffer
+
+	if (m_isPacked && IsPacked())
+	{
+		const int idx = isShadow ? PACKED_SHADOW : PACKED_GBUFFER;
+		ID3D11Buffer *buffers[2] = { mesh.posBuff, mesh.attrBuff };
+		const UINT strides[2] = { sizeof(cVertexCodec::sPackedPos), sizeof(cVertexCodec::sPackedAttr) };
+		cmdBuff.SetInputLayout(m_packedLayout[idx]);
+		cmdBuff.SetVertexShader(m_packedVS[idx]);
+		cmdBuff.SetVSConstantBuffer(9, m_cbDecode);
+		cmdBuff.SetVertexBuffers(isShadow ? 1 : 2, buffers, strides);
+	}
+	else
+	{
+		cmdBuff.SetVertexBuffer(mesh.vtxBuff, sizeof(sMeshVertex));
+	}
+	cmdBuff.SetIndexBuffer(mesh.idxBuff, DXGI_FORMAT_R32_UINT);
+	cmdBuff.SetTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	++stats.lodDrawCount[lod];
+	if (ranges)
+	{
+		for (auto &range : *ranges)
+		{
+			cmdBuff.DrawIndexed(range.indexCount, range.indexOffset, 0);
+			++stats.drawCount;
+			stats.triangleCount += range.indexCount / 3;
+		}
+	}
+	else
+	{
+		cmdBuff.DrawIndexed(mesh.indexCount, 0, 0);
+		++stats.drawCount;
+		stats.triangleCount += mesh.indexCount / 3;
+	}
+}
+
+
+// same command with RenderInstanced(), any thread
+// cbPerFrameInstancing update, bind recorded by caller
+// view, projection from BeginRecord()
+void cMeshLod::RecordInstanced(cCommandBuffer &cmdBuff, const int lod, const UINT instanceCount
+	, const std::vector<cMeshletCuller::sRange> *ranges, OUT sDrawStats &stats) const
+{
+	if ((lod < 0) || (lod >= (int)m_lods.size()) || (0 == instanceCount) || !m_recordCb)
+		return;
+	if (ranges && ranges->empty())
+		return; // all cluster culled
+	const sLod &mesh = m_lods[lod];
+
+	cmdBuff.SetVSConstantBuffer(0, m_recordCb);
+	if (m_isPacked && IsPackedInstancing())
+	{
+		ID3D11Buffer *buffers[2] = { mesh.posBuff, mesh.attrBuff };
+		const UINT strides[2] = { sizeof(cVertexCodec::sPackedPos), sizeof(cVertexCodec::sPackedAttr) };
+		cmdBuff.SetInputLayout(m_packedLayout[PACKED_GBUFFER_INST]);
+		cmdBuff.SetVertexShader(m_packedVS[PACKED_GBUFFER_INST]);
+		cmdBuff.SetVSConstantBuffer(9, m_cbDecode);
+		cmdBuff.SetVertexBuffers(2, buffers, strides);
+	}
+	else
+	{
+		cmdBuff.SetVertexBuffer(mesh.vtxBuff, sizeof(sMeshVertex));
+	}
+	cmdBuff.SetIndexBuffer(mesh.idxBuff, DXGI_FORMAT_R32_UINT);
+	cmdBuff.SetTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	stats.lodDrawCount[lod] += instanceCount;
+	if (ranges)
+	{
+		for (auto &range : *ranges)
+		{
+			cmdBuff.DrawIndexedInstanced(range.indexCount, instanceCount, range.indexOffset, 0);
+			++stats.drawCount;
+			stats.triangleCount += range.indexCount / 3 * instanceCount;
+		}
+	}
+	else
+	{
+		cmdBuff.DrawIndexedInstanced(mesh.indexCount, instanceCount, 0, 0);
+		++stats.drawCount;
+		stats.triangleCount += mesh.indexCount / 3 * instanceCount;
+	}
+}
+
+
+// compressed vertex buffer, shader ready
+bool cMeshLod::IsPacked() const
+{
+	return !m_lods.empty() && m_lods.back().attrBuff && m_cbDecode
+		&& m_packedLayout[PACKED_GBUFFER] && m_packedLayout[PACKED_SHADOW];
+}
+
+
+// compressed vertex instanced draw, Unlit_Packed_Instancing technique loaded
+bool cMeshLod::IsPackedInstancing() const
+{
+	return IsPacked() && m_packedLayout[PACKED_GBUFFER_INST];
+}
+
+
+void cMeshLod::ResetStats()
+{
+	m_drawCount = 0;
+	m_triangleCount = 0;
+	ZeroMemory(m_lodDrawCount, sizeof(m_lodDrawCount));
+}
+
+
+// render thread, Record() statistics
+void cMeshLod::AddStats(const sDrawStats &stats)
+{
+	m_drawCount += stats.drawCount;
+	m_triangleCount += stats.triangleCount;
+	for (int i = 0; i < cMeshImporter::MAX_LOD; ++i)
+		m_lodDrawCount[i] += stats.lodDrawCount[i];
+}
+
+
+// projected bounding sphere diameter (pixel)
+// projScale: projection matrix _22 * viewport height * 0.5
+float cMeshLod::GetScreenSize(const Vector3 &center, const float radius
+	, const Vector3 &eyePos, const float projScale)
+{
+	const float dist = (center - eyePos).Length();
+	if (dist <= radius)
+		return FLT_MAX; // camera inside sphere
+	return radius * 2.f * projScale / dist;
+}
+
+
+// submitted triangle count, LOD vs LOD0, camera distance 2.5, 5, 10, 20 from bound center
+// x,y,z,r : world bounding sphere (cTransformHierarchy bound array)
+// camera look at bound center, no frustum culling
+void cMeshLod::Benchmark(const float *x, const float *y, const float *z, const float *r
+	, const int count, const float projScale, OUT sBenchmark &out) const
+{
+	ZeroMemory(&out, sizeof(out));
+	if (m_lods.empty() || (count <= 0))
+		return;
+
+	Vector3 center(0, 0, 0);
+	for (int i = 0; i < count; ++i)
+		center = center + Vector3(x[i], y[i], z[i]);
+	center = center * (1.f / count);
+
+	const Vector3 dir = Vector3(1, 1, -1).Normal();
+	const float distances[MAX_DISTANCE] = { 2.5f, 5.f, 10.f, 20.f };
+	out.count = count;
+	for (int d = 0; d < MAX_DISTANCE; ++d)
+	{
+		out.distance[d] = distances[d];
+		const Vector3 eyePos = center + dir * distances[d];
+		for (int i = 0; i < count; ++i)
+		{
+			const float size = GetScreenSize(Vector3(x[i], y[i], z[i]), r[i], eyePos, projScale);
+			const int lod = SelectLod(size);
+			out.lodTriangles[d] += m_lods[lod].indexCount / 3;
+			out.fullTriangles[d] += m_lods[0].indexCount / 3;
+			++out.lodHistogram[d][lod];
+		}
+	}
+}
+
+
+void cMeshLod::Clear()
+{
+	for (auto &lod : m_lods)
+	{
+		SAFE_RELEASE(lod.vtxBuff);
+		SAFE_RELEASE(lod.posBuff);
+		SAFE_RELEASE(lod.attrBuff);
+		SAFE_RELEASE(lod.idxBuff);
+	}
+	m_lods.clear();
+
+	for (int i = 0; i < PACKED_MAX; ++i)
+	{
+		SAFE_RELEASE(m_packedLayout[i]);
+		SAFE_RELEASE(m_packedVS[i]);
+	}
+	SAFE_RELEASE(m_packedEffect[0]);
+	SAFE_RELEASE(m_packedEffect[1]);
+	SAFE_RELEASE(m_cbDecode);
+	m_recordCb = NULL;
+	m_recordCbData.clear();
+	m_vertexBytes = 0;
+	m_packedBytes = 0;
+}
@@ -0,0 +1,126 @@
+//
+// 2018-05-18, jjuiddong
+// Mesh LOD
+//	- LOD chain from cMeshImporter (.mesh), one vertex/index buffer per LOD
+//	- LOD select by projected bounding sphere diameter (pixel)
+//	- bias < 1 : coarser LOD (shadow pass)
+//	- Benchmark() : submitted triangle count by camera distance, analytic
+//	- compressed vertex (cVertexCodec), 32 -> 16 bytes, m_isPacked
+//	  shadow pass bind position stream only (8 bytes)
+//	- per LOD meshlet cluster set, Render() visible index range only (cMeshletCuller)
+//	- RenderInstanced() : same LOD instanced draw (cRenderQueue batch)
+//	  packed vertex: Unlit_Packed_Instancing, index range list (batch visible cluster union)
+//	- Record(), RecordInstanced() : same command with Render(), cCommandBuffer
+//	  any thread after BeginRecord(), statistics per command buffer (AddStats())
+//
+#pragma once
+
+#include "meshimporter.h"
+#include "vertexcodec.h"
+#include "meshletculler.h"
+#include "commandbuffer.h"
+
+
+namespace graphic
+{
+
+	class cMeshLod
+	{
+	public:
+		enum { MAX_DISTANCE = 4 };
+		enum { PACKED_GBUFFER, PACKED_SHADOW, PACKED_GBUFFER_INST, PACKED_MAX };
+
+		struct sBenchmark
+		{
+			int count; // object count
+			float distance[MAX_DISTANCE];
+			int lodTriangles[MAX_DISTANCE]; // with LOD
+			int fullTriangles[MAX_DISTANCE]; // LOD0 only
+			int lodHistogram[MAX_DISTANCE][cMeshImporter::MAX_LOD];
+		};
+
+		// Record() statistics, one per command buffer
+		struct sDrawStats
+		{
+			int drawCount;
+			int triangleCount;
+			int lodDrawCount[cMeshImporter::MAX_LOD];
+		};
+
+		struct sLod
+		{
+			ID3D11Buffer *vtxBuff; // sMeshVertex
+			ID3D11Buffer *posBuff; // cVertexCodec::sPackedPos, stream 0
+			ID3D11Buffer *attrBuff; // cVertexCodec::sPackedAttr, stream 1
+			ID3D11Buffer *idxBuff; // R32_UINT
+			UINT indexCount;
+			cMeshletCuller::sClusterSet clusters;
+		};
+
+		cMeshLod();
+		virtual ~cMeshLod();
+
+		bool Create(cRenderer &renderer, const std::vector<sMeshData> &lods);
+		int SelectLod(const float screenSize, const float bias = 1.f) const;
+		void Render(cRenderer &renderer, const int lod, const XMMATRIX &tm
+			, const bool isShadow = false
+			, const std::vector<cMeshletCuller::sRange> *ranges = NULL);
+		void RenderInstanced(cRenderer &renderer, const int lod, const UINT instanceCount
+			, const std::vector<cMeshletCuller::sRange> *ranges = NULL);
+		bool BeginRecord(cRenderer &renderer);
+		void Record(cCommandBuffer &cmdBuff, const int lod, const XMMATRIX &tm
+			, const bool isShadow, const std::vector<cMeshletCuller::sRange> *ranges
+			, OUT sDrawStats &stats) const;
+		void RecordInstanced(cCommandBuffer &cmdBuff, const int lod, const UINT instanceCount
+			, const std::vector<cMeshletCuller::sRange> *ranges, OUT sDrawStats &stats) const;
+		bool IsPacked() const;
+		bool IsPackedInstancing() const;
+		void ResetStats();
+		void AddStats(const sDrawStats &stats);
+		void Benchmark(const float *x, const float *y, const float *z, const float *r
+			, const int count, const float projScale, OUT sBenchmark &out) const;
+		void Clear();
+
+		static float GetScreenSize(const Vector3 &center, const float radius
+			, const Vector3 &eyePos, const float projScale);
+
+
+	protected:
+		bool CreatePacked(cRenderer &renderer, const std::vector<sMeshData> &lods);
+		ID3DX11Effect* LoadPackedEffect(ID3D11Device *device, const char *fileName);
+		bool CreatePackedShader(ID3D11Device *device, ID3DX11Effect *effect
+			, const char *technique, const D3D11_INPUT_ELEMENT_DESC *elems
+			, const int elemCount, const int idx);
+
+
+	public:
+		std::vector<sLod> m_lods;
+		float m_lodScreenSize[cMeshImporter::MAX_LOD]; // pixel, lower -> next LOD
+		Vector3 m_center; // bounding sphere, mesh space
+		float m_radius;
+
+		// compressed vertex
+		// effect [0]: deferredshading.fx, [1]: shadowgen.fx
+		// vertex shader, input layout index: PACKED_GBUFFER, PACKED_SHADOW, PACKED_GBUFFER_INST
+		bool m_isPacked;
+		cVertexCodec::sDecode m_decode;
+		cVertexCodec::sError m_codecError; // LOD0
+		ID3DX11Effect *m_packedEffect[2];
+		ID3D11VertexShader *m_packedVS[PACKED_MAX];
+		ID3D11InputLayout *m_packedLayout[PACKED_MAX];
+		ID3D11Buffer *m_cbDecode; // vertexdecode.fx, register(b9)
+		UINT m_vertexBytes; // all LOD, sMeshVertex
+		UINT m_packedBytes; // all LOD, sPackedPos + sPackedAttr
+
+		// BeginRecord(), cbPerFrame snapshot, Record() patch world matrix
+		ID3D11Buffer *m_recordCb; // renderer cbPerFrame, not owned
+		std::vector<BYTE> m_recordCbData;
+		UINT m_recordWorldOffset;
+
+		// Render() statistics, ResetStats() clear
+		int m_drawCount;
+		int m_triangleCount;
+		int m_lodDrawCount[cMeshImporter::MAX_LOD];
+	};
+
+}
@@ -0,0 +1,417 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "meshoptimizer.h"
+#include "meshsimplifier.h"
+#include "../../Shared/steadytimer.h"
+#include <algorithm>
+
+using namespace graphic;
+
+
+namespace
+{
+	// Forsyth, linear speed vertex cache optimisation
+	const float g_cacheDecayPower = 1.5f;
+	const float g_lastTriScore = 0.75f;
+	const float g_valenceBoostScale = 2.f;
+	const float g_valenceBoostPower = 0.5f;
+
+	// cachePos: LRU position, -1 = not in cache
+	// remaining: not emitted triangle count, use this vertex
+	float GetVertexScore(const int cachePos, const int remaining)
+	{
+		if (remaining <= 0)
+			return -1.f; // no triangle need this vertex
+
+		float score = 0.f;
+		if (cachePos >= 0)
+		{
+			if (cachePos < 3)
+			{
+				score = g_lastTriScore; // used by last triangle, fixed score
+			}
+			else
+			{
+				const float scaler = 1.f / (cMeshOptimizer::LRU_SIZE - 3);
+				score = powf(1.f - (cachePos - 3) * scaler, g_cacheDecayPower);
+			}
+		}
+
+		// boost vertex with few triangle remaining, avoid isolated triangle
+		score += g_valenceBoostScale * powf((float)remaining, -g_valenceBoostPower);
+		return score;
+	}
+
+
+	// FIFO cache simulate by timestamp
+	// vertex hit if transformed in last cacheSize transform
+	struct sFifoCache
+	{
+		std::vector<int> stamps;
+		int time;
+		int cacheSize;
+
+		sFifoCache(const UINT vertexCount, const int size)
+			: stamps(vertexCount, 0), time(size + 1), cacheSize(size) {
+		}
+
+		// return 1 if miss
+		int Access(const UINT v) {
+			if (time - stamps[v] <= cacheSize)
+				return 0;
+			stamps[v] = time++;
+			return 1;
+		}
+
+		// invalidate all entry
+		void Reset() {
+			time += cacheSize + 1;
+		}
+	};
+
+}
+
+
+// vertex cache -> overdraw -> vertex fetch
+void cMeshOptimizer::Optimize(sMeshData &mesh
+	, const bool isOverdraw //= true
+)
+{
+	OptimizeVertexCache(mesh.indices, (UINT)mesh.vertices.size());
+	if (isOverdraw)
+		OptimizeOverdraw(mesh.indices, mesh.vertices);
+	OptimizeVertexFetch(mesh);
+}
+
+
+// Forsyth, greedy emit best score triangle
+// candidate triangle from vertex in cache, else next not emitted triangle
+void cMeshOptimizer::OptimizeVertexCache(std::vector<UINT> &indices, const UINT vertexCount)
+{
+	const int triCount = (int)indices.size() / 3;
+	if (triCount <= 0)
+		return;
+
+	// vertex -> triangle adjacency, front [0, remaining) not emitted
+	std::vector<int> remaining(vertexCount, 0);
+	for (auto idx : indices)
+		++remaining[idx];
+
+	std::vector<int> offsets(vertexCount + 1, 0);
+	for (UINT v = 0; v < vertexCount; ++v)
+		offsets[v + 1] = offsets[v] + remaining[v];
+
+	std::vector<int> adjacency(indices.size());
+	{
+		std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+		for (int t = 0; t < triCount; ++t)
+			for (int k = 0; k < 3; ++k)
+				adjacency[cursor[indices[t * 3 + k]]++] = t;
+	}
+
+	std::vector<int> cachePos(vertexCount, -1);
+	std::vector<float> vtxScore(vertexCount);
+	for (UINT v = 0; v < vertexCount; ++v)
+		vtxScore[v] = GetVertexScore(-1, remaining[v]);
+
+	std::vector<float> triScore(triCount);
+	std::vector<bool> isEmitted(triCount, false);
+	int best = 0;
+	for (int t = 0; t < triCount; ++t)
+	{
+		triScore[t] = vtxScore[indices[t * 3]] + vtxScore[indices[t * 3 + 1]]
+			+ vtxScore[indices[t * 3 + 2]];
+		if (triScore[t] > triScore[best])
+			best = t;
+	}
+
+	std::vector<UINT> out;
+	out.reserve(indices.size());
+	UINT cache[LRU_SIZE + 3];
+	int cacheCount = 0;
+	int nextCandidate = 0; // no candidate in cache, emit order
+
+	while ((int)out.size() < triCount * 3)
+	{
+		if (best < 0)
+		{
+			while (isEmitted[nextCandidate])
+				++nextCandidate;
+			best = nextCandidate;
+		}
+
+		const UINT *tri = &indices[best * 3];
+		out.push_back(tri[0]);
+		out.push_back(tri[1]);
+		out.push_back(tri[2]);
+		isEmitted[best] = true;
+
+		// remove emitted triangle from vertex adjacency
+		for (int k = 0; k < 3; ++k)
+		{
+			const UINT v = tri[k];
+			int *adj = &adjacency[offsets[v]];
+			for (int i = 0; i < remaining[v]; ++i)
+			{
+				if (adj[i] == best)
+				{
+					std::swap(adj[i], adj[remaining[v] - 1]);
+					break;
+				}
+			}
+			--remaining[v];
+		}
+
+		// LRU, triangle vertex to front
+		UINT newCache[LRU_SIZE + 3];
+		int newCount = 0;
+		for (int k = 0; k < 3; ++k)
+			newCache[newCount++] = tri[k];
+		for (int i = 0; i < cacheCount; ++i)
+		{
+			const UINT v = cache[i];
+			if ((v != tri[0]) && (v != tri[1]) && (v != tri[2]))
+				newCache[newCount++] = v;
+		}
+
+		// update vertex score in cache (or evicted) and adjacent triangle score
+		best = -1;
+		float bestScore = -1.f;
+		for (int i = 0; i < newCount; ++i)
+		{
+			const UINT v = newCache[i];
+			cachePos[v] = (i < LRU_SIZE) ? i : -1;
+			const float score = GetVertexScore(cachePos[v], remaining[v]);
+			const float diff = score - vtxScore[v];
+			vtxScore[v] = score;
+
+			const int *adj = &adjacency[offsets[v]];
+			for (int k = 0; k < remaining[v]; ++k)
+			{
+				const int t = adj[k];
+				triScore[t] += diff;
+				if ((i < LRU_SIZE) && (triScore[t] > bestScore))
+				{
+					bestScore = triScore[t];
+					best = t;
+				}
+			}
+		}
+
+		cacheCount = min(newCount, (int)LRU_SIZE);
+		memcpy(cache, newCache, sizeof(UINT) * cacheCount);
+	}
+
+	indices.swap(out);
+}
+
+
+// vertex cache optimized index input
+// cluster: split at cache restart (hard boundary), or where cluster ACMR
+// under threshold * mesh ACMR (soft boundary)
+// sort cluster by dot(cluster center - mesh center, cluster normal), outer first
+void cMeshOptimizer::OptimizeOverdraw(std::vector<UINT> &indices
+	, const std::vector<sMeshVertex> &vertices
+	, const float threshold //= 1.05f
+)
+{
+	const int triCount = (int)indices.size() / 3;
+	if (triCount <= 0)
+		return;
+
+	const sStats stats = AnalyzeVertexCache(indices, (UINT)vertices.size());
+	const float limit = stats.acmr * threshold;
+
+	// hard boundary, triangle all vertex cache miss
+	std::vector<int> hardStarts;
+	{
+		sFifoCache cache((UINT)vertices.size(), CACHE_SIZE);
+		for (int t = 0; t < triCount; ++t)
+		{
+			int miss = 0;
+			for (int k = 0; k < 3; ++k)
+				miss += cache.Access(indices[t * 3 + k]);
+			if ((miss == 3) || (t == 0))
+				hardStarts.push_back(t);
+		}
+		hardStarts.push_back(triCount);
+	}
+
+	// soft boundary, simulate each cluster from cold cache
+	std::vector<int> starts;
+	{
+		sFifoCache cache((UINT)vertices.size(), CACHE_SIZE);
+		for (u_int i = 0; i < hardStarts.size() - 1; ++i)
+		{
+			const int end = hardStarts[i + 1];
+			int start = hardStarts[i];
+			int miss = 0;
+			starts.push_back(start);
+			cache.Reset();
+			for (int t = start; t < end - 1; ++t)
+			{
+				for (int k = 0; k < 3; ++k)
+					miss += cache.Access(indices[t * 3 + k]);
+				if (miss <= limit * (t - start + 1))
+				{
+					start = t + 1;
+					miss = 0;
+					starts.push_back(start);
+					cache.Reset();
+				}
+			}
+		}
+		starts.push_back(triCount);
+	}
+
+	// cluster sort key
+	struct sCluster
+	{
+		int start;
+		int end;
+		float key;
+	};
+
+	const int clusterCount = (int)starts.size() - 1;
+	std::vector<sCluster> clusters(clusterCount);
+	std::vector<Vector3> centers(clusterCount);
+	std::vector<Vector3> normals(clusterCount);
+	Vector3 meshCenter(0, 0, 0);
+	float meshArea = 0.f;
+	for (int c = 0; c < clusterCount; ++c)
+	{
+		Vector3 center(0, 0, 0);
+		Vector3 normal(0, 0, 0);
+		float area = 0.f;
+		for (int t = starts[c]; t < starts[c + 1]; ++t)
+		{
+			const Vector3 &p0 = vertices[indices[t * 3]].pos;
+			const Vector3 &p1 = vertices[indices[t * 3 + 1]].pos;
+			const Vector3 &p2 = vertices[indices[t * 3 + 2]].pos;
+			const Vector3 n = (p1 - p0).CrossProduct(p2 - p0); // length = area * 2
+			const float a = n.Length() * 0.5f;
+			center = center + (p0 + p1 + p2) * (a / 3.f);
+			normal = normal + n;
+			area += a;
+		}
+
+		meshCenter = meshCenter + center;
+		meshArea += area;
+		centers[c] = (area > 0.f) ? center * (1.f / area) : vertices[indices[starts[c] * 3]].pos;
+		const float len = normal.Length();
+		normals[c] = (len > 0.f) ? normal * (1.f / len) : Vector3(0, 0, 0);
+		clusters[c].start = starts[c];
+		clusters[c].end = starts[c + 1];
+	}
+	if (meshArea > 0.f)
+		meshCenter = meshCenter * (1.f / meshArea);
+
+	for (int c = 0; c < clusterCount; ++c)
+		clusters[c].key = (centers[c] - meshCenter).DotProduct(normals[c]);
+
+	std::stable_sort(clusters.begin(), clusters.end()
+		, [](const sCluster &a, const sCluster &b) { return a.key > b.key; });
+
+	std::vector<UINT> out;
+	out.reserve(indices.size());
+	for (auto &cluster : clusters)
+		out.insert(out.end(), indices.begin() + cluster.start * 3
+			, indices.begin() + cluster.end * 3);
+	indices.swap(out);
+}
+
+
+// vertex order = first reference in index buffer
+// vertex not referenced removed
+void cMeshOptimizer::OptimizeVertexFetch(sMeshData &mesh)
+{
+	std::vector<int> remap(mesh.vertices.size(), -1);
+	std::vector<sMeshVertex> vertices;
+	vertices.reserve(mesh.vertices.size());
+	for (auto &idx : mesh.indices)
+	{
+		if (remap[idx] < 0)
+		{
+			remap[idx] = (int)vertices.size();
+			vertices.push_back(mesh.vertices[idx]);
+		}
+		idx = (UINT)remap[idx];
+	}
+	mesh.vertices.swap(vertices);
+}
+
+
+// FIFO cache simulate, index order
+cMeshOptimizer::sStats cMeshOptimizer::AnalyzeVertexCache(const std::vector<UINT> &indices
+	, const UINT vertexCount
+	, const int cacheSize //= CACHE_SIZE
+)
+{
+	sStats stats;
+	ZeroMemory(&stats, sizeof(stats));
+	stats.triangleCount = (int)indices.size() / 3;
+
+	std::vector<bool> isUsed(vertexCount, false);
+	sFifoCache cache(vertexCount, cacheSize);
+	for (auto idx : indices)
+	{
+		stats.transformCount += cache.Access(idx);
+		if (!isUsed[idx])
+		{
+			isUsed[idx] = true;
+			++stats.vertexCount;
+		}
+	}
+
+	if (stats.triangleCount > 0)
+		stats.acmr = (float)stats.transformCount / (float)stats.triangleCount;
+	if (stats.vertexCount > 0)
+		stats.atvr = (float)stats.transformCount / (float)stats.vertexCount;
+	return stats;
+}
+
+
+// import pipeline (ReadX, Simplify, Optimize) without cache, write statistic
+// per LOD, before -> after optimize, FIFO 16, 32
+bool cMeshOptimizer::Report(const char *srcFileName, const char *outFileName)
+{
+	sMeshData src;
+	if (!cMeshImporter::ReadX(srcFileName, src))
+		return false;
+
+	const float ratios[cMeshImporter::MAX_LOD - 1] = { 0.5f, 0.25f, 0.125f };
+	std::vector<sMeshData> lods(1, src);
+	if (!cMeshSimplifier::Simplify(src, ratios, cMeshImporter::MAX_LOD - 1, lods))
+		return false;
+
+	FILE *fp = NULL;
+	if (fopen_s(&fp, outFileName, "w") || !fp)
+		return false;
+
+	fprintf(fp, "%s\n", srcFileName);
+	fprintf(fp, "LOD  vertex  triangle   ACMR16         ATVR16         ACMR32         ATVR32         ms\n");
+	for (u_int i = 0; i < lods.size(); ++i)
+	{
+		sMeshData &mesh = lods[i];
+		const UINT vertexCount = (UINT)mesh.vertices.size();
+		const sStats before16 = AnalyzeVertexCache(mesh.indices, vertexCount, 16);
+		const sStats before32 = AnalyzeVertexCache(mesh.indices, vertexCount, 32);
+
+		const double t0 = GetSteadyTimeMs();
+		Optimize(mesh);
+		const double t1 = GetSteadyTimeMs();
+
+		const sStats after16 = AnalyzeVertexCache(mesh.indices, vertexCount, 16);
+		const sStats after32 = AnalyzeVertexCache(mesh.indices, vertexCount, 32);
+		fprintf(fp, "%-4d %6d  %8d   %.3f->%.3f  %.3f->%.3f  %.3f->%.3f  %.3f->%.3f  %.1f\n"
+			, i, vertexCount, before16.triangleCount
+			, before16.acmr, after16.acmr, before16.atvr, after16.atvr
+			, before32.acmr, after32.acmr, before32.atvr, after32.atvr, t1 - t0);
+	}
+
+	fclose(fp);
+	return true;
+}
@@ -0,0 +1,44 @@
+//
+// 2018-05-19, jjuiddong
+// Mesh Optimizer
+//	- index reorder for post transform vertex cache (Forsyth, LRU 32 score)
+//	- overdraw, cluster triangle and sort outward facing cluster first
+//	  (Sander, Nehab, Barczak, fast triangle reordering)
+//	- vertex reorder by first use, vertex fetch locality
+//	- ACMR (transform / triangle), ATVR (transform / vertex), FIFO cache simulate
+//	- Report() : per LOD statistic, sample command line -meshstats
+//
+#pragma once
+
+#include "meshimporter.h"
+
+
+namespace graphic
+{
+
+	class cMeshOptimizer
+	{
+	public:
+		enum { CACHE_SIZE = 16 }; // FIFO, statistic
+		enum { LRU_SIZE = 32 }; // Forsyth score
+
+		struct sStats
+		{
+			int vertexCount;
+			int triangleCount;
+			int transformCount; // cache miss
+			float acmr; // average cache miss ratio, transform / triangle (0.5 ~ 3)
+			float atvr; // average transform to vertex ratio (1 = ideal)
+		};
+
+		static void Optimize(sMeshData &mesh, const bool isOverdraw = true);
+		static void OptimizeVertexCache(std::vector<UINT> &indices, const UINT vertexCount);
+		static void OptimizeOverdraw(std::vector<UINT> &indices
+			, const std::vector<sMeshVertex> &vertices, const float threshold = 1.05f);
+		static void OptimizeVertexFetch(sMeshData &mesh);
+		static sStats AnalyzeVertexCache(const std::vector<UINT> &indices, const UINT vertexCount
+			, const int cacheSize = CACHE_SIZE);
+		static bool Report(const char *srcFileName, const char *outFileName);
+	};
+
+}
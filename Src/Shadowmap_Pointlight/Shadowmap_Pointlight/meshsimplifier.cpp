@@ -0,0 +1,408 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "meshsimplifier.h"
+#include <map>
+#include <queue>
+#include <tuple>
+#include <algorithm>
+
+using namespace graphic;
+
+
+namespace
+{
+	// symmetric 4x4, upper triangle
+	struct sQuadric
+	{
+		double a[10]; // xx xy xz xw yy yz yw zz zw ww
+
+		sQuadric() { ZeroMemory(a, sizeof(a)); }
+
+		// plane (nx, ny, nz, d), weight
+		void AddPlane(const double x, const double y, const double z, const double w
+			, const double weight) {
+			a[0] += weight * x * x; a[1] += weight * x * y; a[2] += weight * x * z; a[3] += weight * x * w;
+			a[4] += weight * y * y; a[5] += weight * y * z; a[6] += weight * y * w;
+			a[7] += weight * z * z; a[8] += weight * z * w;
+			a[9] += weight * w * w;
+		}
+
+		void Add(const sQuadric &q) {
+			for (int i = 0; i < 10; ++i)
+				a[i] += q.a[i];
+		}
+
+		double Eval(const Vector3 &v) const {
+			const double x = v.x, y = v.y, z = v.z;
+			return a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z + 2 * a[3] * x
+				+ a[4] * y * y + 2 * a[5] * y * z + 2 * a[6] * y
+				+ a[7] * z * z + 2 * a[8] * z
+				+ a[9];
+		}
+	};
+
+	// collapse a -> b, b position = target
+	struct sCollapse
+	{
+		double cost;
+		int a, b;
+		int stampA, stampB;
+		int candidate; // target, 0: b, 1: a, 2: midpoint
+		Vector3 target;
+
+		bool operator<(const sCollapse &rhs) const { return cost > rhs.cost; } // min heap
+	};
+
+	const double g_borderWeight = 100.0;
+
+
+	class cSimplifier
+	{
+	public:
+		bool Init(const sMeshData &src);
+		void Collapse(const int targetTriCount);
+		void Output(OUT sMeshData &out) const;
+		int GetTriangleCount() const { return m_aliveCount; }
+
+	protected:
+		void PushEdge(const int a, const int b);
+		bool IsFlip(const int a, const int b, const Vector3 &target) const;
+		Vector3 GetNormal(const int t, const int v, const Vector3 &pos) const;
+
+	public:
+		std::vector<Vector3> m_pos; // welded vertex
+		std::vector<Vector3> m_normal; // source normal, valid if !m_isMoved
+		std::vector<Vector2> m_uv;
+		std::vector<bool> m_isMoved; // position changed, recalculate normal
+		std::vector<bool> m_isLocked; // attribute seam, never removed or moved
+		std::vector<sQuadric> m_quadrics;
+		std::vector<int> m_stamps;
+		std::vector<bool> m_isRemoved;
+		std::vector<std::vector<int>> m_vtxTris; // vertex -> triangle, lazy remove
+		std::vector<int> m_tris; // 3 welded vertex per triangle
+		std::vector<bool> m_isAlive;
+		int m_aliveCount;
+		std::priority_queue<sCollapse> m_heap;
+	};
+
+
+	bool cSimplifier::Init(const sMeshData &src)
+	{
+		// weld same position, normal, uv
+		// position shared by other attribute vertex: seam, lock
+		typedef std::tuple<float, float, float> PosKey;
+		typedef std::tuple<float, float, float, float, float, float, float, float> VtxKey;
+		std::map<VtxKey, int> vtxMap;
+		std::map<PosKey, int> posCount; // welded vertex count per position
+		std::vector<int> remap(src.vertices.size());
+		for (u_int i = 0; i < src.vertices.size(); ++i)
+		{
+			const sMeshVertex &v = src.vertices[i];
+			const VtxKey key = std::make_tuple(v.pos.x, v.pos.y, v.pos.z
+				, v.normal.x, v.normal.y, v.normal.z, v.uv.x, v.uv.y);
+			auto it = vtxMap.find(key);
+			if (vtxMap.end() == it)
+			{
+				remap[i] = (int)m_pos.size();
+				vtxMap[key] = remap[i];
+				m_pos.push_back(v.pos);
+				m_normal.push_back(v.normal);
+				m_uv.push_back(v.uv);
+				++posCount[std::make_tuple(v.pos.x, v.pos.y, v.pos.z)];
+			}
+			else
+			{
+				remap[i] = it->second;
+			}
+		}
+
+		const int vtxCount = (int)m_pos.size();
+		m_isMoved.resize(vtxCount, false);
+		m_isLocked.resize(vtxCount, false);
+		for (int i = 0; i < vtxCount; ++i)
+			m_isLocked[i] = posCount[std::make_tuple(m_pos[i].x, m_pos[i].y, m_pos[i].z)] > 1;
+		m_quadrics.resize(vtxCount);
+		m_stamps.resize(vtxCount, 0);
+		m_isRemoved.resize(vtxCount, false);
+		m_vtxTris.resize(vtxCount);
+
+		// triangle, skip degenerate after weld
+		for (u_int i = 0; i + 2 < src.indices.size(); i += 3)
+		{
+			const int v0 = remap[src.indices[i]];
+			const int v1 = remap[src.indices[i + 1]];
+			const int v2 = remap[src.indices[i + 2]];
+			if ((v0 == v1) || (v1 == v2) || (v2 == v0))
+				continue;
+
+			const int t = (int)m_tris.size() / 3;
+			m_tris.push_back(v0);
+			m_tris.push_back(v1);
+			m_tris.push_back(v2);
+			m_vtxTris[v0].push_back(t);
+			m_vtxTris[v1].push_back(t);
+			m_vtxTris[v2].push_back(t);
+		}
+		m_aliveCount = (int)m_tris.size() / 3;
+		m_isAlive.resize(m_aliveCount, true);
+		RETV2(m_aliveCount == 0, false);
+
+		// plane quadric, area weighted
+		// edge use count, border edge = 1
+		std::map<std::pair<int, int>, int> edgeCount;
+		for (int t = 0; t < m_aliveCount; ++t)
+		{
+			const int *v = &m_tris[t * 3];
+			const Vector3 &p0 = m_pos[v[0]], &p1 = m_pos[v[1]], &p2 = m_pos[v[2]];
+			Vector3 n = (p1 - p0).CrossProduct(p2 - p0);
+			const float len = n.Length();
+			if (len > 0.f)
+			{
+				n = n * (1.f / len);
+				const double d = -n.DotProduct(p0);
+				for (int k = 0; k < 3; ++k)
+					m_quadrics[v[k]].AddPlane(n.x, n.y, n.z, d, len * 0.5);
+			}
+
+			for (int k = 0; k < 3; ++k)
+				++edgeCount[std::make_pair(min(v[k], v[(k + 1) % 3]), max(v[k], v[(k + 1) % 3]))];
+		}
+
+		// border constraint, plane perpendicular to border triangle
+		for (int t = 0; t < m_aliveCount; ++t)
+		{
+			const int *v = &m_tris[t * 3];
+			const Vector3 &p0 = m_pos[v[0]], &p1 = m_pos[v[1]], &p2 = m_pos[v[2]];
+			const Vector3 n = (p1 - p0).CrossProduct(p2 - p0).Normal();
+			for (int k = 0; k < 3; ++k)
+			{
+				const int a = v[k], b = v[(k + 1) % 3];
+				if (edgeCount[std::make_pair(min(a, b), max(a, b))] != 1)
+					continue;
+
+				const Vector3 edge = m_pos[b] - m_pos[a];
+				const Vector3 bn = edge.CrossProduct(n).Normal();
+				const double d = -bn.DotProduct(m_pos[a]);
+				const double weight = g_borderWeight * edge.Length() * edge.Length();
+				m_quadrics[a].AddPlane(bn.x, bn.y, bn.z, d, weight);
+				m_quadrics[b].AddPlane(bn.x, bn.y, bn.z, d, weight);
+			}
+		}
+
+		for (auto &it : edgeCount)
+			PushEdge(it.first.first, it.first.second);
+		return true;
+	}
+
+
+	// best of a, b, midpoint
+	// locked vertex: collapse other vertex into locked vertex position
+	void cSimplifier::PushEdge(const int v0, const int v1)
+	{
+		if (m_isLocked[v0] && m_isLocked[v1])
+			return;
+		const int a = m_isLocked[v0] ? v1 : v0; // removed
+		const int b = m_isLocked[v0] ? v0 : v1; // kept
+
+		sQuadric q = m_quadrics[a];
+		q.Add(m_quadrics[b]);
+
+		const Vector3 candidates[3] = { m_pos[b], m_pos[a], (m_pos[a] + m_pos[b]) * 0.5f };
+		const int candidateCount = m_isLocked[b] ? 1 : 3;
+		int best = 0;
+		double bestCost = q.Eval(candidates[0]);
+		for (int i = 1; i < candidateCount; ++i)
+		{
+			const double cost = q.Eval(candidates[i]);
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				best = i;
+			}
+		}
+
+		sCollapse c;
+		c.cost = bestCost;
+		c.a = a;
+		c.b = b;
+		c.stampA = m_stamps[a];
+		c.stampB = m_stamps[b];
+		c.candidate = best;
+		c.target = candidates[best];
+		m_heap.push(c);
+	}
+
+
+	// triangle t normal, vertex v moved to pos
+	Vector3 cSimplifier::GetNormal(const int t, const int v, const Vector3 &pos) const
+	{
+		Vector3 p[3];
+		for (int k = 0; k < 3; ++k)
+			p[k] = (m_tris[t * 3 + k] == v) ? pos : m_pos[m_tris[t * 3 + k]];
+		return (p[1] - p[0]).CrossProduct(p[2] - p[0]);
+	}
+
+
+	// triangle around a, b flip or degenerate after collapse?
+	bool cSimplifier::IsFlip(const int a, const int b, const Vector3 &target) const
+	{
+		const int verts[2] = { a, b };
+		for (int i = 0; i < 2; ++i)
+		{
+			const int v = verts[i];
+			for (auto t : m_vtxTris[v])
+			{
+				if (!m_isAlive[t])
+					continue;
+				const int *tv = &m_tris[t * 3];
+				const bool hasA = (tv[0] == a) || (tv[1] == a) || (tv[2] == a);
+				const bool hasB = (tv[0] == b) || (tv[1] == b) || (tv[2] == b);
+				if (hasA && hasB)
+					continue; // removed by collapse
+
+				const Vector3 n0 = GetNormal(t, -1, target);
+				const Vector3 n1 = GetNormal(t, v, target);
+				const float len1 = n1.Length();
+				if (len1 <= 0.f)
+					return true;
+				if (n0.DotProduct(n1) <= 0.f)
+					return true;
+			}
+		}
+		return false;
+	}
+
+
+	void cSimplifier::Collapse(const int targetTriCount)
+	{
+		while ((m_aliveCount > targetTriCount) && !m_heap.empty())
+		{
+			const sCollapse c = m_heap.top();
+			m_heap.pop();
+
+			const int a = c.a, b = c.b;
+			if (m_isRemoved[a] || m_isRemoved[b])
+				continue;
+			if ((m_stamps[a] != c.stampA) || (m_stamps[b] != c.stampB))
+				continue; // stale, newer entry pushed
+			if (IsFlip(a, b, c.target))
+				continue;
+
+			// target a: b take a attribute, midpoint: interpolate uv, normal recalculate
+			if (1 == c.candidate)
+			{
+				m_normal[b] = m_normal[a];
+				m_uv[b] = m_uv[a];
+				m_isMoved[b] = m_isMoved[a];
+			}
+			else if (2 == c.candidate)
+			{
+				m_uv[b] = Vector2((m_uv[a].x + m_uv[b].x) * 0.5f, (m_uv[a].y + m_uv[b].y) * 0.5f);
+				m_isMoved[b] = true;
+			}
+			m_pos[b] = c.target;
+			m_quadrics[b].Add(m_quadrics[a]);
+			m_isRemoved[a] = true;
+			++m_stamps[a];
+			++m_stamps[b];
+
+			for (auto t : m_vtxTris[a])
+			{
+				if (!m_isAlive[t])
+					continue;
+				int *tv = &m_tris[t * 3];
+				if ((tv[0] == b) || (tv[1] == b) || (tv[2] == b))
+				{
+					m_isAlive[t] = false;
+					--m_aliveCount;
+					continue;
+				}
+				for (int k = 0; k < 3; ++k)
+					if (tv[k] == a)
+						tv[k] = b;
+				m_vtxTris[b].push_back(t);
+			}
+			m_vtxTris[a].clear();
+
+			// compact b triangle list, push edge around b
+			std::vector<int> &tris = m_vtxTris[b];
+			tris.erase(std::remove_if(tris.begin(), tris.end()
+				, [&](const int t) { return !m_isAlive[t]; }), tris.end());
+
+			for (auto t : tris)
+			{
+				for (int k = 0; k < 3; ++k)
+				{
+					const int v = m_tris[t * 3 + k];
+					if (v != b)
+						PushEdge(min(v, b), max(v, b));
+				}
+			}
+		}
+	}
+
+
+	// compact vertex, unmoved vertex source normal
+	// moved vertex smooth normal from simplified triangle
+	void cSimplifier::Output(OUT sMeshData &out) const
+	{
+		out.vertices.clear();
+		out.indices.clear();
+
+		std::vector<int> remap(m_pos.size(), -1);
+		std::vector<bool> isMoved; // out vertex
+		for (u_int t = 0; t < m_isAlive.size(); ++t)
+		{
+			if (!m_isAlive[t])
+				continue;
+			for (int k = 0; k < 3; ++k)
+			{
+				const int v = m_tris[t * 3 + k];
+				if (remap[v] < 0)
+				{
+					remap[v] = (int)out.vertices.size();
+					sMeshVertex vtx;
+					vtx.pos = m_pos[v];
+					vtx.normal = m_isMoved[v] ? Vector3(0, 0, 0) : m_normal[v];
+					vtx.uv = m_uv[v];
+					out.vertices.push_back(vtx);
+					isMoved.push_back(m_isMoved[v]);
+				}
+				out.indices.push_back((UINT)remap[v]);
+			}
+		}
+
+		for (u_int i = 0; i + 2 < out.indices.size(); i += 3)
+		{
+			const UINT *idx = &out.indices[i];
+			const Vector3 n = (out.vertices[idx[1]].pos - out.vertices[idx[0]].pos).CrossProduct(
+				out.vertices[idx[2]].pos - out.vertices[idx[0]].pos); // area weighted
+			for (int k = 0; k < 3; ++k)
+				if (isMoved[idx[k]])
+					out.vertices[idx[k]].normal = out.vertices[idx[k]].normal + n;
+		}
+		for (u_int i = 0; i < out.vertices.size(); ++i)
+			if (isMoved[i])
+				out.vertices[i].normal.Normalize();
+	}
+}
+
+
+bool cMeshSimplifier::Simplify(const sMeshData &src, const float *ratios, const int count
+	, OUT std::vector<sMeshData> &out)
+{
+	cSimplifier simplifier;
+	RETV2(!simplifier.Init(src), false);
+
+	const int srcTriCount = (int)src.indices.size() / 3;
+	for (int i = 0; i < count; ++i)
+	{
+		simplifier.Collapse(max(1, (int)(srcTriCount * ratios[i])));
+		out.push_back({});
+		simplifier.Output(out.back());
+	}
+	return true;
+}
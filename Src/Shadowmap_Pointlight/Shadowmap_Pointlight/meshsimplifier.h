@@ -0,0 +1,29 @@
+//
+// 2018-05-18, jjuiddong
+// Mesh Simplifier
+//	- quadric error metric edge collapse (Garland, Heckbert)
+//	- vertex weld by position + normal + uv, border edge constraint plane
+//	- attribute seam vertex (same position, other normal, uv) locked,
+//	  no crack, no uv stretch across seam
+//	- reject collapse that flip triangle normal
+//	- LOD vertex: uv follow collapse target, unmoved vertex keep source normal,
+//	  moved vertex recalculated smooth normal
+//
+#pragma once
+
+#include "meshimporter.h"
+
+
+namespace graphic
+{
+
+	class cMeshSimplifier
+	{
+	public:
+		// ratios: triangle count ratio of source, descending order
+		// simplified mesh append to out
+		static bool Simplify(const sMeshData &src, const float *ratios, const int count
+			, OUT std::vector<sMeshData> &out);
+	};
+
+}
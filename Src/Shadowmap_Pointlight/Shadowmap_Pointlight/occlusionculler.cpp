@@ -0,0 +1,357 @@
+
+#include "../../Shared/platform.h"
+#include "occlusionculler.h"
+#include "../../Shared/steadytimer.h"
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+using namespace graphic;
+
+
+namespace
+{
+	// (x,y,z,1) * m -> clip space, m: float[16] row major
+	inline void TransformClip(const float *m, const float x, const float y, const float z
+		, OUT float *out)
+	{
+		for (int i = 0; i < 4; ++i)
+			out[i] = x * m[i] + y * m[4 + i] + z * m[8 + i] + m[12 + i];
+	}
+
+	// out = a * b, float[16] row major
+	inline void Multiply(const float *a, const float *b, OUT float *out)
+	{
+		for (int r = 0; r < 4; ++r)
+			for (int c = 0; c < 4; ++c)
+				out[r * 4 + c] = a[r * 4] * b[c] + a[r * 4 + 1] * b[4 + c]
+					+ a[r * 4 + 2] * b[8 + c] + a[r * 4 + 3] * b[12 + c];
+	}
+
+	// box face, corner index bit (x:1, y:2, z:4)
+	const int g_boxIndices[36] = {
+		0, 2, 6, 0, 6, 4, // -x
+		1, 5, 7, 1, 7, 3, // +x
+		0, 4, 5, 0, 5, 1, // -y
+		2, 3, 7, 2, 7, 6, // +y
+		0, 1, 3, 0, 3, 2, // -z
+		4, 6, 7, 4, 7, 5, // +z
+	};
+
+	const float g_minW = 0.0001f;
+}
+
+
+cOcclusionCuller::cOcclusionCuller()
+	: m_maxTriangle(0)
+	, m_triangleCount(0)
+	, m_skipTriangleCount(0)
+	, m_occludedCount(0)
+	, m_rasterMs(0)
+{
+	ZeroMemory(m_viewProj, sizeof(m_viewProj));
+}
+
+cOcclusionCuller::~cOcclusionCuller()
+{
+	Clear();
+}
+
+
+bool cOcclusionCuller::Create(
+	const int maxTriangle //= 4096
+)
+{
+	Clear();
+
+	m_depth.resize(WIDTH * HEIGHT, 1.f);
+	m_hiz.resize((WIDTH / TILE) * (HEIGHT / TILE), 1.f);
+	m_verts.reserve(maxTriangle * 3);
+	m_maxTriangle = maxTriangle;
+	return true;
+}
+
+
+// clear occluder triangle
+// viewProj: float[16]
+void cOcclusionCuller::Begin(const float *viewProj)
+{
+	memcpy(m_viewProj, viewProj, sizeof(m_viewProj));
+	m_verts.clear();
+	m_triangleCount = 0;
+	m_skipTriangleCount = 0;
+}
+
+
+// world: float[16], center, halfSize: float[3] in world local space
+// must be inside of object geometry, otherwise over occlusion
+void cOcclusionCuller::AddBox(const float *world, const float *center
+	, const float *halfSize)
+{
+	if (m_triangleCount + 12 > m_maxTriangle)
+	{
+		m_skipTriangleCount += 12;
+		return;
+	}
+
+	float wvp[16];
+	Multiply(world, m_viewProj, wvp);
+
+	sVertex screen[8];
+	bool isFront[8];
+	for (int i = 0; i < 8; ++i)
+	{
+		float clip[4];
+		TransformClip(wvp
+			, center[0] + ((i & 1) ? halfSize[0] : -halfSize[0])
+			, center[1] + ((i & 2) ? halfSize[1] : -halfSize[1])
+			, center[2] + ((i & 4) ? halfSize[2] : -halfSize[2])
+			, clip);
+
+		// behind near plane
+		isFront[i] = (clip[3] > g_minW) && (clip[2] >= 0.f);
+		if (!isFront[i])
+			continue;
+
+		const float rcpW = 1.f / clip[3];
+		screen[i].x = (clip[0] * rcpW * 0.5f + 0.5f) * (float)WIDTH;
+		screen[i].y = (0.5f - clip[1] * rcpW * 0.5f) * (float)HEIGHT;
+		screen[i].z = clip[2] * rcpW;
+	}
+
+	for (int i = 0; i < 36; i += 3)
+	{
+		const int a = g_boxIndices[i], b = g_boxIndices[i + 1], c = g_boxIndices[i + 2];
+		if (!isFront[a] || !isFront[b] || !isFront[c])
+		{
+			++m_skipTriangleCount;
+			continue;
+		}
+
+		m_verts.push_back(screen[a]);
+		m_verts.push_back(screen[b]);
+		m_verts.push_back(screen[c]);
+		++m_triangleCount;
+	}
+}
+
+
+// rasterize occluder, band per worker thread
+void cOcclusionCuller::Rasterize(cJobSystem &jobs)
+{
+	const double t0 = GetSteadyTimeMs();
+	jobs.ParallelFor(HEIGHT, BAND, [this](const int begin, const int end, const int) {
+		RasterizeBand(begin, end);
+	});
+	m_rasterMs = GetSteadyTimeMs() - t0;
+}
+
+
+// single thread
+void cOcclusionCuller::Rasterize()
+{
+	const double t0 = GetSteadyTimeMs();
+	RasterizeBand(0, HEIGHT);
+	m_rasterMs = GetSteadyTimeMs() - t0;
+}
+
+
+// clear, rasterize all triangle, build hierarchical depth, row [y0, y1)
+// y0, y1: multiple of TILE
+void cOcclusionCuller::RasterizeBand(const int y0, const int y1)
+{
+	std::fill(m_depth.begin() + y0 * WIDTH, m_depth.begin() + y1 * WIDTH, 1.f);
+
+	for (int i = 0; i < m_triangleCount; ++i)
+		RasterizeTriangle(&m_verts[i * 3], y0, y1);
+
+	const int tileW = WIDTH / TILE;
+	for (int ty = y0 / TILE; ty < y1 / TILE; ++ty)
+	{
+		for (int tx = 0; tx < tileW; ++tx)
+		{
+			float farthest = 0.f;
+			for (int y = ty * TILE; y < (ty + 1) * TILE; ++y)
+			{
+				const float *row = &m_depth[y * WIDTH + tx * TILE];
+				for (int x = 0; x < TILE; ++x)
+					farthest = std::max(farthest, row[x]);
+			}
+			m_hiz[ty * tileW + tx] = farthest;
+		}
+	}
+}
+
+
+// edge function, pixel center sample, depth min
+void cOcclusionCuller::RasterizeTriangle(const sVertex *v, const int y0, const int y1)
+{
+	const float minX = std::min(v[0].x, std::min(v[1].x, v[2].x));
+	const float maxX = std::max(v[0].x, std::max(v[1].x, v[2].x));
+	const float minY = std::min(v[0].y, std::min(v[1].y, v[2].y));
+	const float maxY = std::max(v[0].y, std::max(v[1].y, v[2].y));
+
+	const int x0 = (int)std::max(0.f, minX) & ~3; // 4 pixel align
+	const int x1 = (int)std::min((float)(WIDTH - 1), maxX);
+	const int ry0 = std::max(y0, (int)std::max(0.f, minY));
+	const int ry1 = std::min(y1 - 1, (int)std::min((float)(HEIGHT - 1), maxY));
+	if ((x0 > x1) || (ry0 > ry1))
+		return;
+
+	// e_i = A_i * x + B_i * y + C_i, edge opposite vertex i
+	float A[3], B[3], C[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		const sVertex &p1 = v[(i + 1) % 3];
+		const sVertex &p2 = v[(i + 2) % 3];
+		A[i] = p1.y - p2.y;
+		B[i] = p2.x - p1.x;
+		C[i] = p1.x * p2.y - p2.x * p1.y;
+	}
+
+	float area = A[0] * v[0].x + B[0] * v[0].y + C[0];
+	if (std::abs(area) < 0.0001f)
+		return;
+	if (area < 0.f)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			A[i] = -A[i];
+			B[i] = -B[i];
+			C[i] = -C[i];
+		}
+		area = -area;
+	}
+
+	// depth plane, z = Az * x + Bz * y + Cz
+	const float rcpArea = 1.f / area;
+	const float Az = (v[0].z * A[0] + v[1].z * A[1] + v[2].z * A[2]) * rcpArea;
+	const float Bz = (v[0].z * B[0] + v[1].z * B[1] + v[2].z * B[2]) * rcpArea;
+	const float Cz = (v[0].z * C[0] + v[1].z * C[1] + v[2].z * C[2]) * rcpArea;
+
+	for (int y = ry0; y <= ry1; ++y)
+	{
+		const float py = (float)y + 0.5f;
+		float *row = &m_depth[y * WIDTH];
+
+#ifdef SIMD_MATH_SSE
+		const __m128 offset = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		const __m128 zero = _mm_setzero_ps();
+		for (int x = x0; x <= x1; x += 4)
+		{
+			const __m128 px = _mm_add_ps(_mm_set1_ps((float)x), offset);
+			__m128 mask = zero;
+			for (int i = 0; i < 3; ++i)
+			{
+				const __m128 e = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(A[i]))
+					, _mm_set1_ps(B[i] * py + C[i]));
+				const __m128 in = _mm_cmpge_ps(e, zero);
+				mask = (i == 0) ? in : _mm_and_ps(mask, in);
+			}
+
+			const __m128 z = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(Az))
+				, _mm_set1_ps(Bz * py + Cz));
+			const __m128 d = _mm_loadu_ps(row + x);
+			const __m128 nd = _mm_min_ps(d, z);
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(mask, nd), _mm_andnot_ps(mask, d)));
+		}
+#else
+		for (int x = x0; x <= x1; ++x)
+		{
+			const float px = (float)x + 0.5f;
+			if ((A[0] * px + B[0] * py + C[0] < 0.f)
+				|| (A[1] * px + B[1] * py + C[1] < 0.f)
+				|| (A[2] * px + B[2] * py + C[2] < 0.f))
+				continue;
+			row[x] = std::min(row[x], Az * px + Bz * py + Cz);
+		}
+#endif
+	}
+}
+
+
+// sphere -> world AABB -> screen rect, nearest depth
+// visible if any pixel in rect farther than nearest depth
+bool cOcclusionCuller::IsVisible(const float x, const float y, const float z
+	, const float radius) const
+{
+	float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+	float maxX = -FLT_MAX, maxY = -FLT_MAX;
+	for (int i = 0; i < 8; ++i)
+	{
+		float clip[4];
+		TransformClip(m_viewProj
+			, x + ((i & 1) ? radius : -radius)
+			, y + ((i & 2) ? radius : -radius)
+			, z + ((i & 4) ? radius : -radius)
+			, clip);
+		if ((clip[3] <= g_minW) || (clip[2] < 0.f))
+			return true; // cross near plane
+
+		const float rcpW = 1.f / clip[3];
+		const float sx = (clip[0] * rcpW * 0.5f + 0.5f) * (float)WIDTH;
+		const float sy = (0.5f - clip[1] * rcpW * 0.5f) * (float)HEIGHT;
+		minX = std::min(minX, sx);
+		maxX = std::max(maxX, sx);
+		minY = std::min(minY, sy);
+		maxY = std::max(maxY, sy);
+		minZ = std::min(minZ, clip[2] * rcpW);
+	}
+
+	if ((maxX < 0.f) || (maxY < 0.f) || (minX >= (float)WIDTH) || (minY >= (float)HEIGHT))
+		return true; // out of screen, frustum culling decide
+
+	const int x0 = (int)std::max(0.f, minX);
+	const int x1 = (int)std::min((float)(WIDTH - 1), maxX);
+	const int y0 = (int)std::max(0.f, minY);
+	const int y1 = (int)std::min((float)(HEIGHT - 1), maxY);
+	if ((x0 > x1) || (y0 > y1))
+		return true; // out of screen, frustum culling decide
+
+	const int tileW = WIDTH / TILE;
+	for (int ty = y0 / TILE; ty <= y1 / TILE; ++ty)
+	{
+		for (int tx = x0 / TILE; tx <= x1 / TILE; ++tx)
+		{
+			if (minZ > m_hiz[ty * tileW + tx])
+				continue; // tile occluded
+
+			const int px0 = std::max(x0, tx * TILE), px1 = std::min(x1, tx * TILE + TILE - 1);
+			const int py0 = std::max(y0, ty * TILE), py1 = std::min(y1, ty * TILE + TILE - 1);
+			for (int py = py0; py <= py1; ++py)
+				for (int px = px0; px <= px1; ++px)
+					if (minZ <= m_depth[py * WIDTH + px])
+						return true;
+		}
+	}
+	return false;
+}
+
+
+// indices: test object index, visible can be same array with indices
+// return visible count
+int cOcclusionCuller::Cull(const float *x, const float *y, const float *z, const float *r
+	, const int *indices, const int count, OUT int *visible)
+{
+	int n = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		const int idx = indices[i];
+		if (IsVisible(x[idx], y[idx], z[idx], r[idx]))
+			visible[n++] = idx;
+	}
+	m_occludedCount = count - n;
+	return n;
+}
+
+
+void cOcclusionCuller::Clear()
+{
+	m_depth.clear();
+	m_hiz.clear();
+	m_verts.clear();
+	m_maxTriangle = 0;
+	m_triangleCount = 0;
+	m_skipTriangleCount = 0;
+	m_occludedCount = 0;
+}
@@ -0,0 +1,67 @@
+//
+// 2018-05-16, jjuiddong
+// Software Occlusion Culler
+//	- CPU depth rasterizer, 256 x 128 depth buffer
+//	- occluder: low poly box, inside of real geometry (conservative)
+//	- rasterize by horizontal band, band per worker thread
+//	- hierarchical depth, 8x8 tile farthest depth, fine test only if tile pass
+//	- occludee: bounding sphere -> AABB -> screen rect, nearest depth
+//	- triangle cross near plane skip (occluder) or visible (occludee)
+//	- no Common dependency (Shared/platform.h), matrix = float[16] row major
+//
+#pragma once
+
+#include "simdcpu.h"
+#include "jobsystem.h"
+
+
+namespace graphic
+{
+
+	class cOcclusionCuller
+	{
+	public:
+		enum {
+			WIDTH = 256
+			, HEIGHT = 128
+			, TILE = 8 // hierarchical depth tile size
+			, BAND = 16 // rasterize band height, job chunk
+		};
+
+		struct sVertex
+		{
+			float x, y, z; // screen x, y, z/w
+		};
+
+		cOcclusionCuller();
+		virtual ~cOcclusionCuller();
+
+		bool Create(const int maxTriangle = 4096);
+		void Begin(const float *viewProj);
+		void AddBox(const float *world, const float *center, const float *halfSize);
+		void Rasterize(cJobSystem &jobs);
+		void Rasterize();
+		bool IsVisible(const float x, const float y, const float z, const float radius) const;
+		int Cull(const float *x, const float *y, const float *z, const float *r
+			, const int *indices, const int count, OUT int *visible);
+		void Clear();
+
+
+	protected:
+		void RasterizeBand(const int y0, const int y1);
+		void RasterizeTriangle(const sVertex *v, const int y0, const int y1);
+
+
+	public:
+		float m_viewProj[16];
+		std::vector<float> m_depth; // WIDTH x HEIGHT, z/w, 1 = far
+		std::vector<float> m_hiz; // tile farthest depth
+		std::vector<sVertex> m_verts; // screen space triangle
+		int m_maxTriangle;
+		int m_triangleCount;
+		int m_skipTriangleCount; // near plane, triangle buffer full
+		int m_occludedCount; // last Cull()
+		double m_rasterMs; // last Rasterize()
+	};
+
+}
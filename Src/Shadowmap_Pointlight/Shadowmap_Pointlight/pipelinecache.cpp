@@ -0,0 +1,304 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "pipelinecache.h"
+#include "shadercache.h"
+#include "jobsystem.h"
+#include "../../Shared/steadytimer.h"
+
+using namespace graphic;
+
+
+namespace
+{
+	// FNV-1a 64, seed: state type
+	unsigned __int64 Hash(const BYTE *data, const UINT size, const int seed)
+	{
+		unsigned __int64 h = 14695981039346656037ull ^ (unsigned __int64)seed;
+		for (UINT i = 0; i < size; ++i)
+		{
+			h ^= data[i];
+			h *= 1099511628211ull;
+		}
+		return h;
+	}
+}
+
+
+cPipelineCache::cPipelineCache()
+	: m_device(NULL)
+	, m_shaderCache(NULL)
+	, m_current(INVALID)
+	, m_isShaderBound(false)
+	, m_lookupCount(0)
+	, m_hitCount(0)
+	, m_bindCount(0)
+	, m_skipCount(0)
+	, m_buildMs(0)
+{
+}
+
+cPipelineCache::~cPipelineCache()
+{
+	Clear();
+}
+
+
+// shaderCache: sPipelineDesc::shaderKey variant, NULL: no shader bind
+bool cPipelineCache::Create(cRenderer &renderer, cShaderCache *shaderCache)
+{
+	Clear();
+	m_device = renderer.GetDevice();
+	m_shaderCache = shaderCache;
+	return true;
+}
+
+
+// return pipeline handle, same description -> same handle
+// state object not created until Build()
+int cPipelineCache::Add(const sPipelineDesc &desc)
+{
+	// copy to zero initialized descriptor, padding byte not hashed garbage
+	sRasterizer rs;
+	ZeroMemory(&rs, sizeof(rs));
+	rs.desc = desc.rasterizer;
+
+	sDepthStencil ds;
+	ZeroMemory(&ds, sizeof(ds));
+	ds.desc.DepthEnable = desc.depthStencil.DepthEnable;
+	ds.desc.DepthWriteMask = desc.depthStencil.DepthWriteMask;
+	ds.desc.DepthFunc = desc.depthStencil.DepthFunc;
+	ds.desc.StencilEnable = desc.depthStencil.StencilEnable;
+	ds.desc.StencilReadMask = desc.depthStencil.StencilReadMask;
+	ds.desc.StencilWriteMask = desc.depthStencil.StencilWriteMask;
+	ds.desc.FrontFace = desc.depthStencil.FrontFace;
+	ds.desc.BackFace = desc.depthStencil.BackFace;
+
+	sBlend bs;
+	ZeroMemory(&bs, sizeof(bs));
+	bs.desc.AlphaToCoverageEnable = desc.blend.AlphaToCoverageEnable;
+	bs.desc.IndependentBlendEnable = desc.blend.IndependentBlendEnable;
+	const int rtCount = desc.blend.IndependentBlendEnable ? D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT : 1;
+	for (int i = 0; i < rtCount; ++i)
+	{
+		const D3D11_RENDER_TARGET_BLEND_DESC &src = desc.blend.RenderTarget[i];
+		D3D11_RENDER_TARGET_BLEND_DESC &dst = bs.desc.RenderTarget[i];
+		dst.BlendEnable = src.BlendEnable;
+		dst.SrcBlend = src.SrcBlend;
+		dst.DestBlend = src.DestBlend;
+		dst.BlendOp = src.BlendOp;
+		dst.SrcBlendAlpha = src.SrcBlendAlpha;
+		dst.DestBlendAlpha = src.DestBlendAlpha;
+		dst.BlendOpAlpha = src.BlendOpAlpha;
+		dst.RenderTargetWriteMask = src.RenderTargetWriteMask;
+	}
+
+	sPipeline pso;
+	pso.shaderKey = desc.shaderKey;
+	pso.inputLayout = desc.inputLayout;
+	pso.topology = desc.topology;
+	pso.rasterizer = AddState(m_rasterizers, rs, 0);
+	pso.depthStencil = AddState(m_depthStencils, ds, 1);
+	pso.blend = AddState(m_blends, bs, 2);
+	pso.stencilRef = desc.stencilRef;
+
+	for (u_int i = 0; i < m_pipelines.size(); ++i)
+	{
+		const sPipeline &p = m_pipelines[i];
+		if ((p.shaderKey == pso.shaderKey)
+			&& (p.inputLayout == pso.inputLayout)
+			&& (p.topology == pso.topology)
+			&& (p.rasterizer == pso.rasterizer)
+			&& (p.depthStencil == pso.depthStencil)
+			&& (p.blend == pso.blend)
+			&& (p.stencilRef == pso.stencilRef))
+			return (int)i;
+	}
+
+	m_pipelines.push_back(pso);
+	return (int)m_pipelines.size() - 1;
+}
+
+
+// create not created state, all pipeline, load shader variant
+// ID3D11Device free threaded, one state per job
+bool cPipelineCache::Build(cJobSystem &jobs)
+{
+	RETV2(!m_device, false);
+
+	const double t0 = GetSteadyTimeMs();
+
+	// shader variant load, cShaderCache not thread safe
+	for (auto &pso : m_pipelines)
+		if ((NO_SHADER != pso.shaderKey) && m_shaderCache)
+			m_shaderCache->Get(pso.shaderKey);
+
+	const int count = (int)(m_rasterizers.size() + m_depthStencils.size() + m_blends.size());
+	std::atomic<int> failCount(0);
+	jobs.ParallelFor(count, 1, [&](const int begin, const int end, const int) {
+		for (int i = begin; i < end; ++i)
+			if (!CreateState(i))
+				++failCount;
+	});
+	m_buildMs = GetSteadyTimeMs() - t0;
+	return 0 == failCount;
+}
+
+
+// bind pipeline state, skip if same handle already bound
+// return true if shader variant bound (NO_SHADER, not compiled variant: false)
+bool cPipelineCache::Bind(cRenderer &renderer, const int handle)
+{
+	++m_bindCount;
+	if (handle == m_current)
+	{
+		++m_skipCount;
+		return m_isShaderBound;
+	}
+	RETV2((handle < 0) || (handle >= (int)m_pipelines.size()), false);
+
+	ID3D11DeviceContext *devContext = renderer.GetDevContext();
+	const sPipeline &pso = m_pipelines[handle];
+	m_isShaderBound = (NO_SHADER != pso.shaderKey) && m_shaderCache
+		&& m_shaderCache->Apply(renderer, pso.shaderKey);
+	if (D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED != pso.topology)
+	{
+		devContext->IASetInputLayout(pso.inputLayout);
+		devContext->IASetPrimitiveTopology(pso.topology);
+	}
+	devContext->RSSetState(m_rasterizers[pso.rasterizer].state);
+	devContext->OMSetDepthStencilState(m_depthStencils[pso.depthStencil].state, pso.stencilRef);
+	devContext->OMSetBlendState(m_blends[pso.blend].state, NULL, 0xffffffff);
+	m_current = handle;
+	return m_isShaderBound;
+}
+
+
+// state changed outside cache, next Bind() never skip
+void cPipelineCache::Invalidate()
+{
+	m_current = INVALID;
+	m_isShaderBound = false;
+}
+
+
+// Add() state descriptor dedup ratio, 0 ~ 1
+float cPipelineCache::GetHitRate() const
+{
+	return (m_lookupCount > 0) ? ((float)m_hitCount / (float)m_lookupCount) : 0.f;
+}
+
+
+// return state index, same descriptor -> same index
+// hash collision, next hash slot
+template<class T>
+int cPipelineCache::AddState(std::vector<T> &states, const T &state, const int type)
+{
+	++m_lookupCount;
+	unsigned __int64 h = Hash((const BYTE*)&state.desc, sizeof(state.desc), type);
+	auto it = m_stateMap.find(h);
+	while (m_stateMap.end() != it)
+	{
+		const int idx = it->second;
+		if ((idx < (int)states.size())
+			&& !memcmp(&states[idx].desc, &state.desc, sizeof(state.desc)))
+		{
+			++m_hitCount;
+			return idx;
+		}
+		it = m_stateMap.find(++h);
+	}
+
+	states.push_back(state);
+	memcpy(&states.back().desc, &state.desc, sizeof(state.desc)); // padding byte
+	m_stateMap[h] = (int)states.size() - 1;
+	return (int)states.size() - 1;
+}
+
+
+// idx: m_rasterizers, m_depthStencils, m_blends continuous index
+bool cPipelineCache::CreateState(const int idx)
+{
+	const int rsCount = (int)m_rasterizers.size();
+	const int dsCount = (int)m_depthStencils.size();
+	if (idx < rsCount)
+	{
+		sRasterizer &rs = m_rasterizers[idx];
+		return rs.state || SUCCEEDED(m_device->CreateRasterizerState(&rs.desc, &rs.state));
+	}
+	if (idx < rsCount + dsCount)
+	{
+		sDepthStencil &ds = m_depthStencils[idx - rsCount];
+		return ds.state || SUCCEEDED(m_device->CreateDepthStencilState(&ds.desc, &ds.state));
+	}
+	sBlend &bs = m_blends[idx - rsCount - dsCount];
+	return bs.state || SUCCEEDED(m_device->CreateBlendState(&bs.desc, &bs.state));
+}
+
+
+void cPipelineCache::Clear()
+{
+	for (auto &rs : m_rasterizers)
+		SAFE_RELEASE(rs.state);
+	for (auto &ds : m_depthStencils)
+		SAFE_RELEASE(ds.state);
+	for (auto &bs : m_blends)
+		SAFE_RELEASE(bs.state);
+	m_rasterizers.clear();
+	m_depthStencils.clear();
+	m_blends.clear();
+	m_pipelines.clear();
+	m_stateMap.clear();
+	m_current = INVALID;
+	m_isShaderBound = false;
+	m_lookupCount = 0;
+	m_hitCount = 0;
+	m_bindCount = 0;
+	m_skipCount = 0;
+	m_buildMs = 0;
+}
+
+
+// D3D11 default state, no shader, input assembler from draw call
+void cPipelineCache::GetDefault(OUT sPipelineDesc &desc)
+{
+	ZeroMemory(&desc, sizeof(desc));
+	desc.shaderKey = NO_SHADER;
+	desc.inputLayout = NULL;
+	desc.topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+	desc.rasterizer.FillMode = D3D11_FILL_SOLID;
+	desc.rasterizer.CullMode = D3D11_CULL_BACK;
+	desc.rasterizer.FrontCounterClockwise = FALSE;
+	desc.rasterizer.DepthBias = D3D11_DEFAULT_DEPTH_BIAS;
+	desc.rasterizer.DepthBiasClamp = D3D11_DEFAULT_DEPTH_BIAS_CLAMP;
+	desc.rasterizer.SlopeScaledDepthBias = D3D11_DEFAULT_SLOPE_SCALED_DEPTH_BIAS;
+	desc.rasterizer.DepthClipEnable = TRUE;
+
+	const D3D11_DEPTH_STENCILOP_DESC defaultStencilOp = { D3D11_STENCIL_OP_KEEP
+		, D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_COMPARISON_ALWAYS };
+	desc.depthStencil.DepthEnable = TRUE;
+	desc.depthStencil.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+	desc.depthStencil.DepthFunc = D3D11_COMPARISON_LESS;
+	desc.depthStencil.StencilEnable = FALSE;
+	desc.depthStencil.StencilReadMask = D3D11_DEFAULT_STENCIL_READ_MASK;
+	desc.depthStencil.StencilWriteMask = D3D11_DEFAULT_STENCIL_WRITE_MASK;
+	desc.depthStencil.FrontFace = defaultStencilOp;
+	desc.depthStencil.BackFace = defaultStencilOp;
+
+	for (UINT i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
+	{
+		D3D11_RENDER_TARGET_BLEND_DESC &rt = desc.blend.RenderTarget[i];
+		rt.BlendEnable = FALSE;
+		rt.SrcBlend = D3D11_BLEND_ONE;
+		rt.DestBlend = D3D11_BLEND_ZERO;
+		rt.BlendOp = D3D11_BLEND_OP_ADD;
+		rt.SrcBlendAlpha = D3D11_BLEND_ONE;
+		rt.DestBlendAlpha = D3D11_BLEND_ZERO;
+		rt.BlendOpAlpha = D3D11_BLEND_OP_ADD;
+		rt.RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+	}
+	desc.stencilRef = 0;
+}
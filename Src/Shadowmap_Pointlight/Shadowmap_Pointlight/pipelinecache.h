@@ -0,0 +1,103 @@
+//
+// 2018-05-24, jjuiddong
+// Pipeline State Cache
+//	- pipeline = shader variant + input layout, topology + rasterizer, depth stencil, blend state
+//	- state descriptor hash, same descriptor -> one state object (dedup)
+//	- Add() : describe pipeline, return handle, Build() : create all state (cJobSystem)
+//	- Bind() : whole pipeline by handle, one redundant check (same handle skip)
+//	- Invalidate() : after state change outside cache (cShader11, cGBuffer, ImGui)
+//
+#pragma once
+
+#include <map>
+
+
+namespace graphic
+{
+	class cShaderCache;
+	class cJobSystem;
+
+	class cPipelineCache
+	{
+	public:
+		enum { INVALID = -1 };
+		static const unsigned __int64 NO_SHADER = ~0ull; // shader bind by caller
+
+		struct sPipelineDesc
+		{
+			unsigned __int64 shaderKey; // cShaderCache key, NO_SHADER
+			ID3D11InputLayout *inputLayout;
+			D3D11_PRIMITIVE_TOPOLOGY topology; // UNDEFINED: input assembler from draw call
+			D3D11_RASTERIZER_DESC rasterizer;
+			D3D11_DEPTH_STENCIL_DESC depthStencil;
+			D3D11_BLEND_DESC blend;
+			UINT stencilRef;
+		};
+
+		cPipelineCache();
+		virtual ~cPipelineCache();
+
+		bool Create(cRenderer &renderer, cShaderCache *shaderCache);
+		int Add(const sPipelineDesc &desc);
+		bool Build(cJobSystem &jobs);
+		bool Bind(cRenderer &renderer, const int handle);
+		void Invalidate();
+		float GetHitRate() const;
+		void Clear();
+
+		static void GetDefault(OUT sPipelineDesc &desc);
+
+
+	protected:
+		template<class T> int AddState(std::vector<T> &states, const T &state, const int type);
+		bool CreateState(const int idx);
+
+
+	public:
+		struct sRasterizer
+		{
+			D3D11_RASTERIZER_DESC desc;
+			ID3D11RasterizerState *state;
+		};
+
+		struct sDepthStencil
+		{
+			D3D11_DEPTH_STENCIL_DESC desc; // padding zero
+			ID3D11DepthStencilState *state;
+		};
+
+		struct sBlend
+		{
+			D3D11_BLEND_DESC desc; // padding zero, RenderTarget[1~7] zero if !IndependentBlendEnable
+			ID3D11BlendState *state;
+		};
+
+		struct sPipeline
+		{
+			unsigned __int64 shaderKey;
+			ID3D11InputLayout *inputLayout;
+			D3D11_PRIMITIVE_TOPOLOGY topology;
+			int rasterizer; // m_rasterizers index
+			int depthStencil; // m_depthStencils index
+			int blend; // m_blends index
+			UINT stencilRef;
+		};
+
+		ID3D11Device *m_device;
+		cShaderCache *m_shaderCache;
+		std::vector<sRasterizer> m_rasterizers;
+		std::vector<sDepthStencil> m_depthStencils;
+		std::vector<sBlend> m_blends;
+		std::vector<sPipeline> m_pipelines; // handle = index
+		std::map<unsigned __int64, int> m_stateMap; // descriptor hash -> state index
+		int m_current; // bound pipeline handle
+		bool m_isShaderBound; // m_current shader variant bind
+
+		int m_lookupCount; // Add() state descriptor count (3 per pipeline)
+		int m_hitCount; // same descriptor found
+		int m_bindCount;
+		int m_skipCount; // redundant Bind()
+		double m_buildMs;
+	};
+
+}
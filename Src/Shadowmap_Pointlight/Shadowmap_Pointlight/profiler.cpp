@@ -0,0 +1,271 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "profiler.h"
+
+using namespace graphic;
+
+
+namespace
+{
+	inline __int64 GetCounter() {
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+		return counter.QuadPart;
+	}
+}
+
+
+cProfiler::cProfiler()
+	: m_frameIdx(0)
+	, m_depth(0)
+	, m_isBeginFrame(false)
+	, m_frameScopeId(-1)
+	, m_frequency(1)
+	, m_startCounter(0)
+	, m_readBackCount(0)
+	, m_historyHead(0)
+	, m_historyCount(0)
+{
+	ZeroMemory(m_frames, sizeof(m_frames));
+}
+
+cProfiler::~cProfiler()
+{
+	Clear();
+}
+
+
+bool cProfiler::Create(cRenderer &renderer)
+{
+	Clear();
+
+	LARGE_INTEGER freq;
+	QueryPerformanceFrequency(&freq);
+	m_frequency = freq.QuadPart;
+	m_startCounter = GetCounter();
+
+	ID3D11Device *device = renderer.GetDevice();
+	D3D11_QUERY_DESC disjointDesc = { D3D11_QUERY_TIMESTAMP_DISJOINT, 0 };
+	D3D11_QUERY_DESC timestampDesc = { D3D11_QUERY_TIMESTAMP, 0 };
+
+	for (auto &frame : m_frames)
+	{
+		RETV2(FAILED(device->CreateQuery(&disjointDesc, &frame.disjoint)), false);
+		for (auto &query : frame.timestamps)
+			RETV2(FAILED(device->CreateQuery(&timestampDesc, &query)), false);
+	}
+
+	// allocate once, no allocation at read back
+	m_results.reserve(MAX_SCOPE);
+	m_tempResults.reserve(MAX_SCOPE);
+	m_history.resize(MAX_HISTORY * MAX_SCOPE * 2);
+	m_historySize.resize(MAX_HISTORY, 0);
+	return true;
+}
+
+
+// read back query result of 3 frame before, and begin frame scope
+void cProfiler::BeginFrame(cRenderer &renderer)
+{
+	sFrame &frame = m_frames[m_frameIdx % FRAME_LATENCY];
+	if (!frame.disjoint)
+		return;
+
+	if (frame.isPending)
+		ReadBack(renderer, frame);
+
+	frame.scopeCount = 0;
+	m_depth = 0;
+	m_isBeginFrame = true;
+	renderer.GetDevContext()->Begin(frame.disjoint);
+	m_frameScopeId = Begin(renderer, "Frame");
+}
+
+
+void cProfiler::EndFrame(cRenderer &renderer)
+{
+	if (!m_isBeginFrame)
+		return;
+
+	sFrame &frame = m_frames[m_frameIdx % FRAME_LATENCY];
+	End(renderer, m_frameScopeId);
+	renderer.GetDevContext()->End(frame.disjoint);
+	frame.isPending = true;
+	m_isBeginFrame = false;
+	m_frameScopeId = -1;
+	++m_frameIdx;
+}
+
+
+// return scope id, -1 if not profiling
+int cProfiler::Begin(cRenderer &renderer, const char *name)
+{
+	sFrame &frame = m_frames[m_frameIdx % FRAME_LATENCY];
+	if (!m_isBeginFrame || (frame.scopeCount >= MAX_SCOPE))
+		return -1;
+
+	const int id = frame.scopeCount++;
+	sScope &scope = frame.scopes[id];
+	scope.name = name;
+	scope.depth = m_depth++;
+	renderer.GetDevContext()->End(frame.timestamps[id * 2]);
+	scope.allocBegin = cAllocTracker::GetThreadCount();
+	scope.allocCount = 0;
+	scope.cpuBegin = GetCounter();
+	return id;
+}
+
+
+void cProfiler::End(cRenderer &renderer, const int scopeId)
+{
+	if (!m_isBeginFrame || (scopeId < 0))
+		return;
+
+	sFrame &frame = m_frames[m_frameIdx % FRAME_LATENCY];
+	sScope &scope = frame.scopes[scopeId];
+	scope.cpuEnd = GetCounter();
+	scope.allocCount = (int)(cAllocTracker::GetThreadCount() - scope.allocBegin);
+	renderer.GetDevContext()->End(frame.timestamps[scopeId * 2 + 1]);
+	--m_depth;
+}
+
+
+// not wait GPU, skip frame if query not ready
+void cProfiler::ReadBack(cRenderer &renderer, sFrame &frame)
+{
+	ID3D11DeviceContext *devContext = renderer.GetDevContext();
+	frame.isPending = false;
+
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+	if (S_OK != devContext->GetData(frame.disjoint, &disjoint, sizeof(disjoint), 0))
+		return;
+	if (disjoint.Disjoint || (0 == frame.scopeCount))
+		return;
+
+	UINT64 timestamps[MAX_SCOPE * 2];
+	for (int i = 0; i < frame.scopeCount * 2; ++i)
+		if (S_OK != devContext->GetData(frame.timestamps[i], &timestamps[i], sizeof(UINT64), 0))
+			return;
+
+	// GPU timeline, align to frame begin CPU time
+	const double frameBegin = ToMicroSeconds(frame.scopes[0].cpuBegin);
+	const double gpuFreq = (double)disjoint.Frequency;
+
+	std::vector<sResult> &results = m_tempResults;
+	results.clear();
+	sEvent *events = m_history.empty() ? NULL : &m_history[m_historyHead * MAX_SCOPE * 2];
+
+	for (int i = 0; i < frame.scopeCount; ++i)
+	{
+		const sScope &scope = frame.scopes[i];
+		const float cpuMs = (float)((scope.cpuEnd - scope.cpuBegin) * 1000.0 / m_frequency);
+		const float gpuMs = (float)((timestamps[i * 2 + 1] - timestamps[i * 2]) * 1000.0 / gpuFreq);
+
+		sResult result;
+		result.name = scope.name;
+		result.depth = scope.depth;
+		result.cpuMs = cpuMs;
+		result.gpuMs = gpuMs;
+		result.cpuLastMs = cpuMs;
+		result.gpuLastMs = gpuMs;
+		result.allocCount = scope.allocCount;
+		if (const sResult *prev = Find(scope.name))
+		{
+			result.cpuMs = prev->cpuMs * 0.9f + cpuMs * 0.1f;
+			result.gpuMs = prev->gpuMs * 0.9f + gpuMs * 0.1f;
+		}
+		results.push_back(result);
+
+		if (events)
+		{
+			const sEvent cpu = { scope.name, 0, ToMicroSeconds(scope.cpuBegin), cpuMs * 1000.0 };
+			const sEvent gpu = { scope.name, 1
+				, frameBegin + (timestamps[i * 2] - timestamps[0]) * 1000000.0 / gpuFreq
+				, gpuMs * 1000.0 };
+			events[i * 2] = cpu;
+			events[i * 2 + 1] = gpu;
+		}
+	}
+
+	m_results.swap(results);
+	++m_readBackCount;
+
+	if (events)
+	{
+		m_historySize[m_historyHead] = frame.scopeCount * 2;
+		m_historyHead = (m_historyHead + 1) % MAX_HISTORY;
+		m_historyCount = min(m_historyCount + 1, (int)MAX_HISTORY);
+	}
+}
+
+
+const cProfiler::sResult* cProfiler::Find(const char *name) const
+{
+	for (auto &result : m_results)
+		if (!strcmp(result.name, name))
+			return &result;
+	return NULL;
+}
+
+
+// chrome://tracing, JSON Array Format
+bool cProfiler::WriteChromeTrace(const char *fileName)
+{
+	FILE *fp = NULL;
+	if (fopen_s(&fp, fileName, "w") || !fp)
+		return false;
+
+	fprintf(fp, "{\"traceEvents\":[\n");
+	fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n");
+	fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"GPU\"}}");
+
+	// oldest frame first
+	for (int i = 0; i < m_historyCount; ++i)
+	{
+		const int frame = (m_historyHead - m_historyCount + i + MAX_HISTORY) % MAX_HISTORY;
+		for (int k = 0; k < m_historySize[frame]; ++k)
+		{
+			const sEvent &e = m_history[frame * MAX_SCOPE * 2 + k];
+			fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}"
+				, e.name, e.tid ? "gpu" : "cpu", e.tid, e.ts, e.dur);
+		}
+	}
+
+	fprintf(fp, "\n]}\n");
+	const bool result = !ferror(fp);
+	fclose(fp);
+	return result;
+}
+
+
+double cProfiler::ToMicroSeconds(const __int64 counter) const
+{
+	return (counter - m_startCounter) * 1000000.0 / m_frequency;
+}
+
+
+void cProfiler::Clear()
+{
+	for (auto &frame : m_frames)
+	{
+		SAFE_RELEASE(frame.disjoint);
+		for (auto &query : frame.timestamps)
+			SAFE_RELEASE(query);
+		frame.scopeCount = 0;
+		frame.isPending = false;
+	}
+	m_frameIdx = 0;
+	m_depth = 0;
+	m_isBeginFrame = false;
+	m_frameScopeId = -1;
+	m_results.clear();
+	m_tempResults.clear();
+	m_readBackCount = 0;
+	m_history.clear();
+	m_historySize.clear();
+	m_historyHead = 0;
+	m_historyCount = 0;
+}
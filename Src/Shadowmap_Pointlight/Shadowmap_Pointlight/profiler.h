@@ -0,0 +1,120 @@
+//
+// 2018-05-10, jjuiddong
+// CPU/GPU Profiler
+//	- cAutoProfile scope, QueryPerformanceCounter (CPU), timestamp query (GPU)
+//	- GPU result read back 3 frame later, no pipeline stall
+//	- scope name must be static string (not copied)
+//	- Chrome trace export (chrome://tracing, JSON)
+//	- heap allocation count per scope (cAllocTracker)
+//	- no heap allocation after Create()
+//
+#pragma once
+
+#include "alloctracker.h"
+
+namespace graphic
+{
+
+	class cProfiler
+	{
+	public:
+		enum {
+			MAX_SCOPE = 32 // per frame
+			, FRAME_LATENCY = 3 // query ring size
+			, MAX_HISTORY = 300 // frame count for Chrome trace
+		};
+
+		struct sScope
+		{
+			const char *name;
+			int depth;
+			__int64 cpuBegin; // QueryPerformanceCounter
+			__int64 cpuEnd;
+			__int64 allocBegin; // cAllocTracker::GetThreadCount()
+			int allocCount;
+		};
+
+		// query ring element
+		struct sFrame
+		{
+			ID3D11Query *disjoint;
+			ID3D11Query *timestamps[MAX_SCOPE * 2]; // begin, end
+			sScope scopes[MAX_SCOPE];
+			int scopeCount;
+			bool isPending; // wait read back
+		};
+
+		struct sResult
+		{
+			const char *name;
+			int depth;
+			float cpuMs; // moving average
+			float gpuMs;
+			float cpuLastMs; // last read back frame
+			float gpuLastMs;
+			int allocCount; // heap allocation, last read back frame
+		};
+
+		// Chrome trace event
+		struct sEvent
+		{
+			const char *name;
+			int tid; // 0=CPU, 1=GPU
+			double ts; // microseconds
+			double dur;
+		};
+
+		cProfiler();
+		virtual ~cProfiler();
+
+		bool Create(cRenderer &renderer);
+		void BeginFrame(cRenderer &renderer);
+		void EndFrame(cRenderer &renderer);
+		int Begin(cRenderer &renderer, const char *name);
+		void End(cRenderer &renderer, const int scopeId);
+		const sResult* Find(const char *name) const;
+		bool WriteChromeTrace(const char *fileName);
+		void Clear();
+
+
+	protected:
+		void ReadBack(cRenderer &renderer, sFrame &frame);
+		double ToMicroSeconds(const __int64 counter) const;
+
+
+	public:
+		sFrame m_frames[FRAME_LATENCY];
+		int m_frameIdx;
+		int m_depth;
+		bool m_isBeginFrame;
+		int m_frameScopeId;
+		__int64 m_frequency; // QueryPerformanceFrequency
+		__int64 m_startCounter;
+		std::vector<sResult> m_results; // scope order, last read back frame
+		std::vector<sResult> m_tempResults; // swap with m_results
+		int m_readBackCount; // increase every read back success
+		std::vector<sEvent> m_history; // frame event ring, MAX_HISTORY x MAX_SCOPE x 2
+		std::vector<int> m_historySize; // event count per frame
+		int m_historyHead; // next write frame
+		int m_historyCount; // stored frame count
+	};
+
+
+	// profile scope
+	class cAutoProfile
+	{
+	public:
+		cAutoProfile(cProfiler &profiler, cRenderer &renderer, const char *name)
+			: m_profiler(profiler), m_renderer(renderer) {
+			m_id = profiler.Begin(renderer, name);
+		}
+		virtual ~cAutoProfile() {
+			m_profiler.End(m_renderer, m_id);
+		}
+
+		cProfiler &m_profiler;
+		cRenderer &m_renderer;
+		int m_id;
+	};
+
+}
@@ -0,0 +1,331 @@
+
+#include "../../Shared/platform.h"
+#include "renderqueue.h"
+#include "../../Shared/steadytimer.h"
+#include <cstring>
+#include <algorithm>
+
+using namespace graphic;
+
+
+namespace
+{
+	const int DIGIT_COUNT = 8; // 64 bit key, 8 bit digit
+	const unsigned __int64 STATE_MASK = ~0ull << cRenderQueue::MESH_SHIFT; // except depth
+
+	// chunk [begin, end), single chunk run on caller thread (no job dispatch)
+	template<class Func>
+	void RunChunk(cJobSystem *jobs, const int chunkCount, const Func &func)
+	{
+		if (jobs && (chunkCount > 1))
+			jobs->ParallelFor(chunkCount, 1, func);
+		else
+			func(0, chunkCount, 0);
+	}
+}
+
+
+cRenderQueue::cRenderQueue()
+	: m_skipPass(0)
+	, m_sortMs(0)
+{
+}
+
+cRenderQueue::~cRenderQueue()
+{
+	Clear();
+}
+
+
+void cRenderQueue::Reserve(const int count)
+{
+	m_items.reserve(count);
+	m_temp.reserve(count);
+	m_batches.reserve(count);
+}
+
+
+// every frame, capacity keep (no heap allocation after warm up)
+void cRenderQueue::Reset()
+{
+	m_items.clear();
+	m_batches.clear();
+}
+
+
+void cRenderQueue::Add(const unsigned __int64 key, const UINT index)
+{
+	sItem item;
+	item.key = key;
+	item.index = index;
+	m_items.push_back(item);
+}
+
+
+// ascending key, same key keep Add() order
+// jobs: NULL or less than PARALLEL_MIN item, single thread
+void cRenderQueue::Sort(cJobSystem *jobs //= NULL
+)
+{
+	const double t0 = GetSteadyTimeMs();
+	const int chunkCount = (jobs && ((int)m_items.size() >= PARALLEL_MIN))
+		? jobs->GetWorkerCount() : 1;
+	RadixSort(jobs, chunkCount);
+	m_sortMs = GetSteadyTimeMs() - t0;
+}
+
+
+// LSD radix sort, m_items -> m_temp -> m_items ..
+// per pass: chunk digit count -> offset (digit major, chunk minor) -> chunk scatter
+void cRenderQueue::RadixSort(cJobSystem *jobs, const int chunkCount)
+{
+	m_skipPass = 0;
+	const int count = (int)m_items.size();
+	if (count <= 1)
+		return;
+
+	m_temp.resize(count);
+	m_digitCount.resize(chunkCount * DIGIT_COUNT * 256);
+	m_offsets.resize(chunkCount * 256);
+	const int chunkSize = (count + chunkCount - 1) / chunkCount;
+
+	// all digit count, one read, constant digit detect
+	RunChunk(jobs, chunkCount, [&](const int begin, const int end, const int) {
+		for (int c = begin; c < end; ++c)
+		{
+			UINT *digitCount = &m_digitCount[c * DIGIT_COUNT * 256];
+			ZeroMemory(digitCount, sizeof(UINT) * DIGIT_COUNT * 256);
+			const int last = std::min(count, (c + 1) * chunkSize);
+			for (int i = c * chunkSize; i < last; ++i)
+			{
+				const unsigned __int64 key = m_items[i].key;
+				for (int d = 0; d < DIGIT_COUNT; ++d)
+					++digitCount[d * 256 + (UINT)((key >> (d * 8)) & 0xff)];
+			}
+		}
+	});
+
+	sItem *src = &m_items[0];
+	sItem *dst = &m_temp[0];
+	for (int d = 0; d < DIGIT_COUNT; ++d)
+	{
+		const int shift = d * 8;
+
+		// all item same digit, order not change
+		const UINT digit0 = (UINT)((src[0].key >> shift) & 0xff);
+		UINT sameCount = 0;
+		for (int c = 0; c < chunkCount; ++c)
+			sameCount += m_digitCount[(c * DIGIT_COUNT + d) * 256 + digit0];
+		if ((int)sameCount == count)
+		{
+			++m_skipPass;
+			continue;
+		}
+
+		// chunk count, current order
+		RunChunk(jobs, chunkCount, [&](const int begin, const int end, const int) {
+			for (int c = begin; c < end; ++c)
+			{
+				UINT *offsets = &m_offsets[c * 256];
+				ZeroMemory(offsets, sizeof(UINT) * 256);
+				const int last = std::min(count, (c + 1) * chunkSize);
+				for (int i = c * chunkSize; i < last; ++i)
+					++offsets[(UINT)((src[i].key >> shift) & 0xff)];
+			}
+		});
+
+		UINT offset = 0;
+		for (int v = 0; v < 256; ++v)
+		{
+			for (int c = 0; c < chunkCount; ++c)
+			{
+				const UINT n = m_offsets[c * 256 + v];
+				m_offsets[c * 256 + v] = offset;
+				offset += n;
+			}
+		}
+
+		RunChunk(jobs, chunkCount, [&](const int begin, const int end, const int) {
+			for (int c = begin; c < end; ++c)
+			{
+				UINT *offsets = &m_offsets[c * 256];
+				const int last = std::min(count, (c + 1) * chunkSize);
+				for (int i = c * chunkSize; i < last; ++i)
+					dst[offsets[(UINT)((src[i].key >> shift) & 0xff)]++] = src[i];
+			}
+		});
+
+		std::swap(src, dst);
+	}
+
+	if (src != &m_items[0])
+		m_items.swap(m_temp);
+}
+
+
+// after Sort(), same key except depth -> one batch, maxInstance item
+// return batch count
+int cRenderQueue::Batch(const int maxInstance //= MAX_INSTANCE
+)
+{
+	m_batches.clear();
+	const UINT count = (UINT)m_items.size();
+	UINT i = 0;
+	while (i < count)
+	{
+		sBatch batch;
+		batch.key = m_items[i].key;
+		batch.first = i;
+		batch.count = 1;
+		const unsigned __int64 state = batch.key & STATE_MASK;
+		while ((i + batch.count < count) && ((int)batch.count < maxInstance)
+			&& ((m_items[i + batch.count].key & STATE_MASK) == state))
+			++batch.count;
+
+		m_batches.push_back(batch);
+		i += batch.count;
+	}
+	return (int)m_batches.size();
+}
+
+
+// random draw, submit: caller render function
+// unsorted submit: one draw per item, array order (no batch)
+void cRenderQueue::Benchmark(cJobSystem &jobs, const int drawCount, const int pipelineCount
+	, const int materialCount, const int meshCount, const SubmitFunc &submit
+	, OUT sBenchmark &out)
+{
+	ZeroMemory(&out, sizeof(out));
+	out.drawCount = drawCount;
+	out.threadCount = jobs.GetWorkerCount();
+	if ((drawCount <= 0) || (pipelineCount <= 0) || (materialCount <= 0) || (meshCount <= 0))
+		return;
+
+	std::vector<sItem> items(drawCount);
+	srand(0);
+	for (int i = 0; i < drawCount; ++i)
+	{
+		items[i].key = MakeKey(0, rand() % pipelineCount, rand() % materialCount
+			, rand() % meshCount, (float)(rand() % 10000) * 0.01f);
+		items[i].index = (UINT)i;
+	}
+
+	// reference, same key -> index order (radix sort stable)
+	std::vector<sItem> ref = items;
+	double t0 = GetSteadyTimeMs();
+	std::sort(ref.begin(), ref.end(), [](const sItem &a, const sItem &b) {
+		return (a.key < b.key) || ((a.key == b.key) && (a.index < b.index));
+	});
+	out.stdSortMs = GetSteadyTimeMs() - t0;
+
+	auto isEqual = [](const std::vector<sItem> &a, const std::vector<sItem> &b) {
+		for (UINT i = 0; i < a.size(); ++i)
+			if ((a[i].key != b[i].key) || (a[i].index != b[i].index))
+				return false;
+		return a.size() == b.size();
+	};
+
+	cRenderQueue queue;
+	queue.Reserve(drawCount);
+	queue.m_items = items;
+	queue.Sort(NULL);
+	out.radixMs = queue.m_sortMs;
+	const bool isMatch = isEqual(ref, queue.m_items);
+
+	queue.m_items = items;
+	queue.Sort(&jobs);
+	out.parallelMs = queue.m_sortMs;
+	out.isMatch = isMatch && isEqual(ref, queue.m_items);
+	out.skipPass = queue.m_skipPass;
+
+	t0 = GetSteadyTimeMs();
+	out.batchCount = queue.Batch();
+	out.batchMs = GetSteadyTimeMs() - t0;
+
+	out.unsortedChange = GetStateChange(&items[0], drawCount);
+	out.sortedChange = GetStateChange(&queue.m_items[0], drawCount);
+
+	t0 = GetSteadyTimeMs();
+	for (int i = 0; i < drawCount; ++i)
+	{
+		sBatch batch;
+		batch.key = items[i].key;
+		batch.first = (UINT)i;
+		batch.count = 1;
+		submit(batch, &items[i]);
+	}
+	out.unsortedSubmitMs = GetSteadyTimeMs() - t0;
+
+	t0 = GetSteadyTimeMs();
+	for (auto &batch : queue.m_batches)
+		submit(batch, &queue.m_items[batch.first]);
+	out.sortedSubmitMs = GetSteadyTimeMs() - t0;
+}
+
+
+void cRenderQueue::Clear()
+{
+	m_items.clear();
+	m_temp.clear();
+	m_batches.clear();
+	m_digitCount.clear();
+	m_offsets.clear();
+	m_skipPass = 0;
+	m_sortMs = 0;
+}
+
+
+// depth: view distance, >= 0, front to back
+// positive float bit pattern, same order with float value
+unsigned __int64 cRenderQueue::MakeKey(const int pass, const int pipeline, const int material
+	, const int mesh, const float depth)
+{
+	const float d = std::max(0.f, depth);
+	DWORD depthBits;
+	memcpy(&depthBits, &d, sizeof(depthBits));
+	return ((unsigned __int64)(pass & 0xf) << PASS_SHIFT)
+		| ((unsigned __int64)(pipeline & 0xff) << PIPELINE_SHIFT)
+		| ((unsigned __int64)(material & 0xfff) << MATERIAL_SHIFT)
+		| ((unsigned __int64)(mesh & 0xff) << MESH_SHIFT)
+		| (unsigned __int64)depthBits;
+}
+
+
+int cRenderQueue::GetPass(const unsigned __int64 key)
+{
+	return (int)((key >> PASS_SHIFT) & 0xf);
+}
+
+
+int cRenderQueue::GetPipeline(const unsigned __int64 key)
+{
+	return (int)((key >> PIPELINE_SHIFT) & 0xff);
+}
+
+
+int cRenderQueue::GetMaterial(const unsigned __int64 key)
+{
+	return (int)((key >> MATERIAL_SHIFT) & 0xfff);
+}
+
+
+int cRenderQueue::GetMesh(const unsigned __int64 key)
+{
+	return (int)((key >> MESH_SHIFT) & 0xff);
+}
+
+
+// submit order, pipeline + material + mesh change count
+int cRenderQueue::GetStateChange(const sItem *items, const int count)
+{
+	int change = 0;
+	for (int i = 1; i < count; ++i)
+	{
+		const unsigned __int64 prev = items[i - 1].key;
+		const unsigned __int64 cur = items[i].key;
+		change += (GetPipeline(prev) != GetPipeline(cur)) ? 1 : 0;
+		change += (GetMaterial(prev) != GetMaterial(cur)) ? 1 : 0;
+		change += (GetMesh(prev) != GetMesh(cur)) ? 1 : 0;
+	}
+	return change;
+}
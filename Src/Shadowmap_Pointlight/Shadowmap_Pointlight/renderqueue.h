@@ -0,0 +1,103 @@
+//
+// 2018-05-25, jjuiddong
+// Render Queue
+//	- draw = 64 bit sort key + caller draw index, sort -> minimum state change
+//	- key: pass 4 | pipeline 8 | material 12 | mesh 8 | depth 32 (front to back)
+//	- LSD radix sort, 8 bit digit, constant digit pass skip, stable
+//	- parallel chunk count, scatter (cJobSystem), small queue single thread
+//	- Batch() : same pass, pipeline, material, mesh -> one instanced batch
+//	- Benchmark() : std::sort vs radix vs parallel radix, unsorted vs batched submit
+//	- no Common dependency (Shared/platform.h)
+//
+#pragma once
+
+#include <functional>
+#include "jobsystem.h"
+
+
+namespace graphic
+{
+
+	class cRenderQueue
+	{
+	public:
+		enum {
+			PASS_SHIFT = 60
+			, PIPELINE_SHIFT = 52
+			, MATERIAL_SHIFT = 40
+			, MESH_SHIFT = 32
+			, MAX_INSTANCE = 256 // common.fx, cbPerFrameInstancing gWorldInst[256]
+			, PARALLEL_MIN = 4096 // less than, single thread sort
+		};
+
+		struct sItem
+		{
+			unsigned __int64 key;
+			UINT index; // caller draw index
+		};
+
+		// m_items[first ~ first + count - 1], same key except depth
+		struct sBatch
+		{
+			unsigned __int64 key; // first item key
+			UINT first;
+			UINT count;
+		};
+
+		struct sBenchmark
+		{
+			int drawCount;
+			int threadCount;
+			double stdSortMs;
+			double radixMs; // 1 thread
+			double parallelMs;
+			bool isMatch; // radix, parallel radix == std::sort
+			int skipPass; // constant digit, 8 pass
+			double batchMs;
+			int batchCount;
+			int unsortedChange; // pipeline, material, mesh change count
+			int sortedChange;
+			double unsortedSubmitMs; // array order, one draw per item
+			double sortedSubmitMs; // batch order
+		};
+
+		// batch, batch first item
+		typedef std::function<void(const sBatch&, const sItem*)> SubmitFunc;
+
+		cRenderQueue();
+		virtual ~cRenderQueue();
+
+		void Reserve(const int count);
+		void Reset();
+		void Add(const unsigned __int64 key, const UINT index);
+		void Sort(cJobSystem *jobs = NULL);
+		int Batch(const int maxInstance = MAX_INSTANCE);
+		void Benchmark(cJobSystem &jobs, const int drawCount, const int pipelineCount
+			, const int materialCount, const int meshCount, const SubmitFunc &submit
+			, OUT sBenchmark &out);
+		void Clear();
+
+		static unsigned __int64 MakeKey(const int pass, const int pipeline, const int material
+			, const int mesh, const float depth);
+		static int GetPass(const unsigned __int64 key);
+		static int GetPipeline(const unsigned __int64 key);
+		static int GetMaterial(const unsigned __int64 key);
+		static int GetMesh(const unsigned __int64 key);
+		static int GetStateChange(const sItem *items, const int count);
+
+
+	protected:
+		void RadixSort(cJobSystem *jobs, const int chunkCount);
+
+
+	public:
+		std::vector<sItem> m_items;
+		std::vector<sItem> m_temp; // radix sort ping-pong
+		std::vector<sBatch> m_batches;
+		std::vector<UINT> m_digitCount; // chunk * 8 digit * 256
+		std::vector<UINT> m_offsets; // chunk * 256, current pass
+		int m_skipPass; // last Sort()
+		double m_sortMs;
+	};
+
+}
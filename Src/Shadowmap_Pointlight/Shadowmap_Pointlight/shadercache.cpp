@@ -0,0 +1,164 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "shadercache.h"
+#include "../../Shared/steadytimer.h"
+
+using namespace graphic;
+
+
+cShaderCache::cShaderCache()
+	: m_device(NULL)
+	, m_loadCount(0)
+	, m_missCount(0)
+	, m_loadMs(0)
+{
+}
+
+cShaderCache::~cShaderCache()
+{
+	Clear();
+}
+
+
+// directory: cShaderPermutation::CompileAll() output
+bool cShaderCache::Create(cRenderer &renderer, const char *directory)
+{
+	Clear();
+	m_device = renderer.GetDevice();
+	m_directory = directory;
+	return true;
+}
+
+
+// key: cShaderPermutation key, Validate() inside
+// return NULL if variant not compiled
+cShaderCache::sVariant* cShaderCache::Get(const unsigned __int64 key)
+{
+	const unsigned __int64 validKey = cShaderPermutation::Validate(key);
+	auto it = m_variants.find(validKey);
+	if (m_variants.end() != it)
+		return it->second;
+
+	sVariant *variant = Load(validKey);
+	m_variants[validKey] = variant;
+	return variant;
+}
+
+
+// variant pass apply, same as cShader11::BeginPass()
+// return false if variant not compiled
+bool cShaderCache::Apply(cRenderer &renderer, const unsigned __int64 key)
+{
+	sVariant *variant = Get(key);
+	if (!variant)
+		return false;
+	variant->pass->Apply(0, renderer.GetDevContext());
+	return true;
+}
+
+
+cShaderCache::sVariant* cShaderCache::Load(const unsigned __int64 key)
+{
+	const double t0 = GetSteadyTimeMs();
+	const std::string fileName = cShaderPermutation::GetFileName(m_directory.c_str(), key);
+
+	std::vector<BYTE> data;
+	FILE *fp = NULL;
+	if (!fopen_s(&fp, fileName.c_str(), "rb") && fp)
+	{
+		fseek(fp, 0, SEEK_END);
+		data.resize(max(0L, ftell(fp)));
+		fseek(fp, 0, SEEK_SET);
+		const size_t readSize = data.empty() ? 0 : fread(&data[0], 1, data.size(), fp);
+		fclose(fp);
+		if (readSize != data.size())
+			data.clear();
+	}
+
+	sVariant *variant = CreateVariant(key, data);
+	if (variant)
+		++m_loadCount;
+	else
+		++m_missCount;
+	m_loadMs += GetSteadyTimeMs() - t0;
+	return variant;
+}
+
+
+// code: compiled effect (fx_5_0)
+cShaderCache::sVariant* cShaderCache::CreateVariant(const unsigned __int64 key
+	, const std::vector<BYTE> &code)
+{
+	ID3DX11Effect *effect = NULL;
+	if (!m_device || code.empty()
+		|| FAILED(D3DX11CreateEffectFromMemory(&code[0], code.size(), 0, m_device, &effect)))
+		return NULL;
+
+	ID3DX11EffectPass *pass = effect->GetTechniqueByName(
+		cShaderPermutation::GetEffectDesc(key).technique)->GetPassByIndex(0);
+	if (!pass->IsValid())
+	{
+		SAFE_RELEASE(effect);
+		return NULL;
+	}
+
+	sVariant *variant = new sVariant;
+	variant->effect = effect;
+	variant->pass = pass;
+	return variant;
+}
+
+
+// hot reload, swap variant effect, previous effect release
+// sVariant pointer not change, Get() result still valid
+// return false if code invalid, previous variant keep
+bool cShaderCache::Replace(const unsigned __int64 key, const std::vector<BYTE> &code)
+{
+	const unsigned __int64 validKey = cShaderPermutation::Validate(key);
+	sVariant *newVariant = CreateVariant(validKey, code);
+	if (!newVariant)
+		return false;
+
+	auto it = m_variants.find(validKey);
+	if ((m_variants.end() != it) && it->second)
+	{
+		SAFE_RELEASE(it->second->effect);
+		*it->second = *newVariant;
+		delete newVariant;
+		return true;
+	}
+
+	if (m_variants.end() != it) // not compiled before
+		--m_missCount;
+	++m_loadCount;
+	m_variants[validKey] = newVariant;
+	return true;
+}
+
+
+// loaded or missing variant key
+void cShaderCache::GetKeys(OUT std::vector<unsigned __int64> &keys) const
+{
+	keys.clear();
+	for (auto &kv : m_variants)
+		keys.push_back(kv.first);
+}
+
+
+void cShaderCache::Clear()
+{
+	for (auto &kv : m_variants)
+	{
+		if (!kv.second)
+			continue;
+		SAFE_RELEASE(kv.second->effect);
+		delete kv.second;
+	}
+	m_variants.clear();
+	m_loadCount = 0;
+	m_missCount = 0;
+	m_loadMs = 0;
+}
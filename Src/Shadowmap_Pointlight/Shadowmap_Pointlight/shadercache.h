@@ -0,0 +1,52 @@
+//
+// 2018-05-22, jjuiddong
+// Shader Variant Cache
+//	- cShaderPermutation key -> precompiled effect (.fxo), load on first Get()
+//	- startup load only used variant, never compile at runtime
+//	- not compiled variant return NULL (cached), caller fallback hand compiled .fxo
+//	- Replace() : hot reload result swap, render thread, frame boundary
+//
+#pragma once
+
+#include "shaderpermutation.h"
+#include <map>
+
+
+namespace graphic
+{
+
+	class cShaderCache
+	{
+	public:
+		struct sVariant
+		{
+			ID3DX11Effect *effect;
+			ID3DX11EffectPass *pass; // sEffect::technique, pass 0
+		};
+
+		cShaderCache();
+		virtual ~cShaderCache();
+
+		bool Create(cRenderer &renderer, const char *directory);
+		sVariant* Get(const unsigned __int64 key);
+		bool Apply(cRenderer &renderer, const unsigned __int64 key);
+		bool Replace(const unsigned __int64 key, const std::vector<BYTE> &code);
+		void GetKeys(OUT std::vector<unsigned __int64> &keys) const;
+		void Clear();
+
+
+	protected:
+		sVariant* Load(const unsigned __int64 key);
+		sVariant* CreateVariant(const unsigned __int64 key, const std::vector<BYTE> &code);
+
+
+	public:
+		ID3D11Device *m_device;
+		std::string m_directory;
+		std::map<unsigned __int64, sVariant*> m_variants; // NULL: not compiled
+		int m_loadCount;
+		int m_missCount;
+		double m_loadMs; // all Load() time
+	};
+
+}
@@ -0,0 +1,321 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "shaderpermutation.h"
+#include <d3dcompiler.h>
+#include "../../Shared/steadytimer.h"
+#include <algorithm>
+
+#pragma comment(lib, "d3dcompiler.lib")
+
+using namespace graphic;
+
+
+namespace
+{
+	// key bit field, eShaderOption order
+	const cShaderPermutation::sOption g_options[eShaderOption::MAX] = {
+		{ "LIGHT_TYPE", 0, 2 }
+		, { "SHADOW", 2, 2 }
+		, { "INSTANCING", 3, 2 }
+		, { "GBUFFER_LAYOUT", 4, 2 }
+	};
+
+	// eShaderEffect order
+	const cShaderPermutation::sEffect g_effects[eShaderEffect::MAX] = {
+		{ "deferredshading", "deferredshading.fx", "Unlit"
+			, (1 << eShaderOption::INSTANCING) | (1 << eShaderOption::GBUFFER_LAYOUT) }
+		, { "light", "light.fx", "Unlit"
+			, (1 << eShaderOption::LIGHT_TYPE) | (1 << eShaderOption::SHADOW)
+			| (1 << eShaderOption::GBUFFER_LAYOUT) }
+	};
+
+	// bit field width, valueCount <= 1 << width
+	inline unsigned __int64 GetOptionMask(const cShaderPermutation::sOption &option)
+	{
+		int bits = 1;
+		while ((1 << bits) < option.valueCount)
+			++bits;
+		return ((1ull << bits) - 1) << option.shift;
+	}
+}
+
+
+unsigned __int64 cShaderPermutation::MakeKey(const eShaderEffect::Enum effect)
+{
+	return (unsigned __int64)effect << 32;
+}
+
+
+unsigned __int64 cShaderPermutation::SetOption(const unsigned __int64 key
+	, const eShaderOption::Enum option, const int value)
+{
+	const sOption &desc = g_options[option];
+	const unsigned __int64 mask = GetOptionMask(desc);
+	return (key & ~mask) | (((unsigned __int64)value << desc.shift) & mask);
+}
+
+
+int cShaderPermutation::GetOption(const unsigned __int64 key, const eShaderOption::Enum option)
+{
+	const sOption &desc = g_options[option];
+	return (int)((key & GetOptionMask(desc)) >> desc.shift);
+}
+
+
+int cShaderPermutation::GetEffect(const unsigned __int64 key)
+{
+	const int effect = (int)(key >> 32);
+	return ((effect >= 0) && (effect < eShaderEffect::MAX)) ? effect : 0;
+}
+
+
+const cShaderPermutation::sEffect& cShaderPermutation::GetEffectDesc(const unsigned __int64 key)
+{
+	return g_effects[GetEffect(key)];
+}
+
+
+const cShaderPermutation::sOption& cShaderPermutation::GetOptionDesc(
+	const eShaderOption::Enum option)
+{
+	return g_options[option];
+}
+
+
+// clear option not used by effect, out of range value
+// directional light has no shadow option
+unsigned __int64 cShaderPermutation::Validate(const unsigned __int64 key)
+{
+	const sEffect &effect = GetEffectDesc(key);
+	unsigned __int64 out = MakeKey((eShaderEffect::Enum)GetEffect(key));
+	for (int i = 0; i < eShaderOption::MAX; ++i)
+	{
+		const eShaderOption::Enum option = (eShaderOption::Enum)i;
+		const int value = GetOption(key, option);
+		if ((effect.options & (1 << i)) && (value < g_options[i].valueCount))
+			out = SetOption(out, option, value);
+	}
+
+	if ((GetEffect(out) == eShaderEffect::LIGHT)
+		&& (GetOption(out, eShaderOption::LIGHT_TYPE) == LIGHT_TYPE_DIRECTIONAL))
+		out = SetOption(out, eShaderOption::SHADOW, 0);
+	return out;
+}
+
+
+// all distinct variant, effect order
+void cShaderPermutation::Enumerate(OUT std::vector<unsigned __int64> &keys)
+{
+	keys.clear();
+	for (int e = 0; e < eShaderEffect::MAX; ++e)
+	{
+		const sEffect &effect = g_effects[e];
+		int count = 1;
+		for (int i = 0; i < eShaderOption::MAX; ++i)
+			if (effect.options & (1 << i))
+				count *= g_options[i].valueCount;
+
+		const size_t first = keys.size();
+		for (int n = 0; n < count; ++n)
+		{
+			unsigned __int64 key = MakeKey((eShaderEffect::Enum)e);
+			int v = n;
+			for (int i = 0; i < eShaderOption::MAX; ++i)
+			{
+				if (!(effect.options & (1 << i)))
+					continue;
+				key = SetOption(key, (eShaderOption::Enum)i, v % g_options[i].valueCount);
+				v /= g_options[i].valueCount;
+			}
+			keys.push_back(Validate(key));
+		}
+
+		std::sort(keys.begin() + first, keys.end());
+		keys.erase(std::unique(keys.begin() + first, keys.end()), keys.end());
+	}
+}
+
+
+// directory/name_<16 digit hex key>.fxo
+std::string cShaderPermutation::GetFileName(const char *directory, const unsigned __int64 key)
+{
+	char buff[32];
+	sprintf_s(buff, "_%016llx.fxo", key);
+	return std::string(directory) + "/" + GetEffectDesc(key).name + buff;
+}
+
+
+// fx_5_0 compile from file, thread safe
+// macros: null terminate array, NULL: no define
+// flags: D3DCOMPILE_xxx
+bool cShaderPermutation::CompileFile(const char *srcFileName, const D3D_SHADER_MACRO *macros
+	, const UINT flags, OUT std::vector<BYTE> &code, OUT std::string &error)
+{
+	const std::string fileName = srcFileName;
+	const std::wstring wSrcFileName(fileName.begin(), fileName.end());
+
+	ID3DBlob *blob = NULL;
+	ID3DBlob *errors = NULL;
+	const HRESULT hr = D3DCompileFromFile(wSrcFileName.c_str(), macros
+		, D3D_COMPILE_STANDARD_FILE_INCLUDE, NULL, "fx_5_0", flags, 0, &blob, &errors);
+	if (FAILED(hr) || !blob)
+	{
+		error = errors ? (const char*)errors->GetBufferPointer() : fileName;
+		SAFE_RELEASE(blob);
+		SAFE_RELEASE(errors);
+		return false;
+	}
+	SAFE_RELEASE(errors);
+
+	const BYTE *ptr = (const BYTE*)blob->GetBufferPointer();
+	code.assign(ptr, ptr + blob->GetBufferSize());
+	SAFE_RELEASE(blob);
+	return !code.empty();
+}
+
+
+// fx_5_0 compile with option define, thread safe
+bool cShaderPermutation::Compile(const char *srcDirectory, const unsigned __int64 key
+	, OUT std::vector<BYTE> &code, OUT std::string &error)
+{
+	const sEffect &effect = GetEffectDesc(key);
+	const std::string srcFileName = std::string(srcDirectory) + "/" + effect.fileName;
+
+	// define string, null terminate macro array
+	char values[eShaderOption::MAX][8];
+	D3D_SHADER_MACRO macros[eShaderOption::MAX + 1];
+	int macroCount = 0;
+	for (int i = 0; i < eShaderOption::MAX; ++i)
+	{
+		if (!(effect.options & (1 << i)))
+			continue;
+		sprintf_s(values[i], "%d", GetOption(key, (eShaderOption::Enum)i));
+		macros[macroCount].Name = g_options[i].define;
+		macros[macroCount].Definition = values[i];
+		++macroCount;
+	}
+	macros[macroCount].Name = NULL;
+	macros[macroCount].Definition = NULL;
+
+	return CompileFile(srcFileName.c_str(), macros, D3DCOMPILE_OPTIMIZATION_LEVEL3
+		, code, error);
+}
+
+
+// compile and write to outDirectory, GetFileName()
+bool cShaderPermutation::Compile(const char *srcDirectory, const char *outDirectory
+	, const unsigned __int64 key, OUT std::string &error)
+{
+	std::vector<BYTE> code;
+	if (!Compile(srcDirectory, key, code, error))
+		return false;
+	if (!Write(outDirectory, key, code))
+	{
+		error = GetFileName(outDirectory, key);
+		return false;
+	}
+	return true;
+}
+
+
+bool cShaderPermutation::Write(const char *outDirectory, const unsigned __int64 key
+	, const std::vector<BYTE> &code)
+{
+	return WriteAtomic(GetFileName(outDirectory, key).c_str(), code);
+}
+
+
+// write fileName.tmp, rename to fileName
+// cShaderCache::Load(), cShader11 load never read half written file
+bool cShaderPermutation::WriteAtomic(const char *fileName, const std::vector<BYTE> &code)
+{
+	if (code.empty())
+		return false;
+
+	const std::string tempFileName = std::string(fileName) + ".tmp";
+	FILE *fp = NULL;
+	if (fopen_s(&fp, tempFileName.c_str(), "wb") || !fp)
+		return false;
+	const bool isWrite = (code.size() == fwrite(&code[0], 1, code.size(), fp));
+	const bool isClose = (0 == fclose(fp));
+	if (!isWrite || !isClose
+		|| !MoveFileExA(tempFileName.c_str(), fileName
+			, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+	{
+		DeleteFileA(tempFileName.c_str());
+		return false;
+	}
+	return true;
+}
+
+
+// one variant per job
+bool cShaderPermutation::CompileAll(cJobSystem &jobs, const char *srcDirectory
+	, const char *outDirectory, OUT sCompileResult &out)
+{
+	out.variantCount = 0;
+	out.failCount = 0;
+	out.threadCount = jobs.GetWorkerCount();
+	out.ms = 0;
+	out.error.clear();
+
+	if (!CreateDirectoryA(outDirectory, NULL) && (ERROR_ALREADY_EXISTS != GetLastError()))
+	{
+		out.error = outDirectory;
+		return false;
+	}
+
+	std::vector<unsigned __int64> keys;
+	Enumerate(keys);
+	std::vector<std::string> errors(keys.size());
+	std::vector<int> results(keys.size(), 0);
+
+	const double t0 = GetSteadyTimeMs();
+	jobs.ParallelFor((int)keys.size(), 1, [&](const int begin, const int end, const int) {
+		for (int i = begin; i < end; ++i)
+			results[i] = Compile(srcDirectory, outDirectory, keys[i], errors[i]) ? 1 : 0;
+	});
+	out.ms = GetSteadyTimeMs() - t0;
+
+	out.variantCount = (int)keys.size();
+	for (u_int i = 0; i < keys.size(); ++i)
+	{
+		if (results[i])
+			continue;
+		if (0 == out.failCount)
+			out.error = errors[i];
+		++out.failCount;
+	}
+	return 0 == out.failCount;
+}
+
+
+// variant list, compile time
+bool cShaderPermutation::Report(const sCompileResult &result, const char *fileName)
+{
+	FILE *fp = NULL;
+	if (fopen_s(&fp, fileName, "w") || !fp)
+		return false;
+
+	fprintf(fp, "variant %d, fail %d, %d thread, %.1f ms\n", result.variantCount
+		, result.failCount, result.threadCount, result.ms);
+
+	std::vector<unsigned __int64> keys;
+	Enumerate(keys);
+	for (auto key : keys)
+	{
+		fprintf(fp, "%016llx %-16s", key, GetEffectDesc(key).name);
+		for (int i = 0; i < eShaderOption::MAX; ++i)
+			if (GetEffectDesc(key).options & (1 << i))
+				fprintf(fp, " %s=%d", g_options[i].define, GetOption(key, (eShaderOption::Enum)i));
+		fprintf(fp, "\n");
+	}
+
+	if (!result.error.empty())
+		fprintf(fp, "\nerror\n%s\n", result.error.c_str());
+	fclose(fp);
+	return true;
+}
@@ -0,0 +1,84 @@
+//
+// 2018-05-22, jjuiddong
+// Shader Permutation
+//	- permutation description, effect root file + define option (permutation.fx)
+//	- 64 bit key, [0, 32): option value bit field, [32, 64): effect id
+//	- unused option cleared, one key per distinct variant
+//	- CompileAll() : offline batch compile, all variant, multi thread (cJobSystem)
+//	  sample command line -compileshaders, output xxx_<key>.fxo
+//	- WriteAtomic() : temp file + MoveFileEx, reader never see half written .fxo
+//
+#pragma once
+
+#include "jobsystem.h"
+
+
+namespace graphic
+{
+
+	struct eShaderEffect {
+		enum Enum { GBUFFER, LIGHT, MAX };
+	};
+
+	struct eShaderOption {
+		enum Enum { LIGHT_TYPE, SHADOW, INSTANCING, GBUFFER_LAYOUT, MAX };
+	};
+
+
+	class cShaderPermutation
+	{
+	public:
+		// option value, same with permutation.fx
+		enum { LIGHT_TYPE_DIRECTIONAL = 0, LIGHT_TYPE_POINT = 1 };
+		enum { GBUFFER_LAYOUT_RGB = 0, GBUFFER_LAYOUT_OCT = 1 };
+
+		struct sOption
+		{
+			const char *define;
+			int shift; // key bit offset
+			int valueCount;
+		};
+
+		struct sEffect
+		{
+			const char *name; // output file name prefix
+			const char *fileName; // root .fx
+			const char *technique;
+			UINT options; // 1 << eShaderOption
+		};
+
+		struct sCompileResult
+		{
+			int variantCount;
+			int failCount;
+			int threadCount;
+			double ms;
+			std::string error; // first fail message
+		};
+
+		static unsigned __int64 MakeKey(const eShaderEffect::Enum effect);
+		static unsigned __int64 SetOption(const unsigned __int64 key
+			, const eShaderOption::Enum option, const int value);
+		static int GetOption(const unsigned __int64 key, const eShaderOption::Enum option);
+		static int GetEffect(const unsigned __int64 key);
+		static unsigned __int64 Validate(const unsigned __int64 key);
+		static void Enumerate(OUT std::vector<unsigned __int64> &keys);
+		static std::string GetFileName(const char *directory, const unsigned __int64 key);
+		static const sEffect& GetEffectDesc(const unsigned __int64 key);
+		static const sOption& GetOptionDesc(const eShaderOption::Enum option);
+
+		static bool CompileFile(const char *srcFileName, const D3D_SHADER_MACRO *macros
+			, const UINT flags, OUT std::vector<BYTE> &code, OUT std::string &error);
+		static bool Compile(const char *srcDirectory, const unsigned __int64 key
+			, OUT std::vector<BYTE> &code, OUT std::string &error);
+		static bool Compile(const char *srcDirectory, const char *outDirectory
+			, const unsigned __int64 key, OUT std::string &error);
+		static bool Write(const char *outDirectory, const unsigned __int64 key
+			, const std::vector<BYTE> &code);
+		static bool WriteAtomic(const char *fileName, const std::vector<BYTE> &code);
+		static bool CompileAll(cJobSystem &jobs, const char *srcDirectory
+			, const char *outDirectory, OUT sCompileResult &out);
+		static bool Report(const sCompileResult &result, const char *fileName);
+	};
+
+}
@@ -0,0 +1,336 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "shaderreloader.h"
+#include "../../Shared/steadytimer.h"
+#include <d3dcompiler.h>
+#include <map>
+
+using namespace graphic;
+
+
+namespace
+{
+	bool IsShaderFile(const std::string &fileName)
+	{
+		if ("*" == fileName)
+			return true; // notify overflow, unknown change
+		const size_t pos = fileName.find_last_of('.');
+		return (std::string::npos != pos)
+			&& (0 == _stricmp(fileName.c_str() + pos, ".fx"));
+	}
+
+	// full path, lower case, compare file name
+	// return empty string if fail
+	std::string GetFullFileName(const std::string &fileName)
+	{
+		char buff[MAX_PATH];
+		const DWORD len = GetFullPathNameA(fileName.c_str(), sizeof(buff), buff, NULL);
+		if ((0 == len) || (len >= sizeof(buff)))
+			return "";
+		_strlwr_s(buff);
+		return buff;
+	}
+
+	// #include "xxx" file, recursive, include file directory relative
+	// (D3D_COMPILE_STANDARD_FILE_INCLUDE)
+	// #if condition ignored, superset of real dependency
+	void ScanIncludes(const std::string &fileName, OUT std::set<std::string> &files)
+	{
+		const std::string fullName = GetFullFileName(fileName);
+		if (fullName.empty() || !files.insert(fullName).second)
+			return;
+
+		FILE *fp = NULL;
+		if (fopen_s(&fp, fullName.c_str(), "r") || !fp)
+			return;
+
+		const std::string directory = fullName.substr(0, fullName.find_last_of("\\/") + 1);
+		std::vector<std::string> includes;
+		char line[512];
+		while (fgets(line, sizeof(line), fp))
+		{
+			const char *inc = strstr(line, "#include");
+			const char *q0 = inc ? strchr(inc, '"') : NULL;
+			const char *q1 = q0 ? strchr(q0 + 1, '"') : NULL;
+			if (q1)
+				includes.push_back(directory + std::string(q0 + 1, q1));
+		}
+		fclose(fp);
+
+		for (auto &include : includes)
+			ScanIncludes(include, files);
+	}
+
+	// srcFileName or its include file changed?
+	bool IsDependent(const std::string &srcFileName, const std::set<std::string> &changeFiles)
+	{
+		std::set<std::string> files;
+		ScanIncludes(srcFileName, files);
+		for (auto &fileName : changeFiles)
+			if (files.end() != files.find(fileName))
+				return true;
+		return false;
+	}
+}
+
+
+cShaderReloader::cShaderReloader()
+	: m_isLoop(false)
+	, m_keyCount(0)
+	, m_reloadCount(0)
+	, m_failCount(0)
+	, m_lastLatencyMs(0)
+	, m_maxLatencyMs(0)
+	, m_lastCompileMs(0)
+	, m_lastSwapMs(0)
+{
+}
+
+cShaderReloader::~cShaderReloader()
+{
+	Clear();
+}
+
+
+// watchDirectory: recursive, Media/ (common.fx, sample .fx)
+// srcDirectory, outDirectory: cShaderPermutation::Compile()
+bool cShaderReloader::Create(const char *watchDirectory, const char *srcDirectory
+	, const char *outDirectory)
+{
+	Clear();
+	m_srcDirectory = srcDirectory;
+	m_outDirectory = outDirectory;
+	RETV2(!m_watcher.Create(watchDirectory, true), false);
+
+	m_isLoop = true;
+	m_thread = std::thread(&cShaderReloader::WorkerThread, this);
+	return true;
+}
+
+
+// hand compiled effect, m_shaderMgr.LoadShader() same argument
+// fxoFileName: fxc output, source .fx same directory, same name
+// call after Create(), render thread
+bool cShaderReloader::AddEffect(const char *fxoFileName, const int vtxType)
+{
+	const std::string fileName = fxoFileName;
+	const size_t pos = fileName.find_last_of('.');
+	RETV2(std::string::npos == pos, false);
+
+	sEffect effect;
+	effect.fileName = fileName;
+	effect.srcFileName = fileName.substr(0, pos) + ".fx";
+	effect.vtxType = vtxType;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_effects.push_back(effect);
+	return true;
+}
+
+
+// render thread, frame boundary
+// register new cache key, swap compiled variant, cShader11 effect
+// return swap count
+int cShaderReloader::Update(cRenderer &renderer, cShaderCache &cache)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+		if (!lock.owns_lock())
+			return 0; // worker copy result, next frame
+
+		if (m_keyCount != cache.m_variants.size())
+		{
+			cache.GetKeys(m_keys);
+			m_keyCount = cache.m_variants.size();
+		}
+		if (m_results.empty())
+			return 0;
+		m_swapResults.swap(m_results);
+	}
+
+	int count = 0;
+	for (auto &result : m_swapResults)
+	{
+		if (result.code.empty())
+		{
+			++m_failCount;
+			m_lastError = result.error;
+			continue;
+		}
+
+		const double t0 = GetSteadyTimeMs();
+		const bool isSwap = (result.effect < 0) ? cache.Replace(result.key, result.code)
+			: SwapEffect(renderer, m_effects[result.effect], result.code);
+		if (!isSwap)
+		{
+			++m_failCount;
+			m_lastError = "effect create fail";
+			continue;
+		}
+		const double t1 = GetSteadyTimeMs();
+
+		++count;
+		++m_reloadCount;
+		m_lastSwapMs = t1 - t0;
+		m_lastCompileMs = result.compileMs;
+		m_lastLatencyMs = t1 - result.detectTime;
+		m_maxLatencyMs = max(m_maxLatencyMs, m_lastLatencyMs);
+		m_lastError.clear();
+	}
+	m_swapResults.clear();
+	return count;
+}
+
+
+// swap cShader11 effect, keep current technique
+// input layout not change, vertex input signature change need restart
+bool cShaderReloader::SwapEffect(cRenderer &renderer, const sEffect &effect
+	, const std::vector<BYTE> &code)
+{
+	cShader11 *shader = renderer.m_shaderMgr.LoadShader(renderer, effect.fileName.c_str()
+		, effect.vtxType, false);
+	if (!shader || !shader->m_effect)
+		return false;
+
+	ID3DX11Effect *newEffect = NULL;
+	if (FAILED(D3DX11CreateEffectFromMemory(&code[0], code.size(), 0
+		, renderer.GetDevice(), &newEffect)))
+		return false;
+
+	ID3DX11EffectTechnique *technique = newEffect->GetTechniqueByIndex(0);
+	D3DX11_TECHNIQUE_DESC desc;
+	if (shader->m_technique && SUCCEEDED(shader->m_technique->GetDesc(&desc)))
+		technique = newEffect->GetTechniqueByName(desc.Name);
+
+	SAFE_RELEASE(shader->m_effect);
+	shader->m_effect = newEffect;
+	shader->m_technique = technique;
+	return true;
+}
+
+
+// wait .fx change -> debounce -> compile dependent variant, effect
+void cShaderReloader::WorkerThread()
+{
+	std::vector<std::string> fileNames;
+	std::set<std::string> changeFiles; // full path, lower case
+	std::vector<unsigned __int64> keys;
+	std::vector<sEffect> effects;
+	std::vector<sResult> results;
+
+	while (m_isLoop)
+	{
+		if (m_watcher.Wait(INFINITE, fileNames) < 0)
+			break;
+
+		// collect change until debounce timeout
+		const double detectTime = GetSteadyTimeMs();
+		bool isAll = false; // notify overflow
+		changeFiles.clear();
+		do
+		{
+			for (auto &fileName : fileNames)
+			{
+				if (!IsShaderFile(fileName))
+					continue;
+				if ("*" == fileName)
+					isAll = true;
+				else
+					changeFiles.insert(GetFullFileName(m_watcher.m_directory + "/" + fileName));
+			}
+		} while (m_isLoop && (m_watcher.Wait(DEBOUNCE_MS, fileNames) > 0));
+		if (!m_isLoop)
+			break;
+		if (!isAll && changeFiles.empty())
+			continue;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			keys = m_keys;
+			effects = m_effects;
+		}
+
+		// include graph scan every change, edit can add/remove #include
+		// one scan per root .fx, variant share root
+		std::map<std::string, bool> dependents; // root .fx, dependent?
+		auto isDependent = [&](const std::string &srcFileName) {
+			if (isAll)
+				return true;
+			auto it = dependents.find(srcFileName);
+			if (dependents.end() != it)
+				return it->second;
+			const bool result = IsDependent(srcFileName, changeFiles);
+			dependents[srcFileName] = result;
+			return result;
+		};
+
+		results.clear();
+		for (auto key : keys)
+		{
+			const std::string srcFileName = m_srcDirectory + "/"
+				+ cShaderPermutation::GetEffectDesc(key).fileName;
+			if (!isDependent(srcFileName))
+				continue;
+
+			sResult result;
+			const double t0 = GetSteadyTimeMs();
+			result.effect = -1;
+			result.key = key;
+			result.detectTime = detectTime;
+			if (cShaderPermutation::Compile(m_srcDirectory.c_str(), key, result.code
+				, result.error))
+				cShaderPermutation::Write(m_outDirectory.c_str(), key, result.code);
+			else
+				result.code.clear();
+			result.compileMs = GetSteadyTimeMs() - t0;
+			results.push_back(result);
+		}
+
+		// same option with project fxc build step (/Od /Zi)
+		for (u_int i = 0; i < effects.size(); ++i)
+		{
+			const sEffect &effect = effects[i];
+			if (!isDependent(effect.srcFileName))
+				continue;
+
+			sResult result;
+			const double t0 = GetSteadyTimeMs();
+			result.effect = (int)i;
+			result.key = 0;
+			result.detectTime = detectTime;
+			if (cShaderPermutation::CompileFile(effect.srcFileName.c_str(), NULL
+				, D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION, result.code, result.error))
+				cShaderPermutation::WriteAtomic(effect.fileName.c_str(), result.code);
+			else
+				result.code.clear();
+			result.compileMs = GetSteadyTimeMs() - t0;
+			results.push_back(result);
+		}
+
+		if (results.empty())
+			continue;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto &result : results)
+			m_results.push_back(result);
+	}
+}
+
+
+void cShaderReloader::Clear()
+{
+	m_isLoop = false;
+	m_watcher.Cancel();
+	if (m_thread.joinable())
+		m_thread.join();
+	m_watcher.Clear();
+
+	m_keys.clear();
+	m_effects.clear();
+	m_results.clear();
+	m_swapResults.clear();
+	m_keyCount = 0;
+}
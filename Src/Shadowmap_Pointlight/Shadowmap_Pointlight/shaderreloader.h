@@ -0,0 +1,89 @@
+//
+// 2018-05-23, jjuiddong
+// Shader Hot Reload
+//	- watch Media/ (cFileWatcher), .fx change -> recompile dependent effect
+//	  root .fx #include scan, only variant/effect include changed file
+//	- compile on worker thread, never block render thread
+//	- Update() : render thread, frame boundary
+//	  variant: cShaderCache::Replace()
+//	  AddEffect() .fxo: cShader11 (m_shaderMgr) effect swap
+//	  try_lock only, result wait next frame if worker hold lock
+//	- recompiled .fxo write, cShaderPermutation::WriteAtomic()
+//	- latency: change detect ~ swap, milliseconds
+//
+#pragma once
+
+#include "filewatcher.h"
+#include "shadercache.h"
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <set>
+
+
+namespace graphic
+{
+
+	class cShaderReloader
+	{
+	public:
+		// hand compiled effect, cShaderManager::LoadShader() argument
+		struct sEffect
+		{
+			std::string fileName; // .fxo
+			std::string srcFileName; // .fx, same directory
+			int vtxType;
+		};
+
+		struct sResult
+		{
+			int effect; // m_effects index, -1: cShaderCache variant
+			unsigned __int64 key;
+			std::vector<BYTE> code; // empty if fail
+			std::string error;
+			double detectTime; // file change detect, GetSteadyTimeMs()
+			double compileMs;
+		};
+
+		cShaderReloader();
+		virtual ~cShaderReloader();
+
+		bool Create(const char *watchDirectory, const char *srcDirectory
+			, const char *outDirectory);
+		bool AddEffect(const char *fxoFileName, const int vtxType);
+		int Update(cRenderer &renderer, cShaderCache &cache);
+		void Clear();
+
+
+	protected:
+		void WorkerThread();
+		bool SwapEffect(cRenderer &renderer, const sEffect &effect
+			, const std::vector<BYTE> &code);
+
+
+	public:
+		enum { DEBOUNCE_MS = 100 }; // editor save write file several time
+
+		std::string m_srcDirectory;
+		std::string m_outDirectory;
+		cFileWatcher m_watcher;
+		std::atomic<bool> m_isLoop;
+		std::thread m_thread;
+		std::mutex m_mutex;
+		std::vector<unsigned __int64> m_keys; // m_mutex, cShaderCache variant key
+		std::vector<sEffect> m_effects; // render thread AddEffect(), worker copy with m_mutex
+		std::vector<sResult> m_results; // m_mutex, wait swap
+		std::vector<sResult> m_swapResults; // render thread
+		size_t m_keyCount; // render thread, last m_keys update cache size
+
+		// statistics, render thread
+		int m_reloadCount;
+		int m_failCount;
+		double m_lastLatencyMs; // change detect ~ swap
+		double m_maxLatencyMs;
+		double m_lastCompileMs;
+		double m_lastSwapMs; // Replace() time, render thread
+		std::string m_lastError;
+	};
+
+}
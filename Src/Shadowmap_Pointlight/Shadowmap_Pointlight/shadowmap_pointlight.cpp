@@ -11,36 +11,54 @@ using namespace common;
 #include "../../../../../Common/Framework11/framework11.h"
 #include "gbuffer.h"
 #include "cubedepthbuffer.h"
+#include "textureloader.h"
+#include "assetcache.h"
+#include "constantallocator.h"
+#include "framegraphd3d.h"
+#include "deferredgraph.h"
+#include "jobsystem.h"
+#include "profiler.h"
+#include "../../Shared/benchmarkrunner.h"
+#include "framearena.h"
+#include "alloctracker.h"
+#include "simdmath.h"
+#include "transformhierarchy.h"
+#include "frustumculler.h"
+#include "occlusionculler.h"
+#include "meshlod.h"
+#include "meshoptimizer.h"
+#include "meshletculler.h"
+#include "shadercache.h"
+#include "shaderreloader.h"
+#include "pipelinecache.h"
+#include "renderqueue.h"
+#include "commandbuffer.h"
+#include "cbstruct.h"
+#include "toolpanel.h"
 
 using namespace graphic;
 
 
-struct sCbDirightPS
-{
-	XMVECTOR AmbientDown;
-	XMVECTOR AmbientRange;
-};
-
-struct sCbPointLight
-{
-	XMVECTOR PointLightPos;
-	XMVECTOR PointLightRangeRcp;
-	XMVECTOR PointColor;
-
-	XMMATRIX LightProjection;
-	XMVECTOR LightPerspectiveValues;
-};
-
-struct sCbShadowmapCube
-{
-	XMMATRIX cubeViewProj[6];
-};
-
-
 static const char *g_hlslPath = "../Media/shadowmap_pointlight/hlsl.fxo";
 static const char *g_dirlightPath = "../Media/shadowmap_pointlight/dirlight.fxo";
 static const char *g_deferredShaderPath = "../Media/shadowmap_pointlight/deferredshading.fxo";
 static const char *g_shadowShaderPath = "../Media/shadowmap_pointlight/shadowgen.fxo";
+static const char *g_shaderSrcPath = "../Media/shadowmap_pointlight"; // permutation root .fx
+static const char *g_shaderVariantPath = "../Media/shadowmap_pointlight/permutation";
+static const char *g_meshPath = "../Media/ChessQueen.x";
+static const char *g_clusterBenchPath = "../Media/BoxLifter.x";
+static const char *g_texturePaths[] = {
+	"../Media/ChessColumn.dds"
+	, "../Media/white.dds"
+	, "../Media/Metal-floor.jpg"
+};
+static const char *g_pointLightScopeNames[] = { // profile scope name
+	"Point Light 0"
+	, "Point Light 1"
+	, "Point Light 2"
+	, "Point Light 3"
+};
+static const int g_shadowChunkSize = 8; // Shadow pass model per record chunk
 
 class cViewer : public framework::cGameMain
 {
@@ -59,31 +77,94 @@ public:
 
 
 protected:
+	void RenderUI();
+	void CreateFrameGraph(const UINT width, const UINT height);
+	bool CreatePipeline();
 	void GenerateShadowmap();
-	void RenderDirectionalLight();
-	void RenderPointLight(const int lightIdx);
+	void RenderGBuffer();
+	void RenderLight();
+	bool UpdateLightConstant(const int lightCount);
+	void SetDirLightConstant();
+	void SetPointLightConstant(const int lightIdx);
+	void RenderDirectionalLight(const bool isCbAlloc);
+	void RenderPointLight(const int lightIdx, const bool isShadow, const bool isCbAlloc);
+	unsigned __int64 GetShaderKey(const eShaderEffect::Enum effect, const int lightType = 0);
 
 
 public:
 	cCamera3D m_camera;
 	cGridLine m_ground;
 	cModel m_model[64];
+	cTransformHierarchy m_transforms;
+	int m_modelNodes[64]; // m_transforms node id
+	cFrustumCuller m_frustumCuller;
+	bool m_isFrustumCulling;
+	int m_visibleModels[64]; // m_model index, GBuffer pass
+	int m_visibleModelCount;
+	cOcclusionCuller m_occlusion;
+	bool m_isOcclusionCulling;
+	cMeshLod m_meshLod; // chessqueen.x LOD chain, m_model[] fallback
+	bool m_isMeshLod;
+	cMeshletCuller m_meshletCuller;
+	bool m_isClusterCulling;
+	int m_clusterLods[64]; // m_model index, Cluster Culling selected LOD
+	std::vector<cMeshletCuller::sRange> m_clusterRanges[64]; // m_model index, visible index range
+	cMeshletCuller::sStats m_clusterStats[64];
+	cMeshletCuller::sStats m_clusterFrame; // all visible model sum
+	// GBuffer batch, Shadow model chunk, cMeshLod::Record() by job system, replay in order
+	struct sRecordChunk
+	{
+		cCommandBuffer cmds;
+		cMeshLod::sDrawStats stats;
+		std::vector<cMeshletCuller::sRange> ranges; // instanced batch, m_clusterRanges union
+	};
+	std::vector<sRecordChunk> m_gbufferChunks; // m_renderQueue batch index
+	std::vector<sRecordChunk> m_shadowChunks; // g_shadowChunkSize model
+	bool m_isParallelRecord; // false: record render thread
+	cShaderCache m_shaderCache; // precompiled variant, hand compiled .fxo fallback
+	cShaderReloader m_shaderReloader;
+	bool m_isPointShadow;
+	int m_gbufferLayout; // every GBuffer writer same layout, cGridLine, cQuad hand compiled (RGB)
 	cQuad m_quad;
 	cCubeDepthBuffer m_depthBuff;
 	cImGui m_gui;
 	cGBuffer m_gbuff;
+	cAssetCache m_assetCache;
+	cTextureLoader m_texLoader;
+	int m_texIds[ARRAYSIZE(g_texturePaths)];
+	cFrameGraph m_frameGraph;
+	int m_gbufferViewRes; // frame graph output, GBuffer debug view
+	bool m_isShowGBuffer;
+	cJobSystem m_jobs;
+	cProfiler m_profiler;
+	cBenchmarkRunner m_benchmark;
+	int m_benchReadBack; // cProfiler::m_readBackCount, pass time sample once
+	cToolPanel m_tools; // benchmark, capture, replay window
+	cFrameArena m_frameArena; // transient CPU data, reset every frame
+	cAllocTracker m_allocTracker;
 
 	cConstantBuffer<sCbDirightPS> m_cbDirLight;
 	cConstantBuffer<sCbPointLight> m_cbPointLight;
 	cConstantBuffer<sCbShadowmapCube> m_cbShadowCube;	
+	cConstantBuffer<sCbInstancing> m_cbInstancing;
+	cConstantAllocator m_cbAlloc;
+	bool m_isCbAlloc; // light pass constant from m_cbAlloc, false: device not support
+	UINT m_cbUploadBytes; // light pass constant upload bytes per frame
+	UINT m_perFrameOffset;
+	UINT m_lightOffset;
+	UINT m_dirLightOffset;
+	UINT m_gbufferOffset;
+	UINT m_pointLightOffset[4];
 	Vector3 m_ambientDown;
 	Vector3 m_ambientUp;
-	ID3D11RasterizerState* m_pNoDepthClipFrontRS;
-	ID3D11RasterizerState* m_pShadowGenRS;
-	ID3D11DepthStencilState* m_pShadowGenDepthState;
-	ID3D11DepthStencilState* m_pNoDepthWriteLessStencilMaskState;
-	ID3D11DepthStencilState* m_pNoDepthWriteGreatherStencilMaskState;
-	ID3D11BlendState* m_pAdditiveBlendState;
+	cPipelineCache m_pipelineCache;
+	cRenderQueue m_renderQueue; // GBuffer pass, visible model
+	int m_psoDefault; // D3D11 default state, pass end
+	int m_psoShadow;
+	int m_psoGBuffer;
+	int m_psoGBufferInst; // INSTANCING variant, cRenderQueue batch
+	int m_psoDirLight;
+	int m_psoPointLight[2]; // m_isPointShadow off, on
 
 	int m_renderType; //0=new, 1=old
 	bool m_isAnimate;
@@ -109,10 +190,31 @@ cViewer::cViewer()
 	, m_renderType(0)
 	, m_target(0, 0, 0)
 	, m_isAnimate(false)
-	, m_pNoDepthWriteLessStencilMaskState(NULL)
-	, m_pNoDepthWriteGreatherStencilMaskState(NULL)
+	, m_benchReadBack(0)
+	, m_isCbAlloc(false)
+	, m_cbUploadBytes(0)
+	, m_gbufferViewRes(-1)
+	, m_isShowGBuffer(false)
+	, m_isFrustumCulling(true)
+	, m_visibleModelCount(0)
+	, m_isOcclusionCulling(true)
+	, m_isMeshLod(true)
+	, m_isClusterCulling(true)
+	, m_isParallelRecord(true)
+	, m_isPointShadow(true)
+	, m_gbufferLayout(cShaderPermutation::GBUFFER_LAYOUT_RGB)
+	, m_psoDefault(cPipelineCache::INVALID)
+	, m_psoShadow(cPipelineCache::INVALID)
+	, m_psoGBuffer(cPipelineCache::INVALID)
+	, m_psoGBufferInst(cPipelineCache::INVALID)
+	, m_psoDirLight(cPipelineCache::INVALID)
 {
 	m_windowName = L"DX11 Shadowmap - Point Light";
+	ZeroMemory(m_clusterLods, sizeof(m_clusterLods));
+	ZeroMemory(m_clusterStats, sizeof(m_clusterStats));
+	ZeroMemory(&m_clusterFrame, sizeof(m_clusterFrame));
+	m_psoPointLight[0] = cPipelineCache::INVALID;
+	m_psoPointLight[1] = cPipelineCache::INVALID;
 	const RECT r = { 0, 0, 1280, 960 };
 	m_windowRect = r;
 	m_moveLen = 0;
@@ -126,11 +228,14 @@ cViewer::cViewer()
 
 cViewer::~cViewer()
 {
-	SAFE_RELEASE(m_pNoDepthWriteLessStencilMaskState);
-	SAFE_RELEASE(m_pNoDepthWriteGreatherStencilMaskState);
-	SAFE_RELEASE(m_pNoDepthClipFrontRS);
-	SAFE_RELEASE(m_pShadowGenRS);
-	SAFE_RELEASE(m_pAdditiveBlendState);
+	m_texLoader.Clear();
+	m_tools.Clear();
+	m_meshLod.Clear();
+	m_shaderReloader.Clear();
+	m_pipelineCache.Clear();
+	m_shaderCache.Clear();
+	m_jobs.Clear();
+	m_profiler.Clear();
 	graphic::ReleaseRenderer();
 }
 
@@ -151,9 +256,48 @@ bool cViewer::OnInit()
 
 	m_gui.Init(m_hWnd, m_renderer.GetDevice(), m_renderer.GetDevContext(), NULL);
 
+	// request texture, never block, placeholder texture until upload finish
+	m_assetCache.Create("../Media/cache");
+	m_texLoader.m_cache = &m_assetCache;
+	m_texLoader.Create(m_renderer);
+	for (int i = 0; i < ARRAYSIZE(g_texturePaths); ++i)
+		m_texIds[i] = m_texLoader.Load(g_texturePaths[i]);
+
+	// chessqueen.x -> .mesh (LOD chain), import once, cached
+	{
+		std::string meshFileName;
+		std::vector<sMeshData> lods;
+		if (cMeshImporter::Import(g_meshPath, meshFileName, &m_assetCache)
+			&& cMeshImporter::ReadMesh(meshFileName.c_str(), lods))
+			m_meshLod.Create(m_renderer, lods);
+	}
+
 	m_cbDirLight.Create(m_renderer);
 	m_cbPointLight.Create(m_renderer);
 	m_cbShadowCube.Create(m_renderer);
+	m_cbInstancing.Create(m_renderer);
+	m_isCbAlloc = m_cbAlloc.Create(m_renderer);
+
+	m_profiler.Create(m_renderer);
+	m_frameArena.Create();
+	m_frameGraph.m_arena = &m_frameArena;
+	m_jobs.Create();
+	m_tools.Create(m_renderer, m_jobs.GetWorkerCount());
+	m_occlusion.Create();
+	m_renderQueue.Reserve(64);
+
+	// shader variant, load used variant only
+	m_shaderCache.Create(m_renderer, g_shaderVariantPath);
+	m_shaderCache.Get(GetShaderKey(eShaderEffect::GBUFFER));
+	m_shaderCache.Get(GetShaderKey(eShaderEffect::LIGHT, cShaderPermutation::LIGHT_TYPE_DIRECTIONAL));
+	m_shaderCache.Get(GetShaderKey(eShaderEffect::LIGHT, cShaderPermutation::LIGHT_TYPE_POINT));
+	m_shaderReloader.Create("../Media", g_shaderSrcPath, g_shaderVariantPath);
+	m_shaderReloader.AddEffect(g_hlslPath, 0);
+	m_shaderReloader.AddEffect(g_dirlightPath, 0);
+	m_shaderReloader.AddEffect(g_deferredShaderPath
+		, eVertexType::POSITION | eVertexType::NORMAL | eVertexType::TEXTURE0);
+	m_shaderReloader.AddEffect(g_shadowShaderPath
+		, eVertexType::POSITION | eVertexType::NORMAL | eVertexType::TEXTURE0);
 
 	GetMainLight().Init(cLight::LIGHT_DIRECTIONAL,
 		Vector4(0.f, 0.f, 0.f, 1), Vector4(0.f, 0.f, 0.f, 1),
@@ -176,6 +320,12 @@ bool cViewer::OnInit()
 	m_innerAngle = ANGLE2RAD(45);
 	m_outerAngle = ANGLE2RAD(55);
 
+	// model world matrix from transform hierarchy
+	// board root -> 64 chess queen, m_model[].m_transform identity
+	Matrix44 identity;
+	identity.SetIdentity();
+	const int boardNode = m_transforms.AddNode(-1, identity);
+
 	int idx = 0;
 	for (int x = 0; x < 8; ++x)
 	{
@@ -184,9 +334,13 @@ bool cViewer::OnInit()
 			m_model[idx].Create(m_renderer, 0, "chessqueen.x");
 			m_model[idx].SetRenderFlag(eRenderFlag::ALPHABLEND, false);
 			m_model[idx].SetRenderFlag(eRenderFlag::NOALPHABLEND, true);
-			m_model[idx].m_transform.pos = Vector3((x - 4)*1.f, 0, (z - 4)*1.f);
-			m_model[idx].m_transform.pos.y = 0.1f;
-			m_model[idx].m_transform.scale *= 10.f;
+
+			Transform tfm;
+			tfm.pos = Vector3((x - 4)*1.f, 0.1f, (z - 4)*1.f);
+			tfm.scale *= 10.f;
+			m_modelNodes[idx] = m_transforms.AddNode(boardNode, tfm.GetMatrix());
+			// chessqueen.x bounding sphere, model space
+			m_transforms.SetBounds(m_modelNodes[idx], Vector3(0, 0.066f, 0.003f), 0.081f);
 			++idx;
 		}
 	}
@@ -198,73 +352,44 @@ bool cViewer::OnInit()
 	m_quad.m_transform.pos.y = 0.1f;
 
 	m_gbuff.Create(m_renderer, (UINT)WINSIZE_X, (UINT)WINSIZE_Y);
+	CreateFrameGraph((UINT)WINSIZE_X, (UINT)WINSIZE_Y);
 
 	cViewport vp;
 	vp.Create(0, 0, 1024, 1024, 0.f, 1.f);
 	m_depthBuff.Create(m_renderer, vp, false);
 
 
-	D3D11_DEPTH_STENCIL_DESC descDepth;
-	descDepth.DepthEnable = TRUE;
-	descDepth.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
-	descDepth.DepthFunc = D3D11_COMPARISON_LESS;
-	descDepth.StencilEnable = TRUE;
-	descDepth.StencilReadMask = D3D11_DEFAULT_STENCIL_READ_MASK;
-	descDepth.StencilWriteMask = D3D11_DEFAULT_STENCIL_WRITE_MASK;
-	const D3D11_DEPTH_STENCILOP_DESC noSkyStencilOp = { D3D11_STENCIL_OP_KEEP
-		, D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_COMPARISON_EQUAL };
-	descDepth.FrontFace = noSkyStencilOp;
-	descDepth.BackFace = noSkyStencilOp;
-	if (FAILED(m_renderer.GetDevice()->CreateDepthStencilState(&descDepth, &m_pNoDepthWriteLessStencilMaskState)))
+	// rasterizer, depth stencil, blend state, dedup, create parallel
+	if (!CreatePipeline())
 		return false;
 
-	descDepth.DepthFunc = D3D11_COMPARISON_GREATER_EQUAL;
-	if (FAILED(m_renderer.GetDevice()->CreateDepthStencilState(&descDepth, &m_pNoDepthWriteGreatherStencilMaskState)))
-		return false;
-
-	descDepth.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
-	descDepth.StencilEnable = FALSE;
-	descDepth.DepthFunc = D3D11_COMPARISON_LESS;
-	if (FAILED(m_renderer.GetDevice()->CreateDepthStencilState(&descDepth, &m_pShadowGenDepthState)))
-		return false;
-
-	D3D11_RASTERIZER_DESC descRast = {
-		D3D11_FILL_SOLID,
-		D3D11_CULL_FRONT,
-		FALSE,
-		D3D11_DEFAULT_DEPTH_BIAS,
-		D3D11_DEFAULT_DEPTH_BIAS_CLAMP,
-		D3D11_DEFAULT_SLOPE_SCALED_DEPTH_BIAS,
-		TRUE,
-		FALSE,
-		FALSE,
-		FALSE
-	};
-	descRast.CullMode = D3D11_CULL_FRONT;
-	if (FAILED(m_renderer.GetDevice()->CreateRasterizerState(&descRast, &m_pNoDepthClipFrontRS)))
-		return false;
+	// mesh statistic mode, vertex cache ACMR/ATVR per LOD, write and exit
+	//	- command line: -meshstats
+	if (strstr(GetCommandLineA(), "-meshstats"))
+	{
+		cMeshOptimizer::Report(g_meshPath, "mesh_stats.txt");
+		PostMessage(m_hWnd, WM_CLOSE, 0, 0);
+		return true;
+	}
 
-	descRast.CullMode = D3D11_CULL_BACK;
-	descRast.FillMode = D3D11_FILL_SOLID;
-	descRast.DepthBias = 85;
-	descRast.SlopeScaledDepthBias = 5.0f;
-	if (FAILED(m_renderer.GetDevice()->CreateRasterizerState(&descRast, &m_pShadowGenRS)))
-		return false;
+	// offline shader variant compile, all permutation, report and exit
+	//	- command line: -compileshaders
+	if (strstr(GetCommandLineA(), "-compileshaders"))
+	{
+		cShaderPermutation::sCompileResult result;
+		cShaderPermutation::CompileAll(m_jobs, g_shaderSrcPath, g_shaderVariantPath, result);
+		cShaderPermutation::Report(result, "shader_permutation.txt");
+		PostMessage(m_hWnd, WM_CLOSE, 0, 0);
+		return true;
+	}
 
-	D3D11_BLEND_DESC descBlend;
-	descBlend.AlphaToCoverageEnable = FALSE;
-	descBlend.IndependentBlendEnable = FALSE;
-	const D3D11_RENDER_TARGET_BLEND_DESC defaultRenderTargetBlendDesc =
+	// benchmark mode, scripted camera orbit, light animation, no input
+	if (m_benchmark.Init(GetCommandLineA(), "Shadowmap_Pointlight"))
 	{
-		TRUE,
-		D3D11_BLEND_ONE, D3D11_BLEND_ONE, D3D11_BLEND_OP_ADD,
-		D3D11_BLEND_ONE, D3D11_BLEND_ONE, D3D11_BLEND_OP_ADD,
-		D3D11_COLOR_WRITE_ENABLE_ALL,
-	};
-	for (UINT i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; ++i)
-		descBlend.RenderTarget[i] = defaultRenderTargetBlendDesc;
-	if (FAILED(m_renderer.GetDevice()->CreateBlendState(&descBlend, &m_pAdditiveBlendState)))
-		return false;
+		m_isAnimate = true;
+		const float center[3] = { 0, 0, 0 };
+		m_benchmark.AddOrbit(center, 10.f, 4.f, 8.f);
+	}
 
 	return true;
 }
@@ -285,11 +410,164 @@ const Vector3 GammaToLinear(const Vector3& color)
 void cViewer::OnRender(const float deltaSeconds)
 {
 	cAutoCam cam(&m_camera);
-	ID3D11DeviceContext *devContext = m_renderer.GetDevContext();
 
+	// benchmark mode, fixed delta time
+	const float dt = m_benchmark.m_isRun ? m_benchmark.GetDeltaSeconds() : deltaSeconds;
+	if (m_benchmark.m_isRun)
+	{
+		float eyePos[3], lookAt[3];
+		m_benchmark.GetCamera(eyePos, lookAt);
+		m_camera.SetCamera(Vector3(eyePos[0], eyePos[1], eyePos[2])
+			, Vector3(lookAt[0], lookAt[1], lookAt[2]), Vector3(0, 1, 0));
+	}
+
+	m_tools.BeginFrame(m_renderer); // frame capture
+
+	m_frameArena.Reset();
+	m_allocTracker.BeginFrame();
+	m_profiler.BeginFrame(m_renderer);
 	m_gui.NewFrame();
+	m_cbUploadBytes = 0;
+
+	// upload decoded texture, bounded per frame
+	{
+		cAutoProfile prof(m_profiler, m_renderer, "Texture Upload");
+		m_texLoader.Update(m_renderer);
+	}
+
+	// shader hot reload, swap recompiled variant, effect at frame boundary
+	m_shaderReloader.Update(m_renderer, m_shaderCache);
+	m_pipelineCache.Invalidate(); // ImGui, previous frame state
+
+	RenderUI();
+
+	// Animation
+	{
+		const float angle = dt * 1.f * (m_isAnimate ? 1.0f : 0.f);
+		Matrix44 tm;
+		tm.SetRotationY(angle);
+
+		cSimdMath::TransformPoints(&tm.m[0][0], m_PointLightPos, 4, m_PointLightPos);
+		for (int i = 0; i < 4; ++i)
+		{
+			const Vector3 lightPos = m_PointLightPos[i];
+			const Vector3 lightLookat(0, 0, 0);
+			const Vector3 lightDir = (lightLookat - lightPos).Normal();
+			m_PointLightDir[i] = lightDir;
+			m_PointLight[i].SetPosition(lightPos);
+			m_PointLight[i].SetDirection(lightDir);
+		}
+	}
 
-	// UI
+	// static scene, no recompute after first frame
+	m_transforms.Update();
+
+	// view frustum culling, model bounding sphere
+	// model node continuous in m_transforms (m_modelNodes[0] ~ [63])
+	// shadow pass not culled, caster out of view cast shadow
+	{
+		cAutoProfile prof(m_profiler, m_renderer, "Frustum Culling");
+		if (m_isFrustumCulling)
+		{
+			const int first = m_modelNodes[0];
+			m_frustumCuller.SetFrustum(&GetMainCamera().GetViewProjectionMatrix().m[0][0]);
+			m_visibleModelCount = m_frustumCuller.Cull(&m_transforms.m_boundX[first]
+				, &m_transforms.m_boundY[first], &m_transforms.m_boundZ[first]
+				, &m_transforms.m_boundR[first], 64, m_visibleModels);
+		}
+		else
+		{
+			for (int i = 0; i < 64; ++i)
+				m_visibleModels[i] = i;
+			m_visibleModelCount = 64;
+		}
+	}
+
+	// software occlusion culling, frustum visible model
+	// occluder: chessqueen.x inner box (model space), occludee: bounding sphere
+	if (m_isOcclusionCulling)
+	{
+		cAutoProfile prof(m_profiler, m_renderer, "Occlusion Culling");
+		const float boxCenter[3] = { 0, 0.045f, 0.003f };
+		const float boxHalfSize[3] = { 0.008f, 0.035f, 0.008f };
+		m_occlusion.Begin(&GetMainCamera().GetViewProjectionMatrix().m[0][0]);
+		for (int k = 0; k < m_visibleModelCount; ++k)
+			m_occlusion.AddBox(&m_transforms.GetWorld(m_modelNodes[m_visibleModels[k]]).m[0][0]
+				, boxCenter, boxHalfSize);
+		m_occlusion.Rasterize(m_jobs);
+
+		const int first = m_modelNodes[0];
+		m_visibleModelCount = m_occlusion.Cull(&m_transforms.m_boundX[first]
+			, &m_transforms.m_boundY[first], &m_transforms.m_boundZ[first]
+			, &m_transforms.m_boundR[first], m_visibleModels, m_visibleModelCount
+			, m_visibleModels);
+	}
+
+	// meshlet cluster culling, visible model, GBuffer pass index range
+	ZeroMemory(&m_clusterFrame, sizeof(m_clusterFrame));
+	if (m_isMeshLod && m_isClusterCulling && !m_meshLod.m_lods.empty())
+	{
+		cAutoProfile prof(m_profiler, m_renderer, "Cluster Culling");
+		const Vector3 eyePos = GetMainCamera().GetEyePos();
+		const float projScale = GetMainCamera().GetProjectionMatrix().m[1][1]
+			* (float)(m_windowRect.bottom - m_windowRect.top) * 0.5f;
+		m_meshletCuller.Begin(GetMainCamera().GetViewProjectionMatrix(), eyePos);
+
+		m_jobs.ParallelFor(m_visibleModelCount, 4, [&](const int begin, const int end, const int) {
+			for (int k = begin; k < end; ++k)
+			{
+				const int i = m_visibleModels[k];
+				const int node = m_modelNodes[i];
+				const float size = cMeshLod::GetScreenSize(Vector3(m_transforms.m_boundX[node]
+					, m_transforms.m_boundY[node], m_transforms.m_boundZ[node])
+					, m_transforms.m_boundR[node], eyePos, projScale);
+				m_clusterLods[i] = m_meshLod.SelectLod(size);
+				m_meshletCuller.Cull(m_meshLod.m_lods[m_clusterLods[i]].clusters
+					, m_transforms.GetWorld(node), m_clusterRanges[i], m_clusterStats[i]);
+			}
+		});
+
+		for (int k = 0; k < m_visibleModelCount; ++k)
+			cMeshletCuller::AddStats(m_clusterStats[m_visibleModels[k]], m_clusterFrame);
+	}
+
+	// Shadow -> GBuffer -> Lighting -> (GBuffer Debug) -> Composite
+	m_meshLod.ResetStats();
+	m_frameGraph.SetOutput(m_gbufferViewRes, m_isShowGBuffer);
+	m_frameGraph.Compile();
+	cD3DFrameGraphExecutor executor(m_renderer);
+	m_frameGraph.Execute(&executor);
+
+	m_renderer.EndScene();
+	m_profiler.EndFrame(m_renderer);
+	m_tools.EndFrame();
+	m_renderer.Present();
+	m_allocTracker.EndFrame();
+
+	if (m_benchmark.m_isRun)
+	{
+		// pass time, only new read back result
+		if (m_benchReadBack != m_profiler.m_readBackCount)
+		{
+			m_benchReadBack = m_profiler.m_readBackCount;
+			if (m_benchmark.IsMeasureFrame())
+				for (auto &result : m_profiler.m_results)
+					m_benchmark.AddPassSample(result.name, result.cpuLastMs
+						, result.gpuLastMs, result.allocCount);
+		}
+
+		m_benchmark.EndFrame(m_allocTracker.m_frameAllocs);
+
+		if (!m_benchmark.m_isRun) // finish, json written
+			PostMessage(m_hWnd, WM_CLOSE, 0, 0);
+	}
+}
+
+
+// scene option, frame statistic
+// benchmark, capture, replay: cToolPanel
+void cViewer::RenderUI()
+{
 	if (ImGui::Begin("Information", NULL, ImVec2(300, 600)))
 	{
 		ImGui::Checkbox("Animate", &m_isAnimate);
@@ -303,28 +581,235 @@ void cViewer::OnRender(const float deltaSeconds)
 		ImGui::ColorEdit3("Ambient Up", (float*)&m_ambientUp);
 		ImGui::DragFloat("Specular Intensity Exp", &GetMainLight().m_specExp, 0.001f, 0.f, 200.f);
 		ImGui::DragFloat("Specular Intensity", &GetMainLight().m_specIntensity, 0.001f, 0.f, 1.f);
-		ImGui::End();
+
+		ImGui::Separator();
+		if (m_cbAlloc.IsSupport())
+			ImGui::Checkbox("Constant Allocator", &m_isCbAlloc);
+		ImGui::Text("Light Constant Upload %d bytes/frame", m_cbUploadBytes);
+
+		ImGui::Separator();
+		ImGui::Checkbox("Show GBuffer", &m_isShowGBuffer);
+		for (auto idx : m_frameGraph.m_order)
+			ImGui::Text("Pass: %s", m_frameGraph.m_passes[idx].name.c_str());
+		ImGui::Text("Culled %d, Transient %d KB, Aliasing %d KB", m_frameGraph.m_culledCount
+			, m_frameGraph.m_transientBytes / 1024, m_frameGraph.m_aliasBytes / 1024);
+
+		ImGui::Separator();
+		static const char *stateStr[] = { "None", "Queued", "Loading", "Staging", "Complete", "Failed" };
+		for (int i = 0; i < ARRAYSIZE(g_texturePaths); ++i)
+		{
+			const int id = m_texIds[i];
+			const bool isFinish = m_texLoader.IsLoadFinish(id);
+			ImGui::Text("%s : %s, %.1f ms, %d KB", g_texturePaths[i]
+				, stateStr[m_texLoader.GetState(id)]
+				, isFinish ? m_texLoader.m_textures[id]->loadTime : 0.f
+				, isFinish ? m_texLoader.m_textures[id]->gpuBytes / 1024 : 0);
+		}
+		ImGui::Text("Upload %d KB/frame, Staging %d KB"
+			, m_texLoader.m_uploadBytes / 1024, m_texLoader.m_stagingBytes / 1024);
+		ImGui::Text("Asset Cache hit %d, miss %d"
+			, m_assetCache.m_hitCount, m_assetCache.m_missCount);
+		ImGui::Text("Transform %d node, update %d (%d batch)", m_transforms.GetNodeCount()
+			, m_transforms.m_updateCount, m_transforms.m_batchCount);
+
+		// 3 frame latency, previous frame result
+		ImGui::Separator();
+		ImGui::Text("Profile (ms)           CPU      GPU  Alloc");
+		for (auto &result : m_profiler.m_results)
+			ImGui::Text("%*s%-*s %6.2f   %6.2f  %5d", result.depth * 2, "", 20 - result.depth * 2
+				, result.name, result.cpuMs, result.gpuMs, result.allocCount);
+
+		ImGui::Checkbox("Frustum Culling", &m_isFrustumCulling);
+		ImGui::Checkbox("Occlusion Culling", &m_isOcclusionCulling);
+		ImGui::Text("Model visible %d, culled %d", m_visibleModelCount, 64 - m_visibleModelCount);
+		if (m_isOcclusionCulling)
+			ImGui::Text("Occluded %d, raster %.3f ms (%d tri)", m_occlusion.m_occludedCount
+				, m_occlusion.m_rasterMs, m_occlusion.m_triangleCount);
+		ImGui::Checkbox("Mesh LOD", &m_isMeshLod);
+		ImGui::Checkbox("Parallel Record", &m_isParallelRecord);
+		if (!m_meshLod.m_lods.empty())
+		{
+			ImGui::Text("LOD %d draw, %d tri/frame (%d/%d/%d/%d)", m_meshLod.m_drawCount
+				, m_meshLod.m_triangleCount, m_meshLod.m_lodDrawCount[0], m_meshLod.m_lodDrawCount[1]
+				, m_meshLod.m_lodDrawCount[2], m_meshLod.m_lodDrawCount[3]);
+			if (m_meshLod.IsPacked())
+			{
+				const cVertexCodec::sError &e = m_meshLod.m_codecError;
+				ImGui::Checkbox("Vertex Compression", &m_meshLod.m_isPacked);
+				ImGui::Text("Vertex 32 -> 16 bytes (shadow 8), %d KB -> %d KB"
+					, m_meshLod.m_vertexBytes / 1024, m_meshLod.m_packedBytes / 1024);
+				ImGui::Text("Error pos %.2e, normal %.4f deg, uv %.2e, %s", e.position
+					, e.normal, e.uv, e.isValid ? "in bound" : "out of bound");
+			}
+
+			ImGui::Checkbox("Cluster Culling", &m_isClusterCulling);
+			if (m_isClusterCulling)
+			{
+				ImGui::Text("Cluster %d/%d, tri %d/%d", m_clusterFrame.visibleCluster
+					, m_clusterFrame.clusterCount, m_clusterFrame.visibleTriangle
+					, m_clusterFrame.triangleCount);
+				ImGui::Text("Removed tri, frustum %d, backface %d", m_clusterFrame.frustumTriangle
+					, m_clusterFrame.coneTriangle);
+			}
+		}
+		ImGui::Checkbox("Point Light Shadow", &m_isPointShadow);
+		ImGui::Text("Pipeline %d, state rs %d, ds %d, blend %d, dedup %.0f%%"
+			, (int)m_pipelineCache.m_pipelines.size(), (int)m_pipelineCache.m_rasterizers.size()
+			, (int)m_pipelineCache.m_depthStencils.size(), (int)m_pipelineCache.m_blends.size()
+			, m_pipelineCache.GetHitRate() * 100.f);
+		ImGui::Text("  bind %d, redundant %d, build %.2f ms", m_pipelineCache.m_bindCount
+			, m_pipelineCache.m_skipCount, m_pipelineCache.m_buildMs);
+		ImGui::Text("Render queue %d draw, %d batch, sort %.3f ms", (int)m_renderQueue.m_items.size()
+			, (int)m_renderQueue.m_batches.size(), m_renderQueue.m_sortMs);
+		ImGui::Text("Shader variant %d loaded, %d missing, %.2f ms", m_shaderCache.m_loadCount
+			, m_shaderCache.m_missCount, m_shaderCache.m_loadMs);
+		ImGui::Text("Hot reload %d, fail %d, latency %.1f ms (max %.1f)"
+			, m_shaderReloader.m_reloadCount, m_shaderReloader.m_failCount
+			, m_shaderReloader.m_lastLatencyMs, m_shaderReloader.m_maxLatencyMs);
+		ImGui::Text("  compile %.1f ms, swap %.2f ms", m_shaderReloader.m_lastCompileMs
+			, m_shaderReloader.m_lastSwapMs);
+		if (!m_shaderReloader.m_lastError.empty())
+			ImGui::TextWrapped("%s", m_shaderReloader.m_lastError.c_str());
+
+		// steady state: render thread zero heap allocation after warm up
+		ImGui::Text("Heap Alloc %d/frame (all thread %d), Arena peak %d KB"
+			, m_allocTracker.m_frameAllocs, m_allocTracker.m_frameAllocsAll
+			, m_frameArena.m_peak / 1024);
+		if (m_allocTracker.m_steadyFrames > 0)
+			ImGui::Text("Steady State: %s (%d/%d frame alloc, max %d)"
+				, m_allocTracker.IsSteadyState() ? "OK" : "FAIL"
+				, m_allocTracker.m_steadyAllocFrames, m_allocTracker.m_steadyFrames
+				, m_allocTracker.m_steadyMaxAllocs);
+		else
+			ImGui::Text("Steady State: warm up");
+		ImGui::SameLine();
+		if (ImGui::Button("Reset"))
+			m_allocTracker.ResetSteadyState();
 	}
+	ImGui::End();
+
+	const int first = m_modelNodes[0];
+	cToolPanel::sContext ctx;
+	ctx.jobs = &m_jobs;
+	ctx.profiler = &m_profiler;
+	ctx.assetCache = &m_assetCache;
+	ctx.texLoader = &m_texLoader;
+	ctx.texIds = m_texIds;
+	ctx.texCount = ARRAYSIZE(m_texIds);
+	ctx.gbuff = &m_gbuff;
+	ctx.pipelineCache = &m_pipelineCache;
+	ctx.psoGBuffer = m_psoGBuffer;
+	ctx.psoGBufferInst = m_psoGBufferInst;
+	ctx.cbInstancing = &m_cbInstancing;
+	ctx.meshLod = &m_meshLod;
+	ctx.frustumCuller = &m_frustumCuller;
+	ctx.meshletCuller = &m_meshletCuller;
+	ctx.boundX = &m_transforms.m_boundX[first];
+	ctx.boundY = &m_transforms.m_boundY[first];
+	ctx.boundZ = &m_transforms.m_boundZ[first];
+	ctx.boundR = &m_transforms.m_boundR[first];
+	ctx.modelCount = 64;
+	ctx.width = (float)(m_windowRect.right - m_windowRect.left);
+	ctx.height = (float)(m_windowRect.bottom - m_windowRect.top);
+	ctx.deferredShaderPath = g_deferredShaderPath;
+	ctx.clusterMeshPath = g_clusterBenchPath;
+	m_tools.Render(m_renderer, ctx);
+}
 
-	// Animation
-	{
-		const float angle = deltaSeconds * 1.f * (m_isAnimate ? 1.0f : 0.f);
-		Matrix44 tm;
-		tm.SetRotationY(angle);
 
-		for (int i = 0; i < 4; ++i)
+// frame graph declaration (deferredgraph.cpp), set pass function
+void cViewer::CreateFrameGraph(const UINT width, const UINT height)
+{
+	sDeferredGraph graph;
+	CreateDeferredGraph(m_frameGraph, width, height, graph);
+	m_gbufferViewRes = graph.gbufferView;
+
+	m_frameGraph.SetExecute(graph.shadowPass, [this]() { GenerateShadowmap(); });
+	m_frameGraph.SetExecute(graph.gbuffPass, [this]() { RenderGBuffer(); });
+	m_frameGraph.SetExecute(graph.lightPass, [this]() { RenderLight(); });
+
+	// culled if m_isShowGBuffer false
+	m_frameGraph.SetExecute(graph.debugPass, [this]() {
+		m_renderer.SetRenderTarget(NULL, NULL); // recovery
+		m_gbuff.Render(m_renderer);
+	});
+
+	m_frameGraph.SetExecute(graph.compositePass, [this]() {
 		{
-			const Vector3 lightPos = m_PointLightPos[i] * tm;
-			const Vector3 lightLookat(0, 0, 0);
-			const Vector3 lightDir = (lightLookat - lightPos).Normal();
-			m_PointLightPos[i] = lightPos;
-			m_PointLightDir[i] = lightDir;
-			m_PointLight[i].SetPosition(lightPos);
-			m_PointLight[i].SetDirection(lightDir);
+			cAutoProfile prof(m_profiler, m_renderer, "ImGui");
+			m_gui.Render();
 		}
+		m_renderer.RenderFPS();
+	});
+}
+
+
+// every pass pipeline, describe once, state object shared if same descriptor
+// Build() after all Add(), cJobSystem create state
+bool cViewer::CreatePipeline()
+{
+	m_pipelineCache.Create(m_renderer, &m_shaderCache);
+
+	cPipelineCache::sPipelineDesc desc;
+	cPipelineCache::GetDefault(desc);
+	m_psoDefault = m_pipelineCache.Add(desc);
+
+	// shadow caster, depth bias, shader from cShader11 or cMeshLod
+	cPipelineCache::GetDefault(desc);
+	desc.rasterizer.DepthBias = 85;
+	desc.rasterizer.SlopeScaledDepthBias = 5.0f;
+	m_psoShadow = m_pipelineCache.Add(desc);
+
+	// same with cGBuffer depth stencil, stencil mark
+	cPipelineCache::GetDefault(desc);
+	desc.shaderKey = GetShaderKey(eShaderEffect::GBUFFER);
+	desc.depthStencil.StencilEnable = TRUE;
+	const D3D11_DEPTH_STENCILOP_DESC stencilMarkOp = { D3D11_STENCIL_OP_REPLACE
+		, D3D11_STENCIL_OP_REPLACE, D3D11_STENCIL_OP_REPLACE, D3D11_COMPARISON_ALWAYS };
+	desc.depthStencil.FrontFace = stencilMarkOp;
+	desc.depthStencil.BackFace = stencilMarkOp;
+	desc.stencilRef = 1;
+	m_psoGBuffer = m_pipelineCache.Add(desc);
+
+	desc.shaderKey = cShaderPermutation::Validate(cShaderPermutation::SetOption(
+		desc.shaderKey, eShaderOption::INSTANCING, 1));
+	m_psoGBufferInst = m_pipelineCache.Add(desc);
+
+	// full screen quad, no vertex buffer, sky pixel masked by stencil
+	cPipelineCache::GetDefault(desc);
+	desc.shaderKey = GetShaderKey(eShaderEffect::LIGHT, cShaderPermutation::LIGHT_TYPE_DIRECTIONAL);
+	desc.topology = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP;
+	desc.depthStencil.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+	desc.depthStencil.StencilEnable = TRUE;
+	const D3D11_DEPTH_STENCILOP_DESC noSkyStencilOp = { D3D11_STENCIL_OP_KEEP
+		, D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_COMPARISON_EQUAL };
+	desc.depthStencil.FrontFace = noSkyStencilOp;
+	desc.depthStencil.BackFace = noSkyStencilOp;
+	desc.stencilRef = 1;
+	m_psoDirLight = m_pipelineCache.Add(desc);
+
+	// tessellated light volume, front face cull, depth greater, additive
+	desc.topology = D3D11_PRIMITIVE_TOPOLOGY_1_CONTROL_POINT_PATCHLIST;
+	desc.rasterizer.CullMode = D3D11_CULL_FRONT;
+	desc.depthStencil.DepthFunc = D3D11_COMPARISON_GREATER_EQUAL;
+	desc.blend.RenderTarget[0].BlendEnable = TRUE;
+	desc.blend.RenderTarget[0].DestBlend = D3D11_BLEND_ONE;
+	desc.blend.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+	for (int i = 0; i < 2; ++i)
+	{
+		desc.shaderKey = cShaderPermutation::Validate(cShaderPermutation::SetOption(
+			GetShaderKey(eShaderEffect::LIGHT, cShaderPermutation::LIGHT_TYPE_POINT)
+			, eShaderOption::SHADOW, i));
+		m_psoPointLight[i] = m_pipelineCache.Add(desc);
 	}
 
-	GenerateShadowmap();
+	return m_pipelineCache.Build(m_jobs);
+}
+
+
+void cViewer::RenderGBuffer()
+{
+	cAutoProfile prof(m_profiler, m_renderer, "GBuffer");
 
 	// Update Model Option
 	for (int i = 0; i < 64; ++i)
@@ -337,13 +822,6 @@ void cViewer::OnRender(const float deltaSeconds)
 	{
 		GetMainCamera().Bind(m_renderer);
 
-		for (int i = 0; i < 4; ++i)
-		{
-			m_renderer.m_dbgSphere.SetPos(m_PointLightPos[i]);
-			m_renderer.m_dbgSphere.SetRadius(0.1f);
-			m_renderer.m_dbgSphere.Render(m_renderer);
-		}
-
 		cShader11 *deferredShader = m_renderer.m_shaderMgr.LoadShader(m_renderer, g_deferredShaderPath
 			, eVertexType::POSITION | eVertexType::NORMAL | eVertexType::TEXTURE0, false);
 
@@ -351,76 +829,186 @@ void cViewer::OnRender(const float deltaSeconds)
 		deferredShader->Begin();
 		deferredShader->BeginPass(m_renderer, 0);
 
-		for (int i = 0; i < 64; ++i)
+		// mesh LOD by screen size, world bounding sphere from m_transforms
+		// cluster culling: LOD, index range from Cluster Culling
+		const bool isMeshLod = m_isMeshLod && !m_meshLod.m_lods.empty();
+		const bool isClusterCulling = isMeshLod && m_isClusterCulling;
+		const Vector3 eyePos = GetMainCamera().GetEyePos();
+		const float projScale = GetMainCamera().GetProjectionMatrix().m[1][1]
+			* (float)(m_windowRect.bottom - m_windowRect.top) * 0.5f;
+		// visible model -> render queue, pipeline, texture, LOD, front to back
+		// same LOD batch, instanced draw, cluster culling: batch visible range union
+		// batch draw recorded by job system (cCommandBuffer), replay batch order
+		if (isMeshLod)
 		{
-			if (m_model[i].m_model)
+			m_renderQueue.Reset();
+			for (int k = 0; k < m_visibleModelCount; ++k)
+			{
+				const int i = m_visibleModels[k];
+				const int node = m_modelNodes[i];
+				const Vector3 center(m_transforms.m_boundX[node], m_transforms.m_boundY[node]
+					, m_transforms.m_boundZ[node]);
+				const int lod = isClusterCulling ? m_clusterLods[i]
+					: m_meshLod.SelectLod(cMeshLod::GetScreenSize(center
+						, m_transforms.m_boundR[node], eyePos, projScale));
+				m_renderQueue.Add(cRenderQueue::MakeKey(0, m_psoGBuffer, m_texIds[0], lod
+					, center.Distance(eyePos)), (UINT)i);
+			}
+			m_renderQueue.Sort(&m_jobs);
+			m_renderQueue.Batch();
+
+			// instancing pipeline bind result, same every batch
+			// cbPerFrameInstancing bound, record target
+			ID3D11DeviceContext *devContext = m_renderer.GetDevContext();
+			const bool isInstancing = m_pipelineCache.Bind(m_renderer, m_psoGBufferInst);
+			ID3D11Buffer *cbInstancing = NULL;
+			UINT cbInstancingSize = 0;
+			if (isInstancing)
 			{
+				m_cbInstancing.Update(m_renderer, 3);
+				cbInstancing = cCommandBuffer::GetVSConstantBuffer(devContext, 3);
+				if (cbInstancing)
+				{
+					D3D11_BUFFER_DESC desc;
+					cbInstancing->GetDesc(&desc);
+					cbInstancingSize = desc.ByteWidth;
+				}
+			}
+
+			// record batch draw, any thread
+			const int batchCount = (int)m_renderQueue.m_batches.size();
+			if ((int)m_gbufferChunks.size() < batchCount)
+				m_gbufferChunks.resize(batchCount);
+			m_meshLod.BeginRecord(m_renderer);
+
+			auto record = [&](const int begin, const int end, const int) {
+				for (int b = begin; b < end; ++b)
+				{
+					const cRenderQueue::sBatch &batch = m_renderQueue.m_batches[b];
+					const cRenderQueue::sItem *items = &m_renderQueue.m_items[batch.first];
+					const int lod = cRenderQueue::GetMesh(batch.key);
+					sRecordChunk &chunk = m_gbufferChunks[b];
+					chunk.cmds.Reset();
+					ZeroMemory(&chunk.stats, sizeof(chunk.stats));
+
+					if (isInstancing && cbInstancing && (batch.count > 1))
+					{
+						BYTE *worldInst = chunk.cmds.UpdateBuffer(cbInstancing, NULL, cbInstancingSize);
+						for (UINT j = 0; j < batch.count; ++j)
+						{
+							const XMMATRIX world = XMMatrixTranspose(
+								m_transforms.GetWorld(m_modelNodes[items[j].index]).GetMatrixXM());
+							memcpy(worldInst + sizeof(XMMATRIX) * j, &world, sizeof(world));
+						}
+						chunk.cmds.SetVSConstantBuffer(3, cbInstancing);
+
+						// cluster visible in any instance, draw all instance (conservative)
+						if (isClusterCulling)
+						{
+							chunk.ranges.clear();
+							for (UINT j = 0; j < batch.count; ++j)
+							{
+								const std::vector<cMeshletCuller::sRange> &ranges = m_clusterRanges[items[j].index];
+								chunk.ranges.insert(chunk.ranges.end(), ranges.begin(), ranges.end());
+							}
+							cMeshletCuller::MergeRanges(chunk.ranges);
+						}
+						m_meshLod.RecordInstanced(chunk.cmds, lod, batch.count
+							, isClusterCulling ? &chunk.ranges : NULL, chunk.stats);
+						continue;
+					}
+
+					for (UINT j = 0; j < batch.count; ++j)
+					{
+						const int i = (int)items[j].index;
+						m_meshLod.Record(chunk.cmds, lod, m_transforms.GetWorld(m_modelNodes[i]).GetMatrixXM()
+							, false, isClusterCulling ? &m_clusterRanges[i] : NULL, chunk.stats);
+					}
+				}
+			};
+
+			if (m_isParallelRecord)
+				m_jobs.ParallelFor(batchCount, 1, record);
+			else
+				record(0, batchCount, 0);
+
+			// replay batch order, pipeline, texture bind render thread
+			for (int b = 0; b < batchCount; ++b)
+			{
+				const cRenderQueue::sBatch &batch = m_renderQueue.m_batches[b];
+				ID3D11ShaderResourceView *srv = m_texLoader.GetSRV(cRenderQueue::GetMaterial(batch.key));
+				devContext->PSSetShaderResources(0, 1, &srv);
+				m_pipelineCache.Bind(m_renderer, (isInstancing && cbInstancing && (batch.count > 1))
+					? m_psoGBufferInst : cRenderQueue::GetPipeline(batch.key));
+				m_gbufferChunks[b].cmds.Execute(devContext);
+				m_meshLod.AddStats(m_gbufferChunks[b].stats);
+			}
+		}
+		else
+		{
+			for (int k = 0; k < m_visibleModelCount; ++k)
+			{
+				const int i = m_visibleModels[k];
+				if (!m_model[i].m_model)
+					continue;
 				m_model[i].SetShader(deferredShader);
-				m_model[i].Render(m_renderer);
+				m_model[i].Render(m_renderer, m_transforms.GetWorld(m_modelNodes[i]).GetMatrixXM());
 			}
 		}
 
+		// after model, small debug sphere, large ground (early-Z reject)
+		for (int i = 0; i < 4; ++i)
+		{
+			m_renderer.m_dbgSphere.SetPos(m_PointLightPos[i]);
+			m_renderer.m_dbgSphere.SetRadius(0.1f);
+			m_renderer.m_dbgSphere.Render(m_renderer);
+		}
+
 		m_quad.m_shader = deferredShader;
 		m_quad.Render(m_renderer);
 		m_ground.Render(m_renderer);
 
 		m_gbuff.End(m_renderer);
 	}
+}
+
 
+void cViewer::RenderLight()
+{
 	// Render to Main TargetBuffer
 	m_renderer.UnbindShaderAll();
+	m_pipelineCache.Invalidate();
 	m_renderer.ClearScene();
 	m_renderer.BeginScene();
-	if (1)
 	{
 		GetMainCamera().Bind(m_renderer);
 		GetMainLight().Bind(m_renderer);
 
-		ID3D11DepthStencilState* pPrevDepthState;
-		UINT nPrevStencil;
-		devContext->OMGetDepthStencilState(&pPrevDepthState, &nPrevStencil);
-		RenderDirectionalLight();
-
-		ID3D11BlendState* pPrevBlendState;
-		FLOAT prevBlendFactor[4];
-		UINT prevSampleMask;
-		devContext->OMGetBlendState(&pPrevBlendState, prevBlendFactor, &prevSampleMask);
-		devContext->OMSetBlendState(m_pAdditiveBlendState, prevBlendFactor, prevSampleMask);
+		// frame invariant constant write once, point light constant per light
+		const int lightCount = ARRAYSIZE(m_PointLight);
+		// map, alloc fail: Update() fallback this frame only
+		const bool isCbAlloc = m_isCbAlloc && UpdateLightConstant(lightCount);
 
-		for (int i = 0; i < 1; ++i)
-			RenderPointLight(i);
+		// shadow cube map, light 0 only
+		RenderDirectionalLight(isCbAlloc);
+		for (int i = 0; i < lightCount; ++i)
+			RenderPointLight(i, m_isPointShadow && (0 == i), isCbAlloc);
 
-		devContext->OMSetBlendState(pPrevBlendState, prevBlendFactor, prevSampleMask);
-		SAFE_RELEASE(pPrevBlendState);
-
-		devContext->OMSetDepthStencilState(pPrevDepthState, nPrevStencil);
-		SAFE_RELEASE(pPrevDepthState);
+		m_pipelineCache.Bind(m_renderer, m_psoDefault);
 	}
-
-	// Render GBuffer
-	//m_renderer.SetRenderTarget(NULL, NULL); // recovery
-	//m_gbuff.Render(m_renderer);
-	//m_depthBuff.Render(m_renderer);
-
-	m_gui.Render();
-	m_renderer.RenderFPS();
-	m_renderer.EndScene();
-	m_renderer.Present();
 }
 
 
 void cViewer::GenerateShadowmap()
 {
-	ID3D11DeviceContext *devContext = m_renderer.GetDevContext();
+	cAutoProfile prof(m_profiler, m_renderer, "Shadow");
 
-	// Generate Shadowmap
-	ID3D11RasterizerState* pPrevRSState;
-	devContext->RSGetState(&pPrevRSState);
-
-	ID3D11DepthStencilState* pPrevDepthState;
-	UINT nPrevStencil;
-	devContext->OMGetDepthStencilState(&pPrevDepthState, &nPrevStencil);
+	// point light SHADOW 0 variant never sample shadow map
+	if (!m_isPointShadow && m_shaderCache.Get(
+		GetShaderKey(eShaderEffect::LIGHT, cShaderPermutation::LIGHT_TYPE_POINT)))
+		return;
 
+	// Generate Shadowmap
 	if (m_depthBuff.Begin(m_renderer))
 	{
 		cShader11 *shadowShader = m_renderer.m_shaderMgr.LoadShader(m_renderer, g_shadowShaderPath
@@ -429,8 +1017,7 @@ void cViewer::GenerateShadowmap()
 		shadowShader->SetTechnique("Unlit");
 		shadowShader->Begin();
 		shadowShader->BeginPass(m_renderer, 0);
-		devContext->RSSetState(m_pShadowGenRS);
-		devContext->OMSetDepthStencilState(m_pShadowGenDepthState, 0);
+		m_pipelineCache.Bind(m_renderer, m_psoShadow);
 
 		Matrix44 proj;
 		proj.SetProjection(MATH_PI * 0.5f, 1.0, 0.1f, m_PointLightRange);
@@ -466,12 +1053,48 @@ void cViewer::GenerateShadowmap()
 		m_cbShadowCube.m_v->cubeViewProj[5] = XMMatrixTranspose(view.GetMatrixXM() * proj.GetMatrixXM());
 		m_cbShadowCube.Update(m_renderer, 6);
 
-		for (int i = 0; i < 64; ++i)
+		// shadow caster coarser LOD, cube face 1024 pixel, 90 degree fov (projScale 512)
+		// model chunk recorded by job system (cCommandBuffer), replay chunk order
+		const bool isMeshLod = m_isMeshLod && !m_meshLod.m_lods.empty();
+		if (isMeshLod && m_meshLod.BeginRecord(m_renderer))
+		{
+			m_shadowChunks.resize((64 + g_shadowChunkSize - 1) / g_shadowChunkSize);
+
+			auto record = [&](const int begin, const int end, const int) {
+				sRecordChunk &chunk = m_shadowChunks[begin / g_shadowChunkSize];
+				chunk.cmds.Reset();
+				ZeroMemory(&chunk.stats, sizeof(chunk.stats));
+				for (int i = begin; i < end; ++i)
+				{
+					const int node = m_modelNodes[i];
+					const float size = cMeshLod::GetScreenSize(Vector3(m_transforms.m_boundX[node]
+						, m_transforms.m_boundY[node], m_transforms.m_boundZ[node])
+						, m_transforms.m_boundR[node], lightPos, 512.f);
+					m_meshLod.Record(chunk.cmds, m_meshLod.SelectLod(size, 0.5f)
+						, m_transforms.GetWorld(node).GetMatrixXM(), true, NULL, chunk.stats);
+				}
+			};
+
+			if (m_isParallelRecord)
+				m_jobs.ParallelFor(64, g_shadowChunkSize, record);
+			else
+				for (int i = 0; i < 64; i += g_shadowChunkSize)
+					record(i, min(64, i + g_shadowChunkSize), 0);
+
+			for (auto &chunk : m_shadowChunks)
+			{
+				chunk.cmds.Execute(m_renderer.GetDevContext());
+				m_meshLod.AddStats(chunk.stats);
+			}
+		}
+		else
 		{
-			if (m_model[i].m_model)
+			for (int i = 0; i < 64; ++i)
 			{
+				if (!m_model[i].m_model)
+					continue;
 				m_model[i].SetShader(shadowShader);
-				m_model[i].Render(m_renderer);
+				m_model[i].Render(m_renderer, m_transforms.GetWorld(m_modelNodes[i]).GetMatrixXM());
 			}
 		}
 
@@ -480,29 +1103,33 @@ void cViewer::GenerateShadowmap()
 		m_depthBuff.End(m_renderer);
 	}
 
-	devContext->RSSetState(pPrevRSState);
-	SAFE_RELEASE(pPrevRSState);
-
-	devContext->OMSetDepthStencilState(pPrevDepthState, nPrevStencil);
-	SAFE_RELEASE(pPrevDepthState);
+	m_pipelineCache.Bind(m_renderer, m_psoDefault);
 }
 
 
-void cViewer::RenderDirectionalLight()
+// isCbAlloc: UpdateLightConstant() success this frame, bind offset only
+void cViewer::RenderDirectionalLight(const bool isCbAlloc)
 {
+	cAutoProfile prof(m_profiler, m_renderer, "Directional Light");
 	ID3D11DeviceContext *devContext = m_renderer.GetDevContext();
-	devContext->ClearRenderTargetView(m_renderer.m_renderTargetView
-		, (float*)&Vector4(50.f / 255.f, 50.f / 255.f, 50.f / 255.f, 1.0f));
+	const Vector4 clearColor(50.f / 255.f, 50.f / 255.f, 50.f / 255.f, 1.0f);
+	devContext->ClearRenderTargetView(m_renderer.m_renderTargetView, (float*)&clearColor);
 	devContext->OMSetRenderTargets(1
 		, &m_renderer.m_renderTargetView, m_gbuff.m_DepthStencilReadOnlyDSV);
-	m_gbuff.PrepareForUnpack(m_renderer);
-
-	devContext->OMSetDepthStencilState(m_pNoDepthWriteLessStencilMaskState, 1);
+	if (!isCbAlloc)
+	{
+		m_gbuff.PrepareForUnpack(m_renderer);
+		m_cbUploadBytes += sizeof(sCbGBuffer);
+	}
 
-	cShader11 *dirLightShader = m_renderer.m_shaderMgr.LoadShader(m_renderer, g_dirlightPath, 0, false);
-	dirLightShader->SetTechnique("Unlit");
-	dirLightShader->Begin();
-	dirLightShader->BeginPass(m_renderer, 0);
+	if (!m_pipelineCache.Bind(m_renderer, m_psoDirLight))
+	{
+		cShader11 *dirLightShader = m_renderer.m_shaderMgr.LoadShader(m_renderer, g_dirlightPath, 0, false);
+		dirLightShader->SetTechnique("Unlit");
+		dirLightShader->Begin();
+		dirLightShader->BeginPass(m_renderer, 0);
+		devContext->IASetInputLayout(NULL);
+	}
 
 	ID3D11ShaderResourceView* arrViews[4] = { m_gbuff.m_DepthStencilSRV
 		, m_gbuff.m_ColorSpecIntensitySRV
@@ -510,96 +1137,169 @@ void cViewer::RenderDirectionalLight()
 		, m_gbuff.m_SpecPowerSRV };
 	devContext->PSSetShaderResources(0, 4, arrViews);
 
-	m_renderer.m_cbPerFrame.Update(m_renderer);
-	m_renderer.m_cbLight.Update(m_renderer, 1);
+	if (isCbAlloc)
+	{
+		m_cbAlloc.Bind(m_renderer, 0, m_perFrameOffset, sizeof(*m_renderer.m_cbPerFrame.m_v));
+		m_cbAlloc.Bind(m_renderer, 1, m_lightOffset, sizeof(*m_renderer.m_cbLight.m_v));
+		m_cbAlloc.Bind(m_renderer, 6, m_dirLightOffset, sizeof(sCbDirightPS));
+		m_cbAlloc.Bind(m_renderer, 7, m_gbufferOffset, sizeof(sCbGBuffer));
+	}
+	else
+	{
+		m_renderer.m_cbPerFrame.Update(m_renderer);
+		m_renderer.m_cbLight.Update(m_renderer, 1);
 
-	m_cbDirLight.m_v->AmbientDown = XMLoadFloat3((XMFLOAT3*)&GammaToLinear(m_ambientDown));
-	m_cbDirLight.m_v->AmbientRange = XMLoadFloat3((XMFLOAT3*)&(GammaToLinear(m_ambientUp) - GammaToLinear(m_ambientDown)));
-	m_cbDirLight.Update(m_renderer, 6);
-	m_gbuff.m_cbGBuffer.Update(m_renderer, 7);
+		SetDirLightConstant();
+		m_cbDirLight.Update(m_renderer, 6);
+		m_gbuff.m_cbGBuffer.Update(m_renderer, 7);
 
-	devContext->IASetInputLayout(NULL);
-	devContext->IASetVertexBuffers(0, 0, NULL, NULL, NULL);
-	devContext->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+		m_cbUploadBytes += sizeof(*m_renderer.m_cbPerFrame.m_v) + sizeof(*m_renderer.m_cbLight.m_v)
+			+ sizeof(sCbDirightPS) + sizeof(sCbGBuffer);
+	}
 
+	devContext->IASetVertexBuffers(0, 0, NULL, NULL, NULL);
 	devContext->Draw(4, 0);
-
-	ID3D11ShaderResourceView *arrRV[1] = { NULL };
-	devContext->PSSetShaderResources(4, 1, arrRV);
-	ZeroMemory(arrViews, sizeof(arrViews));
-	devContext->PSSetShaderResources(0, 4, arrViews);
 }
 
 
-void cViewer::RenderPointLight(const int lightIdx)
+// write light pass constant to m_cbAlloc, before render light
+bool cViewer::UpdateLightConstant(const int lightCount)
 {
-	const float lightRange = m_PointLightRange;
-	const Vector3 lightPos = m_PointLightPos[lightIdx];
-	const Vector3 lightDir = m_PointLightDir[lightIdx];
-	const Vector3 lightScale(lightRange, lightRange, lightRange);
-	const Vector3 lightColor = m_PointLightColor[lightIdx];
+	SetDirLightConstant();
+	m_gbuff.SetUnpackValue();
 
-	ID3D11DeviceContext *devContext = m_renderer.GetDevContext();
-	cShader11 *hlslShader = m_renderer.m_shaderMgr.LoadShader(m_renderer, g_hlslPath, 0, false);
-	hlslShader->SetTechnique("Unlit");
-	hlslShader->Begin();
-	hlslShader->BeginPass(m_renderer, 0);
+	if (!m_cbAlloc.Begin(m_renderer))
+		return false;
 
-	ID3D11RasterizerState* pPrevRSState;
-	devContext->RSGetState(&pPrevRSState);
-	devContext->RSSetState(m_pNoDepthClipFrontRS);
-	devContext->OMSetDepthStencilState(m_pNoDepthWriteGreatherStencilMaskState, 1);
+	m_perFrameOffset = m_cbAlloc.Alloc(m_renderer.m_cbPerFrame.m_v, sizeof(*m_renderer.m_cbPerFrame.m_v));
+	m_lightOffset = m_cbAlloc.Alloc(m_renderer.m_cbLight.m_v, sizeof(*m_renderer.m_cbLight.m_v));
+	m_dirLightOffset = m_cbAlloc.Alloc(m_cbDirLight.m_v, sizeof(sCbDirightPS));
+	m_gbufferOffset = m_cbAlloc.Alloc(m_gbuff.m_cbGBuffer.m_v, sizeof(sCbGBuffer));
 
-	ID3D11ShaderResourceView* arrViews[4] = { m_gbuff.m_DepthStencilSRV
-		, m_gbuff.m_ColorSpecIntensitySRV
-		, m_gbuff.m_NormalSRV
-		, m_gbuff.m_SpecPowerSRV };
-	devContext->PSSetShaderResources(0, 4, arrViews);
+	bool result = (cConstantAllocator::INVALID != m_gbufferOffset);
+	for (int i = 0; i < lightCount; ++i)
+	{
+		SetPointLightConstant(i);
+		m_pointLightOffset[i] = m_cbAlloc.Alloc(m_cbPointLight.m_v, sizeof(sCbPointLight));
+		result = result && (cConstantAllocator::INVALID != m_pointLightOffset[i]);
+	}
 
-	// Shadowmap
-	m_depthBuff.Bind(m_renderer, 4);
+	m_cbAlloc.End(m_renderer);
+	m_cbUploadBytes += m_cbAlloc.m_packer.m_uploadBytes;
+	return result;
+}
 
-	m_renderer.m_cbPerFrame.Update(m_renderer);
-	m_renderer.m_cbLight.Update(m_renderer, 1);
 
-	m_cbDirLight.m_v->AmbientDown = XMLoadFloat3((XMFLOAT3*)&GammaToLinear(m_ambientDown));
-	m_cbDirLight.m_v->AmbientRange = XMLoadFloat3((XMFLOAT3*)&(GammaToLinear(m_ambientUp) - GammaToLinear(m_ambientDown)));
-	m_cbDirLight.Update(m_renderer, 6);
-	m_gbuff.m_cbGBuffer.Update(m_renderer, 7);
+void cViewer::SetDirLightConstant()
+{
+	const Vector3 ambientDown = GammaToLinear(m_ambientDown);
+	const Vector3 ambientRange = GammaToLinear(m_ambientUp) - ambientDown;
+	m_cbDirLight.m_v->AmbientDown = XMLoadFloat3((const XMFLOAT3*)&ambientDown);
+	m_cbDirLight.m_v->AmbientRange = XMLoadFloat3((const XMFLOAT3*)&ambientRange);
+}
+
+
+void cViewer::SetPointLightConstant(const int lightIdx)
+{
+	const float lightRange = m_PointLightRange;
+	const Vector3 lightPos = m_PointLightPos[lightIdx];
+	const Vector3 lightDir = m_PointLightDir[lightIdx];
+	const Vector3 lightScale(lightRange, lightRange, lightRange);
+	const Vector3 lightColor = m_PointLightColor[lightIdx];
 
 	m_cbPointLight.m_v->PointLightPos = lightPos.GetVectorXM();
 	m_cbPointLight.m_v->PointLightRangeRcp = (Vector3(1, 1, 1) * (1.f / lightRange)).GetVectorXM();
 	m_cbPointLight.m_v->PointColor = GammaToLinear(lightColor).GetVectorXM();
 
-	auto ret = m_PointLight[lightIdx].GetShadowMatrix(2.f * m_outerAngle, 1.f, 0.1f, m_PointLightRange);
-
 	Transform lightTfm;
 	lightTfm.scale = lightScale;
 	lightTfm.pos = lightPos;
 	lightTfm.rot.SetRotationArc(Vector3(0, 0, 1), lightDir);
-	const Matrix44 lightProj = lightTfm.GetMatrix() * GetMainCamera().GetViewProjectionMatrix();
-	m_cbPointLight.m_v->LightProjection = XMMatrixTranspose(lightProj.GetMatrixXM());
+	const Matrix44 lightTm = lightTfm.GetMatrix();
+	const Matrix44 &viewProj = GetMainCamera().GetViewProjectionMatrix();
+	cSimdMath::MultiplyTranspose(&lightTm.m[0][0], &viewProj.m[0][0]
+		, (float*)&m_cbPointLight.m_v->LightProjection);
 
 	Matrix44 pointProj;
 	pointProj.SetProjection(MATH_PI*0.5f, 1.f, 0.1f, m_PointLightRange);
 	const Vector3 perspectiveValue(pointProj.m[2][2], pointProj.m[3][2], 0);
 	m_cbPointLight.m_v->LightPerspectiveValues = perspectiveValue.GetVectorXM();
+}
 
-	m_cbPointLight.Update(m_renderer, 8);
 
-	devContext->IASetInputLayout(NULL);
+// isShadow: sample m_depthBuff, SHADOW 1 variant
+// isCbAlloc: UpdateLightConstant() success this frame, bind offset only
+void cViewer::RenderPointLight(const int lightIdx, const bool isShadow, const bool isCbAlloc)
+{
+	cAutoProfile prof(m_profiler, m_renderer, g_pointLightScopeNames[lightIdx]);
+	ID3D11DeviceContext *devContext = m_renderer.GetDevContext();
+	if (!m_pipelineCache.Bind(m_renderer, m_psoPointLight[isShadow ? 1 : 0]))
+	{
+		// hand compiled hlsl.fxo always sample light 0 shadow map, skip other light
+		if (0 != lightIdx)
+			return;
+
+		cShader11 *hlslShader = m_renderer.m_shaderMgr.LoadShader(m_renderer, g_hlslPath, 0, false);
+		hlslShader->SetTechnique("Unlit");
+		hlslShader->Begin();
+		hlslShader->BeginPass(m_renderer, 0);
+		devContext->IASetInputLayout(NULL);
+	}
+
+	ID3D11ShaderResourceView* arrViews[4] = { m_gbuff.m_DepthStencilSRV
+		, m_gbuff.m_ColorSpecIntensitySRV
+		, m_gbuff.m_NormalSRV
+		, m_gbuff.m_SpecPowerSRV };
+	devContext->PSSetShaderResources(0, 4, arrViews);
+
+	// Shadowmap
+	m_depthBuff.Bind(m_renderer, 4);
+
+	if (isCbAlloc)
+	{
+		// frame invariant constant already written, bind only
+		m_cbAlloc.Bind(m_renderer, 0, m_perFrameOffset, sizeof(*m_renderer.m_cbPerFrame.m_v));
+		m_cbAlloc.Bind(m_renderer, 1, m_lightOffset, sizeof(*m_renderer.m_cbLight.m_v));
+		m_cbAlloc.Bind(m_renderer, 6, m_dirLightOffset, sizeof(sCbDirightPS));
+		m_cbAlloc.Bind(m_renderer, 7, m_gbufferOffset, sizeof(sCbGBuffer));
+		m_cbAlloc.Bind(m_renderer, 8, m_pointLightOffset[lightIdx], sizeof(sCbPointLight));
+	}
+	else
+	{
+		m_renderer.m_cbPerFrame.Update(m_renderer);
+		m_renderer.m_cbLight.Update(m_renderer, 1);
+
+		SetDirLightConstant();
+		m_cbDirLight.Update(m_renderer, 6);
+		m_gbuff.m_cbGBuffer.Update(m_renderer, 7);
+
+		SetPointLightConstant(lightIdx);
+		m_cbPointLight.Update(m_renderer, 8);
+
+		m_cbUploadBytes += sizeof(*m_renderer.m_cbPerFrame.m_v) + sizeof(*m_renderer.m_cbLight.m_v)
+			+ sizeof(sCbDirightPS) + sizeof(sCbGBuffer) + sizeof(sCbPointLight);
+	}
+
 	devContext->IASetVertexBuffers(0, 0, NULL, NULL, NULL);
-	devContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_1_CONTROL_POINT_PATCHLIST);
 	devContext->Draw(2, 0);
 
-	devContext->RSSetState(pPrevRSState);
-	SAFE_RELEASE(pPrevRSState);
-
-	ID3D11ShaderResourceView *arrRV[1] = { NULL };
-	devContext->PSSetShaderResources(4, 1, arrRV);
-	ZeroMemory(arrViews, sizeof(arrViews));
-	devContext->PSSetShaderResources(0, 4, arrViews);
 	m_renderer.UnbindShaderAll();
+	m_pipelineCache.Invalidate(); // shader unbind
+}
+
+
+// current render option -> permutation key
+// lightType: eShaderEffect::LIGHT only
+unsigned __int64 cViewer::GetShaderKey(const eShaderEffect::Enum effect
+	, const int lightType //= 0
+)
+{
+	unsigned __int64 key = cShaderPermutation::MakeKey(effect);
+	key = cShaderPermutation::SetOption(key, eShaderOption::LIGHT_TYPE, lightType);
+	key = cShaderPermutation::SetOption(key, eShaderOption::SHADOW, m_isPointShadow ? 1 : 0);
+	key = cShaderPermutation::SetOption(key, eShaderOption::INSTANCING, 0);
+	key = cShaderPermutation::SetOption(key, eShaderOption::GBUFFER_LAYOUT, m_gbufferLayout);
+	return cShaderPermutation::Validate(key);
 }
 
 
@@ -613,6 +1313,10 @@ void cViewer::OnLostDevice()
 
 void cViewer::OnShutdown()
 {
+	m_texLoader.Clear();
+	m_tools.Clear();
+	m_shaderReloader.Clear();
+	m_jobs.Clear();
 }
 
 
@@ -651,6 +1355,9 @@ void cViewer::UpdateLookAt()
 
 void cViewer::OnMessageProc(UINT message, WPARAM wParam, LPARAM lParam)
 {
+	if (m_benchmark.m_isRun) // scripted camera, ignore input
+		return;
+
 	m_gui.WndProcHandler(m_hWnd, message, wParam, lParam);
 	if (ImGui::IsAnyItemHovered())
 	{
@@ -0,0 +1,95 @@
+
+// AVX kernel, this file only compiled with /arch:AVX (-mavx)
+// no Common, STL include, inline function from other header can't get VEX encoded copy
+#ifndef OUT
+	#define OUT
+#endif
+#include "simdcpu.h"
+#ifdef SIMD_MATH_AVX_DISPATCH
+	#include <immintrin.h>
+#endif
+
+using namespace graphic;
+
+
+#ifdef SIMD_MATH_AVX_DISPATCH
+namespace
+{
+	// append set bit index, base + bit
+	inline int WriteMask(int mask, const int base, OUT int *visible)
+	{
+		int n = 0;
+		while (mask)
+		{
+			int bit = 0;
+			while (!(mask & (1 << bit)))
+				++bit;
+			visible[n++] = base + bit;
+			mask &= mask - 1;
+		}
+		return n;
+	}
+}
+#endif
+
+
+int cSimdCpu::TransformPointsAvx(const float *m, const float *x, const float *y
+	, const float *z, const int count, OUT float *outX, OUT float *outY, OUT float *outZ)
+{
+	int i = 0;
+#ifdef SIMD_MATH_AVX_DISPATCH
+	const __m256 m00 = _mm256_set1_ps(m[0]), m01 = _mm256_set1_ps(m[1]), m02 = _mm256_set1_ps(m[2]);
+	const __m256 m10 = _mm256_set1_ps(m[4]), m11 = _mm256_set1_ps(m[5]), m12 = _mm256_set1_ps(m[6]);
+	const __m256 m20 = _mm256_set1_ps(m[8]), m21 = _mm256_set1_ps(m[9]), m22 = _mm256_set1_ps(m[10]);
+	const __m256 m30 = _mm256_set1_ps(m[12]), m31 = _mm256_set1_ps(m[13]), m32 = _mm256_set1_ps(m[14]);
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 vx = _mm256_loadu_ps(x + i);
+		const __m256 vy = _mm256_loadu_ps(y + i);
+		const __m256 vz = _mm256_loadu_ps(z + i);
+		const __m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, m00), _mm256_mul_ps(vy, m10))
+			, _mm256_add_ps(_mm256_mul_ps(vz, m20), m30));
+		const __m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, m01), _mm256_mul_ps(vy, m11))
+			, _mm256_add_ps(_mm256_mul_ps(vz, m21), m31));
+		const __m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, m02), _mm256_mul_ps(vy, m12))
+			, _mm256_add_ps(_mm256_mul_ps(vz, m22), m32));
+		_mm256_storeu_ps(outX + i, rx);
+		_mm256_storeu_ps(outY + i, ry);
+		_mm256_storeu_ps(outZ + i, rz);
+	}
+	_mm256_zeroupper(); // caller SSE code, no transition penalty
+#endif
+	return i;
+}
+
+
+int cSimdCpu::CullSpheresAvx(const float (*planes)[4], const float *x, const float *y
+	, const float *z, const float *r, const int count, OUT int *visible
+	, OUT int &visibleCount)
+{
+	int i = 0;
+#ifdef SIMD_MATH_AVX_DISPATCH
+	int n = visibleCount;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 vx = _mm256_loadu_ps(x + i);
+		const __m256 vy = _mm256_loadu_ps(y + i);
+		const __m256 vz = _mm256_loadu_ps(z + i);
+		const __m256 negR = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(r + i));
+		__m256 inside = _mm256_setzero_ps();
+		for (int k = 0; k < 6; ++k)
+		{
+			const float *p = planes[k];
+			const __m256 d = _mm256_add_ps(
+				_mm256_add_ps(_mm256_mul_ps(vx, _mm256_set1_ps(p[0])), _mm256_mul_ps(vy, _mm256_set1_ps(p[1])))
+				, _mm256_add_ps(_mm256_mul_ps(vz, _mm256_set1_ps(p[2])), _mm256_set1_ps(p[3])));
+			const __m256 in = _mm256_cmp_ps(d, negR, _CMP_GE_OQ);
+			inside = (k == 0) ? in : _mm256_and_ps(inside, in);
+		}
+		n += WriteMask(_mm256_movemask_ps(inside), i, visible + n);
+	}
+	visibleCount = n;
+	_mm256_zeroupper();
+#endif
+	return i;
+}
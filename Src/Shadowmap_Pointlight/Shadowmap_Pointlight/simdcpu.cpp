@@ -0,0 +1,40 @@
+
+#include "../../Shared/platform.h"
+#include "simdcpu.h"
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+using namespace graphic;
+
+
+namespace
+{
+	// AVX instruction + OS save YMM register (XCR0 bit 1, 2)
+	bool CheckAvx()
+	{
+#if defined(_MSC_VER) && defined(SIMD_MATH_AVX_DISPATCH)
+		int info[4];
+		__cpuid(info, 1);
+		const bool isOsxSave = (info[2] & (1 << 27)) != 0;
+		const bool isAvx = (info[2] & (1 << 28)) != 0;
+		if (!isOsxSave || !isAvx)
+			return false;
+		const unsigned __int64 xcr0 = _xgetbv(0);
+		return (xcr0 & 0x6) == 0x6;
+#elif defined(__GNUC__) && defined(SIMD_MATH_AVX_DISPATCH)
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx") != 0; // include OS YMM state check
+#else
+		return false;
+#endif
+	}
+}
+
+
+// cpuid once
+bool cSimdCpu::IsAvx()
+{
+	static const bool isAvx = CheckAvx();
+	return isAvx;
+}
@@ -0,0 +1,40 @@
+//
+// 2018-05-26, jjuiddong
+// SIMD CPU Dispatch
+//	- SSE: compile time (x86, x64 always has SSE2)
+//	- AVX: runtime, cpuid + OS YMM state check, IsAvx()
+//	  8 wide kernel in simdavx.cpp, only that file compiled with /arch:AVX (-mavx)
+//	  other file never emit VEX instruction, run on non AVX CPU
+//	- kernel return processed count (multiple of 8), caller finish remainder
+//
+#pragma once
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+	#define SIMD_MATH_SSE
+	#include <xmmintrin.h>
+#endif
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+	#define SIMD_MATH_AVX_DISPATCH
+#endif
+
+
+namespace graphic
+{
+
+	class cSimdCpu
+	{
+	public:
+		static bool IsAvx();
+
+		// simdavx.cpp, call only if IsAvx()
+		// SoA point transform, (x,y,z,1) * m, 8 point per iteration
+		static int TransformPointsAvx(const float *m, const float *x, const float *y
+			, const float *z, const int count, OUT float *outX, OUT float *outY, OUT float *outZ);
+		// bounding sphere vs 6 plane, 8 sphere per iteration
+		// visible: append index, visibleCount: in/out
+		static int CullSpheresAvx(const float (*planes)[4], const float *x, const float *y
+			, const float *z, const float *r, const int count, OUT int *visible
+			, OUT int &visibleCount);
+	};
+
+}
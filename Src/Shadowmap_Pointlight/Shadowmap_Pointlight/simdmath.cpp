@@ -0,0 +1,276 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "simdmath.h"
+#include "../../Shared/steadytimer.h"
+
+using namespace graphic;
+
+static_assert(sizeof(Matrix44) == sizeof(float) * 16, "Matrix44 layout mismatch");
+static_assert(sizeof(Vector3) == sizeof(float) * 3, "Vector3 layout mismatch");
+
+
+namespace
+{
+#ifdef SIMD_MATH_SSE
+	// row = a_row * b
+	inline __m128 MulRow(const float *aRow, const __m128 b0, const __m128 b1
+		, const __m128 b2, const __m128 b3)
+	{
+		__m128 r = _mm_mul_ps(_mm_set1_ps(aRow[0]), b0);
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(aRow[1]), b1));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(aRow[2]), b2));
+		return _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(aRow[3]), b3));
+	}
+#else
+	inline void MulScalar(const float *a, const float *b, OUT float *out)
+	{
+		for (int r = 0; r < 4; ++r)
+			for (int c = 0; c < 4; ++c)
+				out[r * 4 + c] = a[r * 4] * b[c] + a[r * 4 + 1] * b[4 + c]
+					+ a[r * 4 + 2] * b[8 + c] + a[r * 4 + 3] * b[12 + c];
+	}
+#endif
+}
+
+
+void cSimdMath::Multiply(const float *a, const float *b, OUT float *out)
+{
+#ifdef SIMD_MATH_SSE
+	const __m128 b0 = _mm_loadu_ps(b);
+	const __m128 b1 = _mm_loadu_ps(b + 4);
+	const __m128 b2 = _mm_loadu_ps(b + 8);
+	const __m128 b3 = _mm_loadu_ps(b + 12);
+	_mm_storeu_ps(out, MulRow(a, b0, b1, b2, b3));
+	_mm_storeu_ps(out + 4, MulRow(a + 4, b0, b1, b2, b3));
+	_mm_storeu_ps(out + 8, MulRow(a + 8, b0, b1, b2, b3));
+	_mm_storeu_ps(out + 12, MulRow(a + 12, b0, b1, b2, b3));
+#else
+	MulScalar(a, b, out);
+#endif
+}
+
+
+void cSimdMath::MultiplyTranspose(const float *a, const float *b, OUT float *out)
+{
+	MultiplyTransposeBatch(a, b, 1, out);
+}
+
+
+void cSimdMath::MultiplyBatch(const float *a, const float *b, const int count
+	, OUT float *out)
+{
+#ifdef SIMD_MATH_SSE
+	const __m128 b0 = _mm_loadu_ps(b);
+	const __m128 b1 = _mm_loadu_ps(b + 4);
+	const __m128 b2 = _mm_loadu_ps(b + 8);
+	const __m128 b3 = _mm_loadu_ps(b + 12);
+	for (int i = 0; i < count; ++i, a += 16, out += 16)
+	{
+		const __m128 r0 = MulRow(a, b0, b1, b2, b3);
+		const __m128 r1 = MulRow(a + 4, b0, b1, b2, b3);
+		const __m128 r2 = MulRow(a + 8, b0, b1, b2, b3);
+		const __m128 r3 = MulRow(a + 12, b0, b1, b2, b3);
+		_mm_storeu_ps(out, r0);
+		_mm_storeu_ps(out + 4, r1);
+		_mm_storeu_ps(out + 8, r2);
+		_mm_storeu_ps(out + 12, r3);
+	}
+#else
+	for (int i = 0; i < count; ++i)
+		MulScalar(a + i * 16, b, out + i * 16);
+#endif
+}
+
+
+// transpose in register, no XMMatrixTranspose() after multiply
+void cSimdMath::MultiplyTransposeBatch(const float *a, const float *b, const int count
+	, OUT float *out
+	, const int outStride //= 16
+)
+{
+#ifdef SIMD_MATH_SSE
+	const __m128 b0 = _mm_loadu_ps(b);
+	const __m128 b1 = _mm_loadu_ps(b + 4);
+	const __m128 b2 = _mm_loadu_ps(b + 8);
+	const __m128 b3 = _mm_loadu_ps(b + 12);
+	for (int i = 0; i < count; ++i, a += 16, out += outStride)
+	{
+		__m128 r0 = MulRow(a, b0, b1, b2, b3);
+		__m128 r1 = MulRow(a + 4, b0, b1, b2, b3);
+		__m128 r2 = MulRow(a + 8, b0, b1, b2, b3);
+		__m128 r3 = MulRow(a + 12, b0, b1, b2, b3);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(out, r0);
+		_mm_storeu_ps(out + 4, r1);
+		_mm_storeu_ps(out + 8, r2);
+		_mm_storeu_ps(out + 12, r3);
+	}
+#else
+	for (int i = 0; i < count; ++i, a += 16, out += outStride)
+	{
+		float m[16];
+		MulScalar(a, b, m);
+		for (int r = 0; r < 4; ++r)
+			for (int c = 0; c < 4; ++c)
+				out[c * 4 + r] = m[r * 4 + c];
+	}
+#endif
+}
+
+
+// output can be same array with input
+void cSimdMath::TransformPoints(const float *m, const float *x, const float *y
+	, const float *z, const int count, OUT float *outX, OUT float *outY, OUT float *outZ)
+{
+	int i = 0;
+
+	// 8 wide, AVX CPU only
+	if (cSimdCpu::IsAvx())
+		i = cSimdCpu::TransformPointsAvx(m, x, y, z, count, outX, outY, outZ);
+
+#ifdef SIMD_MATH_SSE
+	{
+		const __m128 m00 = _mm_set1_ps(m[0]), m01 = _mm_set1_ps(m[1]), m02 = _mm_set1_ps(m[2]);
+		const __m128 m10 = _mm_set1_ps(m[4]), m11 = _mm_set1_ps(m[5]), m12 = _mm_set1_ps(m[6]);
+		const __m128 m20 = _mm_set1_ps(m[8]), m21 = _mm_set1_ps(m[9]), m22 = _mm_set1_ps(m[10]);
+		const __m128 m30 = _mm_set1_ps(m[12]), m31 = _mm_set1_ps(m[13]), m32 = _mm_set1_ps(m[14]);
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 vx = _mm_loadu_ps(x + i);
+			const __m128 vy = _mm_loadu_ps(y + i);
+			const __m128 vz = _mm_loadu_ps(z + i);
+			const __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m00), _mm_mul_ps(vy, m10))
+				, _mm_add_ps(_mm_mul_ps(vz, m20), m30));
+			const __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m01), _mm_mul_ps(vy, m11))
+				, _mm_add_ps(_mm_mul_ps(vz, m21), m31));
+			const __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m02), _mm_mul_ps(vy, m12))
+				, _mm_add_ps(_mm_mul_ps(vz, m22), m32));
+			_mm_storeu_ps(outX + i, rx);
+			_mm_storeu_ps(outY + i, ry);
+			_mm_storeu_ps(outZ + i, rz);
+		}
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		const float vx = x[i], vy = y[i], vz = z[i];
+		outX[i] = vx * m[0] + vy * m[4] + vz * m[8] + m[12];
+		outY[i] = vx * m[1] + vy * m[5] + vz * m[9] + m[13];
+		outZ[i] = vx * m[2] + vy * m[6] + vz * m[10] + m[14];
+	}
+}
+
+
+// dst can be same array with src
+void cSimdMath::TransformPoints(const float *m, const Vector3 *src, const int count
+	, OUT Vector3 *dst)
+{
+#ifdef SIMD_MATH_SSE
+	const __m128 r0 = _mm_loadu_ps(m);
+	const __m128 r1 = _mm_loadu_ps(m + 4);
+	const __m128 r2 = _mm_loadu_ps(m + 8);
+	const __m128 r3 = _mm_loadu_ps(m + 12);
+	for (int i = 0; i < count; ++i)
+	{
+		__m128 v = _mm_mul_ps(_mm_set1_ps(src[i].x), r0);
+		v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(src[i].y), r1));
+		v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(src[i].z), r2));
+		v = _mm_add_ps(v, r3);
+		float out[4];
+		_mm_storeu_ps(out, v);
+		dst[i].x = out[0];
+		dst[i].y = out[1];
+		dst[i].z = out[2];
+	}
+#else
+	for (int i = 0; i < count; ++i)
+	{
+		const float vx = src[i].x, vy = src[i].y, vz = src[i].z;
+		dst[i].x = vx * m[0] + vy * m[4] + vz * m[8] + m[12];
+		dst[i].y = vx * m[1] + vy * m[5] + vz * m[9] + m[13];
+		dst[i].z = vx * m[2] + vy * m[6] + vz * m[10] + m[14];
+	}
+#endif
+}
+
+
+// scalar Matrix44/Vector3 vs SIMD path
+void cSimdMath::Benchmark(const int count, OUT sBenchmark &out)
+{
+	ZeroMemory(&out, sizeof(out));
+	out.count = count;
+	out.isAvx = cSimdCpu::IsAvx();
+	if (count <= 0)
+		return;
+
+	Matrix44 view, proj;
+	view.SetView(Vector3(0, 10, -10), Vector3(0, -1, 1).Normal(), Vector3(0, 1, 0));
+	proj.SetProjection(MATH_PI / 4.f, 1.f, 0.1f, 1000.f);
+	const Matrix44 viewProj = view * proj;
+
+	std::vector<Matrix44> worlds(count);
+	std::vector<Vector3> points(count);
+	for (int i = 0; i < count; ++i)
+	{
+		worlds[i].SetRotationY((float)i * 0.01f);
+		worlds[i].m[3][0] = (float)(i % 100);
+		worlds[i].m[3][2] = (float)(i / 100);
+		points[i] = Vector3((float)(i % 100), (float)(i % 7), (float)(i / 100));
+	}
+
+	// matrix, transposed constant buffer layout
+	std::vector<XMFLOAT4X4> scalarOut(count);
+	std::vector<XMFLOAT4X4> simdOut(count);
+	{
+		double t0 = GetSteadyTimeMs();
+		for (int i = 0; i < count; ++i)
+			XMStoreFloat4x4(&scalarOut[i], XMMatrixTranspose((worlds[i] * viewProj).GetMatrixXM()));
+		out.scalarMatrixMs = GetSteadyTimeMs() - t0;
+
+		t0 = GetSteadyTimeMs();
+		MultiplyTransposeBatch(&worlds[0].m[0][0], &viewProj.m[0][0], count, &simdOut[0]._11);
+		out.simdMatrixMs = GetSteadyTimeMs() - t0;
+	}
+
+	// point
+	Matrix44 tm;
+	tm.SetRotationY(0.3f);
+	tm.m[3][0] = 1.f;
+	tm.m[3][1] = 2.f;
+	tm.m[3][2] = 3.f;
+
+	std::vector<Vector3> scalarPoints(count);
+	std::vector<float> x(count), y(count), z(count);
+	for (int i = 0; i < count; ++i)
+	{
+		x[i] = points[i].x;
+		y[i] = points[i].y;
+		z[i] = points[i].z;
+	}
+	{
+		double t0 = GetSteadyTimeMs();
+		for (int i = 0; i < count; ++i)
+			scalarPoints[i] = points[i] * tm;
+		out.scalarPointMs = GetSteadyTimeMs() - t0;
+
+		t0 = GetSteadyTimeMs();
+		TransformPoints(&tm.m[0][0], &x[0], &y[0], &z[0], count, &x[0], &y[0], &z[0]);
+		out.simdPointMs = GetSteadyTimeMs() - t0;
+	}
+
+	// validate
+	for (int i = 0; i < count; ++i)
+	{
+		const float *a = &scalarOut[i]._11;
+		const float *b = &simdOut[i]._11;
+		for (int k = 0; k < 16; ++k)
+			out.maxError = max(out.maxError, abs(a[k] - b[k]));
+		out.maxError = max(out.maxError, abs(scalarPoints[i].x - x[i]));
+		out.maxError = max(out.maxError, abs(scalarPoints[i].y - y[i]));
+		out.maxError = max(out.maxError, abs(scalarPoints[i].z - z[i]));
+	}
+}
@@ -0,0 +1,53 @@
+//
+// 2018-05-13, jjuiddong
+// SIMD Math
+//	- row major matrix (Matrix44 layout), row vector (v * M)
+//	- SSE path, AVX path (runtime dispatch, cSimdCpu), scalar path (other platform)
+//	- batch matrix multiply, batch point transform (SoA, AoS)
+//	- transposed output, direct write to constant buffer (HLSL column major)
+//	- point transform is affine, no w divide
+//
+#pragma once
+
+#include "simdcpu.h"
+
+
+namespace graphic
+{
+
+	class cSimdMath
+	{
+	public:
+		struct sBenchmark
+		{
+			int count;
+			double scalarMatrixMs; // Matrix44 * Matrix44, XMMatrixTranspose()
+			double simdMatrixMs; // MultiplyTransposeBatch()
+			double scalarPointMs; // Vector3 * Matrix44
+			double simdPointMs; // TransformPoints() SoA
+			bool isAvx; // TransformPoints() AVX kernel
+			float maxError;
+		};
+
+		// out = a * b, 16 float, out can't alias a, b
+		static void Multiply(const float *a, const float *b, OUT float *out);
+		// out = transpose(a * b)
+		static void MultiplyTranspose(const float *a, const float *b, OUT float *out);
+		// out[i] = a[i] * b
+		static void MultiplyBatch(const float *a, const float *b, const int count
+			, OUT float *out);
+		// out[i] = transpose(a[i] * b), outStride: float count between output matrix
+		static void MultiplyTransposeBatch(const float *a, const float *b, const int count
+			, OUT float *out, const int outStride = 16);
+
+		// SoA point transform, (x,y,z,1) * m
+		static void TransformPoints(const float *m, const float *x, const float *y
+			, const float *z, const int count, OUT float *outX, OUT float *outY, OUT float *outZ);
+		// AoS point transform, Vector3 array
+		static void TransformPoints(const float *m, const Vector3 *src, const int count
+			, OUT Vector3 *dst);
+
+		static void Benchmark(const int count, OUT sBenchmark &out);
+	};
+
+}
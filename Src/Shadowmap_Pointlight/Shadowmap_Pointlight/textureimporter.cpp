@@ -0,0 +1,453 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "textureimporter.h"
+#include <atomic>
+#include <algorithm>
+
+using namespace graphic;
+
+
+namespace
+{
+	// sRGB <-> linear conversion table
+	struct sGammaTable
+	{
+		float toLinear[256];
+		BYTE toGamma[4096];
+
+		sGammaTable() {
+			for (int i = 0; i < 256; ++i)
+			{
+				const float c = i / 255.f;
+				toLinear[i] = (c <= 0.04045f) ? (c / 12.92f) : powf((c + 0.055f) / 1.055f, 2.4f);
+			}
+			for (int i = 0; i < 4096; ++i)
+			{
+				const float l = i / 4095.f;
+				const float c = (l <= 0.0031308f) ? (l * 12.92f) : (1.055f * powf(l, 1.f / 2.4f) - 0.055f);
+				toGamma[i] = (BYTE)(c * 255.f + 0.5f);
+			}
+		}
+	};
+
+	const sGammaTable& GetGammaTable()
+	{
+		static sGammaTable table;
+		return table;
+	}
+
+	inline BYTE ToByte(const float v) {
+		return (BYTE)(common::clamp(0.f, 1.f, v) * 255.f + 0.5f);
+	}
+
+	inline WORD To565(const int r, const int g, const int b) {
+		return (WORD)(((r * 31 + 127) / 255) << 11) | (WORD)(((g * 63 + 127) / 255) << 5)
+			| (WORD)((b * 31 + 127) / 255);
+	}
+
+	inline void From565(const WORD c, OUT float *rgb) {
+		rgb[0] = ((c >> 11) & 0x1f) * (255.f / 31.f);
+		rgb[1] = ((c >> 5) & 0x3f) * (255.f / 63.f);
+		rgb[2] = (c & 0x1f) * (255.f / 31.f);
+	}
+
+	bool IsExtension(const char *fileName, const char *ext)
+	{
+		const char *dot = strrchr(fileName, '.');
+		return dot && (0 == _stricmp(dot + 1, ext));
+	}
+
+	// is file1 newer than file2?
+	bool IsNewerFile(const char *fileName1, const char *fileName2)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA attr1, attr2;
+		if (!GetFileAttributesExA(fileName1, GetFileExInfoStandard, &attr1))
+			return false;
+		if (!GetFileAttributesExA(fileName2, GetFileExInfoStandard, &attr2))
+			return false;
+		return CompareFileTime(&attr1.ftLastWriteTime, &attr2.ftLastWriteTime) >= 0;
+	}
+}
+
+
+// convert texture to block compressed DDS with mip chain
+// DDS file return as is, outFileName = srcFileName if fail
+bool cTextureImporter::Import(const char *srcFileName, OUT std::string &outFileName
+	, cAssetCache *cache //= NULL
+	, const bool isForce //= false
+)
+{
+	outFileName = srcFileName;
+	if (IsExtension(srcFileName, "dds"))
+		return true;
+
+	const std::string key = cache ? cache->GetKey(srcFileName, "texture", VERSION) : "";
+	const std::string cacheFileName = GetCacheFileName(srcFileName);
+	if (!isForce)
+	{
+		if (cache && cache->Find(key, outFileName))
+			return true;
+		if (!cache && IsNewerFile(cacheFileName.c_str(), srcFileName))
+		{
+			outFileName = cacheFileName;
+			return true;
+		}
+	}
+
+	sTextureData src;
+	if (!cTextureLoader::ReadTexture(srcFileName, src))
+		return false;
+
+	const DXGI_FORMAT format = SelectFormat(srcFileName, src);
+	sTextureData mips;
+	if (!GenerateMips(src, DXGI_FORMAT_BC5_UNORM != format, mips))
+		return false;
+
+	sTextureData bc;
+	if (!Compress(mips, format, bc))
+		return false;
+
+	// write temporary file and rename, never read half written cache
+	const std::string tmpFileName = cache ? cache->GetTempFileName(key)
+		: (cacheFileName + ".tmp");
+	if (!cTextureLoader::WriteDDS(tmpFileName.c_str(), bc))
+		return false;
+	if (cache)
+		return cache->Store(key, tmpFileName.c_str(), outFileName);
+	if (!MoveFileExA(tmpFileName.c_str(), cacheFileName.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileA(tmpFileName.c_str());
+		return false;
+	}
+
+	outFileName = cacheFileName;
+	return true;
+}
+
+
+// generate full mip chain from RGBA32 top level
+// isSRGB: filter in linear space, alpha and normal map filter as is
+bool cTextureImporter::GenerateMips(const sTextureData &src, const bool isSRGB
+	, OUT sTextureData &out)
+{
+	RETV2(DXGI_FORMAT_R8G8B8A8_UNORM != src.format, false);
+	RETV2(src.subres.empty(), false);
+
+	const sGammaTable &gamma = GetGammaTable();
+
+	UINT w = src.width;
+	UINT h = src.height;
+	UINT mipLevels = 1;
+	while ((w > 1) || (h > 1))
+	{
+		w = max(1u, w / 2);
+		h = max(1u, h / 2);
+		++mipLevels;
+	}
+
+	out.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	out.width = src.width;
+	out.height = src.height;
+	out.mipLevels = mipLevels;
+	out.arraySize = 1;
+	out.isCube = false;
+	out.pixels.clear();
+	out.subres.clear();
+
+	// top level, linear float
+	w = src.width;
+	h = src.height;
+	std::vector<float> cur(w * h * 4);
+	for (UINT y = 0; y < h; ++y)
+	{
+		const BYTE *row = &src.pixels[src.subres[0].offset + y * src.subres[0].rowPitch];
+		for (UINT x = 0; x < w * 4; ++x)
+		{
+			const bool isAlpha = (3 == (x % 4));
+			cur[y * w * 4 + x] = (isSRGB && !isAlpha) ? gamma.toLinear[row[x]] : (row[x] / 255.f);
+		}
+	}
+
+	std::vector<float> next;
+	for (UINT m = 0; m < mipLevels; ++m)
+	{
+		// store current level
+		sTextureData::sSubresource sub;
+		sub.offset = (UINT)out.pixels.size();
+		sub.rowPitch = w * 4;
+		sub.slicePitch = w * 4 * h;
+		out.subres.push_back(sub);
+		out.pixels.resize(out.pixels.size() + sub.slicePitch);
+
+		BYTE *dst = &out.pixels[sub.offset];
+		for (UINT i = 0; i < w * h * 4; ++i)
+		{
+			const float v = cur[i];
+			const bool isAlpha = (3 == (i % 4));
+			dst[i] = (isSRGB && !isAlpha) ?
+				gamma.toGamma[(int)(common::clamp(0.f, 1.f, v) * 4095.f + 0.5f)] : ToByte(v);
+		}
+
+		if (m == mipLevels - 1)
+			break;
+
+		// 2x2 box filter, one pixel (RGBA) per SSE register
+		// odd size clamp to edge
+		const UINT nw = max(1u, w / 2);
+		const UINT nh = max(1u, h / 2);
+		next.resize(nw * nh * 4);
+		const __m128 quarter = _mm_set1_ps(0.25f);
+		for (UINT y = 0; y < nh; ++y)
+		{
+			const UINT y0 = min(y * 2, h - 1);
+			const UINT y1 = min(y * 2 + 1, h - 1);
+			for (UINT x = 0; x < nw; ++x)
+			{
+				const UINT x0 = min(x * 2, w - 1);
+				const UINT x1 = min(x * 2 + 1, w - 1);
+				const __m128 p00 = _mm_loadu_ps(&cur[(y0 * w + x0) * 4]);
+				const __m128 p01 = _mm_loadu_ps(&cur[(y0 * w + x1) * 4]);
+				const __m128 p10 = _mm_loadu_ps(&cur[(y1 * w + x0) * 4]);
+				const __m128 p11 = _mm_loadu_ps(&cur[(y1 * w + x1) * 4]);
+				const __m128 sum = _mm_add_ps(_mm_add_ps(p00, p01), _mm_add_ps(p10, p11));
+				_mm_storeu_ps(&next[(y * nw + x) * 4], _mm_mul_ps(sum, quarter));
+			}
+		}
+
+		cur.swap(next);
+		w = nw;
+		h = nh;
+	}
+
+	return true;
+}
+
+
+// RGBA32 mip chain -> BC1, BC3, BC5
+// block row distributed to worker thread
+bool cTextureImporter::Compress(const sTextureData &src, const DXGI_FORMAT format
+	, OUT sTextureData &out
+	, const int threadCount //= 0
+)
+{
+	RETV2(DXGI_FORMAT_R8G8B8A8_UNORM != src.format, false);
+	RETV2((DXGI_FORMAT_BC1_UNORM != format) && (DXGI_FORMAT_BC3_UNORM != format)
+		&& (DXGI_FORMAT_BC5_UNORM != format), false);
+
+	const UINT blockSize = (DXGI_FORMAT_BC1_UNORM == format) ? 8 : 16;
+
+	out.format = format;
+	out.width = src.width;
+	out.height = src.height;
+	out.mipLevels = src.mipLevels;
+	out.arraySize = 1;
+	out.isCube = false;
+	out.subres.clear();
+
+	struct sRow { UINT mip; UINT blockY; };
+	std::vector<sRow> rows;
+
+	UINT total = 0;
+	for (UINT m = 0; m < src.mipLevels; ++m)
+	{
+		const UINT w = max(1u, src.width >> m);
+		const UINT h = max(1u, src.height >> m);
+		sTextureData::sSubresource sub;
+		sub.offset = total;
+		sub.rowPitch = max(1u, (w + 3) / 4) * blockSize;
+		sub.slicePitch = sub.rowPitch * max(1u, (h + 3) / 4);
+		out.subres.push_back(sub);
+		total += sub.slicePitch;
+
+		for (UINT by = 0; by < max(1u, (h + 3) / 4); ++by)
+			rows.push_back({ m, by });
+	}
+	out.pixels.resize(total);
+
+	std::atomic<int> index(0);
+	auto encodeRows = [&]() {
+		BYTE block[16 * 4];
+		int idx = 0;
+		while ((idx = index++) < (int)rows.size())
+		{
+			const UINT m = rows[idx].mip;
+			const UINT w = max(1u, src.width >> m);
+			const UINT h = max(1u, src.height >> m);
+			const sTextureData::sSubresource &srcSub = src.subres[m];
+			const sTextureData::sSubresource &dstSub = out.subres[m];
+			const UINT by = rows[idx].blockY;
+
+			for (UINT bx = 0; bx < max(1u, (w + 3) / 4); ++bx)
+			{
+				// gather 4x4 block, clamp to edge
+				for (UINT y = 0; y < 4; ++y)
+				{
+					const UINT sy = min(by * 4 + y, h - 1);
+					for (UINT x = 0; x < 4; ++x)
+					{
+						const UINT sx = min(bx * 4 + x, w - 1);
+						memcpy(&block[(y * 4 + x) * 4]
+							, &src.pixels[srcSub.offset + sy * srcSub.rowPitch + sx * 4], 4);
+					}
+				}
+
+				BYTE *dst = &out.pixels[dstSub.offset + by * dstSub.rowPitch + bx * blockSize];
+				switch (format)
+				{
+				case DXGI_FORMAT_BC1_UNORM: EncodeBC1Block(block, dst); break;
+				case DXGI_FORMAT_BC3_UNORM: EncodeBC3Block(block, dst); break;
+				case DXGI_FORMAT_BC5_UNORM: EncodeBC5Block(block, dst); break;
+				}
+			}
+		}
+	};
+
+	const int count = (threadCount > 0) ? threadCount
+		: max(1, (int)std::thread::hardware_concurrency());
+	std::vector<std::thread> threads;
+	for (int i = 1; i < count; ++i)
+		threads.push_back(std::thread(encodeRows));
+	encodeRows();
+	for (auto &th : threads)
+		th.join();
+
+	return true;
+}
+
+
+// normal map (file name contain 'normal' or '_n.') -> BC5
+// alpha exist -> BC3, else BC1
+DXGI_FORMAT cTextureImporter::SelectFormat(const char *fileName, const sTextureData &src)
+{
+	std::string name = fileName;
+	std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+	if ((name.find("normal") != std::string::npos) || (name.find("_n.") != std::string::npos))
+		return DXGI_FORMAT_BC5_UNORM;
+
+	if (!src.subres.empty())
+	{
+		const sTextureData::sSubresource &sub = src.subres[0];
+		for (UINT y = 0; y < src.height; ++y)
+			for (UINT x = 0; x < src.width; ++x)
+				if (src.pixels[sub.offset + y * sub.rowPitch + x * 4 + 3] < 255)
+					return DXGI_FORMAT_BC3_UNORM;
+	}
+
+	return DXGI_FORMAT_BC1_UNORM;
+}
+
+
+std::string cTextureImporter::GetCacheFileName(const char *srcFileName)
+{
+	return std::string(srcFileName) + ".dds";
+}
+
+
+// 4x4 RGBA32 -> BC1 8byte
+// bounding box endpoint, inset 1/16, project to endpoint line
+void cTextureImporter::EncodeBC1Block(const BYTE *rgba, OUT BYTE *dst)
+{
+	int minC[3] = { 255, 255, 255 };
+	int maxC[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; ++i)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			minC[k] = min(minC[k], (int)rgba[i * 4 + k]);
+			maxC[k] = max(maxC[k], (int)rgba[i * 4 + k]);
+		}
+	}
+
+	for (int k = 0; k < 3; ++k)
+	{
+		const int inset = (maxC[k] - minC[k]) >> 4;
+		minC[k] += inset;
+		maxC[k] -= inset;
+	}
+
+	// max >= min each channel, c0 >= c1 (4 color mode or solid)
+	const WORD c0 = To565(maxC[0], maxC[1], maxC[2]);
+	const WORD c1 = To565(minC[0], minC[1], minC[2]);
+	dst[0] = (BYTE)(c0 & 0xff);
+	dst[1] = (BYTE)(c0 >> 8);
+	dst[2] = (BYTE)(c1 & 0xff);
+	dst[3] = (BYTE)(c1 >> 8);
+
+	DWORD indices = 0;
+	if (c0 != c1)
+	{
+		float p0[3], p1[3];
+		From565(c0, p0);
+		From565(c1, p1);
+		const float dir[3] = { p0[0] - p1[0], p0[1] - p1[1], p0[2] - p1[2] };
+		const float lenSq = dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2];
+		const float scale = (lenSq > 0.f) ? (3.f / lenSq) : 0.f;
+
+		// step 0(c1) ~ 3(c0) -> index
+		static const DWORD stepToIndex[4] = { 1, 3, 2, 0 };
+		for (int i = 0; i < 16; ++i)
+		{
+			const float t = ((rgba[i * 4 + 0] - p1[0]) * dir[0]
+				+ (rgba[i * 4 + 1] - p1[1]) * dir[1]
+				+ (rgba[i * 4 + 2] - p1[2]) * dir[2]) * scale;
+			const int step = max(0, min(3, (int)(t + 0.5f)));
+			indices |= stepToIndex[step] << (i * 2);
+		}
+	}
+
+	dst[4] = (BYTE)(indices & 0xff);
+	dst[5] = (BYTE)((indices >> 8) & 0xff);
+	dst[6] = (BYTE)((indices >> 16) & 0xff);
+	dst[7] = (BYTE)((indices >> 24) & 0xff);
+}
+
+
+// BC4 alpha block(8byte) + BC1 color block(8byte)
+void cTextureImporter::EncodeBC3Block(const BYTE *rgba, OUT BYTE *dst)
+{
+	EncodeBC4Block(rgba, 3, dst);
+	EncodeBC1Block(rgba, dst + 8);
+}
+
+
+// BC4 red block(8byte) + BC4 green block(8byte)
+void cTextureImporter::EncodeBC5Block(const BYTE *rgba, OUT BYTE *dst)
+{
+	EncodeBC4Block(rgba, 0, dst);
+	EncodeBC4Block(rgba, 1, dst + 8);
+}
+
+
+// one channel of 4x4 RGBA32 -> 8byte, 8 value mode (a0 > a1)
+void cTextureImporter::EncodeBC4Block(const BYTE *rgba, const int channel, OUT BYTE *dst)
+{
+	int minV = 255;
+	int maxV = 0;
+	for (int i = 0; i < 16; ++i)
+	{
+		minV = min(minV, (int)rgba[i * 4 + channel]);
+		maxV = max(maxV, (int)rgba[i * 4 + channel]);
+	}
+
+	dst[0] = (BYTE)maxV;
+	dst[1] = (BYTE)minV;
+
+	unsigned __int64 indices = 0;
+	if (maxV != minV)
+	{
+		const float scale = 7.f / (float)(maxV - minV);
+		for (int i = 0; i < 16; ++i)
+		{
+			// step 0(a1) ~ 7(a0) -> index
+			const int step = (int)((rgba[i * 4 + channel] - minV) * scale + 0.5f);
+			const unsigned __int64 idx = (7 == step) ? 0 : ((0 == step) ? 1 : (8 - step));
+			indices |= idx << (i * 3);
+		}
+	}
+
+	for (int i = 0; i < 6; ++i)
+		dst[2 + i] = (BYTE)((indices >> (i * 8)) & 0xff);
+}
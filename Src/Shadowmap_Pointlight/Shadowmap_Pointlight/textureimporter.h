@@ -0,0 +1,39 @@
+//
+// 2018-05-04, jjuiddong
+// Texture Importer
+//	- JPG/PNG/BMP -> mip chain (gamma correct box filter, SSE) -> BC1/BC3/BC5
+//	- block compression run parallel, block row split
+//	- result cached as DDS in asset cache (source hash key)
+//	  or next to the source file if no cache (xxx.jpg -> xxx.jpg.dds)
+//
+#pragma once
+
+#include "textureloader.h"
+#include "assetcache.h"
+
+
+namespace graphic
+{
+
+	class cTextureImporter
+	{
+	public:
+		enum { VERSION = 1 }; // increase when output change, invalidate cache
+
+		static bool Import(const char *srcFileName, OUT std::string &outFileName
+			, cAssetCache *cache = NULL, const bool isForce = false);
+
+		static bool GenerateMips(const sTextureData &src, const bool isSRGB
+			, OUT sTextureData &out);
+		static bool Compress(const sTextureData &src, const DXGI_FORMAT format
+			, OUT sTextureData &out, const int threadCount = 0);
+		static DXGI_FORMAT SelectFormat(const char *fileName, const sTextureData &src);
+		static std::string GetCacheFileName(const char *srcFileName);
+
+		static void EncodeBC1Block(const BYTE *rgba, OUT BYTE *dst);
+		static void EncodeBC3Block(const BYTE *rgba, OUT BYTE *dst);
+		static void EncodeBC5Block(const BYTE *rgba, OUT BYTE *dst);
+		static void EncodeBC4Block(const BYTE *rgba, const int channel, OUT BYTE *dst);
+	};
+
+}
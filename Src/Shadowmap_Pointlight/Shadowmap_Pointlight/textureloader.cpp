@@ -0,0 +1,828 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "textureloader.h"
+#include "textureimporter.h"
+#include <wincodec.h>
+#include "../../Shared/steadytimer.h"
+#include <atomic>
+
+#pragma comment(lib, "windowscodecs.lib")
+
+using namespace graphic;
+
+
+namespace
+{
+	// DDS file format
+	// https://msdn.microsoft.com/en-us/library/windows/desktop/bb943991(v=vs.85).aspx
+	const DWORD DDS_MAGIC = 0x20534444; // "DDS "
+	const DWORD DDSD_CAPS = 0x00000001;
+	const DWORD DDSD_HEIGHT = 0x00000002;
+	const DWORD DDSD_WIDTH = 0x00000004;
+	const DWORD DDSD_PITCH = 0x00000008;
+	const DWORD DDSD_PIXELFORMAT = 0x00001000;
+	const DWORD DDSD_MIPMAPCOUNT = 0x00020000;
+	const DWORD DDSD_LINEARSIZE = 0x00080000;
+	const DWORD DDSCAPS_COMPLEX = 0x00000008;
+	const DWORD DDSCAPS_TEXTURE = 0x00001000;
+	const DWORD DDSCAPS_MIPMAP = 0x00400000;
+	const DWORD DDS_ALPHAPIXELS = 0x00000001;
+	const DWORD DDS_FOURCC = 0x00000004;
+	const DWORD DDS_RGB = 0x00000040;
+	const DWORD DDS_LUMINANCE = 0x00020000;
+	const DWORD DDS_CUBEMAP = 0x00000200;
+	const DWORD DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+#pragma pack(push, 1)
+	struct sDDSPixelFormat
+	{
+		DWORD size;
+		DWORD flags;
+		DWORD fourCC;
+		DWORD RGBBitCount;
+		DWORD RBitMask;
+		DWORD GBitMask;
+		DWORD BBitMask;
+		DWORD ABitMask;
+	};
+
+	struct sDDSHeader
+	{
+		DWORD size;
+		DWORD flags;
+		DWORD height;
+		DWORD width;
+		DWORD pitchOrLinearSize;
+		DWORD depth;
+		DWORD mipMapCount;
+		DWORD reserved1[11];
+		sDDSPixelFormat ddspf;
+		DWORD caps;
+		DWORD caps2;
+		DWORD caps3;
+		DWORD caps4;
+		DWORD reserved2;
+	};
+
+	struct sDDSHeaderDXT10
+	{
+		DXGI_FORMAT dxgiFormat;
+		UINT resourceDimension;
+		UINT miscFlag;
+		UINT arraySize;
+		UINT miscFlags2;
+	};
+#pragma pack(pop)
+
+	inline DWORD MakeFourCC(const char a, const char b, const char c, const char d) {
+		return (DWORD)a | ((DWORD)b << 8) | ((DWORD)c << 16) | ((DWORD)d << 24);
+	}
+
+	DXGI_FORMAT GetDXGIFormat(const sDDSPixelFormat &pf)
+	{
+		if (pf.flags & DDS_FOURCC)
+		{
+			if (MakeFourCC('D', 'X', 'T', '1') == pf.fourCC) return DXGI_FORMAT_BC1_UNORM;
+			if (MakeFourCC('D', 'X', 'T', '2') == pf.fourCC) return DXGI_FORMAT_BC2_UNORM;
+			if (MakeFourCC('D', 'X', 'T', '3') == pf.fourCC) return DXGI_FORMAT_BC2_UNORM;
+			if (MakeFourCC('D', 'X', 'T', '4') == pf.fourCC) return DXGI_FORMAT_BC3_UNORM;
+			if (MakeFourCC('D', 'X', 'T', '5') == pf.fourCC) return DXGI_FORMAT_BC3_UNORM;
+			if (MakeFourCC('A', 'T', 'I', '1') == pf.fourCC) return DXGI_FORMAT_BC4_UNORM;
+			if (MakeFourCC('B', 'C', '4', 'U') == pf.fourCC) return DXGI_FORMAT_BC4_UNORM;
+			if (MakeFourCC('A', 'T', 'I', '2') == pf.fourCC) return DXGI_FORMAT_BC5_UNORM;
+			if (MakeFourCC('B', 'C', '5', 'U') == pf.fourCC) return DXGI_FORMAT_BC5_UNORM;
+			return DXGI_FORMAT_UNKNOWN;
+		}
+
+		if ((pf.flags & DDS_RGB) && (32 == pf.RGBBitCount))
+		{
+			if ((0x000000ff == pf.RBitMask) && (0x0000ff00 == pf.GBitMask) && (0x00ff0000 == pf.BBitMask))
+				return DXGI_FORMAT_R8G8B8A8_UNORM;
+			if ((0x00ff0000 == pf.RBitMask) && (0x0000ff00 == pf.GBitMask) && (0x000000ff == pf.BBitMask))
+				return pf.ABitMask ? DXGI_FORMAT_B8G8R8A8_UNORM : DXGI_FORMAT_B8G8R8X8_UNORM;
+		}
+
+		if ((pf.flags & DDS_LUMINANCE) && (8 == pf.RGBBitCount))
+			return DXGI_FORMAT_R8_UNORM;
+
+		return DXGI_FORMAT_UNKNOWN;
+	}
+
+	// return block size (bytes) of block compressed format, 0 = not compressed
+	UINT GetBlockSize(const DXGI_FORMAT fmt)
+	{
+		switch (fmt)
+		{
+		case DXGI_FORMAT_BC1_TYPELESS:
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+		case DXGI_FORMAT_BC4_TYPELESS:
+		case DXGI_FORMAT_BC4_UNORM:
+		case DXGI_FORMAT_BC4_SNORM:
+			return 8;
+
+		case DXGI_FORMAT_BC2_TYPELESS:
+		case DXGI_FORMAT_BC2_UNORM:
+		case DXGI_FORMAT_BC2_UNORM_SRGB:
+		case DXGI_FORMAT_BC3_TYPELESS:
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+		case DXGI_FORMAT_BC5_TYPELESS:
+		case DXGI_FORMAT_BC5_UNORM:
+		case DXGI_FORMAT_BC5_SNORM:
+		case DXGI_FORMAT_BC6H_TYPELESS:
+		case DXGI_FORMAT_BC6H_UF16:
+		case DXGI_FORMAT_BC6H_SF16:
+		case DXGI_FORMAT_BC7_TYPELESS:
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return 16;
+		}
+		return 0;
+	}
+
+	// return bits per pixel of uncompressed format, 0 = not support
+	UINT GetBitsPerPixel(const DXGI_FORMAT fmt)
+	{
+		switch (fmt)
+		{
+		case DXGI_FORMAT_R32G32B32A32_FLOAT: return 128;
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		case DXGI_FORMAT_R16G16B16A16_UNORM: return 64;
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8X8_UNORM:
+		case DXGI_FORMAT_R10G10B10A2_UNORM:
+		case DXGI_FORMAT_R11G11B10_FLOAT:
+		case DXGI_FORMAT_R32_FLOAT: return 32;
+		case DXGI_FORMAT_R8G8_UNORM:
+		case DXGI_FORMAT_R16_FLOAT:
+		case DXGI_FORMAT_R16_UNORM: return 16;
+		case DXGI_FORMAT_R8_UNORM:
+		case DXGI_FORMAT_A8_UNORM: return 8;
+		}
+		return 0;
+	}
+
+	bool GetSurfaceInfo(const UINT width, const UINT height, const DXGI_FORMAT fmt
+		, OUT UINT &rowPitch, OUT UINT &slicePitch)
+	{
+		if (const UINT blockSize = GetBlockSize(fmt))
+		{
+			const UINT blockW = max(1u, (width + 3) / 4);
+			const UINT blockH = max(1u, (height + 3) / 4);
+			rowPitch = blockW * blockSize;
+			slicePitch = rowPitch * blockH;
+			return true;
+		}
+
+		if (const UINT bpp = GetBitsPerPixel(fmt))
+		{
+			rowPitch = (width * bpp + 7) / 8;
+			slicePitch = rowPitch * height;
+			return true;
+		}
+
+		return false;
+	}
+
+	bool IsExtension(const char *fileName, const char *ext)
+	{
+		const char *dot = strrchr(fileName, '.');
+		return dot && (0 == _stricmp(dot + 1, ext));
+	}
+
+	bool ReadFile(const char *fileName, OUT std::vector<BYTE> &out)
+	{
+		FILE *fp = NULL;
+		if (fopen_s(&fp, fileName, "rb") || !fp)
+			return false;
+
+		fseek(fp, 0, SEEK_END);
+		const long size = ftell(fp);
+		fseek(fp, 0, SEEK_SET);
+		if (size <= 0)
+		{
+			fclose(fp);
+			return false;
+		}
+
+		out.resize((size_t)size);
+		const size_t readSize = fread(&out[0], 1, out.size(), fp);
+		fclose(fp);
+		return readSize == out.size();
+	}
+
+	// COM initialize per worker thread for WIC
+	struct sComInit
+	{
+		HRESULT hr;
+		sComInit() { hr = CoInitializeEx(NULL, COINIT_MULTITHREADED); }
+		~sComInit() { if (SUCCEEDED(hr)) CoUninitialize(); }
+	};
+}
+
+
+cTextureLoader::cTextureLoader()
+	: m_placeholderTex(NULL)
+	, m_placeholderSRV(NULL)
+	, m_stagingSize(0)
+	, m_stagingBytes(0)
+	, m_uploadSizePerFrame(0)
+	, m_uploadBytes(0)
+	, m_isImport(true)
+	, m_cache(NULL)
+	, m_isLoop(false)
+{
+}
+
+cTextureLoader::~cTextureLoader()
+{
+	Clear();
+}
+
+
+bool cTextureLoader::Create(cRenderer &renderer
+	, const int threadCount //= 4
+	, const UINT stagingSize //= 32 * 1024 * 1024
+	, const UINT uploadSizePerFrame //= 4 * 1024 * 1024
+)
+{
+	Clear();
+
+	m_stagingSize = stagingSize;
+	m_uploadSizePerFrame = uploadSizePerFrame;
+
+	if (!CreatePlaceholder(renderer))
+		return false;
+
+	m_isLoop = true;
+	for (int i = 0; i < max(1, threadCount); ++i)
+		m_threads.push_back(std::thread(&cTextureLoader::WorkerThread, this));
+
+	return true;
+}
+
+
+// 1x1 white texture, shown until upload finish
+bool cTextureLoader::CreatePlaceholder(cRenderer &renderer)
+{
+	const DWORD white = 0xffffffff;
+	D3D11_SUBRESOURCE_DATA initData = { &white, sizeof(white), sizeof(white) };
+
+	D3D11_TEXTURE2D_DESC desc;
+	ZeroMemory(&desc, sizeof(desc));
+	desc.Width = 1;
+	desc.Height = 1;
+	desc.MipLevels = 1;
+	desc.ArraySize = 1;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	HRESULT hr = renderer.GetDevice()->CreateTexture2D(&desc, &initData, &m_placeholderTex);
+	RETV2(FAILED(hr), false);
+
+	hr = renderer.GetDevice()->CreateShaderResourceView(m_placeholderTex, NULL, &m_placeholderSRV);
+	RETV2(FAILED(hr), false);
+
+	return true;
+}
+
+
+// request texture loading, never block
+// requestMip : required most detailed mip level, smaller value loaded first
+// return texture id
+int cTextureLoader::Load(const char *fileName
+	, const int requestMip //= 0
+)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	for (u_int i = 0; i < m_textures.size(); ++i)
+	{
+		sTexture *tex = m_textures[i];
+		if (tex->fileName != fileName)
+			continue;
+
+		// raise priority, if still waiting worker thread
+		if ((eState::QUEUED == tex->state) && (requestMip < tex->requestMip))
+		{
+			tex->requestMip = requestMip;
+			m_jobs.push({ (int)i, requestMip });
+			m_jobCond.notify_one();
+		}
+		return (int)i;
+	}
+
+	sTexture *tex = new sTexture;
+	tex->fileName = fileName;
+	tex->requestMip = requestMip;
+	tex->state = eState::QUEUED;
+	tex->tex = NULL;
+	tex->srv = NULL;
+	tex->requestTime = GetSteadyTimeMs();
+	tex->loadTime = 0;
+	tex->gpuBytes = 0;
+
+	const int id = (int)m_textures.size();
+	m_textures.push_back(tex);
+	m_jobs.push({ id, requestMip });
+	m_jobCond.notify_one();
+	return id;
+}
+
+
+// return texture, placeholder texture if not loaded
+ID3D11ShaderResourceView* cTextureLoader::GetSRV(const int id)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if ((id < 0) || (id >= (int)m_textures.size()))
+		return m_placeholderSRV;
+	sTexture *tex = m_textures[id];
+	return (eState::COMPLETE == tex->state) ? tex->srv : m_placeholderSRV;
+}
+
+
+cTextureLoader::eState::Enum cTextureLoader::GetState(const int id)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if ((id < 0) || (id >= (int)m_textures.size()))
+		return eState::NONE;
+	return m_textures[id]->state;
+}
+
+
+bool cTextureLoader::IsLoadFinish(const int id)
+{
+	const eState::Enum state = GetState(id);
+	return (eState::COMPLETE == state) || (eState::FAILED == state);
+}
+
+
+// render thread, upload decoded texture to GPU
+// upload bytes bounded by m_uploadSizePerFrame (at least one texture per frame)
+// return upload texture count
+int cTextureLoader::Update(cRenderer &renderer)
+{
+	m_uploadBytes = 0;
+	int count = 0;
+
+	while (1)
+	{
+		sTexture *tex = NULL;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (m_staging.empty())
+				break;
+
+			sTexture *front = m_textures[m_staging.front()];
+			const UINT size = (UINT)front->data.pixels.size();
+			if ((count > 0) && (m_uploadBytes + size > m_uploadSizePerFrame))
+				break;
+
+			m_staging.pop_front();
+			tex = front;
+		}
+
+		const UINT size = (UINT)tex->data.pixels.size();
+		const bool result = Upload(renderer, tex);
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			tex->state = result ? eState::COMPLETE : eState::FAILED;
+			tex->loadTime = GetSteadyTimeMs() - tex->requestTime;
+			tex->gpuBytes = result ? size : 0;
+			tex->data.pixels.clear();
+			tex->data.pixels.shrink_to_fit();
+			tex->data.subres.clear();
+			m_stagingBytes -= size;
+		}
+		m_stagingCond.notify_all();
+
+		m_uploadBytes += size;
+		++count;
+	}
+
+	return count;
+}
+
+
+bool cTextureLoader::Upload(cRenderer &renderer, sTexture *texture)
+{
+	sTextureData &data = texture->data;
+	RETV2(data.subres.empty(), false);
+
+	std::vector<D3D11_SUBRESOURCE_DATA> initData(data.subres.size());
+	for (u_int i = 0; i < data.subres.size(); ++i)
+	{
+		initData[i].pSysMem = &data.pixels[data.subres[i].offset];
+		initData[i].SysMemPitch = data.subres[i].rowPitch;
+		initData[i].SysMemSlicePitch = data.subres[i].slicePitch;
+	}
+
+	D3D11_TEXTURE2D_DESC desc;
+	ZeroMemory(&desc, sizeof(desc));
+	desc.Width = data.width;
+	desc.Height = data.height;
+	desc.MipLevels = data.mipLevels;
+	desc.ArraySize = data.arraySize;
+	desc.Format = data.format;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.MiscFlags = data.isCube ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+
+	HRESULT hr = renderer.GetDevice()->CreateTexture2D(&desc, &initData[0], &texture->tex);
+	RETV2(FAILED(hr), false);
+
+	hr = renderer.GetDevice()->CreateShaderResourceView(texture->tex, NULL, &texture->srv);
+	RETV2(FAILED(hr), false);
+
+	return true;
+}
+
+
+void cTextureLoader::WorkerThread()
+{
+	sComInit comInit;
+
+	while (1)
+	{
+		int id = -1;
+		sTexture *tex = NULL;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobCond.wait(lock, [this]() { return !m_isLoop || !m_jobs.empty(); });
+			if (!m_isLoop)
+				break;
+
+			const sJob job = m_jobs.top();
+			m_jobs.pop();
+			id = job.id;
+			tex = m_textures[id];
+			if (eState::QUEUED != tex->state)
+				continue; // duplicate job, priority changed
+			tex->state = eState::LOADING;
+		}
+
+		// JPG/PNG/BMP -> cached BC DDS, fallback to source file if fail
+		std::string fileName = tex->fileName;
+		if (m_isImport)
+			cTextureImporter::Import(tex->fileName.c_str(), fileName, m_cache);
+
+		sTextureData data;
+		const bool result = ReadTexture(fileName.c_str(), data);
+		const UINT size = (UINT)data.pixels.size();
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (!result)
+		{
+			tex->state = eState::FAILED;
+			tex->loadTime = GetSteadyTimeMs() - tex->requestTime;
+			continue;
+		}
+
+		// bounded staging memory, wait until render thread upload
+		m_stagingCond.wait(lock, [this, size]() {
+			return !m_isLoop || (0 == m_stagingBytes)
+				|| (m_stagingBytes + size <= m_stagingSize); });
+		if (!m_isLoop)
+			break;
+
+		tex->data.format = data.format;
+		tex->data.width = data.width;
+		tex->data.height = data.height;
+		tex->data.mipLevels = data.mipLevels;
+		tex->data.arraySize = data.arraySize;
+		tex->data.isCube = data.isCube;
+		tex->data.pixels.swap(data.pixels);
+		tex->data.subres.swap(data.subres);
+		tex->state = eState::STAGING;
+		m_stagingBytes += size;
+		m_staging.push_back(id);
+	}
+}
+
+
+// file read + decode, thread safe
+bool cTextureLoader::ReadTexture(const char *fileName, OUT sTextureData &out
+	, OUT __int64 *fileBytes //= NULL
+)
+{
+	std::vector<BYTE> src;
+	if (!ReadFile(fileName, src))
+		return false;
+
+	if (fileBytes)
+		*fileBytes = (__int64)src.size();
+
+	if (IsExtension(fileName, "dds"))
+		return ParseDDS(&src[0], (UINT)src.size(), out);
+	return DecodeWIC(&src[0], (UINT)src.size(), out);
+}
+
+
+bool cTextureLoader::ParseDDS(const BYTE *src, const UINT size, OUT sTextureData &out)
+{
+	RETV2(size < sizeof(DWORD) + sizeof(sDDSHeader), false);
+	RETV2(DDS_MAGIC != *(const DWORD*)src, false);
+
+	const sDDSHeader *header = (const sDDSHeader*)(src + sizeof(DWORD));
+	RETV2(header->size != sizeof(sDDSHeader), false);
+	RETV2(header->ddspf.size != sizeof(sDDSPixelFormat), false);
+
+	UINT offset = sizeof(DWORD) + sizeof(sDDSHeader);
+	out.width = header->width;
+	out.height = header->height;
+	out.mipLevels = max(1u, (UINT)header->mipMapCount);
+	out.arraySize = 1;
+	out.isCube = false;
+
+	if ((header->ddspf.flags & DDS_FOURCC)
+		&& (MakeFourCC('D', 'X', '1', '0') == header->ddspf.fourCC))
+	{
+		RETV2(size < offset + sizeof(sDDSHeaderDXT10), false);
+		const sDDSHeaderDXT10 *dx10 = (const sDDSHeaderDXT10*)(src + offset);
+		offset += sizeof(sDDSHeaderDXT10);
+
+		out.format = dx10->dxgiFormat;
+		out.arraySize = max(1u, dx10->arraySize);
+		if (dx10->miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE)
+		{
+			out.isCube = true;
+			out.arraySize *= 6;
+		}
+	}
+	else
+	{
+		out.format = GetDXGIFormat(header->ddspf);
+		if (header->caps2 & DDS_CUBEMAP)
+		{
+			out.isCube = true;
+			out.arraySize = 6;
+		}
+	}
+
+	RETV2(DXGI_FORMAT_UNKNOWN == out.format, false);
+
+	// calculate subresource layout, array major
+	UINT total = 0;
+	out.subres.clear();
+	out.subres.reserve(out.arraySize * out.mipLevels);
+	for (UINT a = 0; a < out.arraySize; ++a)
+	{
+		UINT w = out.width;
+		UINT h = out.height;
+		for (UINT m = 0; m < out.mipLevels; ++m)
+		{
+			sTextureData::sSubresource sub;
+			RETV2(!GetSurfaceInfo(w, h, out.format, sub.rowPitch, sub.slicePitch), false);
+			sub.offset = total;
+			out.subres.push_back(sub);
+			total += sub.slicePitch;
+			w = max(1u, w / 2);
+			h = max(1u, h / 2);
+		}
+	}
+
+	RETV2(size < offset + total, false);
+	out.pixels.assign(src + offset, src + offset + total);
+	return true;
+}
+
+
+// write single 2D texture, legacy DDS header (DXT1/3/5, ATI1/2, RGBA32)
+bool cTextureLoader::WriteDDS(const char *fileName, const sTextureData &data)
+{
+	RETV2(data.isCube || (data.arraySize > 1), false);
+	RETV2(data.subres.empty(), false);
+
+	sDDSHeader header;
+	ZeroMemory(&header, sizeof(header));
+	header.size = sizeof(sDDSHeader);
+	header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT;
+	header.width = data.width;
+	header.height = data.height;
+	header.mipMapCount = data.mipLevels;
+	header.caps = DDSCAPS_TEXTURE;
+	if (data.mipLevels > 1)
+	{
+		header.flags |= DDSD_MIPMAPCOUNT;
+		header.caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+	}
+
+	header.ddspf.size = sizeof(sDDSPixelFormat);
+	switch (data.format)
+	{
+	case DXGI_FORMAT_BC1_UNORM: header.ddspf.fourCC = MakeFourCC('D', 'X', 'T', '1'); break;
+	case DXGI_FORMAT_BC2_UNORM: header.ddspf.fourCC = MakeFourCC('D', 'X', 'T', '3'); break;
+	case DXGI_FORMAT_BC3_UNORM: header.ddspf.fourCC = MakeFourCC('D', 'X', 'T', '5'); break;
+	case DXGI_FORMAT_BC4_UNORM: header.ddspf.fourCC = MakeFourCC('A', 'T', 'I', '1'); break;
+	case DXGI_FORMAT_BC5_UNORM: header.ddspf.fourCC = MakeFourCC('A', 'T', 'I', '2'); break;
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+		header.ddspf.flags = DDS_RGB | DDS_ALPHAPIXELS;
+		header.ddspf.RGBBitCount = 32;
+		header.ddspf.RBitMask = 0x000000ff;
+		header.ddspf.GBitMask = 0x0000ff00;
+		header.ddspf.BBitMask = 0x00ff0000;
+		header.ddspf.ABitMask = 0xff000000;
+		break;
+	default:
+		return false;
+	}
+
+	if (header.ddspf.fourCC)
+	{
+		header.ddspf.flags = DDS_FOURCC;
+		header.flags |= DDSD_LINEARSIZE;
+	}
+	else
+	{
+		header.flags |= DDSD_PITCH;
+	}
+	header.pitchOrLinearSize = header.ddspf.fourCC ?
+		data.subres[0].slicePitch : data.subres[0].rowPitch;
+
+	FILE *fp = NULL;
+	if (fopen_s(&fp, fileName, "wb") || !fp)
+		return false;
+
+	bool result = (1 == fwrite(&DDS_MAGIC, sizeof(DDS_MAGIC), 1, fp))
+		&& (1 == fwrite(&header, sizeof(header), 1, fp))
+		&& (data.pixels.size() == fwrite(&data.pixels[0], 1, data.pixels.size(), fp));
+	fclose(fp);
+	return result;
+}
+
+
+// decode JPG, PNG, BMP.. to RGBA32 with WIC, need CoInitialize
+bool cTextureLoader::DecodeWIC(const BYTE *src, const UINT size, OUT sTextureData &out)
+{
+	IWICImagingFactory *factory = NULL;
+	IWICStream *stream = NULL;
+	IWICBitmapDecoder *decoder = NULL;
+	IWICBitmapFrameDecode *frame = NULL;
+	IWICFormatConverter *converter = NULL;
+	bool result = false;
+
+	HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, NULL, CLSCTX_INPROC_SERVER
+		, IID_PPV_ARGS(&factory));
+	if (SUCCEEDED(hr))
+		hr = factory->CreateStream(&stream);
+	if (SUCCEEDED(hr))
+		hr = stream->InitializeFromMemory((BYTE*)src, size);
+	if (SUCCEEDED(hr))
+		hr = factory->CreateDecoderFromStream(stream, NULL, WICDecodeMetadataCacheOnDemand, &decoder);
+	if (SUCCEEDED(hr))
+		hr = decoder->GetFrame(0, &frame);
+	if (SUCCEEDED(hr))
+		hr = factory->CreateFormatConverter(&converter);
+	if (SUCCEEDED(hr))
+		hr = converter->Initialize(frame, GUID_WICPixelFormat32bppRGBA
+			, WICBitmapDitherTypeNone, NULL, 0.f, WICBitmapPaletteTypeCustom);
+
+	UINT width = 0, height = 0;
+	if (SUCCEEDED(hr))
+		hr = converter->GetSize(&width, &height);
+
+	if (SUCCEEDED(hr) && (width > 0) && (height > 0))
+	{
+		const UINT rowPitch = width * 4;
+		out.pixels.resize(rowPitch * height);
+		hr = converter->CopyPixels(NULL, rowPitch, (UINT)out.pixels.size(), &out.pixels[0]);
+		if (SUCCEEDED(hr))
+		{
+			out.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+			out.width = width;
+			out.height = height;
+			out.mipLevels = 1;
+			out.arraySize = 1;
+			out.isCube = false;
+
+			sTextureData::sSubresource sub = { 0, rowPitch, rowPitch * height };
+			out.subres.clear();
+			out.subres.push_back(sub);
+			result = true;
+		}
+	}
+
+	SAFE_RELEASE(converter);
+	SAFE_RELEASE(frame);
+	SAFE_RELEASE(decoder);
+	SAFE_RELEASE(stream);
+	SAFE_RELEASE(factory);
+	return result;
+}
+
+
+// texture file read + decode benchmark
+// all texture file in directory (dds, jpg, png, bmp)
+// single thread vs worker thread count
+bool cTextureLoader::Benchmark(const char *directory, OUT sBenchmark &out)
+{
+	ZeroMemory(&out, sizeof(out));
+
+	std::vector<std::string> files;
+	{
+		WIN32_FIND_DATAA fd;
+		const std::string findPath = std::string(directory) + "/*.*";
+		HANDLE hFind = FindFirstFileA(findPath.c_str(), &fd);
+		RETV2(INVALID_HANDLE_VALUE == hFind, false);
+		do
+		{
+			if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+				continue;
+			if (IsExtension(fd.cFileName, "dds") || IsExtension(fd.cFileName, "jpg")
+				|| IsExtension(fd.cFileName, "png") || IsExtension(fd.cFileName, "bmp"))
+				files.push_back(std::string(directory) + "/" + fd.cFileName);
+		} while (FindNextFileA(hFind, &fd));
+		FindClose(hFind);
+	}
+	RETV2(files.empty(), false);
+
+	out.fileCount = (int)files.size();
+	out.threadCount = max(1, (int)m_threads.size());
+
+	// single thread
+	{
+		sComInit comInit;
+		const double t0 = GetSteadyTimeMs();
+		for (auto &file : files)
+		{
+			sTextureData data;
+			__int64 fileBytes = 0;
+			if (ReadTexture(file.c_str(), data, &fileBytes))
+			{
+				out.fileBytes += fileBytes;
+				out.decodeBytes += data.pixels.size();
+			}
+			else
+			{
+				++out.failCount;
+			}
+		}
+		out.singleThreadMs = GetSteadyTimeMs() - t0;
+	}
+
+	// worker thread, same thread count with loader
+	{
+		std::atomic<int> index(0);
+		const double t0 = GetSteadyTimeMs();
+		std::vector<std::thread> threads;
+		for (int i = 0; i < out.threadCount; ++i)
+		{
+			threads.push_back(std::thread([&]() {
+				sComInit comInit;
+				int idx = 0;
+				while ((idx = index++) < (int)files.size())
+				{
+					sTextureData data;
+					ReadTexture(files[idx].c_str(), data);
+				}
+			}));
+		}
+		for (auto &th : threads)
+			th.join();
+		out.multiThreadMs = GetSteadyTimeMs() - t0;
+	}
+
+	return true;
+}
+
+
+void cTextureLoader::Clear()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_isLoop = false;
+	}
+	m_jobCond.notify_all();
+	m_stagingCond.notify_all();
+	for (auto &th : m_threads)
+		if (th.joinable())
+			th.join();
+	m_threads.clear();
+
+	for (auto &tex : m_textures)
+	{
+		SAFE_RELEASE(tex->srv);
+		SAFE_RELEASE(tex->tex);
+		delete tex;
+	}
+	m_textures.clear();
+
+	while (!m_jobs.empty())
+		m_jobs.pop();
+	m_staging.clear();
+	m_stagingBytes = 0;
+
+	SAFE_RELEASE(m_placeholderSRV);
+	SAFE_RELEASE(m_placeholderTex);
+}
@@ -0,0 +1,132 @@
+//
+// 2018-05-03, jjuiddong
+// Asynchronous Texture Loader
+//	- file read, DDS header parse, JPG/PNG/BMP decode (WIC) on worker thread
+//	- GPU upload on render thread, bounded staging memory
+//	- placeholder texture returned until upload finish, first frame never block
+//
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+
+
+namespace graphic
+{
+	class cAssetCache;
+
+	// CPU side decoded texture
+	struct sTextureData
+	{
+		struct sSubresource
+		{
+			UINT offset;
+			UINT rowPitch;
+			UINT slicePitch;
+		};
+
+		DXGI_FORMAT format;
+		UINT width;
+		UINT height;
+		UINT mipLevels;
+		UINT arraySize;
+		bool isCube;
+		std::vector<BYTE> pixels;
+		std::vector<sSubresource> subres; // arraySize * mipLevels
+	};
+
+
+	class cTextureLoader
+	{
+	public:
+		struct eState {
+			enum Enum { NONE, QUEUED, LOADING, STAGING, COMPLETE, FAILED };
+		};
+
+		struct sTexture
+		{
+			std::string fileName;
+			int requestMip; // priority, smaller mip first
+			eState::Enum state;
+			ID3D11Texture2D *tex;
+			ID3D11ShaderResourceView *srv;
+			sTextureData data;
+			double requestTime;
+			double loadTime; // milliseconds, request ~ upload finish
+			UINT gpuBytes; // uploaded texture size
+		};
+
+		struct sBenchmark
+		{
+			int fileCount;
+			int failCount;
+			__int64 fileBytes;
+			__int64 decodeBytes;
+			double singleThreadMs;
+			double multiThreadMs;
+			int threadCount;
+		};
+
+		cTextureLoader();
+		virtual ~cTextureLoader();
+
+		bool Create(cRenderer &renderer
+			, const int threadCount = 4
+			, const UINT stagingSize = 32 * 1024 * 1024
+			, const UINT uploadSizePerFrame = 4 * 1024 * 1024
+		);
+		int Load(const char *fileName, const int requestMip = 0);
+		ID3D11ShaderResourceView* GetSRV(const int id);
+		eState::Enum GetState(const int id);
+		bool IsLoadFinish(const int id);
+		int Update(cRenderer &renderer);
+		bool Benchmark(const char *directory, OUT sBenchmark &out);
+		void Clear();
+
+		static bool ReadTexture(const char *fileName, OUT sTextureData &out
+			, OUT __int64 *fileBytes = NULL);
+		static bool ParseDDS(const BYTE *src, const UINT size, OUT sTextureData &out);
+		static bool DecodeWIC(const BYTE *src, const UINT size, OUT sTextureData &out);
+		static bool WriteDDS(const char *fileName, const sTextureData &data);
+
+
+	protected:
+		bool CreatePlaceholder(cRenderer &renderer);
+		bool Upload(cRenderer &renderer, sTexture *texture);
+		void WorkerThread();
+
+
+	public:
+		struct sJob
+		{
+			int id;
+			int requestMip;
+			bool operator<(const sJob &rhs) const {
+				return (requestMip == rhs.requestMip) ? (id > rhs.id)
+					: (requestMip > rhs.requestMip);
+			}
+		};
+
+		std::vector<sTexture*> m_textures; // index = texture id
+		ID3D11Texture2D *m_placeholderTex;
+		ID3D11ShaderResourceView *m_placeholderSRV;
+
+		UINT m_stagingSize; // maximum decoded bytes waiting upload
+		UINT m_stagingBytes;
+		UINT m_uploadSizePerFrame;
+		UINT m_uploadBytes; // last frame upload bytes
+		bool m_isImport; // convert JPG/PNG/BMP to BC compressed DDS with mip chain
+		cAssetCache *m_cache; // import result cache, reference
+
+		bool m_isLoop;
+		std::vector<std::thread> m_threads;
+		std::priority_queue<sJob> m_jobs;
+		std::deque<int> m_staging; // decoded, wait upload
+		std::mutex m_mutex;
+		std::condition_variable m_jobCond;
+		std::condition_variable m_stagingCond;
+	};
+
+}
@@ -0,0 +1,307 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "gbuffer.h"
+#include "assetcache.h"
+#include "profiler.h"
+#include "pipelinecache.h"
+#include "toolpanel.h"
+
+using namespace graphic;
+
+
+cToolPanel::cToolPanel()
+	: m_captureRequest(0)
+{
+	ZeroMemory(&m_drawBenchResult, sizeof(m_drawBenchResult));
+	ZeroMemory(&m_indirectResult, sizeof(m_indirectResult));
+	ZeroMemory(&m_replayResult, sizeof(m_replayResult));
+	ZeroMemory(&m_texBench, sizeof(m_texBench));
+	ZeroMemory(&m_simdBench, sizeof(m_simdBench));
+	ZeroMemory(&m_cullBench, sizeof(m_cullBench));
+	ZeroMemory(&m_lodBench, sizeof(m_lodBench));
+	ZeroMemory(&m_clusterBench, sizeof(m_clusterBench));
+	ZeroMemory(&m_queueBench, sizeof(m_queueBench));
+}
+
+cToolPanel::~cToolPanel()
+{
+	Clear();
+}
+
+
+bool cToolPanel::Create(cRenderer &renderer, const int workerCount)
+{
+	m_drawBench.Create(renderer, workerCount);
+	m_indirectDraw.Create(renderer);
+	return true;
+}
+
+
+// record immediate context call, frame begin ~ frame end
+void cToolPanel::BeginFrame(cRenderer &renderer)
+{
+	if ((m_captureRequest > 0) && !m_capture.IsCapture())
+		if (!m_capture.Begin(renderer, "frame_capture.cap"))
+			m_captureRequest = 0;
+	m_capture.BeginFrame();
+}
+
+
+// before Present()
+void cToolPanel::EndFrame()
+{
+	m_capture.EndFrame();
+	if (m_capture.IsCapture() && (m_capture.m_frameIdx >= m_captureRequest))
+	{
+		m_capture.End();
+		m_captureRequest = 0;
+	}
+	if (m_capture.m_error)
+		m_captureRequest = 0; // unsupported call, no restart
+}
+
+
+void cToolPanel::Render(cRenderer &renderer, sContext &ctx)
+{
+	if (!ImGui::Begin("Tools", NULL, ImVec2(300, 400)))
+	{
+		ImGui::End();
+		return;
+	}
+
+	if (ImGui::Button("Texture Load Benchmark"))
+		ctx.texLoader->Benchmark("../Media", m_texBench);
+	if (m_texBench.fileCount > 0)
+	{
+		ImGui::Text("%d files (%d fail), %d KB -> %d KB", m_texBench.fileCount
+			, m_texBench.failCount, (int)(m_texBench.fileBytes / 1024)
+			, (int)(m_texBench.decodeBytes / 1024));
+		ImGui::Text("1 thread %.1f ms, %d thread %.1f ms", m_texBench.singleThreadMs
+			, m_texBench.threadCount, m_texBench.multiThreadMs);
+	}
+
+	ImGui::Separator();
+	if (ImGui::Button("Draw Benchmark (10k)"))
+		m_drawBench.Run(renderer, *ctx.jobs, m_drawBenchResult, 10000);
+	if (m_drawBenchResult.drawCount > 0)
+	{
+		const cDrawBenchmark::sResult &r = m_drawBenchResult;
+		ImGui::Text("%d draws, %d thread, %s", r.drawCount, r.threadCount
+			, r.isDriverCommandList ? "driver command list" : "emulated command list");
+		ImGui::Text("Immediate %.2f ms", r.immediateMs);
+		ImGui::Text("Deferred record %.2f ms, execute %.2f ms"
+			, r.deferredRecordMs, r.deferredExecuteMs);
+		ImGui::Text("Recorder record %.2f ms (1 thread %.2f ms), replay %.2f ms"
+			, r.recorderRecordMs, r.recorderSingleMs, r.recorderReplayMs);
+	}
+
+	if (ImGui::Button("Indirect Draw Benchmark (100k)"))
+		m_indirectDraw.Run(renderer, m_indirectResult);
+	if (m_indirectResult.instanceCount > 0)
+	{
+		const cIndirectDraw::sResult &r = m_indirectResult;
+		ImGui::Text("visible CPU %d, GPU %d, %s", r.cpuVisibleCount, r.gpuVisibleCount
+			, r.isMatch ? "match" : "mismatch");
+		ImGui::Text("Per object %.2f ms, CPU cull %.2f ms, GPU cull %.2f ms"
+			, r.perObjectMs, r.cpuCullMs, r.gpuCullMs);
+	}
+
+	if (ImGui::Button("SIMD Math Benchmark (100k)"))
+		cSimdMath::Benchmark(100000, m_simdBench);
+	if (m_simdBench.count > 0)
+	{
+		ImGui::Text("Matrix scalar %.2f ms, simd %.2f ms"
+			, m_simdBench.scalarMatrixMs, m_simdBench.simdMatrixMs);
+		ImGui::Text("Point scalar %.2f ms, simd %.2f ms (%s), max error %f"
+			, m_simdBench.scalarPointMs, m_simdBench.simdPointMs
+			, m_simdBench.isAvx ? "AVX" : "SSE", m_simdBench.maxError);
+	}
+
+	if (ImGui::Button("Culling Benchmark (100k)"))
+		ctx.frustumCuller->Benchmark(*ctx.jobs, 100000, m_cullBench);
+	if (m_cullBench.count > 0)
+	{
+		ImGui::Text("visible %d, scalar %.2f ms, simd %.2f ms (%s)", m_cullBench.visibleCount
+			, m_cullBench.scalarMs, m_cullBench.simdMs, m_cullBench.isAvx ? "AVX" : "SSE");
+		ImGui::Text("%d thread %.2f ms, %s", m_cullBench.threadCount, m_cullBench.parallelMs
+			, m_cullBench.isMatch ? "match" : "mismatch");
+	}
+
+	if (!ctx.meshLod->m_lods.empty())
+	{
+		ImGui::Separator();
+		if (ImGui::Button("LOD Benchmark"))
+		{
+			const float projScale = GetMainCamera().GetProjectionMatrix().m[1][1] * ctx.height * 0.5f;
+			ctx.meshLod->Benchmark(ctx.boundX, ctx.boundY, ctx.boundZ, ctx.boundR
+				, ctx.modelCount, projScale, m_lodBench);
+		}
+		for (int i = 0; (m_lodBench.count > 0) && (i < cMeshLod::MAX_DISTANCE); ++i)
+			ImGui::Text("dist %.1f: %d tri (full %d), %d/%d/%d/%d", m_lodBench.distance[i]
+				, m_lodBench.lodTriangles[i], m_lodBench.fullTriangles[i]
+				, m_lodBench.lodHistogram[i][0], m_lodBench.lodHistogram[i][1]
+				, m_lodBench.lodHistogram[i][2], m_lodBench.lodHistogram[i][3]);
+
+		if (ImGui::Button("Cluster Culling Benchmark"))
+			ClusterBenchmark(ctx);
+		if (m_clusterBench.objectCount > 0)
+		{
+			const cMeshletCuller::sStats &s = m_clusterBench.stats;
+			ImGui::Text("%d x %d cluster, tri %d -> %d", m_clusterBench.objectCount
+				, m_clusterBench.clusterCount, s.triangleCount, s.visibleTriangle);
+			ImGui::Text("Removed tri, frustum %d, backface %d", s.frustumTriangle
+				, s.coneTriangle);
+			ImGui::Text("scalar %.2f ms, simd %.2f ms, %d thread %.2f ms, %s"
+				, m_clusterBench.scalarMs, m_clusterBench.simdMs, m_clusterBench.threadCount
+				, m_clusterBench.parallelMs, m_clusterBench.isMatch ? "match" : "mismatch");
+		}
+
+		if (ImGui::Button("Render Queue Benchmark (100k)"))
+			RenderQueueBenchmark(renderer, ctx);
+		if (m_queueBench.drawCount > 0)
+		{
+			const cRenderQueue::sBenchmark &b = m_queueBench;
+			ImGui::Text("std::sort %.2f ms, radix %.2f ms, %d thread %.2f ms, %s", b.stdSortMs
+				, b.radixMs, b.threadCount, b.parallelMs, b.isMatch ? "match" : "mismatch");
+			ImGui::Text("%d batch (%.2f ms), state change %d -> %d", b.batchCount, b.batchMs
+				, b.unsortedChange, b.sortedChange);
+			ImGui::Text("submit unsorted %.2f ms, sort + batch + submit %.2f ms", b.unsortedSubmitMs
+				, b.parallelMs + b.batchMs + b.sortedSubmitMs);
+		}
+	}
+
+	ImGui::Separator();
+	if (ImGui::Button("Export Chrome Trace"))
+		ctx.profiler->WriteChromeTrace("profile_trace.json");
+
+	if (m_capture.IsCapture())
+		ImGui::Text("Capture %d frame, %d KB", m_capture.m_frameIdx
+			, (int)(m_capture.m_fileBytes / 1024));
+	else if (ImGui::Button("Capture 10 Frames"))
+		m_captureRequest = 10;
+	if (m_capture.m_error)
+		ImGui::TextColored(ImVec4(1, 0.3f, 0.3f, 1), "Capture failed, %s not recorded"
+			, m_capture.m_error);
+	if (ImGui::Button("Replay Null"))
+		m_replay.Replay("frame_capture.cap", cFrameReplay::eBackend::NONE, m_replayResult);
+	ImGui::SameLine();
+	if (ImGui::Button("Replay WARP"))
+		m_replay.Replay("frame_capture.cap", cFrameReplay::eBackend::WARP, m_replayResult);
+	if (m_replayResult.unsupported[0])
+		ImGui::TextColored(ImVec4(1, 0.3f, 0.3f, 1), "Replay failed, incomplete capture (%s)"
+			, m_replayResult.unsupported);
+	if (m_replayResult.frameCount > 0)
+	{
+		const cFrameReplay::sResult &r = m_replayResult;
+		ImGui::Text("%d frame, %d KB, %d object", r.frameCount
+			, (int)(r.fileBytes / 1024), r.objectCount);
+		ImGui::Text("%d call/frame, %.3f ms/frame (max %.3f ms)"
+			, r.callCount / r.frameCount, r.replayMs / r.frameCount, r.maxFrameMs);
+		for (int i = eCaptureCmd::OBJECT + 1; i < eCaptureCmd::MAX; ++i)
+			if (r.calls[i] > 0)
+				ImGui::Text("  %s %d", cFrameCapture::GetCommandName((eCaptureCmd::Enum)i)
+					, r.calls[i] / r.frameCount);
+	}
+
+	ImGui::End();
+}
+
+
+bool cToolPanel::IsCapture() const
+{
+	return m_capture.IsCapture();
+}
+
+
+// boxlifter.x LOD0 cluster, 8x8 grid, sample default camera
+// import once, cached .mesh
+void cToolPanel::ClusterBenchmark(sContext &ctx)
+{
+	std::string meshFileName;
+	std::vector<sMeshData> lods;
+	if (!cMeshImporter::Import(ctx.clusterMeshPath, meshFileName, ctx.assetCache)
+		|| !cMeshImporter::ReadMesh(meshFileName.c_str(), lods))
+		return;
+
+	cMeshletCuller::sClusterSet clusters;
+	cMeshletCuller::CreateClusterSet(lods[0].meshlets, clusters);
+
+	const Vector3 eyePos(30, 30, -30);
+	Matrix44 view, proj;
+	view.SetView(eyePos, (Vector3(0, 0, 0) - eyePos).Normal(), Vector3(0, 1, 0));
+	proj.SetProjection(MATH_PI / 4.f, ctx.width / ctx.height, 0.1f, 10000.0f);
+	ctx.meshletCuller->Benchmark(*ctx.jobs, clusters, view * proj, eyePos, m_clusterBench);
+}
+
+
+// 100k random draw, GBuffer pipeline, texture material, chessqueen LOD mesh
+// one meshlet per draw (GPU load small), CPU submit time only, GBuffer target
+// unsorted: cbPerFrame world per draw, sorted: instanced batch (cbPerFrameInstancing)
+void cToolPanel::RenderQueueBenchmark(cRenderer &renderer, sContext &ctx)
+{
+	cMeshLod &meshLod = *ctx.meshLod;
+	cPipelineCache &pipelineCache = *ctx.pipelineCache;
+	if (meshLod.m_lods.empty() || !ctx.gbuff->Begin(renderer))
+		return;
+
+	ID3D11DeviceContext *devContext = renderer.GetDevContext();
+	GetMainCamera().Bind(renderer);
+	cShader11 *deferredShader = renderer.m_shaderMgr.LoadShader(renderer, ctx.deferredShaderPath
+		, eVertexType::POSITION | eVertexType::NORMAL | eVertexType::TEXTURE0, false);
+	deferredShader->SetTechnique("Unlit");
+	deferredShader->Begin();
+	deferredShader->BeginPass(renderer, 0); // sMeshVertex input layout
+
+	pipelineCache.Invalidate();
+
+	std::vector<cMeshletCuller::sRange> ranges[cMeshImporter::MAX_LOD];
+	for (u_int i = 0; i < meshLod.m_lods.size(); ++i)
+	{
+		const cMeshletCuller::sClusterSet &clusters = meshLod.m_lods[i].clusters;
+		cMeshletCuller::sRange range;
+		range.indexOffset = clusters.indexOffset.empty() ? 0 : clusters.indexOffset[0];
+		range.indexCount = clusters.triangleCount.empty() ? meshLod.m_lods[i].indexCount
+			: clusters.triangleCount[0] * 3;
+		ranges[i].push_back(range);
+	}
+
+	m_queue.Benchmark(*ctx.jobs, 100000, 1, ctx.texCount, (int)meshLod.m_lods.size()
+		, [&](const cRenderQueue::sBatch &batch, const cRenderQueue::sItem *items) {
+		const int lod = cRenderQueue::GetMesh(batch.key);
+		ID3D11ShaderResourceView *srv = ctx.texLoader->GetSRV(ctx.texIds[cRenderQueue::GetMaterial(batch.key)]);
+		devContext->PSSetShaderResources(0, 1, &srv);
+
+		if ((batch.count > 1) && pipelineCache.Bind(renderer, ctx.psoGBufferInst))
+		{
+			for (UINT i = 0; i < batch.count; ++i)
+				ctx.cbInstancing->m_v->worldInst[i] = XMMatrixTranspose(XMMatrixScaling(10.f, 10.f, 10.f)
+					* XMMatrixTranslation((float)(items[i].index % 316) - 158.f, 0.f
+						, (float)(items[i].index / 316) - 158.f));
+			ctx.cbInstancing->Update(renderer, 3);
+			meshLod.RenderInstanced(renderer, lod, batch.count, &ranges[lod]);
+			return;
+		}
+
+		pipelineCache.Bind(renderer, ctx.psoGBuffer);
+		for (UINT i = 0; i < batch.count; ++i)
+			meshLod.Render(renderer, lod, XMMatrixScaling(10.f, 10.f, 10.f)
+				* XMMatrixTranslation((float)(items[i].index % 316) - 158.f, 0.f
+					, (float)(items[i].index / 316) - 158.f), false, &ranges[lod]);
+	}, m_queueBench);
+
+	pipelineCache.Invalidate();
+	ctx.gbuff->End(renderer);
+}
+
+
+void cToolPanel::Clear()
+{
+	m_capture.End();
+	m_replay.Clear();
+	m_drawBench.Clear();
+	m_indirectDraw.Clear();
+	m_queue.Clear();
+}
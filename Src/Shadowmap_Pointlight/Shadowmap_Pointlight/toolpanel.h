@@ -0,0 +1,94 @@
+//
+// 2018-05-26, jjuiddong
+// Tool Panel
+//	- benchmark, frame capture/replay, trace export ImGui window
+//	- tool object, last result owned here, sample OnRender() scene option only
+//	- sample object accessed by sContext, set every frame before Render()
+//
+#pragma once
+
+#include "cbstruct.h"
+#include "drawbenchmark.h"
+#include "indirectdraw.h"
+#include "framecapture.h"
+#include "framereplay.h"
+#include "simdmath.h"
+#include "meshlod.h"
+#include "textureloader.h"
+
+
+class cGBuffer;
+
+namespace graphic
+{
+
+	class cAssetCache;
+	class cProfiler;
+	class cPipelineCache;
+
+	class cToolPanel
+	{
+	public:
+		// sample object, not owned
+		struct sContext
+		{
+			cJobSystem *jobs;
+			cProfiler *profiler;
+			cAssetCache *assetCache;
+			cTextureLoader *texLoader;
+			const int *texIds;
+			int texCount;
+			cGBuffer *gbuff;
+			cPipelineCache *pipelineCache;
+			int psoGBuffer;
+			int psoGBufferInst; // INSTANCING variant
+			cConstantBuffer<sCbInstancing> *cbInstancing;
+			cMeshLod *meshLod;
+			cFrustumCuller *frustumCuller;
+			cMeshletCuller *meshletCuller;
+			const float *boundX; // model bounding sphere, world space
+			const float *boundY;
+			const float *boundZ;
+			const float *boundR;
+			int modelCount;
+			float width; // back buffer size
+			float height;
+			const char *deferredShaderPath;
+			const char *clusterMeshPath; // cluster culling benchmark mesh
+		};
+
+		cToolPanel();
+		virtual ~cToolPanel();
+
+		bool Create(cRenderer &renderer, const int workerCount);
+		void BeginFrame(cRenderer &renderer);
+		void EndFrame();
+		void Render(cRenderer &renderer, sContext &ctx);
+		bool IsCapture() const;
+		void Clear();
+
+
+	protected:
+		void ClusterBenchmark(sContext &ctx);
+		void RenderQueueBenchmark(cRenderer &renderer, sContext &ctx);
+
+
+	public:
+		cDrawBenchmark m_drawBench;
+		cDrawBenchmark::sResult m_drawBenchResult;
+		cIndirectDraw m_indirectDraw;
+		cIndirectDraw::sResult m_indirectResult;
+		cFrameCapture m_capture;
+		cFrameReplay m_replay;
+		cFrameReplay::sResult m_replayResult;
+		int m_captureRequest; // capture frame count, start next frame
+		cRenderQueue m_queue; // Render Queue Benchmark, sample queue untouched
+		cTextureLoader::sBenchmark m_texBench;
+		cSimdMath::sBenchmark m_simdBench;
+		cFrustumCuller::sBenchmark m_cullBench;
+		cMeshLod::sBenchmark m_lodBench;
+		cMeshletCuller::sBenchmark m_clusterBench;
+		cRenderQueue::sBenchmark m_queueBench;
+	};
+
+}
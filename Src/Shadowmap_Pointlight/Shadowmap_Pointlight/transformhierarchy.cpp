@@ -0,0 +1,179 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "transformhierarchy.h"
+
+using namespace graphic;
+
+
+cTransformHierarchy::cTransformHierarchy()
+	: m_firstDirty(0)
+	, m_dirtyCount(0)
+	, m_updateCount(0)
+	, m_batchCount(0)
+{
+}
+
+cTransformHierarchy::~cTransformHierarchy()
+{
+	Clear();
+}
+
+
+// parent: -1 = root, parent must be added before child
+// return node id
+int cTransformHierarchy::AddNode(const int parent, const Matrix44 &local)
+{
+	const int id = (int)m_parents.size();
+	RETV2(parent >= id, -1);
+
+	m_parents.push_back(parent);
+	m_locals.push_back(local);
+	m_worlds.push_back(local);
+	m_dirty.push_back(0);
+	m_localCenters.push_back(Vector3(0, 0, 0));
+	m_localRadius.push_back(0.f);
+	m_boundX.push_back(0.f);
+	m_boundY.push_back(0.f);
+	m_boundZ.push_back(0.f);
+	m_boundR.push_back(0.f);
+	m_updateList.reserve(m_parents.size());
+
+	SetLocal(id, local);
+	return id;
+}
+
+
+void cTransformHierarchy::SetLocal(const int id, const Matrix44 &local)
+{
+	m_locals[id] = local;
+	SetDirty(id);
+}
+
+
+// local space bounding sphere
+void cTransformHierarchy::SetBounds(const int id, const Vector3 &center, const float radius)
+{
+	m_localCenters[id] = center;
+	m_localRadius[id] = radius;
+	SetDirty(id);
+}
+
+
+void cTransformHierarchy::SetDirty(const int id)
+{
+	if (m_dirty[id])
+		return;
+
+	m_dirty[id] = 1;
+	m_firstDirty = (m_dirtyCount == 0) ? id : min(m_firstDirty, id);
+	++m_dirtyCount;
+}
+
+
+const Matrix44& cTransformHierarchy::GetWorld(const int id) const
+{
+	return m_worlds[id];
+}
+
+
+int cTransformHierarchy::GetNodeCount() const
+{
+	return (int)m_parents.size();
+}
+
+
+// recompute dirty node and descendant world matrix, world bounding sphere
+// return recompute node count
+int cTransformHierarchy::Update()
+{
+	m_updateCount = 0;
+	m_batchCount = 0;
+	if (m_dirtyCount == 0)
+		return 0;
+
+	// propagate dirty flag to descendant, parent visited first
+	m_updateList.clear();
+	const int nodeCount = (int)m_parents.size();
+	for (int i = m_firstDirty; i < nodeCount; ++i)
+	{
+		const int parent = m_parents[i];
+		if (!m_dirty[i] && (parent >= 0) && m_dirty[parent])
+			m_dirty[i] = 1;
+		if (m_dirty[i])
+			m_updateList.push_back(i);
+	}
+
+	// world = local * parent world
+	// consecutive sibling -> one batch, same parent matrix
+	const int count = (int)m_updateList.size();
+	for (int k = 0; k < count; )
+	{
+		const int id = m_updateList[k];
+		const int parent = m_parents[id];
+
+		int n = 1;
+		while ((k + n < count) && (m_updateList[k + n] == id + n)
+			&& (m_parents[id + n] == parent))
+			++n;
+
+		if (parent < 0)
+		{
+			for (int i = 0; i < n; ++i)
+				m_worlds[id + i] = m_locals[id + i];
+		}
+		else
+		{
+			cSimdMath::MultiplyBatch(&m_locals[id].m[0][0], &m_worlds[parent].m[0][0]
+				, n, &m_worlds[id].m[0][0]);
+			++m_batchCount;
+		}
+		k += n;
+	}
+
+	// world bounding sphere, radius scaled by largest axis
+	for (auto id : m_updateList)
+	{
+		const Matrix44 &tm = m_worlds[id];
+		Vector3 center;
+		cSimdMath::TransformPoints(&tm.m[0][0], &m_localCenters[id], 1, &center);
+
+		float scale = 0.f;
+		for (int r = 0; r < 3; ++r)
+			scale = max(scale, tm.m[r][0] * tm.m[r][0] + tm.m[r][1] * tm.m[r][1]
+				+ tm.m[r][2] * tm.m[r][2]);
+
+		m_boundX[id] = center.x;
+		m_boundY[id] = center.y;
+		m_boundZ[id] = center.z;
+		m_boundR[id] = m_localRadius[id] * sqrt(scale);
+		m_dirty[id] = 0;
+	}
+
+	m_updateCount = count;
+	m_dirtyCount = 0;
+	m_firstDirty = nodeCount;
+	return count;
+}
+
+
+void cTransformHierarchy::Clear()
+{
+	m_parents.clear();
+	m_locals.clear();
+	m_worlds.clear();
+	m_dirty.clear();
+	m_localCenters.clear();
+	m_localRadius.clear();
+	m_boundX.clear();
+	m_boundY.clear();
+	m_boundZ.clear();
+	m_boundR.clear();
+	m_updateList.clear();
+	m_firstDirty = 0;
+	m_dirtyCount = 0;
+	m_updateCount = 0;
+	m_batchCount = 0;
+}
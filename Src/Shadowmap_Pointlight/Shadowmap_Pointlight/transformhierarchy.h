@@ -0,0 +1,58 @@
+//
+// 2018-05-14, jjuiddong
+// Transform Hierarchy
+//	- flat node array, parent index < node index (topological order)
+//	- SetLocal() mark dirty, Update() recompute dirty subtree only
+//	- consecutive sibling world matrix update batched (cSimdMath)
+//	- nothing dirty -> Update() return immediately, static scene zero cost
+//	- world bounding sphere, SoA array for culling
+//
+#pragma once
+
+#include "simdmath.h"
+
+
+namespace graphic
+{
+
+	class cTransformHierarchy
+	{
+	public:
+		cTransformHierarchy();
+		virtual ~cTransformHierarchy();
+
+		int AddNode(const int parent, const Matrix44 &local);
+		void SetLocal(const int id, const Matrix44 &local);
+		void SetBounds(const int id, const Vector3 &center, const float radius);
+		const Matrix44& GetWorld(const int id) const;
+		int GetNodeCount() const;
+		int Update();
+		void Clear();
+
+
+	protected:
+		void SetDirty(const int id);
+
+
+	public:
+		std::vector<int> m_parents; // -1 = root
+		std::vector<Matrix44> m_locals;
+		std::vector<Matrix44> m_worlds;
+		std::vector<BYTE> m_dirty;
+		std::vector<Vector3> m_localCenters; // bounding sphere, local space
+		std::vector<float> m_localRadius;
+
+		// world bounding sphere, SoA
+		std::vector<float> m_boundX;
+		std::vector<float> m_boundY;
+		std::vector<float> m_boundZ;
+		std::vector<float> m_boundR;
+
+		std::vector<int> m_updateList; // temporary, Update()
+		int m_firstDirty; // lowest dirty node index
+		int m_dirtyCount;
+		int m_updateCount; // last Update() recompute node count
+		int m_batchCount; // last Update() MultiplyBatch() call count
+	};
+
+}
@@ -0,0 +1,265 @@
+
+#include "../../../../../Common/Common/common.h"
+using namespace common;
+#include "../../../../../Common/Graphic11/graphic11.h"
+#include "../../../../../Common/Framework11/framework11.h"
+#include "vertexcodec.h"
+
+using namespace graphic;
+
+
+namespace
+{
+	const float g_radToDeg = 180.f / 3.14159265f;
+
+	inline float Clamp(const float v, const float lo, const float hi)
+	{
+		return (v < lo) ? lo : ((v > hi) ? hi : v);
+	}
+
+	inline float Sign(const float v)
+	{
+		return (v >= 0.f) ? 1.f : -1.f;
+	}
+
+	// angle between vector, degree
+	// atan2, acos not precise for small angle
+	inline float GetAngle(const Vector3 &a, const Vector3 &b)
+	{
+		return atan2f(a.CrossProduct(b).Length(), a.DotProduct(b)) * g_radToDeg;
+	}
+
+	// octahedral decode error bound, degree
+	// oct offset <= step * sqrt(2) / 2, unit vector angle <= 3 * oct offset
+	inline float GetOctBound(const int bits)
+	{
+		const float step = 1.f / (float)((1 << (bits - 1)) - 1);
+		return 3.f * step * 0.7072f * g_radToDeg;
+	}
+}
+
+
+// bound of all mesh, one decode constant for all LOD
+cVertexCodec::sDecode cVertexCodec::GetBound(const std::vector<sMeshData> &meshes)
+{
+	Vector3 bmin(FLT_MAX, FLT_MAX, FLT_MAX);
+	Vector3 bmax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (auto &mesh : meshes)
+	{
+		for (auto &vtx : mesh.vertices)
+		{
+			bmin = Vector3(min(bmin.x, vtx.pos.x), min(bmin.y, vtx.pos.y), min(bmin.z, vtx.pos.z));
+			bmax = Vector3(max(bmax.x, vtx.pos.x), max(bmax.y, vtx.pos.y), max(bmax.z, vtx.pos.z));
+		}
+	}
+
+	sDecode decode;
+	if (bmin.x > bmax.x)
+	{
+		decode.posOffset = XMFLOAT4(0, 0, 0, 0);
+		decode.posScale = XMFLOAT4(0, 0, 0, 0);
+		return decode;
+	}
+	decode.posOffset = XMFLOAT4(bmin.x, bmin.y, bmin.z, 0);
+	decode.posScale = XMFLOAT4(bmax.x - bmin.x, bmax.y - bmin.y, bmax.z - bmin.z, 0);
+	return decode;
+}
+
+
+void cVertexCodec::Encode(const sMeshData &mesh, const sDecode &decode
+	, OUT std::vector<sPackedPos> &positions, OUT std::vector<sPackedAttr> &attrs)
+{
+	positions.resize(mesh.vertices.size());
+	attrs.resize(mesh.vertices.size());
+	for (u_int i = 0; i < mesh.vertices.size(); ++i)
+	{
+		const sMeshVertex &vtx = mesh.vertices[i];
+		positions[i] = EncodePosition(vtx.pos, decode);
+
+		int nx, ny;
+		EncodeOct(vtx.normal, 16, nx, ny);
+		attrs[i].nx = (short)nx;
+		attrs[i].ny = (short)ny;
+		attrs[i].u = FloatToHalf(vtx.uv.x);
+		attrs[i].v = FloatToHalf(vtx.uv.y);
+	}
+}
+
+
+// encode -> decode, max error per attribute
+void cVertexCodec::Validate(const sMeshData &mesh, const sDecode &decode, OUT sError &out)
+{
+	ZeroMemory(&out, sizeof(out));
+
+	// unorm16 round, half step per axis
+	const Vector3 scale(decode.posScale.x, decode.posScale.y, decode.posScale.z);
+	out.positionBound = scale.Length() * (0.5f / 65535.f) * 1.001f;
+	out.normalBound = GetOctBound(16);
+	out.normal8Bound = GetOctBound(8);
+
+	float maxUV = 0.f;
+	for (auto &vtx : mesh.vertices)
+	{
+		const Vector3 pos = DecodePosition(EncodePosition(vtx.pos, decode), decode);
+		out.position = max(out.position, (pos - vtx.pos).Length());
+
+		const float len = vtx.normal.Length();
+		if (len > 0.f)
+		{
+			const Vector3 n = vtx.normal * (1.f / len);
+			int x, y;
+			EncodeOct(n, 16, x, y);
+			out.normal = max(out.normal, GetAngle(n, DecodeOct(x, y, 16)));
+			EncodeOct(n, 8, x, y);
+			out.normal8 = max(out.normal8, GetAngle(n, DecodeOct(x, y, 8)));
+		}
+
+		const float u = HalfToFloat(FloatToHalf(vtx.uv.x));
+		const float v = HalfToFloat(FloatToHalf(vtx.uv.y));
+		out.uv = max(out.uv, max(fabsf(u - vtx.uv.x), fabsf(v - vtx.uv.y)));
+		maxUV = max(maxUV, max(fabsf(vtx.uv.x), fabsf(vtx.uv.y)));
+	}
+
+	// half float, 11 bit significand, round to nearest (+ subnormal step)
+	out.uvBound = maxUV * (1.f / 2048.f) + (1.f / 16777216.f);
+
+	out.isValid = (out.position <= out.positionBound)
+		&& (out.normal <= out.normalBound)
+		&& (out.normal8 <= out.normal8Bound)
+		&& (out.uv <= out.uvBound);
+}
+
+
+cVertexCodec::sPackedPos cVertexCodec::EncodePosition(const Vector3 &pos, const sDecode &decode)
+{
+	const float p[3] = { pos.x - decode.posOffset.x, pos.y - decode.posOffset.y
+		, pos.z - decode.posOffset.z };
+	const float s[3] = { decode.posScale.x, decode.posScale.y, decode.posScale.z };
+	WORD q[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		const float t = (s[i] > 0.f) ? Clamp(p[i] / s[i], 0.f, 1.f) : 0.f;
+		q[i] = (WORD)(t * 65535.f + 0.5f);
+	}
+
+	sPackedPos out;
+	out.x = q[0];
+	out.y = q[1];
+	out.z = q[2];
+	out.w = 0;
+	return out;
+}
+
+
+// same with vertexdecode.fx, DecodePosition()
+Vector3 cVertexCodec::DecodePosition(const sPackedPos &pos, const sDecode &decode)
+{
+	const float rcp = 1.f / 65535.f;
+	return Vector3(decode.posOffset.x + pos.x * rcp * decode.posScale.x
+		, decode.posOffset.y + pos.y * rcp * decode.posScale.y
+		, decode.posOffset.z + pos.z * rcp * decode.posScale.z);
+}
+
+
+// octahedral map, bits = 8 or 16 (snorm)
+// floor/ceil 4 candidate, choose minimum decode error
+void cVertexCodec::EncodeOct(const Vector3 &normal, const int bits, OUT int &x, OUT int &y)
+{
+	const float scale = (float)((1 << (bits - 1)) - 1);
+	const float l1 = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+	float ox = (l1 > 0.f) ? normal.x / l1 : 0.f;
+	float oy = (l1 > 0.f) ? normal.y / l1 : 0.f;
+	if (normal.z < 0.f)
+	{
+		const float tx = (1.f - fabsf(oy)) * Sign(ox);
+		const float ty = (1.f - fabsf(ox)) * Sign(oy);
+		ox = tx;
+		oy = ty;
+	}
+
+	const int bx = (int)floorf(Clamp(ox, -1.f, 1.f) * scale);
+	const int by = (int)floorf(Clamp(oy, -1.f, 1.f) * scale);
+	const int limit = (int)scale;
+	float best = FLT_MAX;
+	x = bx;
+	y = by;
+	for (int i = 0; i < 4; ++i)
+	{
+		const int cx = max(-limit, min(limit, bx + (i & 1)));
+		const int cy = max(-limit, min(limit, by + (i >> 1)));
+		const float angle = GetAngle(DecodeOct(cx, cy, bits), normal);
+		if (angle < best)
+		{
+			best = angle;
+			x = cx;
+			y = cy;
+		}
+	}
+}
+
+
+// same with vertexdecode.fx, DecodeOctNormal()
+Vector3 cVertexCodec::DecodeOct(const int x, const int y, const int bits)
+{
+	const float scale = (float)((1 << (bits - 1)) - 1);
+	const float fx = max(-1.f, x / scale); // snorm conversion
+	const float fy = max(-1.f, y / scale);
+	Vector3 n(fx, fy, 1.f - fabsf(fx) - fabsf(fy));
+	const float t = max(0.f, -n.z);
+	n.x += (n.x >= 0.f) ? -t : t;
+	n.y += (n.y >= 0.f) ? -t : t;
+	return n.Normal();
+}
+
+
+// round to nearest, overflow -> infinity
+WORD cVertexCodec::FloatToHalf(const float f)
+{
+	DWORD bits;
+	memcpy(&bits, &f, sizeof(bits));
+	const WORD sign = (WORD)((bits >> 16) & 0x8000);
+	const DWORD absBits = bits & 0x7fffffff;
+	if (absBits >= 0x7f800000) // inf, nan
+		return sign | 0x7c00 | ((absBits > 0x7f800000) ? 0x200 : 0);
+
+	const int exp = (int)(absBits >> 23) - 127 + 15;
+	DWORD mant = absBits & 0x7fffff;
+	if (exp >= 31)
+		return sign | 0x7c00;
+	if (exp <= 0) // subnormal
+	{
+		if (exp < -10)
+			return sign;
+		mant |= 0x800000;
+		const int shift = 14 - exp;
+		DWORD half = mant >> shift;
+		if ((mant >> (shift - 1)) & 1)
+			++half;
+		return sign | (WORD)half;
+	}
+
+	// mantissa carry overflow to exponent
+	DWORD half = ((DWORD)exp << 10) | (mant >> 13);
+	if (mant & 0x1000)
+		++half;
+	return sign | (WORD)min(half, (DWORD)0x7c00);
+}
+
+
+float cVertexCodec::HalfToFloat(const WORD h)
+{
+	const DWORD sign = (DWORD)(h & 0x8000) << 16;
+	const DWORD exp = (h >> 10) & 0x1f;
+	const DWORD mant = h & 0x3ff;
+	if (0 == exp) // zero, subnormal
+	{
+		const float v = mant * (1.f / 16777216.f);
+		return sign ? -v : v;
+	}
+
+	const DWORD bits = (31 == exp) ? (sign | 0x7f800000 | (mant << 13))
+		: (sign | ((exp - 15 + 127) << 23) | (mant << 13));
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
@@ -0,0 +1,68 @@
+//
+// 2018-05-20, jjuiddong
+// Vertex Codec
+//	- compressed POSITION | NORMAL | TEXTURE0, 32 -> 16 bytes (2 stream, 8 + 8)
+//	- stream 0: position, 16 bit unorm relative to mesh bound (shadow pass, position only)
+//	- stream 1: normal octahedral 2x16 snorm, uv 2x16 half float
+//	- C++ reference codec, same decode with vertexdecode.fx
+//	- Validate() : decode error vs analytic error bound
+//
+#pragma once
+
+#include "meshimporter.h"
+
+
+namespace graphic
+{
+
+	class cVertexCodec
+	{
+	public:
+		// R16G16B16A16_UNORM, w = 0
+		struct sPackedPos
+		{
+			WORD x, y, z, w;
+		};
+
+		// R16G16_SNORM normal, R16G16_FLOAT uv
+		struct sPackedAttr
+		{
+			short nx, ny;
+			WORD u, v;
+		};
+
+		// position = offset + unorm * scale, HLSL cbVertexDecode
+		struct sDecode
+		{
+			XMFLOAT4 posOffset; // xyz: bound min
+			XMFLOAT4 posScale; // xyz: bound size
+		};
+
+		// max decode error, analytic bound
+		struct sError
+		{
+			float position; // distance, mesh space
+			float positionBound;
+			float normal; // angle, degree, 2x16
+			float normalBound;
+			float normal8; // angle, degree, 2x8 (reference)
+			float normal8Bound;
+			float uv;
+			float uvBound;
+			bool isValid; // all error <= bound
+		};
+
+		static sDecode GetBound(const std::vector<sMeshData> &meshes);
+		static void Encode(const sMeshData &mesh, const sDecode &decode
+			, OUT std::vector<sPackedPos> &positions, OUT std::vector<sPackedAttr> &attrs);
+		static void Validate(const sMeshData &mesh, const sDecode &decode, OUT sError &out);
+
+		static sPackedPos EncodePosition(const Vector3 &pos, const sDecode &decode);
+		static Vector3 DecodePosition(const sPackedPos &pos, const sDecode &decode);
+		static void EncodeOct(const Vector3 &normal, const int bits, OUT int &x, OUT int &y);
+		static Vector3 DecodeOct(const int x, const int y, const int bits);
+		static WORD FloatToHalf(const float f);
+		static float HalfToFloat(const WORD h);
+	};
+
+}
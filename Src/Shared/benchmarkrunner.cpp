@@ -0,0 +1,280 @@
+
+#include "platform.h"
+#include "benchmarkrunner.h"
+#include "steadytimer.h"
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+
+using namespace graphic;
+
+
+namespace
+{
+	// "-name=value" in command line, return false if not found
+	bool GetOption(const char *commandLine, const char *name, OUT std::string &value)
+	{
+		const char *p = strstr(commandLine, name);
+		if (!p)
+			return false;
+
+		p += strlen(name);
+		value.clear();
+		if ('=' == *p)
+		{
+			++p;
+			const char end = ('"' == *p) ? '"' : ' ';
+			if ('"' == *p)
+				++p;
+			while (*p && (end != *p))
+				value += *p++;
+		}
+		return true;
+	}
+
+	void WriteStat(FILE *fp, const char *name, std::vector<float> &values)
+	{
+		double sum = 0;
+		for (auto v : values)
+			sum += v;
+		fprintf(fp, "\"%s\": {\"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}"
+			, name, values.empty() ? 0.0 : sum / values.size()
+			, cBenchmarkRunner::Percentile(values, 0.5f)
+			, cBenchmarkRunner::Percentile(values, 0.95f)
+			, cBenchmarkRunner::Percentile(values, 0.99f)
+			, cBenchmarkRunner::Percentile(values, 1.f));
+	}
+}
+
+
+cBenchmarkRunner::cBenchmarkRunner()
+	: m_isRun(false)
+	, m_isWrite(false)
+	, m_warmupFrames(60)
+	, m_measureFrames(600)
+	, m_frame(0)
+	, m_fixedDelta(1.f / 60.f)
+	, m_prevMs(0)
+{
+}
+
+cBenchmarkRunner::~cBenchmarkRunner()
+{
+	Clear();
+}
+
+
+// return true if benchmark mode
+bool cBenchmarkRunner::Init(const char *commandLine, const char *sampleName)
+{
+	Clear();
+
+	std::string value;
+	if (!commandLine || !GetOption(commandLine, "-benchmark", value))
+		return false;
+
+	m_isRun = true;
+	m_sampleName = sampleName;
+	m_outFileName = m_sampleName + "_benchmark.json";
+	if (GetOption(commandLine, "-warmup", value))
+		m_warmupFrames = std::max(0, atoi(value.c_str()));
+	if (GetOption(commandLine, "-frames", value))
+		m_measureFrames = std::max(1, atoi(value.c_str()));
+	if (GetOption(commandLine, "-out", value) && !value.empty())
+		m_outFileName = value;
+
+	m_frameMs.reserve(m_measureFrames);
+	m_frameAllocs.reserve(m_measureFrames);
+	return true;
+}
+
+
+// key frame must be added time order
+void cBenchmarkRunner::AddCameraKey(const float time, const float *eyePos
+	, const float *lookAt)
+{
+	sCameraKey key;
+	key.time = time;
+	for (int i = 0; i < 3; ++i)
+	{
+		key.eyePos[i] = eyePos[i];
+		key.lookAt[i] = lookAt[i];
+	}
+	m_cameraPath.push_back(key);
+}
+
+
+// orbit around center, height alternate high, low every key
+// keyCount + 1 key, last key = first key (loop)
+void cBenchmarkRunner::AddOrbit(const float *center, const float radius
+	, const float lowHeight, const float highHeight
+	, const int keyCount //= 8
+	, const float keyTime //= 1.5f
+)
+{
+	for (int i = 0; i <= keyCount; ++i)
+	{
+		const float angle = 3.141592654f * 2.f * i / keyCount;
+		const float eyePos[3] = {
+			center[0] + cosf(angle) * radius
+			, center[1] + ((i % 2) ? lowHeight : highHeight)
+			, center[2] + sinf(angle) * radius };
+		AddCameraKey(i * keyTime, eyePos, center);
+	}
+}
+
+
+// camera of current frame, loop camera path
+void cBenchmarkRunner::GetCamera(OUT float *eyePos, OUT float *lookAt) const
+{
+	if (m_cameraPath.empty())
+		return;
+
+	const float duration = m_cameraPath.back().time;
+	const float t = (duration > 0.f) ? fmod(m_frame * m_fixedDelta, duration) : 0.f;
+
+	UINT i = 0;
+	while ((i + 2 < m_cameraPath.size()) && (m_cameraPath[i + 1].time <= t))
+		++i;
+
+	const sCameraKey &k0 = m_cameraPath[i];
+	const sCameraKey &k1 = m_cameraPath[std::min(i + 1, (UINT)m_cameraPath.size() - 1)];
+	const float len = k1.time - k0.time;
+	const float a = (len > 0.f) ? std::max(0.f, std::min(1.f, (t - k0.time) / len)) : 0.f;
+	for (int k = 0; k < 3; ++k)
+	{
+		eyePos[k] = k0.eyePos[k] * (1.f - a) + k1.eyePos[k] * a;
+		lookAt[k] = k0.lookAt[k] * (1.f - a) + k1.lookAt[k] * a;
+	}
+}
+
+
+float cBenchmarkRunner::GetDeltaSeconds() const
+{
+	return m_fixedDelta;
+}
+
+
+// true if current frame measured (after warm up)
+// caller add pass time by AddPassSample() before EndFrame()
+bool cBenchmarkRunner::IsMeasureFrame() const
+{
+	return (m_frame >= m_warmupFrames) && !IsFinish();
+}
+
+
+// call after frame end, collect frame time
+// write json, m_isRun = false after last frame
+void cBenchmarkRunner::EndFrame(
+	const int heapAllocCount //= 0
+)
+{
+	const double curMs = GetSteadyTimeMs();
+	const float frameMs = (m_prevMs > 0) ? (float)(curMs - m_prevMs) : 0.f;
+	m_prevMs = curMs;
+
+	if (IsMeasureFrame())
+	{
+		m_frameMs.push_back(frameMs);
+		m_frameAllocs.push_back((float)heapAllocCount);
+	}
+	++m_frame;
+
+	if (m_isRun && IsFinish())
+	{
+		m_isWrite = WriteJson(m_outFileName.c_str());
+		m_isRun = false;
+	}
+}
+
+
+// pass time of measured frame
+void cBenchmarkRunner::AddPassSample(const char *name, const float cpuMs, const float gpuMs
+	, const int allocCount //= 0
+)
+{
+	auto it = std::find_if(m_passes.begin(), m_passes.end()
+		, [&](const sPass &pass) { return pass.name == name; });
+	if (m_passes.end() == it)
+	{
+		sPass pass;
+		pass.name = name;
+		pass.allocCount = 0;
+		pass.cpuMs.reserve(m_measureFrames);
+		pass.gpuMs.reserve(m_measureFrames);
+		m_passes.push_back(pass);
+		it = m_passes.end() - 1;
+	}
+	it->cpuMs.push_back(cpuMs);
+	it->gpuMs.push_back(gpuMs);
+	it->allocCount += allocCount;
+}
+
+
+bool cBenchmarkRunner::IsFinish() const
+{
+	return m_frame >= (m_warmupFrames + m_measureFrames);
+}
+
+
+bool cBenchmarkRunner::WriteJson(const char *fileName)
+{
+	FILE *fp = NULL;
+	if (fopen_s(&fp, fileName, "w") || !fp)
+		return false;
+
+	fprintf(fp, "{\n");
+	fprintf(fp, "\t\"sample\": \"%s\",\n", m_sampleName.c_str());
+	fprintf(fp, "\t\"warmupFrames\": %d,\n", m_warmupFrames);
+	fprintf(fp, "\t\"frames\": %d,\n", (int)m_frameMs.size());
+	int allocFrames = 0;
+	for (auto count : m_frameAllocs)
+		if (count > 0)
+			++allocFrames;
+
+	fprintf(fp, "\t");
+	WriteStat(fp, "frameMs", m_frameMs);
+	fprintf(fp, ",\n\t");
+	WriteStat(fp, "heapAllocs", m_frameAllocs);
+	fprintf(fp, ",\n\t\"heapAllocFrames\": %d", allocFrames);
+	fprintf(fp, ",\n\t\"zeroHeapAllocSteadyState\": %s", allocFrames ? "false" : "true");
+	fprintf(fp, ",\n\t\"passes\": [");
+	for (UINT i = 0; i < m_passes.size(); ++i)
+	{
+		sPass &pass = m_passes[i];
+		fprintf(fp, "%s\n\t\t{\"name\": \"%s\", \"samples\": %d, \"heapAllocs\": %d, "
+			, (i > 0) ? "," : "", pass.name.c_str(), (int)pass.cpuMs.size(), pass.allocCount);
+		WriteStat(fp, "cpuMs", pass.cpuMs);
+		fprintf(fp, ", ");
+		WriteStat(fp, "gpuMs", pass.gpuMs);
+		fprintf(fp, "}");
+	}
+	fprintf(fp, "\n\t]\n}\n");
+
+	const bool result = !ferror(fp);
+	fclose(fp);
+	return result;
+}
+
+
+void cBenchmarkRunner::Clear()
+{
+	m_isRun = false;
+	m_isWrite = false;
+	m_frame = 0;
+	m_prevMs = 0;
+	m_frameMs.clear();
+	m_frameAllocs.clear();
+	m_passes.clear();
+}
+
+
+// nearest rank, p: 0 ~ 1
+float cBenchmarkRunner::Percentile(std::vector<float> &values, const float p)
+{
+	if (values.empty())
+		return 0.f;
+	std::sort(values.begin(), values.end());
+	const int rank = (int)ceil(p * values.size()) - 1;
+	return values[std::max(0, std::min((int)values.size() - 1, rank))];
+}
@@ -0,0 +1,75 @@
+//
+// 2018-05-10, jjuiddong
+// Benchmark Runner
+//	- command line: -benchmark [-warmup=N] [-frames=M] [-out=file.json]
+//	- fixed delta time, scripted camera path (key frame, linear)
+//	- frame time, pass time p50/p95/p99, write JSON
+//	- heap allocation per frame, zero allocation steady state check
+//	- platform independent (steady_clock), every sample main loop, headless benchmark
+//	  pass time from caller (cProfiler, CPU timer), AddPassSample()
+//
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+namespace graphic
+{
+
+	class cBenchmarkRunner
+	{
+	public:
+		struct sCameraKey
+		{
+			float time; // seconds
+			float eyePos[3];
+			float lookAt[3];
+		};
+
+		// per pass sample
+		struct sPass
+		{
+			std::string name;
+			std::vector<float> cpuMs;
+			std::vector<float> gpuMs;
+			int allocCount; // total heap allocation
+		};
+
+		cBenchmarkRunner();
+		virtual ~cBenchmarkRunner();
+
+		bool Init(const char *commandLine, const char *sampleName);
+		void AddCameraKey(const float time, const float *eyePos, const float *lookAt);
+		void AddOrbit(const float *center, const float radius, const float lowHeight
+			, const float highHeight, const int keyCount = 8, const float keyTime = 1.5f);
+		void GetCamera(OUT float *eyePos, OUT float *lookAt) const;
+		float GetDeltaSeconds() const;
+		bool IsMeasureFrame() const;
+		void EndFrame(const int heapAllocCount = 0);
+		void AddPassSample(const char *name, const float cpuMs, const float gpuMs
+			, const int allocCount = 0);
+		bool IsFinish() const;
+		bool WriteJson(const char *fileName);
+		void Clear();
+
+		static float Percentile(std::vector<float> &values, const float p);
+
+
+	public:
+		bool m_isRun; // false after last frame, json written
+		bool m_isWrite; // json write success
+		std::string m_sampleName;
+		std::string m_outFileName;
+		int m_warmupFrames;
+		int m_measureFrames;
+		int m_frame; // rendered frame count
+		float m_fixedDelta; // seconds
+		double m_prevMs; // GetSteadyTimeMs(), previous EndFrame()
+		std::vector<sCameraKey> m_cameraPath;
+		std::vector<float> m_frameMs; // measured frame
+		std::vector<float> m_frameAllocs; // heap allocation per measured frame
+		std::vector<sPass> m_passes;
+	};
+
+}
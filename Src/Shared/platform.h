@@ -0,0 +1,55 @@
+//
+// 2018-05-26, jjuiddong
+// Platform
+//	- platform independent unit include this instead of Common/common.h
+//	  (no Common, Graphic11 dependency, build with headless test on Linux)
+//	- Windows: windows.h type, macro
+//	- other: UINT, BYTE, __int64, ZeroMemory, _aligned_malloc, fopen_s, OUT
+//	- min/max: use std::min, std::max
+//
+#pragma once
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#include <windows.h>
+	#include <malloc.h>
+#else
+	#include <cstdio>
+	#include <cstdlib>
+	#include <cstring>
+	#include <cerrno>
+	#include <strings.h>
+
+	typedef unsigned int UINT;
+	typedef unsigned char BYTE;
+	typedef unsigned int DWORD; // 32 bit, same as Windows
+	#define __int64 long long
+	#define ZeroMemory(dst, size) memset((dst), 0, (size))
+	#define _stricmp strcasecmp
+
+	inline int fopen_s(FILE **fp, const char *fileName, const char *mode)
+	{
+		*fp = fopen(fileName, mode);
+		return *fp ? 0 : errno;
+	}
+
+	inline void* _aligned_malloc(const size_t size, const size_t align)
+	{
+		void *ptr = NULL;
+		return posix_memalign(&ptr, align, size) ? NULL : ptr;
+	}
+
+	inline void _aligned_free(void *ptr)
+	{
+		free(ptr);
+	}
+#endif
+
+#ifndef OUT
+	#define OUT
+#endif
@@ -0,0 +1,22 @@
+//
+// 2018-05-26, jjuiddong
+// Steady Timer
+//	- milliseconds, std::chrono::steady_clock (monotonic)
+//	- platform independent, no Common, Graphic11 dependency
+//
+#pragma once
+
+#include <chrono>
+
+
+namespace graphic
+{
+
+	// milliseconds
+	inline double GetSteadyTimeMs()
+	{
+		using namespace std::chrono;
+		return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+	}
+
+}